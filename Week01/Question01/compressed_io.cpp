@@ -0,0 +1,319 @@
+#include "compressed_io.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "The FPC residual coding assumes a little-endian host.");
+
+namespace {
+
+const char COMPRESSED_MAGIC[8] = {'H', 'E', 'A', 'T', 'F', 'P', 'C', 'Z'};
+
+constexpr std::uint64_t TABLE_MASK = (std::uint64_t(1) << FPC_TABLE_BITS) - 1;
+
+// Predictor state of one chunk; a fresh state per chunk keeps chunks independent
+struct FpcPredictor {
+    std::vector<std::uint64_t> fcm, dfcm;
+    std::uint64_t fcm_hash = 0, dfcm_hash = 0, last = 0;
+
+    FpcPredictor() : fcm(TABLE_MASK + 1, 0), dfcm(TABLE_MASK + 1, 0) {}
+
+    std::uint64_t fcm_prediction() const { return fcm[fcm_hash]; }
+    std::uint64_t dfcm_prediction() const { return dfcm[dfcm_hash] + last; }
+
+    void update(std::uint64_t bits) {
+        fcm[fcm_hash] = bits;
+        fcm_hash = ((fcm_hash << 6) ^ (bits >> 48)) & TABLE_MASK;
+        std::uint64_t delta = bits - last;
+        dfcm[dfcm_hash] = delta;
+        dfcm_hash = ((dfcm_hash << 2) ^ (delta >> 40)) & TABLE_MASK;
+        last = bits;
+    }
+};
+
+// The 3-bit code covers 0-8 leading zero bytes except 4, which is stored as 3 (FPC)
+inline unsigned leading_zero_code(std::uint64_t residual, unsigned& stored_bytes) {
+    unsigned lzb = residual == 0 ? 8 : static_cast<unsigned>(__builtin_clzll(residual)) / 8;
+    if (lzb == 4) lzb = 3;
+    stored_bytes = 8 - lzb;
+    return lzb > 4 ? lzb - 1 : lzb;
+}
+
+} // namespace
+
+bool is_compressed_file(const std::string& filename) {
+    const std::string ext = ".fpc";
+    return filename.size() >= ext.size() &&
+           filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+std::size_t fpc_compress(const double* values, std::size_t count, unsigned char* out) {
+    // Layout: all 4-bit headers (two per byte) first, then the residual bytes
+    const std::size_t header_bytes = (count + 1) / 2;
+    unsigned char* headers = out;
+    unsigned char* p = out + header_bytes;
+    std::memset(headers, 0, header_bytes);
+
+    FpcPredictor predictor;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &values[i], sizeof(bits));
+
+        std::uint64_t fcm_residual = bits ^ predictor.fcm_prediction();
+        std::uint64_t dfcm_residual = bits ^ predictor.dfcm_prediction();
+        predictor.update(bits);
+
+        // The smaller residual has at least as many leading zero bytes
+        unsigned selector = dfcm_residual < fcm_residual ? 1 : 0;
+        std::uint64_t residual = selector ? dfcm_residual : fcm_residual;
+        unsigned stored_bytes;
+        unsigned code = leading_zero_code(residual, stored_bytes);
+
+        headers[i / 2] |= static_cast<unsigned char>(((selector << 3) | code) << ((i & 1) * 4));
+        std::memcpy(p, &residual, sizeof(residual));  // Always fits; only the low bytes are kept
+        p += stored_bytes;
+    }
+
+    return p - out;
+}
+
+void fpc_decompress(const unsigned char* in, std::size_t bytes, std::size_t count, double* out) {
+    const std::size_t header_bytes = (count + 1) / 2;
+    if (bytes < header_bytes) {
+        throw std::runtime_error("Error: Compressed chunk is truncated.");
+    }
+    const unsigned char* p = in + header_bytes;
+    const unsigned char* end = in + bytes;
+
+    FpcPredictor predictor;
+    for (std::size_t i = 0; i < count; ++i) {
+        unsigned nibble = (in[i / 2] >> ((i & 1) * 4)) & 0xF;
+        unsigned code = nibble & 0x7;
+        std::size_t stored_bytes = 8 - (code > 3 ? code + 1 : code);
+        if (static_cast<std::size_t>(end - p) < stored_bytes) {
+            throw std::runtime_error("Error: Compressed chunk is truncated.");
+        }
+
+        std::uint64_t residual = 0;
+        if (end - p >= 8) {
+            std::memcpy(&residual, p, sizeof(residual));
+            if (stored_bytes < 8) {
+                residual &= (std::uint64_t(1) << (8 * stored_bytes)) - 1;
+            }
+        } else {
+            std::memcpy(&residual, p, stored_bytes);  // Near the end of the chunk
+        }
+        p += stored_bytes;
+
+        std::uint64_t prediction = (nibble & 0x8) ? predictor.dfcm_prediction() : predictor.fcm_prediction();
+        std::uint64_t bits = residual ^ prediction;
+        predictor.update(bits);
+        std::memcpy(&out[i], &bits, sizeof(bits));
+    }
+
+    if (p != end) {
+        throw std::runtime_error("Error: Compressed chunk has trailing bytes.");
+    }
+}
+
+CompressedFieldWriter::CompressedFieldWriter(const std::string& filename, const std::vector<std::string>& names,
+                                             double a, double b, ThreadPool& pool, std::uint32_t chunk_values)
+    : file_(filename, std::ios::binary), pool_(pool), header_{}, batch_rows_(std::size_t(chunk_values) * pool.size()),
+      staged_(names.size()), staged_rows_(0), entries_(names.size()), offset_(0), payload_bytes_(0) {
+    if (names.empty() || chunk_values == 0) {
+        throw std::invalid_argument("A compressed field needs at least one column and a positive chunk size.");
+    }
+    if (!file_.is_open()) {
+        throw std::ios_base::failure("Error: Could not open file for writing.");
+    }
+
+    std::memcpy(header_.magic, COMPRESSED_MAGIC, sizeof(COMPRESSED_MAGIC));
+    header_.version = COMPRESSED_FORMAT_VERSION;
+    header_.endian_tag = GRID_ENDIAN_TAG;
+    header_.columns = static_cast<std::uint32_t>(names.size());
+    header_.chunk_values = chunk_values;
+    header_.a = a;
+    header_.b = b;
+
+    // Placeholder header; close() rewrites it once the row count and index offset are known
+    file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    for (const auto& name : names) {
+        if (name.size() >= COMPRESSED_NAME_BYTES) {
+            throw std::invalid_argument("Column name '" + name + "' is too long.");
+        }
+        char padded[COMPRESSED_NAME_BYTES] = {};
+        std::memcpy(padded, name.data(), name.size());
+        file_.write(padded, sizeof(padded));
+    }
+    offset_ = sizeof(header_) + names.size() * COMPRESSED_NAME_BYTES;
+
+    for (auto& column : staged_) {
+        column.resize(batch_rows_);
+    }
+    scratch_.resize(names.size() * pool.size());
+    for (auto& buffer : scratch_) {
+        buffer.resize(fpc_max_compressed_size(chunk_values));
+    }
+}
+
+void CompressedFieldWriter::append_rows(const double* rows, std::size_t count) {
+    const std::size_t columns = staged_.size();
+    while (count > 0) {
+        std::size_t n = std::min(count, batch_rows_ - staged_rows_);
+        for (std::size_t r = 0; r < n; ++r) {
+            for (std::size_t c = 0; c < columns; ++c) {
+                staged_[c][staged_rows_ + r] = rows[r * columns + c];
+            }
+        }
+        staged_rows_ += n;
+        rows += n * columns;
+        count -= n;
+        if (staged_rows_ == batch_rows_) {
+            flush_batch();
+        }
+    }
+}
+
+void CompressedFieldWriter::flush_batch() {
+    if (staged_rows_ == 0) {
+        return;
+    }
+
+    const std::size_t columns = staged_.size();
+    const std::size_t chunk_values = header_.chunk_values;
+    const std::size_t chunks = (staged_rows_ + chunk_values - 1) / chunk_values;
+    std::vector<std::size_t> sizes(columns * chunks);
+
+    // One task per (column, chunk); each chunk gets its own scratch buffer
+    pool_.run(columns * chunks, [&](std::size_t task) {
+        std::size_t c = task / chunks;
+        std::size_t k = task % chunks;
+        std::size_t first = k * chunk_values;
+        std::size_t count = std::min(chunk_values, staged_rows_ - first);
+        sizes[task] = fpc_compress(staged_[c].data() + first, count, scratch_[task].data());
+    });
+
+    for (std::size_t task = 0; task < columns * chunks; ++task) {
+        file_.write(reinterpret_cast<const char*>(scratch_[task].data()), sizes[task]);
+        entries_[task / chunks].push_back({offset_, sizes[task]});
+        offset_ += sizes[task];
+        payload_bytes_ += sizes[task];
+    }
+
+    header_.rows += staged_rows_;
+    staged_rows_ = 0;
+}
+
+void CompressedFieldWriter::close() {
+    flush_batch();
+
+    // Align the index so readers can use it in place
+    constexpr std::size_t align = alignof(CompressedChunkEntry);
+    const char padding[align] = {};
+    std::size_t pad = (align - offset_ % align) % align;
+    file_.write(padding, pad);
+    header_.index_offset = offset_ + pad;
+    for (const auto& column : entries_) {
+        file_.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(CompressedChunkEntry));
+    }
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+
+    file_.close();
+    if (!file_) {
+        throw std::ios_base::failure("Error: Failed while writing compressed file.");
+    }
+}
+
+void write_compressed_rows(const std::string& filename, const std::vector<std::string>& names, const double* rows,
+                           std::size_t count, double a, double b, ThreadPool& pool) {
+    CompressedFieldWriter writer(filename, names, a, b, pool);
+    writer.append_rows(rows, count);
+    writer.close();
+}
+
+CompressedField::CompressedField(const std::string& filename)
+    : file_(filename), header_(nullptr), index_(nullptr), chunks_(0) {
+    const std::size_t length = file_.size();
+    if (length < sizeof(CompressedFileHeader)) {
+        throw std::runtime_error("Error: " + filename + " is too small to be a compressed field file.");
+    }
+
+    header_ = reinterpret_cast<const CompressedFileHeader*>(file_.data());
+    if (std::memcmp(header_->magic, COMPRESSED_MAGIC, sizeof(COMPRESSED_MAGIC)) != 0) {
+        throw std::runtime_error("Error: " + filename + " is not a compressed field file.");
+    }
+    if (header_->endian_tag != GRID_ENDIAN_TAG) {
+        throw std::runtime_error("Error: " + filename + " was written with a different byte order.");
+    }
+    if (header_->version != COMPRESSED_FORMAT_VERSION) {
+        throw std::runtime_error("Error: unsupported compressed format version " +
+                                 std::to_string(header_->version) + ".");
+    }
+    if (header_->columns == 0 || header_->chunk_values == 0) {
+        throw std::runtime_error("Error: " + filename + " is truncated or corrupt.");
+    }
+
+    chunks_ = (header_->rows + header_->chunk_values - 1) / header_->chunk_values;
+    const std::uint64_t index_bytes = std::uint64_t(header_->columns) * chunks_ * sizeof(CompressedChunkEntry);
+    const std::uint64_t names_end = sizeof(CompressedFileHeader) + std::uint64_t(header_->columns) * COMPRESSED_NAME_BYTES;
+    if (names_end > length || header_->index_offset % alignof(CompressedChunkEntry) != 0 ||
+        header_->index_offset > length || index_bytes > length - header_->index_offset) {
+        throw std::runtime_error("Error: " + filename + " is truncated or corrupt.");
+    }
+
+    index_ = reinterpret_cast<const CompressedChunkEntry*>(file_.data() + header_->index_offset);
+    for (std::uint64_t e = 0; e < header_->columns * chunks_; ++e) {
+        if (index_[e].offset > length || index_[e].bytes > length - index_[e].offset) {
+            throw std::runtime_error("Error: " + filename + " is truncated or corrupt.");
+        }
+    }
+}
+
+std::string CompressedField::column_name(std::size_t column) const {
+    const char* name = file_.data() + sizeof(CompressedFileHeader) + column * COMPRESSED_NAME_BYTES;
+    return std::string(name, strnlen(name, COMPRESSED_NAME_BYTES));
+}
+
+std::size_t CompressedField::column_index(const std::string& name) const {
+    for (std::size_t c = 0; c < columns(); ++c) {
+        if (column_name(c) == name) {
+            return c;
+        }
+    }
+    throw std::invalid_argument("Compressed field has no column '" + name + "'.");
+}
+
+std::size_t CompressedField::chunk_size(std::size_t chunk) const {
+    std::uint64_t first = std::uint64_t(chunk) * header_->chunk_values;
+    return static_cast<std::size_t>(std::min<std::uint64_t>(header_->chunk_values, header_->rows - first));
+}
+
+void CompressedField::read_chunk(std::size_t column, std::size_t chunk, double* out) const {
+    if (column >= columns() || chunk >= chunks_) {
+        throw std::out_of_range("Compressed chunk index out of range.");
+    }
+    const CompressedChunkEntry& entry = index_[column * chunks_ + chunk];
+    fpc_decompress(reinterpret_cast<const unsigned char*>(file_.data()) + entry.offset, entry.bytes,
+                   chunk_size(chunk), out);
+}
+
+std::vector<double> CompressedField::read_column(std::size_t column, ThreadPool& pool) const {
+    std::vector<double> values(rows());
+    pool.run(chunks_, [&](std::size_t k) {
+        read_chunk(column, k, values.data() + k * header_->chunk_values);
+    });
+    return values;
+}
+
+// C entry point for the Python reader (libheatfpc.so): decodes one chunk, returns 0 on success
+extern "C" int heatfpc_decompress_chunk(const unsigned char* in, std::uint64_t bytes, std::uint64_t count,
+                                        double* out) {
+    try {
+        fpc_decompress(in, bytes, count, out);
+        return 0;
+    } catch (...) {
+        return -1;
+    }
+}
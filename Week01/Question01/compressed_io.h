@@ -0,0 +1,241 @@
+#ifndef COMPRESSED_IO_H
+#define COMPRESSED_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "grid_io.h"
+#include "thread_pool.h"
+
+/// Current version of the compressed field format.
+constexpr std::uint32_t COMPRESSED_FORMAT_VERSION = 1;
+
+/// Default number of values per column in each independently decodable chunk.
+constexpr std::uint32_t COMPRESSED_CHUNK_VALUES = 1 << 16;
+
+/// log2 of the number of entries in each predictor hash table (small tables stay in L1 and are cheap to reset per chunk).
+constexpr unsigned FPC_TABLE_BITS = 12;
+
+/**
+ * @brief Fixed 64-byte header of a compressed field file.
+ *
+ * The header is followed by `columns` 16-byte, NUL-padded column names and by the
+ * compressed chunks. Every column is split into chunks of `chunk_values` values (the last
+ * one may be shorter), and each chunk is compressed on its own, so any chunk can be
+ * decoded without the others. The chunk index at `index_offset` holds one
+ * CompressedChunkEntry per chunk, column by column.
+ */
+struct CompressedFileHeader {
+    char magic[8];                ///< Always "HEATFPCZ".
+    std::uint32_t version;        ///< Format version (COMPRESSED_FORMAT_VERSION).
+    std::uint32_t endian_tag;     ///< GRID_ENDIAN_TAG in the writer's byte order.
+    std::uint64_t rows;           ///< Number of values per column.
+    std::uint32_t columns;        ///< Number of columns.
+    std::uint32_t chunk_values;   ///< Values per chunk.
+    double a;                     ///< Lower bound of x.
+    double b;                     ///< Upper bound of x.
+    std::uint64_t index_offset;   ///< Byte offset of the chunk index.
+    std::uint32_t reserved[2];    ///< Zero; reserved for future versions.
+};
+
+static_assert(sizeof(CompressedFileHeader) == 64, "CompressedFileHeader must be exactly 64 bytes.");
+
+/**
+ * @brief Location of one compressed chunk.
+ */
+struct CompressedChunkEntry {
+    std::uint64_t offset;  ///< Byte offset of the chunk in the file.
+    std::uint64_t bytes;   ///< Compressed size of the chunk.
+};
+
+/// Length of a column name in the file, including the NUL padding.
+constexpr std::size_t COMPRESSED_NAME_BYTES = 16;
+
+/**
+ * @brief Checks whether a file name refers to a compressed field file (by its ".fpc" extension).
+ *
+ * @param filename The file name to inspect.
+ * @return True if the file name ends in ".fpc".
+ */
+bool is_compressed_file(const std::string& filename);
+
+/**
+ * @brief Upper bound on the compressed size of `count` values.
+ */
+constexpr std::size_t fpc_max_compressed_size(std::size_t count) {
+    return (count + 1) / 2 + 8 * count;
+}
+
+/**
+ * @brief Compresses doubles losslessly with FPC-style predictive XOR coding.
+ *
+ * Every value is predicted by a finite context method (FCM, the value that followed the
+ * same recent history) and a differential FCM (DFCM, the last value plus the stride that
+ * followed the same recent strides). The value is XORed with the closer prediction, and
+ * the result is stored as a 4-bit header (predictor and leading zero byte count) plus its
+ * non-zero low bytes. Smooth fields produce small residuals and therefore few bytes.
+ *
+ * @param values The values to compress.
+ * @param count Number of values.
+ * @param out Destination; must hold fpc_max_compressed_size(count) bytes.
+ * @return Number of bytes written.
+ */
+std::size_t fpc_compress(const double* values, std::size_t count, unsigned char* out);
+
+/**
+ * @brief Decompresses a block produced by fpc_compress.
+ *
+ * @param in The compressed bytes.
+ * @param bytes Number of compressed bytes.
+ * @param count Number of values in the block.
+ * @param out Destination for `count` values.
+ */
+void fpc_decompress(const unsigned char* in, std::size_t bytes, std::size_t count, double* out);
+
+/**
+ * @class CompressedFieldWriter
+ * @brief Writes a compressed field file incrementally, one batch of rows at a time.
+ *
+ * Rows are staged until every thread of the pool has a chunk to compress; the batch is then
+ * compressed in parallel and appended to the file. The chunk index and the header are
+ * written by close().
+ */
+class CompressedFieldWriter {
+public:
+    /**
+     * @brief Opens the output file.
+     * @param filename The output file name.
+     * @param names Column names (at most 15 characters each).
+     * @param a The lower bound of x stored in the header.
+     * @param b The upper bound of x stored in the header.
+     * @param pool Threads that compress the chunks.
+     * @param chunk_values Values per column in each chunk.
+     */
+    CompressedFieldWriter(const std::string& filename, const std::vector<std::string>& names, double a, double b,
+                          ThreadPool& pool, std::uint32_t chunk_values = COMPRESSED_CHUNK_VALUES);
+
+    /**
+     * @brief Appends rows stored row by row, one value per column each.
+     * @param rows Pointer to `count * columns` values.
+     * @param count Number of rows.
+     */
+    void append_rows(const double* rows, std::size_t count);
+
+    /**
+     * @brief Compresses the remaining rows, writes the chunk index and header, and closes the file.
+     */
+    void close();
+
+    /**
+     * @brief Number of compressed payload bytes written so far.
+     */
+    std::uint64_t compressed_bytes() const { return payload_bytes_; }
+
+private:
+    void flush_batch();  ///< Compresses and writes the staged rows.
+
+    std::ofstream file_;                                       ///< Output stream.
+    ThreadPool& pool_;                                         ///< Threads that compress the chunks.
+    CompressedFileHeader header_;                              ///< Header, completed by close().
+    std::size_t batch_rows_;                                   ///< Rows staged before a batch is compressed.
+    std::vector<std::vector<double>> staged_;                  ///< Staged values, one vector per column.
+    std::size_t staged_rows_;                                  ///< Number of staged rows.
+    std::vector<std::vector<unsigned char>> scratch_;          ///< Compression buffer of every chunk in a batch.
+    std::vector<std::vector<CompressedChunkEntry>> entries_;   ///< Chunk index, one vector per column.
+    std::uint64_t offset_;                                     ///< File offset of the next chunk.
+    std::uint64_t payload_bytes_;                              ///< Compressed bytes written so far.
+};
+
+/**
+ * @brief Writes columns of equal length to a compressed field file.
+ *
+ * @param filename The output file name.
+ * @param names Column names.
+ * @param rows Pointer to `count * names.size()` values, stored row by row.
+ * @param count Number of rows.
+ * @param a The lower bound of x stored in the header.
+ * @param b The upper bound of x stored in the header.
+ * @param pool Threads that compress the chunks.
+ */
+void write_compressed_rows(const std::string& filename, const std::vector<std::string>& names, const double* rows,
+                           std::size_t count, double a, double b, ThreadPool& pool);
+
+/**
+ * @class CompressedField
+ * @brief Read-only, memory-mapped view of a compressed field file.
+ */
+class CompressedField {
+public:
+    /**
+     * @brief Maps a compressed field file and validates its header and chunk index.
+     * @param filename The input file name.
+     */
+    explicit CompressedField(const std::string& filename);
+
+    /**
+     * @brief Number of values per column.
+     */
+    std::uint64_t rows() const { return header_->rows; }
+
+    /**
+     * @brief Number of columns.
+     */
+    std::size_t columns() const { return header_->columns; }
+
+    /**
+     * @brief Name of a column.
+     */
+    std::string column_name(std::size_t column) const;
+
+    /**
+     * @brief Index of a column by name (throws if absent).
+     */
+    std::size_t column_index(const std::string& name) const;
+
+    /**
+     * @brief Lower bound of x stored in the header.
+     */
+    double lower() const { return header_->a; }
+
+    /**
+     * @brief Upper bound of x stored in the header.
+     */
+    double upper() const { return header_->b; }
+
+    /**
+     * @brief Number of chunks per column.
+     */
+    std::size_t chunk_count() const { return chunks_; }
+
+    /**
+     * @brief Number of values in a chunk.
+     */
+    std::size_t chunk_size(std::size_t chunk) const;
+
+    /**
+     * @brief Decodes a single chunk of a column.
+     * @param column The column index.
+     * @param chunk The chunk index.
+     * @param out Destination for chunk_size(chunk) values.
+     */
+    void read_chunk(std::size_t column, std::size_t chunk, double* out) const;
+
+    /**
+     * @brief Decodes a whole column, one chunk per task.
+     * @param column The column index.
+     * @param pool Threads that decode the chunks.
+     * @return The column values.
+     */
+    std::vector<double> read_column(std::size_t column, ThreadPool& pool) const;
+
+private:
+    MappedFile file_;                            ///< Mapping of the whole file.
+    const CompressedFileHeader* header_;         ///< Header at the start of the mapping.
+    const CompressedChunkEntry* index_;          ///< Chunk index inside the mapping.
+    std::size_t chunks_;                         ///< Chunks per column.
+};
+
+#endif // COMPRESSED_IO_H
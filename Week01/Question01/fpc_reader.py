@@ -0,0 +1,60 @@
+import ctypes
+import os
+import struct
+from array import array
+
+# Layout of the 64-byte header and the chunk index (see compressed_io.h)
+HEADER_FORMAT = '<8sIIQIIddQ8x'
+ENTRY_FORMAT = '<QQ'
+NAME_BYTES = 16
+ENDIAN_TAG = 0x01020304
+
+
+def load_library(path=None):
+    """Loads the decoder built by `make libheatfpc.so` (next to this script by default)."""
+    if path is None:
+        path = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'libheatfpc.so')
+    lib = ctypes.CDLL(path)
+    lib.heatfpc_decompress_chunk.argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.c_uint64, ctypes.c_void_p]
+    lib.heatfpc_decompress_chunk.restype = ctypes.c_int
+    return lib
+
+
+def read_fpc(filename, lib=None):
+    """Reads a compressed field file.
+
+    Returns (columns, a, b), where columns maps each column name to an array('d') of values.
+    Every chunk is decoded on its own by the C++ decoder, straight into the output array.
+    """
+    if lib is None:
+        lib = load_library()
+
+    with open(filename, 'rb') as file:
+        data = bytearray(file.read())
+
+    magic, version, endian_tag, rows, ncols, chunk_values, a, b, index_offset = \
+        struct.unpack_from(HEADER_FORMAT, data, 0)
+    if magic != b'HEATFPCZ' or endian_tag != ENDIAN_TAG or version != 1:
+        raise ValueError(f"{filename} is not a supported compressed field file")
+
+    names = []
+    for c in range(ncols):
+        raw = data[64 + c * NAME_BYTES:64 + (c + 1) * NAME_BYTES]
+        names.append(raw.split(b'\0', 1)[0].decode())
+
+    chunks = (rows + chunk_values - 1) // chunk_values
+    buffer = (ctypes.c_ubyte * len(data)).from_buffer(data)
+    base = ctypes.addressof(buffer)
+
+    columns = {}
+    for c, name in enumerate(names):
+        values = array('d', bytes(8 * rows))
+        out = ctypes.addressof((ctypes.c_double * rows).from_buffer(values)) if rows else 0
+        for k in range(chunks):
+            offset, nbytes = struct.unpack_from(ENTRY_FORMAT, data, index_offset + (c * chunks + k) * 16)
+            count = min(chunk_values, rows - k * chunk_values)
+            if lib.heatfpc_decompress_chunk(base + offset, nbytes, count, out + 8 * k * chunk_values) != 0:
+                raise ValueError(f"{filename}: chunk {k} of column '{name}' is corrupt")
+        columns[name] = values
+
+    return columns, a, b
@@ -1,19 +1,24 @@
 #include <iostream>
-#include <fstream>
 #include <vector>
-#include <iomanip>
 #include <stdexcept>
 #include <sstream>  
+#include <cstdint>
+#include <charconv>
+#include <algorithm>
+
+#include "grid_io.h"
+#include "heat_distribution.h"
+#include "text_io.h"
 
 /**
- * @brief Converts a string to an integer using stringstream.
+ * @brief Converts a string to a 64-bit integer using stringstream.
  *
  * @param str The input string to be converted.
  * @return The integer value parsed from the string.
  */
-int string_to_int(const std::string& str) {
+std::int64_t string_to_int(const std::string& str) {
     std::stringstream ss(str);
-    int result;
+    std::int64_t result;
     ss >> result;
     if (ss.fail()) {
         throw std::invalid_argument("Invalid integer: " + str);
@@ -38,67 +43,132 @@ double string_to_double(const std::string& str) {
 }
 
 /**
- * @brief Generates a 1D grid with initial temperature values T(x).
+ * @brief Writes the initial grid configuration (index, T_initial) to a CSV file.
  *
- * @param N The number of grid points.
- * @param T_initial The initial temperature.
- * @return A vector of pairs representing (index, T_initial) values.
+ * @param filename The output CSV file name.
+ * @param data A vector of (index, T_initial) pairs.
  */
-std::vector<std::pair<int, double>> generate_initial_grid(int N, double T_initial) {
-    if (N <= 0) {
-        throw std::invalid_argument("Grid size N must be a positive integer.");
-    }
+void write_to_csv(const std::string& filename, const std::vector<std::pair<std::int64_t, double>>& data) {
+    TextWriter file(filename);
 
-    std::vector<std::pair<int, double>> data;
-    for (int i = 0; i < N; ++i) {
-        data.push_back({i, T_initial});  
+    file.write("index,T_initial\n");
+    for (const auto& [index, T] : data) {
+        file.write_integer(index);
+        file.put(',');
+        file.write_fixed(T, 6);
+        file.put('\n');
     }
 
-    return data;
+    file.close();
 }
 
 /**
- * @brief Writes the initial grid configuration (index, T_initial) to a CSV file.
+ * @brief Writes the initial grid directly to a file in fixed-size chunks, without building it in memory.
  *
- * @param filename The output CSV file name.
- * @param data A vector of (index, T_initial) pairs.
+ * Memory use is bounded by the chunk size (or the text buffer for CSV) regardless of N.
+ *
+ * @param filename The output file name (CSV if it ends in .csv, binary grid format otherwise).
+ * @param N The number of grid points.
+ * @param T_initial The initial temperature.
+ * @param a The lower bound of x stored in the binary header.
+ * @param b The upper bound of x stored in the binary header.
+ * @param chunk_size The number of grid points produced and written at a time.
  */
-void write_to_csv(const std::string& filename, const std::vector<std::pair<int, double>>& data) {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        throw std::ios_base::failure("Error: Could not open file for writing.");
+void stream_initial_grid(const std::string& filename, std::int64_t N, double T_initial, double a, double b,
+                         std::size_t chunk_size) {
+    if (N <= 0) {
+        throw std::invalid_argument("Grid size N must be a positive integer.");
     }
 
-    file << "index,T_initial\n";  
-    for (const auto& [index, T] : data) {
-        file << index << "," << std::fixed << std::setprecision(6) << T << "\n";
+    if (!is_csv_file(filename)) {
+        GridFileWriter writer(filename, N, a, b);
+        std::vector<double> chunk(chunk_size, T_initial);
+        for (std::int64_t first = 0; first < N; first += chunk_size) {
+            writer.append(chunk.data(), std::min<std::int64_t>(chunk_size, N - first));
+        }
+        writer.close();
+        return;
+    }
+
+    // Format the constant temperature once; only the index changes from row to row
+    TextWriter file(filename);
+    char value[64];
+    auto formatted = std::to_chars(value, value + sizeof(value), T_initial, std::chars_format::fixed, 6);
+    const std::string_view suffix(value, formatted.ptr - value);
+
+    file.write("index,T_initial\n");
+    for (std::int64_t i = 0; i < N; ++i) {
+        file.write_integer(i);
+        file.put(',');
+        file.write(suffix);
+        file.put('\n');
     }
 
     file.close();
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 4) {
-        std::cerr << "Usage: " << argv[0] << " <N> <T_initial> <output_file>\n";
+    // Split the optional --stream[=chunk_size] flag from the positional arguments
+    std::vector<std::string> args;
+    bool stream = false;
+    std::size_t chunk_size = 1 << 16;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--stream") {
+                stream = true;
+            } else if (arg.rfind("--stream=", 0) == 0) {
+                stream = true;
+                std::int64_t value = string_to_int(arg.substr(9));
+                if (value <= 0) {
+                    throw std::invalid_argument("Chunk size must be a positive integer.");
+                }
+                chunk_size = static_cast<std::size_t>(value);
+            } else {
+                args.push_back(arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (args.size() != 3 && args.size() != 5) {
+        std::cerr << "Usage: " << argv[0] << " <N> <T_initial> <output_file> [<a> <b>] [--stream[=chunk_size]]\n";
+        std::cerr << "       Files ending in .csv are written as CSV, anything else in the binary grid format.\n";
+        std::cerr << "       --stream writes the grid in fixed-size chunks with constant memory.\n";
         return 1;
     }
 
     try {
-        int N = string_to_int(argv[1]);          // Convert string to int
-        double T_initial = string_to_double(argv[2]); // Convert string to double
-        std::string output_file = argv[3];     // Output CSV file name
+        std::int64_t N = string_to_int(args[0]);        // Convert string to a 64-bit integer
+        double T_initial = string_to_double(args[1]);   // Convert string to double
+        std::string output_file = args[2];              // Output file name
+
+        // Bounds recorded in the binary header; default to the index range
+        double a = (args.size() == 5) ? string_to_double(args[3]) : 0.0;
+        double b = (args.size() == 5) ? string_to_double(args[4]) : static_cast<double>(N - 1);
 
         // Debugging statements
         std::cout << "Generating grid with " << N << " points and initial temperature " << T_initial << "\n";
         std::cout << "Writing to file: " << output_file << "\n";
 
-        // Generate grid
-        auto data = generate_initial_grid(N, T_initial);
-
-        std::cout << "Grid generated successfully.\n";
-
-        // Write to CSV file
-        write_to_csv(output_file, data);
+        if (stream) {
+            // Produce and write the grid chunk by chunk
+            stream_initial_grid(output_file, N, T_initial, a, b, chunk_size);
+        } else {
+            // Generate grid
+            auto data = generate_initial_grid(N, T_initial);
+
+            std::cout << "Grid generated successfully.\n";
+
+            // Write to file; CSV stays available as an export format
+            if (is_csv_file(output_file)) {
+                write_to_csv(output_file, data);
+            } else {
+                write_grid_binary(output_file, data, a, b);
+            }
+        }
 
         std::cout << "Initial grid configuration written to " << output_file << "\n";
     } catch (const std::exception& e) {
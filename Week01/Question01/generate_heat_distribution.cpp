@@ -1,60 +1,63 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
-#include <sstream>
-#include <cmath>
 #include <stdexcept>
-#include <iomanip>
+#include <cstdint>
+#include <algorithm>
+
+#include "compressed_io.h"
+#include "grid_io.h"
+#include "heat_distribution.h"
+#include "text_io.h"
+#include "thread_pool.h"
 
 /**
  * @brief Reads the initial grid configuration from a CSV file.
  *
+ * The file is mapped and parsed in parallel; only the index column is kept.
+ *
  * @param filename The input CSV file name.
+ * @param pool Threads that parse the file.
  * @return A vector of grid indices.
  */
-std::vector<int> read_from_csv(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throw std::ios_base::failure("Error: Could not open file for reading.");
-    }
+std::vector<std::int64_t> read_from_csv(const std::string& filename, ThreadPool& pool) {
+    auto columns = read_csv_columns(filename, 2, {0}, pool);
 
-    std::vector<int> indices;
-    std::string line;
-    std::getline(file, line);  
-
-    while (std::getline(file, line)) {
-        std::istringstream ss(line);
-        int index;
-        double T_initial;
-        char comma;
-        ss >> index >> comma >> T_initial;
-        indices.push_back(index);
-    }
+    std::vector<std::int64_t> indices(columns[0].size());
+    pool.parallel_for(0, indices.size(), [&](std::size_t lo, std::size_t hi) {
+        for (std::size_t i = lo; i < hi; ++i) {
+            indices[i] = static_cast<std::int64_t>(columns[0][i]);
+        }
+    });
 
     return indices;
 }
 
 /**
- * @brief Computes the 1D heat distribution using the formula T(x) = 1 - x^2.
+ * @brief Counts the data rows of a CSV file (all lines after the header) without storing them.
  *
- * @param indices A vector of grid indices.
- * @param a The lower bound of x.
- * @param b The upper bound of x.
- * @return A vector of pairs representing (x, T(x)) values for the heat distribution.
+ * @param filename The input CSV file name.
+ * @return The number of data rows.
  */
-std::vector<std::pair<double, double>> compute_heat_distribution(const std::vector<int>& indices, double a, double b) {
-    std::vector<std::pair<double, double>> heat_distribution;
-
-    int N = indices.size();
-    double step = (b - a) / (N - 1);  // Calculate step size
+std::uint64_t count_csv_rows(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::ios_base::failure("Error: Could not open file for reading.");
+    }
 
-    for (int i = 0; i < N; ++i) {
-        double x = a + i * step;  // Map index to x in the range [a, b]
-        double T = 1.0 - x * x;   // Compute T(x) = 1 - x^2
-        heat_distribution.push_back({x, T});
+    std::vector<char> buffer(1 << 20);
+    std::uint64_t lines = 0;
+    char last = '\n';
+    while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+        std::streamsize n = file.gcount();
+        lines += std::count(buffer.data(), buffer.data() + n, '\n');
+        last = buffer[n - 1];
+    }
+    if (last != '\n') {
+        ++lines;  // Final row without a trailing newline
     }
 
-    return heat_distribution;
+    return lines > 0 ? lines - 1 : 0;  // Skip the header
 }
 
 /**
@@ -64,48 +67,167 @@ std::vector<std::pair<double, double>> compute_heat_distribution(const std::vect
  * @param data A vector of (x, T(x)) pairs for the heat distribution.
  */
 void write_heat_distribution_to_csv(const std::string& filename, const std::vector<std::pair<double, double>>& data) {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        throw std::ios_base::failure("Error: Could not open file for writing.");
-    }
+    TextWriter file(filename);
 
-    file << "x,T\n";  
+    file.write("x,T\n");
     for (const auto& [x, T] : data) {
-        file << std::fixed << std::setprecision(6) << x << "," << T << "\n";
+        file.write_fixed(x, 6);
+        file.put(',');
+        file.write_fixed(T, 6);
+        file.put('\n');
+    }
+
+    file.close();
+}
+
+/**
+ * @brief Computes the 1D heat distribution and writes it to a CSV file in fixed-size chunks.
+ *
+ * Only one chunk of (x, T(x)) pairs and the output text buffer are held in memory at a time,
+ * so memory use is constant regardless of N.
+ *
+ * @param filename The output CSV file name.
+ * @param N The number of grid points.
+ * @param a The lower bound of x.
+ * @param b The upper bound of x.
+ * @param chunk_size The number of grid points computed and written at a time.
+ */
+void stream_heat_distribution_to_csv(const std::string& filename, std::uint64_t N, double a, double b,
+                                     std::size_t chunk_size) {
+    TextWriter file(filename);
+
+    file.write("x,T\n");
+    std::vector<std::pair<double, double>> chunk(chunk_size);
+    for (std::uint64_t first = 0; first < N; first += chunk_size) {
+        std::size_t count = std::min<std::uint64_t>(chunk_size, N - first);
+        compute_heat_distribution_chunk(first, count, N, a, b, chunk.data());
+
+        for (std::size_t j = 0; j < count; ++j) {
+            file.write_fixed(chunk[j].first, 6);
+            file.put(',');
+            file.write_fixed(chunk[j].second, 6);
+            file.put('\n');
+        }
     }
 
     file.close();
 }
 
+/**
+ * @brief Writes the 1D heat distribution to a compressed field file with columns "x" and "T".
+ *
+ * @param filename The output file name.
+ * @param data A vector of (x, T(x)) pairs for the heat distribution.
+ * @param a The lower bound of x.
+ * @param b The upper bound of x.
+ * @param pool Threads that compress the chunks.
+ */
+void write_heat_distribution_compressed(const std::string& filename, const std::vector<std::pair<double, double>>& data,
+                                        double a, double b, ThreadPool& pool) {
+    static_assert(sizeof(std::pair<double, double>) == 2 * sizeof(double), "Pairs must be stored as two doubles.");
+    write_compressed_rows(filename, {"x", "T"}, reinterpret_cast<const double*>(data.data()), data.size(), a, b, pool);
+}
+
+/**
+ * @brief Computes the 1D heat distribution and writes it to a compressed field file in fixed-size chunks.
+ *
+ * @param filename The output file name.
+ * @param N The number of grid points.
+ * @param a The lower bound of x.
+ * @param b The upper bound of x.
+ * @param chunk_size The number of grid points computed at a time.
+ * @param pool Threads that compress the chunks.
+ */
+void stream_heat_distribution_compressed(const std::string& filename, std::uint64_t N, double a, double b,
+                                         std::size_t chunk_size, ThreadPool& pool) {
+    CompressedFieldWriter writer(filename, {"x", "T"}, a, b, pool);
+    std::vector<std::pair<double, double>> chunk(chunk_size);
+    for (std::uint64_t first = 0; first < N; first += chunk_size) {
+        std::size_t count = std::min<std::uint64_t>(chunk_size, N - first);
+        compute_heat_distribution_chunk(first, count, N, a, b, chunk.data());
+        writer.append_rows(reinterpret_cast<const double*>(chunk.data()), count);
+    }
+    writer.close();
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 5) {
-        std::cerr << "Usage: " << argv[0] << " <input_file> <a> <b> <output_file>\n";
+    // Split the optional --stream[=chunk_size] flag from the positional arguments
+    std::vector<std::string> args;
+    bool stream = false;
+    std::size_t chunk_size = 1 << 16;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--stream") {
+                stream = true;
+            } else if (arg.rfind("--stream=", 0) == 0) {
+                stream = true;
+                long long value = std::stoll(arg.substr(9));
+                if (value <= 0) {
+                    throw std::invalid_argument("Chunk size must be a positive integer.");
+                }
+                chunk_size = static_cast<std::size_t>(value);
+            } else {
+                args.push_back(arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (args.size() != 4) {
+        std::cerr << "Usage: " << argv[0] << " <input_file> <a> <b> <output_file> [--stream[=chunk_size]]\n";
+        std::cerr << "       --stream computes and writes the distribution in fixed-size chunks with constant memory.\n";
+        std::cerr << "       Output files ending in .fpc are written compressed, anything else as CSV.\n";
         return 1;
     }
 
     try {
-        std::string input_file = argv[1];      // Input CSV file
-        double a = std::stod(argv[2]);         // Lower bound of x
-        double b = std::stod(argv[3]);         // Upper bound of x
-        std::string output_file = argv[4];     // Output CSV file for the heat distribution
+        std::string input_file = args[0];      // Input grid file (binary or CSV)
+        double a = std::stod(args[1]);         // Lower bound of x
+        double b = std::stod(args[2]);         // Upper bound of x
+        std::string output_file = args[3];     // Output file for the heat distribution (CSV or compressed)
+        bool compressed = is_compressed_file(output_file);
+        ThreadPool pool;
 
         // Debugging statements
         std::cout << "Reading from file: " << input_file << "\n";
         std::cout << "Computing heat distribution for range [" << a << ", " << b << "]\n";
         std::cout << "Writing to file: " << output_file << "\n";
 
-        // Read the grid indices from the CSV file
-        auto indices = read_from_csv(input_file);
-
-        std::cout << "Grid read successfully. Number of points: " << indices.size() << "\n";
-
-        // Compute the 1D heat distribution
-        auto heat_distribution = compute_heat_distribution(indices, a, b);
-
-        std::cout << "Heat distribution computed successfully.\n";
-
-        // Write the heat distribution to the output CSV file
-        write_heat_distribution_to_csv(output_file, heat_distribution);
+        if (stream) {
+            // Only the number of points is needed; neither input format is loaded into memory
+            std::uint64_t N = is_csv_file(input_file) ? count_csv_rows(input_file) : MappedGrid(input_file).size();
+            std::cout << "Grid read successfully. Number of points: " << N << "\n";
+
+            if (compressed) {
+                stream_heat_distribution_compressed(output_file, N, a, b, chunk_size, pool);
+            } else {
+                stream_heat_distribution_to_csv(output_file, N, a, b, chunk_size);
+            }
+        } else {
+            // Read the grid from the CSV export or map the binary grid file
+            std::vector<std::pair<double, double>> heat_distribution;
+            if (is_csv_file(input_file)) {
+                auto indices = read_from_csv(input_file, pool);
+                std::cout << "Grid read successfully. Number of points: " << indices.size() << "\n";
+                heat_distribution = compute_heat_distribution(indices, a, b);
+            } else {
+                MappedGrid grid(input_file);
+                std::cout << "Grid mapped successfully. Number of points: " << grid.size() << "\n";
+                heat_distribution = compute_heat_distribution(grid.size(), a, b);
+            }
+
+            std::cout << "Heat distribution computed successfully.\n";
+
+            // Write the heat distribution to the output file
+            if (compressed) {
+                write_heat_distribution_compressed(output_file, heat_distribution, a, b, pool);
+            } else {
+                write_heat_distribution_to_csv(output_file, heat_distribution);
+            }
+        }
 
         std::cout << "Heat distribution written to " << output_file << "\n";
     } catch (const std::exception& e) {
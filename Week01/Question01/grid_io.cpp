@@ -0,0 +1,150 @@
+#include "grid_io.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// Number of values staged in memory before each write to disk
+constexpr std::size_t WRITE_CHUNK = 1 << 16;
+
+const char GRID_MAGIC[8] = {'H', 'E', 'A', 'T', 'G', 'R', 'I', 'D'};
+
+} // namespace
+
+bool is_csv_file(const std::string& filename) {
+    const std::string ext = ".csv";
+    return filename.size() >= ext.size() &&
+           filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+GridFileWriter::GridFileWriter(const std::string& filename, std::uint64_t N, double a, double b,
+                               const GridCheckpointInfo* checkpoint)
+    : file_(filename, std::ios::binary), expected_(N), written_(0) {
+    if (!file_.is_open()) {
+        throw std::ios_base::failure("Error: Could not open file for writing.");
+    }
+
+    GridFileHeader header{};
+    std::memcpy(header.magic, GRID_MAGIC, sizeof(GRID_MAGIC));
+    header.version = GRID_FORMAT_VERSION;
+    header.dtype = GRID_DTYPE_FLOAT64;
+    header.N = N;
+    header.a = a;
+    header.b = b;
+    header.payload_offset = sizeof(GridFileHeader) + (checkpoint ? sizeof(GridCheckpointInfo) : 0);
+    header.endian_tag = GRID_ENDIAN_TAG;
+    header.flags = checkpoint ? std::uint32_t(GRID_FLAG_CHECKPOINT) : 0u;
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (checkpoint) {
+        file_.write(reinterpret_cast<const char*>(checkpoint), sizeof(GridCheckpointInfo));
+    }
+}
+
+void GridFileWriter::append(const double* values, std::size_t count) {
+    file_.write(reinterpret_cast<const char*>(values), count * sizeof(double));
+    written_ += count;
+}
+
+void GridFileWriter::close() {
+    file_.close();
+    if (!file_) {
+        throw std::ios_base::failure("Error: Failed while writing grid file.");
+    }
+    if (written_ != expected_) {
+        throw std::runtime_error("Error: grid file received " + std::to_string(written_) +
+                                 " values but its header announces " + std::to_string(expected_) + ".");
+    }
+}
+
+void write_grid_binary(const std::string& filename, const std::vector<std::pair<std::int64_t, double>>& data,
+                       double a, double b) {
+    GridFileWriter writer(filename, data.size(), a, b);
+
+    // Stage the temperatures in fixed-size chunks; the index is implicit in the position
+    std::vector<double> chunk;
+    chunk.reserve(WRITE_CHUNK);
+    for (const auto& [index, T] : data) {
+        chunk.push_back(T);
+        if (chunk.size() == WRITE_CHUNK) {
+            writer.append(chunk.data(), chunk.size());
+            chunk.clear();
+        }
+    }
+    writer.append(chunk.data(), chunk.size());
+    writer.close();
+}
+
+MappedFile::MappedFile(const std::string& filename) : base_(nullptr), length_(0) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::ios_base::failure("Error: Could not open file for reading.");
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::ios_base::failure("Error: Could not stat " + filename + ".");
+    }
+    length_ = static_cast<std::size_t>(st.st_size);
+    if (length_ == 0) {
+        ::close(fd);
+        return;  // mmap rejects empty mappings; an empty file maps to nullptr
+    }
+
+    base_ = ::mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping stays valid after the descriptor is closed
+    if (base_ == MAP_FAILED) {
+        base_ = nullptr;
+        throw std::ios_base::failure("Error: Could not map " + filename + ".");
+    }
+    ::madvise(base_, length_, MADV_SEQUENTIAL);
+}
+
+MappedFile::~MappedFile() {
+    if (base_ != nullptr) {
+        ::munmap(base_, length_);
+    }
+}
+
+MappedGrid::MappedGrid(const std::string& filename)
+    : file_(filename), header_(nullptr), checkpoint_(nullptr), values_(nullptr) {
+    const std::size_t length = file_.size();
+    if (length < sizeof(GridFileHeader)) {
+        throw std::runtime_error("Error: " + filename + " is too small to be a grid file.");
+    }
+
+    header_ = reinterpret_cast<const GridFileHeader*>(file_.data());
+    if (std::memcmp(header_->magic, GRID_MAGIC, sizeof(GRID_MAGIC)) != 0) {
+        throw std::runtime_error("Error: " + filename + " is not a binary grid file.");
+    }
+    if (header_->endian_tag != GRID_ENDIAN_TAG) {
+        throw std::runtime_error("Error: " + filename + " was written with a different byte order.");
+    }
+    if (header_->version < 1 || header_->version > GRID_FORMAT_VERSION) {
+        throw std::runtime_error("Error: unsupported grid format version " +
+                                 std::to_string(header_->version) + ".");
+    }
+    if (header_->dtype != GRID_DTYPE_FLOAT64) {
+        throw std::runtime_error("Error: unsupported grid dtype " + std::to_string(header_->dtype) + ".");
+    }
+    if (header_->payload_offset % alignof(double) != 0 ||
+        header_->payload_offset > length ||
+        header_->N > (length - header_->payload_offset) / sizeof(double)) {
+        throw std::runtime_error("Error: " + filename + " is truncated or corrupt.");
+    }
+    if (header_->version >= 2 && (header_->flags & GRID_FLAG_CHECKPOINT)) {
+        if (header_->payload_offset < sizeof(GridFileHeader) + sizeof(GridCheckpointInfo)) {
+            throw std::runtime_error("Error: " + filename + " is truncated or corrupt.");
+        }
+        checkpoint_ = reinterpret_cast<const GridCheckpointInfo*>(file_.data() + sizeof(GridFileHeader));
+    }
+
+    values_ = reinterpret_cast<const double*>(file_.data() + header_->payload_offset);
+}
@@ -0,0 +1,209 @@
+#ifndef GRID_IO_H
+#define GRID_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Current version of the binary grid format (version 2 added the checkpoint block; version 1 files are still read).
+constexpr std::uint32_t GRID_FORMAT_VERSION = 2;
+
+/// Tag written in native byte order; a mismatch on read means the file came from a machine with different endianness.
+constexpr std::uint32_t GRID_ENDIAN_TAG = 0x01020304u;
+
+/**
+ * @brief Element type codes for the payload of a binary grid file.
+ */
+enum GridDType : std::uint32_t {
+    GRID_DTYPE_FLOAT64 = 1  ///< IEEE-754 double precision.
+};
+
+/**
+ * @brief Flags stored in the header of a binary grid file.
+ */
+enum GridFlags : std::uint32_t {
+    GRID_FLAG_CHECKPOINT = 1  ///< A GridCheckpointInfo block follows the header.
+};
+
+/**
+ * @brief Fixed 64-byte header of a binary grid file.
+ *
+ * The header is followed by `N` contiguous values of type `dtype`, starting at
+ * `payload_offset` bytes from the beginning of the file. The grid index is
+ * implicit: the i-th value belongs to grid point i. If GRID_FLAG_CHECKPOINT is set,
+ * a GridCheckpointInfo block sits between the header and the payload.
+ */
+struct GridFileHeader {
+    char magic[8];                 ///< Always "HEATGRID".
+    std::uint32_t version;         ///< Format version (GRID_FORMAT_VERSION).
+    std::uint32_t dtype;           ///< Payload element type (GridDType).
+    std::uint64_t N;               ///< Number of grid points.
+    double a;                      ///< Lower bound of x.
+    double b;                      ///< Upper bound of x.
+    std::uint64_t payload_offset;  ///< Byte offset of the payload.
+    std::uint32_t endian_tag;      ///< GRID_ENDIAN_TAG in the writer's byte order.
+    std::uint32_t flags;           ///< GridFlags (version 2; zero in version 1).
+    std::uint32_t reserved[2];     ///< Zero; reserved for future versions.
+};
+
+static_assert(sizeof(GridFileHeader) == 64, "GridFileHeader must be exactly 64 bytes.");
+
+/**
+ * @brief Solver state stored with a grid written during a time-marching run.
+ *
+ * Together with the temperatures it is everything needed to resume the run.
+ */
+struct GridCheckpointInfo {
+    std::uint64_t step;           ///< Number of time steps taken.
+    double time;                  ///< Simulated time reached.
+    double alpha;                 ///< Thermal diffusivity.
+    double dt;                    ///< Time step.
+    std::uint32_t bc_type;        ///< Boundary condition kind (BoundaryType).
+    std::uint32_t reserved;       ///< Zero.
+    double bc_left;               ///< Boundary value at x = a.
+    double bc_right;              ///< Boundary value at x = b.
+};
+
+static_assert(sizeof(GridCheckpointInfo) == 56, "GridCheckpointInfo must be exactly 56 bytes.");
+
+/**
+ * @brief Checks whether a file name refers to a CSV file (by its ".csv" extension).
+ *
+ * @param filename The file name to inspect.
+ * @return True if the file name ends in ".csv".
+ */
+bool is_csv_file(const std::string& filename);
+
+/**
+ * @class GridFileWriter
+ * @brief Writes a binary grid file incrementally, one chunk of values at a time.
+ *
+ * The header is written up front, so the caller never needs the whole grid in memory.
+ */
+class GridFileWriter {
+public:
+    /**
+     * @brief Opens the output file and writes the header.
+     * @param filename The output file name.
+     * @param N The number of values that will be appended.
+     * @param a The lower bound of x stored in the header.
+     * @param b The upper bound of x stored in the header.
+     * @param checkpoint Optional solver state written after the header.
+     */
+    GridFileWriter(const std::string& filename, std::uint64_t N, double a, double b,
+                   const GridCheckpointInfo* checkpoint = nullptr);
+
+    /**
+     * @brief Appends values to the payload.
+     * @param values Pointer to the values to write.
+     * @param count Number of values to write.
+     */
+    void append(const double* values, std::size_t count);
+
+    /**
+     * @brief Flushes and closes the file, checking that exactly N values were written.
+     */
+    void close();
+
+private:
+    std::ofstream file_;      ///< Output stream.
+    std::uint64_t expected_;  ///< Number of values announced in the header.
+    std::uint64_t written_;   ///< Number of values appended so far.
+};
+
+/**
+ * @brief Writes the initial grid configuration to a binary grid file.
+ *
+ * @param filename The output file name.
+ * @param data A vector of (index, T_initial) pairs.
+ * @param a The lower bound of x stored in the header.
+ * @param b The upper bound of x stored in the header.
+ */
+void write_grid_binary(const std::string& filename, const std::vector<std::pair<std::int64_t, double>>& data,
+                       double a, double b);
+
+/**
+ * @class MappedFile
+ * @brief Read-only memory mapping of a whole file.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Maps a file read-only.
+     * @param filename The input file name.
+     */
+    explicit MappedFile(const std::string& filename);
+
+    /**
+     * @brief Unmaps the file.
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief First byte of the file (nullptr for an empty file).
+     */
+    const char* data() const { return static_cast<const char*>(base_); }
+
+    /**
+     * @brief Length of the file in bytes.
+     */
+    std::size_t size() const { return length_; }
+
+private:
+    void* base_;          ///< Start of the mapping.
+    std::size_t length_;  ///< Length of the mapping in bytes.
+};
+
+/**
+ * @class MappedGrid
+ * @brief Read-only, memory-mapped view of a binary grid file.
+ *
+ * The payload is accessed directly from the mapping and is never copied.
+ */
+class MappedGrid {
+public:
+    /**
+     * @brief Maps a binary grid file and validates its header.
+     * @param filename The input file name.
+     */
+    explicit MappedGrid(const std::string& filename);
+
+    /**
+     * @brief Number of grid points stored in the file.
+     */
+    std::uint64_t size() const { return header_->N; }
+
+    /**
+     * @brief Lower bound of x stored in the header.
+     */
+    double lower() const { return header_->a; }
+
+    /**
+     * @brief Upper bound of x stored in the header.
+     */
+    double upper() const { return header_->b; }
+
+    /**
+     * @brief Pointer to the first payload value inside the mapping.
+     */
+    const double* data() const { return values_; }
+
+    /**
+     * @brief Solver state stored with the grid, or nullptr if the file is not a checkpoint.
+     */
+    const GridCheckpointInfo* checkpoint() const { return checkpoint_; }
+
+private:
+    MappedFile file_;                        ///< Mapping of the whole file.
+    const GridFileHeader* header_;           ///< Header at the start of the mapping.
+    const GridCheckpointInfo* checkpoint_;   ///< Checkpoint block inside the mapping, if any.
+    const double* values_;                   ///< Payload inside the mapping.
+};
+
+#endif // GRID_IO_H
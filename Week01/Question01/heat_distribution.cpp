@@ -0,0 +1,74 @@
+#include "heat_distribution.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+// Parse "N T_initial a b" lines, skipping blank lines and comments
+std::vector<RodSpec> read_rod_specs(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::ios_base::failure("Error: Could not open file for reading.");
+    }
+
+    std::vector<RodSpec> rods;
+    std::string line;
+    std::size_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        std::size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        std::istringstream ss(line);
+        RodSpec rod;
+        long long N;
+        if (!(ss >> N >> rod.T_initial >> rod.a >> rod.b) || N < 3 || !(rod.b > rod.a)) {
+            throw std::invalid_argument("Invalid rod specification on line " + std::to_string(line_number) +
+                                        " (expected \"N T_initial a b\" with N >= 3 and a < b).");
+        }
+        rod.N = static_cast<std::uint64_t>(N);
+        rods.push_back(rod);
+    }
+
+    return rods;
+}
+
+// Generate a uniform initial grid of (index, T_initial) pairs
+std::vector<std::pair<std::int64_t, double>> generate_initial_grid(std::int64_t N, double T_initial) {
+    if (N <= 0) {
+        throw std::invalid_argument("Grid size N must be a positive integer.");
+    }
+
+    std::vector<std::pair<std::int64_t, double>> data;
+    data.reserve(N);
+    for (std::int64_t i = 0; i < N; ++i) {
+        data.push_back({i, T_initial});  
+    }
+
+    return data;
+}
+
+// Evaluate T(x) = 1 - x^2 for grid points [first, first + count)
+void compute_heat_distribution_chunk(std::uint64_t first, std::size_t count, std::uint64_t N, double a, double b,
+                                     std::pair<double, double>* out) {
+    double step = (b - a) / (N - 1);  // Calculate step size
+
+    for (std::size_t j = 0; j < count; ++j) {
+        double x = a + (first + j) * step;  // Map index to x in the range [a, b]
+        double T = 1.0 - x * x;             // Compute T(x) = 1 - x^2
+        out[j] = {x, T};
+    }
+}
+
+// Evaluate T(x) = 1 - x^2 for all N grid points
+std::vector<std::pair<double, double>> compute_heat_distribution(std::uint64_t N, double a, double b) {
+    std::vector<std::pair<double, double>> heat_distribution(N);
+    compute_heat_distribution_chunk(0, N, N, a, b, heat_distribution.data());
+    return heat_distribution;
+}
+
+// Evaluate T(x) = 1 - x^2 for the grid described by its indices
+std::vector<std::pair<double, double>> compute_heat_distribution(const std::vector<std::int64_t>& indices, double a, double b) {
+    return compute_heat_distribution(indices.size(), a, b);
+}
@@ -0,0 +1,72 @@
+#ifndef HEAT_DISTRIBUTION_H
+#define HEAT_DISTRIBUTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Parameters of one independent rod (or one case of a parameter sweep).
+ */
+struct RodSpec {
+    std::uint64_t N;   ///< Number of grid points.
+    double T_initial;  ///< Uniform initial temperature.
+    double a;          ///< Lower bound of x.
+    double b;          ///< Upper bound of x.
+};
+
+/**
+ * @brief Reads rod specifications, one "N T_initial a b" line per rod.
+ *
+ * Blank lines and lines starting with '#' are ignored.
+ *
+ * @param filename The specification file name.
+ * @return The rods in file order.
+ */
+std::vector<RodSpec> read_rod_specs(const std::string& filename);
+
+/**
+ * @brief Generates a 1D grid with initial temperature values T(x).
+ *
+ * @param N The number of grid points.
+ * @param T_initial The initial temperature.
+ * @return A vector of pairs representing (index, T_initial) values.
+ */
+std::vector<std::pair<std::int64_t, double>> generate_initial_grid(std::int64_t N, double T_initial);
+
+/**
+ * @brief Computes a contiguous block of the 1D heat distribution T(x) = 1 - x^2.
+ *
+ * @param first The index of the first grid point in the block.
+ * @param count The number of grid points in the block.
+ * @param N The total number of grid points.
+ * @param a The lower bound of x.
+ * @param b The upper bound of x.
+ * @param out Destination for the (x, T(x)) pairs; must hold at least `count` entries.
+ */
+void compute_heat_distribution_chunk(std::uint64_t first, std::size_t count, std::uint64_t N, double a, double b,
+                                     std::pair<double, double>* out);
+
+/**
+ * @brief Computes the 1D heat distribution using the formula T(x) = 1 - x^2.
+ *
+ * @param N The number of grid points.
+ * @param a The lower bound of x.
+ * @param b The upper bound of x.
+ * @return A vector of pairs representing (x, T(x)) values for the heat distribution.
+ */
+std::vector<std::pair<double, double>> compute_heat_distribution(std::uint64_t N, double a, double b);
+
+/**
+ * @brief Computes the 1D heat distribution using the formula T(x) = 1 - x^2.
+ *
+ * @param indices A vector of grid indices.
+ * @param a The lower bound of x.
+ * @param b The upper bound of x.
+ * @return A vector of pairs representing (x, T(x)) values for the heat distribution.
+ */
+std::vector<std::pair<double, double>> compute_heat_distribution(const std::vector<std::int64_t>& indices, double a, double b);
+
+#endif // HEAT_DISTRIBUTION_H
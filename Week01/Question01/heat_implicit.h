@@ -0,0 +1,98 @@
+#ifndef HEAT_IMPLICIT_H
+#define HEAT_IMPLICIT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "heat_distribution.h"
+#include "heat_solver.h"
+#include "thread_pool.h"
+#include "tridiagonal.h"
+
+/**
+ * @brief Implicit time discretizations of the heat equation.
+ */
+enum class TimeScheme {
+    BackwardEuler,  ///< First order, theta = 1.
+    CrankNicolson   ///< Second order, theta = 1/2.
+};
+
+/**
+ * @class RodBatch
+ * @brief Up to TRIDIAGONAL_BATCH_WIDTH rods advanced together with an implicit theta scheme.
+ *
+ * Temperatures and matrix coefficients are interleaved (row-major over grid points, one lane
+ * per rod), so the right-hand side assembly and both Thomas sweeps vectorize across rods.
+ * Rods shorter than the longest rod of the batch are padded with decoupled identity rows.
+ */
+class RodBatch {
+public:
+    /**
+     * @brief Builds and factorizes the systems of the selected rods.
+     * @param rods All rod specifications.
+     * @param ids Indices into `rods` of the rods in this batch (at most TRIDIAGONAL_BATCH_WIDTH).
+     * @param alpha The thermal diffusivity.
+     * @param dt The time step.
+     * @param scheme The time discretization.
+     * @param bc_spec Boundary condition specification (see parse_boundary_condition); periodic is not supported.
+     */
+    RodBatch(const std::vector<RodSpec>& rods, const std::vector<std::size_t>& ids, double alpha, double dt,
+             TimeScheme scheme, const std::string& bc_spec);
+
+    /**
+     * @brief Advances every rod of the batch by one time step.
+     */
+    void step();
+
+    /**
+     * @brief Number of rods in the batch.
+     */
+    std::size_t lanes() const { return ids_.size(); }
+
+    /**
+     * @brief Index of the rod held in a lane.
+     */
+    std::size_t rod_id(std::size_t lane) const { return ids_[lane]; }
+
+    /**
+     * @brief Temperature of grid point i of the rod held in a lane.
+     */
+    double temperature(std::size_t lane, std::size_t i) const {
+        return u_[(i + 1) * TRIDIAGONAL_BATCH_WIDTH + lane];
+    }
+
+private:
+    std::vector<std::size_t> ids_;     ///< Rod index of every lane.
+    std::size_t rows_;                 ///< Rows per system (the longest rod of the batch).
+    std::vector<double> u_;            ///< Current temperatures with one zero ghost row at each end.
+    std::vector<double> u_next_;       ///< Next temperatures, same layout as u_.
+    std::vector<double> lower_;        ///< Implicit sub-diagonal.
+    std::vector<double> upper_prime_;  ///< Factorized super-diagonal.
+    std::vector<double> inv_pivot_;    ///< Factorized reciprocal pivots.
+    std::vector<double> ex_lower_;     ///< Explicit weight of u[i-1] in the right-hand side.
+    std::vector<double> ex_diag_;      ///< Explicit weight of u[i] in the right-hand side.
+    std::vector<double> ex_upper_;     ///< Explicit weight of u[i+1] in the right-hand side.
+    std::vector<double> ex_const_;     ///< Constant part of the right-hand side (boundary data).
+};
+
+/**
+ * @brief Advances many independent rods with an implicit scheme, spreading batches over the pool.
+ *
+ * Rods are sorted by length before batching so that padding stays small.
+ *
+ * @param rods The rod specifications.
+ * @param alpha The thermal diffusivity.
+ * @param dt The time step.
+ * @param steps The number of time steps.
+ * @param scheme The time discretization.
+ * @param bc_spec Boundary condition specification applied to every rod.
+ * @param pool Threads that process the batches.
+ * @return The final temperatures of every rod, in input order.
+ */
+std::vector<std::vector<double>> solve_rods_implicit(const std::vector<RodSpec>& rods, double alpha, double dt,
+                                                     std::uint64_t steps, TimeScheme scheme,
+                                                     const std::string& bc_spec, ThreadPool& pool);
+
+#endif // HEAT_IMPLICIT_H
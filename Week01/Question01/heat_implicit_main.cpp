@@ -0,0 +1,117 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "heat_implicit.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Writes the final profile of every rod as (rod, x, T) rows.
+ *
+ * @param filename The output CSV file name.
+ * @param rods The rod specifications.
+ * @param profiles The final temperatures of every rod.
+ */
+void write_rod_profiles(const std::string& filename, const std::vector<RodSpec>& rods,
+                        const std::vector<std::vector<double>>& profiles) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::ios_base::failure("Error: Could not open file for writing.");
+    }
+
+    file << "rod,x,T\n";
+    char line[128];
+    for (std::size_t rod = 0; rod < rods.size(); ++rod) {
+        double step = (rods[rod].b - rods[rod].a) / (rods[rod].N - 1);
+        for (std::size_t i = 0; i < profiles[rod].size(); ++i) {
+            int len = std::snprintf(line, sizeof(line), "%zu,%.6f,%.6f\n", rod, rods[rod].a + i * step,
+                                    profiles[rod][i]);
+            file.write(line, len);
+        }
+    }
+
+    file.close();
+    if (!file) {
+        throw std::ios_base::failure("Error: Failed while writing rod profiles.");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    std::string bc_spec = "dirichlet:0:0";
+    std::string scheme_name = "cn";
+    unsigned threads = 0;  // 0 selects the hardware concurrency
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--bc=", 0) == 0) {
+                bc_spec = arg.substr(5);
+            } else if (arg.rfind("--scheme=", 0) == 0) {
+                scheme_name = arg.substr(9);
+            } else if (arg.rfind("--threads=", 0) == 0) {
+                threads = static_cast<unsigned>(std::stoul(arg.substr(10)));
+            } else {
+                args.push_back(arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (args.size() != 5 || (scheme_name != "be" && scheme_name != "cn")) {
+        std::cerr << "Usage: " << argv[0] << " <rod_file> <alpha> <t_end> <steps> <output_file>"
+                  << " [--scheme=be|cn] [--bc=<spec>] [--threads=<n>]\n";
+        std::cerr << "       <rod_file> lists one rod per line as \"N T_initial a b\".\n";
+        std::cerr << "       --bc accepts dirichlet[:TL:TR] or neumann[:gL:gR] (default: dirichlet:0:0).\n";
+        return 1;
+    }
+
+    try {
+        std::string rod_file = args[0];
+        double alpha = std::stod(args[1]);
+        double t_end = std::stod(args[2]);
+        std::uint64_t steps = std::stoull(args[3]);
+        std::string output_file = args[4];
+        if (!(alpha > 0.0) || !(t_end > 0.0) || steps == 0) {
+            throw std::invalid_argument("alpha, t_end and steps must be positive.");
+        }
+        double dt = t_end / steps;
+        TimeScheme scheme = (scheme_name == "be") ? TimeScheme::BackwardEuler : TimeScheme::CrankNicolson;
+
+        std::vector<RodSpec> rods = read_rod_specs(rod_file);
+        if (rods.empty()) {
+            throw std::invalid_argument("No rods in " + rod_file + ".");
+        }
+        std::uint64_t points = 0;
+        for (const RodSpec& rod : rods) {
+            points += rod.N;
+        }
+
+        ThreadPool pool(threads);
+        std::cout << "Solving " << rods.size() << " rods (" << points << " points) with "
+                  << (scheme == TimeScheme::BackwardEuler ? "backward Euler" : "Crank-Nicolson")
+                  << ", dt = " << dt << ", threads = " << pool.size() << "\n";
+
+        auto start = std::chrono::steady_clock::now();
+        auto profiles = solve_rods_implicit(rods, alpha, dt, steps, scheme, bc_spec, pool);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "Solve time: " << seconds << " s\n";
+        std::cout << "Cell updates per second: " << static_cast<double>(points) * steps / seconds << "\n";
+
+        write_rod_profiles(output_file, rods, profiles);
+        std::cout << "Final profiles written to " << output_file << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,217 @@
+#include "heat_nd.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// The row kernels are kept out of line so that the naive and the tiled sweeps execute the
+// exact same instructions and therefore produce bit-identical results.
+
+// 5-point update of row y from rows y-1 (south), y (center) and y+1 (north), columns [lo, hi)
+__attribute__((noinline)) void stencil_row_2d(const double* s, const double* c, const double* n, double* out,
+                                              std::size_t lo, std::size_t hi, double r) {
+    for (std::size_t x = lo; x < hi; ++x) {
+        out[x] = c[x] + r * (((c[x - 1] + c[x + 1]) + (s[x] + n[x])) - 4.0 * c[x]);
+    }
+}
+
+// 7-point update of a row from its four in-plane neighbour rows, the rows below/above and the center row
+__attribute__((noinline)) void stencil_row_3d(const double* s, const double* n, const double* d, const double* u,
+                                              const double* c, double* out, std::size_t lo, std::size_t hi,
+                                              double r) {
+    for (std::size_t x = lo; x < hi; ++x) {
+        out[x] = c[x] + r * ((((c[x - 1] + c[x + 1]) + (s[x] + n[x])) + (d[x] + u[x])) - 6.0 * c[x]);
+    }
+}
+
+// Copies the fixed boundary cells of src into dst
+void copy_boundary(const HeatField& f, const double* src, double* dst) {
+    const std::size_t nx = f.nx, ny = f.ny, nz = f.nz;
+    for (std::size_t z = 0; z < nz; ++z) {
+        bool boundary_plane = (f.dims == 3) && (z == 0 || z == nz - 1);
+        for (std::size_t y = 0; y < ny; ++y) {
+            std::size_t row = (z * ny + y) * nx;
+            if (boundary_plane || y == 0 || y == ny - 1) {
+                std::memcpy(dst + row, src + row, nx * sizeof(double));
+            } else {
+                dst[row] = src[row];
+                dst[row + nx - 1] = src[row + nx - 1];
+            }
+        }
+    }
+}
+
+// Advances tile [x0, x1) of a 2D field by T steps from src into dst
+void tile_2d(const HeatField& f, const double* src, double* dst, double r, std::size_t T, std::size_t x0,
+             std::size_t x1, std::vector<double>& scratch) {
+    const std::size_t nx = f.nx, ny = f.ny;
+    const std::size_t X0 = x0 >= T ? x0 - T : 0;
+    const std::size_t X1 = std::min(x1 + T, nx);
+    const std::size_t Wx = X1 - X0;
+    scratch.resize(std::max<std::size_t>(1, (T - 1) * 3 * Wx));
+
+    // Row y of level s, indexable by global x; level 0 and the boundary rows come from src
+    auto row = [&](std::size_t s, std::size_t y) -> double* {
+        if (s == 0 || y == 0 || y == ny - 1) {
+            return const_cast<double*>(src) + y * nx;
+        }
+        return scratch.data() + ((s - 1) * 3 + y % 3) * Wx - X0;
+    };
+
+    for (std::size_t w = 1; w < ny - 1 + T - 1; ++w) {
+        for (std::size_t s = 1; s <= T && s <= w; ++s) {
+            std::size_t y = w - (s - 1);
+            if (y > ny - 2) {
+                continue;
+            }
+            std::size_t halo = T - s;
+            std::size_t lo = std::max<std::size_t>(x0 >= halo ? x0 - halo : 0, 1);
+            std::size_t hi = std::min(x1 + halo, nx - 1);
+            double* out = (s == T) ? dst + y * nx : row(s, y);
+            stencil_row_2d(row(s - 1, y - 1), row(s - 1, y), row(s - 1, y + 1), out, lo, hi, r);
+            if (s < T) {
+                // Boundary columns inside the window are read by the next level
+                if (X0 == 0) out[0] = src[y * nx];
+                if (X1 == nx) out[nx - 1] = src[y * nx + nx - 1];
+            }
+        }
+    }
+}
+
+// Advances tile [x0, x1) x [y0, y1) of a 3D field by T steps from src into dst
+void tile_3d(const HeatField& f, const double* src, double* dst, double r, std::size_t T, std::size_t x0,
+             std::size_t x1, std::size_t y0, std::size_t y1, std::vector<double>& scratch) {
+    const std::size_t nx = f.nx, ny = f.ny, nz = f.nz;
+    const std::size_t X0 = x0 >= T ? x0 - T : 0;
+    const std::size_t X1 = std::min(x1 + T, nx);
+    const std::size_t Y0 = y0 >= T ? y0 - T : 0;
+    const std::size_t Y1 = std::min(y1 + T, ny);
+    const std::size_t Wx = X1 - X0;
+    const std::size_t Wy = Y1 - Y0;
+    scratch.resize(std::max<std::size_t>(1, (T - 1) * 3 * Wx * Wy));
+
+    // Row (z, y) of level s, indexable by global x; level 0 and the boundary planes come from src
+    auto row = [&](std::size_t s, std::size_t z, std::size_t y) -> double* {
+        if (s == 0 || z == 0 || z == nz - 1) {
+            return const_cast<double*>(src) + (z * ny + y) * nx;
+        }
+        return scratch.data() + (((s - 1) * 3 + z % 3) * Wy + (y - Y0)) * Wx - X0;
+    };
+
+    for (std::size_t w = 1; w < nz - 1 + T - 1; ++w) {
+        for (std::size_t s = 1; s <= T && s <= w; ++s) {
+            std::size_t z = w - (s - 1);
+            if (z > nz - 2) {
+                continue;
+            }
+            std::size_t halo = T - s;
+            std::size_t xlo = std::max<std::size_t>(x0 >= halo ? x0 - halo : 0, 1);
+            std::size_t xhi = std::min(x1 + halo, nx - 1);
+            std::size_t ylo = std::max<std::size_t>(y0 >= halo ? y0 - halo : 0, 1);
+            std::size_t yhi = std::min(y1 + halo, ny - 1);
+            for (std::size_t y = ylo; y < yhi; ++y) {
+                double* out = (s == T) ? dst + (z * ny + y) * nx : row(s, z, y);
+                stencil_row_3d(row(s - 1, z, y - 1), row(s - 1, z, y + 1), row(s - 1, z - 1, y),
+                               row(s - 1, z + 1, y), row(s - 1, z, y), out, xlo, xhi, r);
+            }
+            if (s < T) {
+                // Boundary cells inside the window are read by the next level
+                for (std::size_t y = Y0; y < Y1; ++y) {
+                    const double* in = src + (z * ny + y) * nx;
+                    double* out = row(s, z, y);
+                    if (y == 0 || y == ny - 1) {
+                        std::memcpy(out + X0, in + X0, Wx * sizeof(double));
+                    } else {
+                        if (X0 == 0) out[0] = in[0];
+                        if (X1 == nx) out[nx - 1] = in[nx - 1];
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+HeatField::HeatField(std::size_t dims_, std::size_t n, double T_initial, double T_boundary)
+    : dims(dims_), nx(n), ny(n), nz(dims_ == 3 ? n : 1) {
+    if (dims != 2 && dims != 3) {
+        throw std::invalid_argument("HeatField supports 2 or 3 dimensions.");
+    }
+    if (n < 3) {
+        throw std::invalid_argument("HeatField needs at least 3 points per direction.");
+    }
+    data.assign(nx * ny * nz, T_boundary);
+    for (std::size_t z = (dims == 3 ? 1 : 0); z < (dims == 3 ? nz - 1 : 1); ++z) {
+        for (std::size_t y = 1; y < ny - 1; ++y) {
+            std::fill_n(data.begin() + (z * ny + y) * nx + 1, nx - 2, T_initial);
+        }
+    }
+}
+
+void evolve_naive(HeatField& field, double r, std::uint64_t steps, ThreadPool& pool) {
+    const std::size_t nx = field.nx, ny = field.ny, nz = field.nz;
+    std::vector<double> next(field.size());
+    copy_boundary(field, field.data.data(), next.data());
+
+    for (std::uint64_t step = 0; step < steps; ++step) {
+        const double* src = field.data.data();
+        double* dst = next.data();
+        if (field.dims == 2) {
+            pool.parallel_for(1, ny - 1, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t y = begin; y < end; ++y) {
+                    stencil_row_2d(src + (y - 1) * nx, src + y * nx, src + (y + 1) * nx, dst + y * nx, 1, nx - 1, r);
+                }
+            });
+        } else {
+            pool.parallel_for(1, nz - 1, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t z = begin; z < end; ++z) {
+                    for (std::size_t y = 1; y < ny - 1; ++y) {
+                        const double* c = src + (z * ny + y) * nx;
+                        stencil_row_3d(c - nx, c + nx, c - nx * ny, c + nx * ny, c, dst + (z * ny + y) * nx, 1,
+                                       nx - 1, r);
+                    }
+                }
+            });
+        }
+        field.data.swap(next);
+    }
+}
+
+void evolve_tiled(HeatField& field, double r, std::uint64_t steps, const TilingOptions& options, ThreadPool& pool) {
+    if (options.block_x == 0 || options.block_y == 0 || options.time_steps == 0) {
+        throw std::invalid_argument("Tile sizes and fused time steps must be positive.");
+    }
+    const std::size_t nx = field.nx, ny = field.ny;
+    const std::size_t bx = options.block_x;
+    const std::size_t by = (field.dims == 3) ? options.block_y : ny;
+    const std::size_t tiles_x = (nx - 2 + bx - 1) / bx;
+    const std::size_t tiles_y = (field.dims == 3) ? (ny - 2 + by - 1) / by : 1;
+
+    std::vector<double> next(field.size());
+    copy_boundary(field, field.data.data(), next.data());
+
+    for (std::uint64_t done = 0; done < steps;) {
+        const std::size_t T = static_cast<std::size_t>(std::min<std::uint64_t>(options.time_steps, steps - done));
+        const double* src = field.data.data();
+        double* dst = next.data();
+
+        pool.run(tiles_x * tiles_y, [&](std::size_t tile) {
+            thread_local std::vector<double> scratch;
+            std::size_t x0 = 1 + (tile % tiles_x) * bx;
+            std::size_t x1 = std::min(x0 + bx, nx - 1);
+            if (field.dims == 2) {
+                tile_2d(field, src, dst, r, T, x0, x1, scratch);
+            } else {
+                std::size_t y0 = 1 + (tile / tiles_x) * by;
+                std::size_t y1 = std::min(y0 + by, ny - 1);
+                tile_3d(field, src, dst, r, T, x0, x1, y0, y1, scratch);
+            }
+        });
+
+        field.data.swap(next);
+        done += T;
+    }
+}
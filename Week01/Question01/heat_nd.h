@@ -0,0 +1,72 @@
+#ifndef HEAT_ND_H
+#define HEAT_ND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "thread_pool.h"
+
+/**
+ * @brief A 2D or 3D temperature field on a uniform grid with fixed (Dirichlet) boundary cells.
+ *
+ * Values are stored with x fastest, then y, then z. A 2D field has nz = 1.
+ */
+struct HeatField {
+    std::size_t dims;          ///< 2 or 3.
+    std::size_t nx, ny, nz;    ///< Grid points per direction.
+    std::vector<double> data;  ///< Temperatures, index (z * ny + y) * nx + x.
+
+    /**
+     * @brief Creates a field with the given interior and boundary temperatures.
+     * @param dims_ Number of dimensions (2 or 3).
+     * @param n Grid points per direction (at least 3).
+     * @param T_initial Temperature of the interior cells.
+     * @param T_boundary Temperature of the boundary cells.
+     */
+    HeatField(std::size_t dims_, std::size_t n, double T_initial, double T_boundary);
+
+    /**
+     * @brief Total number of grid points.
+     */
+    std::size_t size() const { return data.size(); }
+};
+
+/**
+ * @brief Parameters of the cache-blocked, temporally tiled sweep.
+ */
+struct TilingOptions {
+    std::size_t block_x = 512;    ///< Interior columns per spatial tile.
+    std::size_t block_y = 16;     ///< Interior rows per spatial tile (3D only).
+    std::size_t time_steps = 4;   ///< Time steps fused per pass over the field.
+};
+
+/**
+ * @brief Reference sweep: one full pass over the field per time step (5-point in 2D, 7-point in 3D).
+ *
+ * @param field The field to evolve in place.
+ * @param r The mesh ratio alpha * dt / dx^2 (stable for r <= 1 / (2 dims)).
+ * @param steps The number of time steps.
+ * @param pool Threads that split the planes (3D) or rows (2D).
+ */
+void evolve_naive(HeatField& field, double r, std::uint64_t steps, ThreadPool& pool);
+
+/**
+ * @brief Cache-blocked sweep with wavefront temporal tiling.
+ *
+ * The interior is split into spatial tiles (columns in 2D, column-by-row boxes in 3D). Each tile,
+ * widened by a halo of `time_steps` cells, is swept as a wavefront along the slowest dimension:
+ * level s of row (or plane) k is computed as soon as level s - 1 of k + 1 is available, and the
+ * intermediate levels live in small rolling buffers of three rows (or planes) that stay in cache.
+ * The halo is recomputed by neighbouring tiles, which makes the tiles independent so they are
+ * processed in parallel. The result is bit-for-bit identical to evolve_naive.
+ *
+ * @param field The field to evolve in place.
+ * @param r The mesh ratio alpha * dt / dx^2.
+ * @param steps The number of time steps.
+ * @param options Tile sizes and number of fused time steps.
+ * @param pool Threads that process the tiles.
+ */
+void evolve_tiled(HeatField& field, double r, std::uint64_t steps, const TilingOptions& options, ThreadPool& pool);
+
+#endif // HEAT_ND_H
@@ -0,0 +1,120 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "grid_io.h"
+#include "heat_nd.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Parses a tile size of the form "bx" or "bxxby".
+ *
+ * @param spec The specification string.
+ * @param options Receives block_x and, if given, block_y.
+ */
+void parse_tile(const std::string& spec, TilingOptions& options) {
+    std::size_t sep = spec.find('x');
+    options.block_x = std::stoul(spec.substr(0, sep));
+    if (sep != std::string::npos) {
+        options.block_y = std::stoul(spec.substr(sep + 1));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    TilingOptions tiling;
+    double alpha = 1.0;
+    double T_boundary = 0.0;
+    unsigned threads = 0;  // 0 selects the hardware concurrency
+    std::string output_file;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--tile=", 0) == 0) {
+                parse_tile(arg.substr(7), tiling);
+            } else if (arg.rfind("--time-tile=", 0) == 0) {
+                tiling.time_steps = std::stoul(arg.substr(12));
+            } else if (arg.rfind("--alpha=", 0) == 0) {
+                alpha = std::stod(arg.substr(8));
+            } else if (arg.rfind("--boundary=", 0) == 0) {
+                T_boundary = std::stod(arg.substr(11));
+            } else if (arg.rfind("--threads=", 0) == 0) {
+                threads = static_cast<unsigned>(std::stoul(arg.substr(10)));
+            } else if (arg.rfind("--output=", 0) == 0) {
+                output_file = arg.substr(9);
+            } else {
+                args.push_back(arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (args.size() != 4) {
+        std::cerr << "Usage: " << argv[0] << " <dims> <n> <T_initial> <steps>"
+                  << " [--tile=<bx>[x<by>]] [--time-tile=<T>] [--alpha=<a>] [--boundary=<T_b>]"
+                  << " [--threads=<n>] [--output=<file>]\n";
+        std::cerr << "       Evolves an n^dims field on the unit square/cube with the naive and the tiled sweep\n";
+        std::cerr << "       and reports their speedup and effective memory bandwidth.\n";
+        return 1;
+    }
+
+    try {
+        std::size_t dims = std::stoul(args[0]);
+        std::size_t n = std::stoul(args[1]);
+        double T_initial = std::stod(args[2]);
+        std::uint64_t steps = std::stoull(args[3]);
+
+        HeatField initial(dims, n, T_initial, T_boundary);
+        double dx = 1.0 / (n - 1);
+        double r = 0.9 / (2.0 * dims);  // 90% of the stability limit
+        double dt = r * dx * dx / alpha;
+
+        ThreadPool pool(threads);
+        std::cout << "Evolving a " << n << "^" << dims << " field for " << steps << " steps (dt = " << dt
+                  << ", threads = " << pool.size() << ")\n";
+        std::cout << "Tiles: " << tiling.block_x;
+        if (dims == 3) std::cout << " x " << tiling.block_y;
+        std::cout << " cells, " << tiling.time_steps << " fused time steps\n";
+
+        HeatField naive = initial;
+        auto start = std::chrono::steady_clock::now();
+        evolve_naive(naive, r, steps, pool);
+        double naive_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        HeatField tiled = initial;
+        start = std::chrono::steady_clock::now();
+        evolve_tiled(tiled, r, steps, tiling, pool);
+        double tiled_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (naive.data != tiled.data) {
+            throw std::runtime_error("The tiled sweep does not match the naive sweep.");
+        }
+
+        // One read and one write of every cell per step is the traffic of a sweep without reuse
+        double updates = static_cast<double>(initial.size()) * steps;
+        double bytes = 2.0 * sizeof(double) * updates;
+        std::cout << "Naive: " << naive_seconds << " s, " << updates / naive_seconds / 1e6 << " MLUP/s, "
+                  << bytes / naive_seconds / 1e9 << " GB/s effective\n";
+        std::cout << "Tiled: " << tiled_seconds << " s, " << updates / tiled_seconds / 1e6 << " MLUP/s, "
+                  << bytes / tiled_seconds / 1e9 << " GB/s effective\n";
+        std::cout << "Speedup: " << naive_seconds / tiled_seconds << "x (results identical)\n";
+
+        if (!output_file.empty()) {
+            GridFileWriter writer(output_file, tiled.size(), 0.0, 1.0);
+            writer.append(tiled.data.data(), tiled.size());
+            writer.close();
+            std::cout << "Final field written to " << output_file << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include "heat_solver.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "compressed_io.h"
+#include "grid_io.h"
+
+namespace {
+
+// Below this many points per thread the interior update runs on the calling thread only
+constexpr std::size_t MIN_POINTS_PER_THREAD = 1 << 15;
+
+// Splits "a:b:c" into its fields
+std::vector<std::string> split_fields(const std::string& spec) {
+    std::vector<std::string> fields;
+    std::stringstream ss(spec);
+    std::string field;
+    while (std::getline(ss, field, ':')) {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+} // namespace
+
+BoundaryCondition parse_boundary_condition(const std::string& spec, const double* u, std::uint64_t N) {
+    std::vector<std::string> fields = split_fields(spec);
+    if (fields.empty()) {
+        throw std::invalid_argument("Empty boundary condition.");
+    }
+
+    BoundaryCondition bc;
+    if (fields[0] == "periodic" && fields.size() == 1) {
+        bc.type = BoundaryType::Periodic;
+    } else if (fields[0] == "dirichlet" && (fields.size() == 1 || fields.size() == 3)) {
+        bc.type = BoundaryType::Dirichlet;
+        bc.left = fields.size() == 3 ? std::stod(fields[1]) : u[0];
+        bc.right = fields.size() == 3 ? std::stod(fields[2]) : u[N - 1];
+    } else if (fields[0] == "neumann" && (fields.size() == 1 || fields.size() == 3)) {
+        bc.type = BoundaryType::Neumann;
+        bc.left = fields.size() == 3 ? std::stod(fields[1]) : 0.0;
+        bc.right = fields.size() == 3 ? std::stod(fields[2]) : 0.0;
+    } else {
+        throw std::invalid_argument("Invalid boundary condition: " + spec);
+    }
+    return bc;
+}
+
+void ftcs_stencil(const double* __restrict u, double* __restrict out, std::size_t begin, std::size_t end, double r) {
+    std::size_t i = begin;
+    // The vector paths evaluate (u[i-1] - 2 u[i]) + u[i+1] in the same order as the scalar tail
+#if defined(__AVX__)
+    const __m256d vr = _mm256_set1_pd(r);
+    const __m256d vtwo = _mm256_set1_pd(2.0);
+    for (; i + 4 <= end; i += 4) {
+        __m256d left = _mm256_loadu_pd(u + i - 1);
+        __m256d center = _mm256_loadu_pd(u + i);
+        __m256d right = _mm256_loadu_pd(u + i + 1);
+        __m256d lap = _mm256_add_pd(_mm256_sub_pd(left, _mm256_mul_pd(vtwo, center)), right);
+        _mm256_storeu_pd(out + i, _mm256_add_pd(center, _mm256_mul_pd(vr, lap)));
+    }
+#elif defined(__SSE2__)
+    const __m128d vr = _mm_set1_pd(r);
+    const __m128d vtwo = _mm_set1_pd(2.0);
+    for (; i + 2 <= end; i += 2) {
+        __m128d left = _mm_loadu_pd(u + i - 1);
+        __m128d center = _mm_loadu_pd(u + i);
+        __m128d right = _mm_loadu_pd(u + i + 1);
+        __m128d lap = _mm_add_pd(_mm_sub_pd(left, _mm_mul_pd(vtwo, center)), right);
+        _mm_storeu_pd(out + i, _mm_add_pd(center, _mm_mul_pd(vr, lap)));
+    }
+#endif
+    for (; i < end; ++i) {
+        out[i] = u[i] + r * (u[i - 1] - 2.0 * u[i] + u[i + 1]);
+    }
+}
+
+ExplicitHeatSolver::ExplicitHeatSolver(const double* initial, std::uint64_t N, double a, double b, double alpha,
+                                       double dt, const BoundaryCondition& bc, ThreadPool& pool,
+                                       std::uint64_t first_step, double start_time)
+    : u_(initial, initial + N), u_next_(N), dx_((b - a) / (N - 1)), alpha_(alpha), dt_(dt), r_(0.0), bc_(bc),
+      pool_(pool), steps_(first_step), first_step_(first_step), start_time_(start_time) {
+    if (N < 3) {
+        throw std::invalid_argument("The heat solver needs at least 3 grid points.");
+    }
+    if (!(b > a) || !(alpha > 0.0) || !(dt > 0.0)) {
+        throw std::invalid_argument("The heat solver needs a < b, alpha > 0 and dt > 0.");
+    }
+    r_ = alpha * dt_ / (dx_ * dx_);
+    if (r_ > 0.5) {
+        throw std::invalid_argument("Unstable time step: alpha * dt / dx^2 = " + std::to_string(r_) +
+                                    " exceeds 1/2.");
+    }
+    if (bc_.type == BoundaryType::Dirichlet) {
+        u_.front() = bc_.left;
+        u_.back() = bc_.right;
+    } else if (bc_.type == BoundaryType::Periodic) {
+        u_.back() = u_.front();
+    }
+}
+
+void ExplicitHeatSolver::step() {
+    const std::size_t N = u_.size();
+    const double* u = u_.data();
+    double* out = u_next_.data();
+    const double r = r_;
+
+    // Interior points, split into one contiguous block per thread
+    if (pool_.size() > 1 && N >= MIN_POINTS_PER_THREAD * pool_.size()) {
+        pool_.parallel_for(1, N - 1, [=](std::size_t begin, std::size_t end) {
+            ftcs_stencil(u, out, begin, end, r);
+        });
+    } else {
+        ftcs_stencil(u, out, 1, N - 1, r);
+    }
+
+    apply_boundaries();
+    u_.swap(u_next_);
+    ++steps_;
+}
+
+GridCheckpointInfo ExplicitHeatSolver::checkpoint_info() const {
+    GridCheckpointInfo info{};
+    info.step = steps_;
+    info.time = time();
+    info.alpha = alpha_;
+    info.dt = dt_;
+    info.bc_type = static_cast<std::uint32_t>(bc_.type);
+    info.bc_left = bc_.left;
+    info.bc_right = bc_.right;
+    return info;
+}
+
+void ExplicitHeatSolver::apply_boundaries() {
+    const std::size_t N = u_.size();
+    const double* u = u_.data();
+    double* out = u_next_.data();
+
+    switch (bc_.type) {
+    case BoundaryType::Dirichlet:
+        out[0] = bc_.left;
+        out[N - 1] = bc_.right;
+        break;
+    case BoundaryType::Neumann: {
+        // Ghost points mirror the neighbours so that the centered gradient matches the prescribed one
+        double ghost_left = u[1] - 2.0 * dx_ * bc_.left;
+        double ghost_right = u[N - 2] + 2.0 * dx_ * bc_.right;
+        out[0] = u[0] + r_ * (ghost_left - 2.0 * u[0] + u[1]);
+        out[N - 1] = u[N - 1] + r_ * (u[N - 2] - 2.0 * u[N - 1] + ghost_right);
+        break;
+    }
+    case BoundaryType::Periodic:
+        // x = a and x = b are the same point, so u[N - 1] is a copy of u[0] and the period is b - a
+        out[0] = u[0] + r_ * (u[N - 2] - 2.0 * u[0] + u[1]);
+        out[N - 1] = out[0];
+        break;
+    }
+}
+
+void write_snapshot(const std::string& filename, const double* u, std::uint64_t N, double a, double b,
+                    ThreadPool& pool, const GridCheckpointInfo* checkpoint) {
+    if (is_compressed_file(filename)) {
+        write_compressed_rows(filename, {"T"}, u, N, a, b, pool);
+        return;
+    }
+    if (!is_csv_file(filename)) {
+        GridFileWriter writer(filename, N, a, b, checkpoint);
+        writer.append(u, N);
+        writer.close();
+        return;
+    }
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::ios_base::failure("Error: Could not open file for writing.");
+    }
+
+    file << "x,T\n";
+    double step = (b - a) / (N - 1);
+    char line[96];
+    for (std::uint64_t i = 0; i < N; ++i) {
+        int len = std::snprintf(line, sizeof(line), "%.6f,%.6f\n", a + i * step, u[i]);
+        file.write(line, len);
+    }
+
+    file.close();
+    if (!file) {
+        throw std::ios_base::failure("Error: Failed while writing snapshot file.");
+    }
+}
+
+BoundaryCondition boundary_from_checkpoint(const GridCheckpointInfo& checkpoint) {
+    if (checkpoint.bc_type > static_cast<std::uint32_t>(BoundaryType::Periodic)) {
+        throw std::runtime_error("Error: unknown boundary condition in checkpoint.");
+    }
+    BoundaryCondition bc;
+    bc.type = static_cast<BoundaryType>(checkpoint.bc_type);
+    bc.left = checkpoint.bc_left;
+    bc.right = checkpoint.bc_right;
+    return bc;
+}
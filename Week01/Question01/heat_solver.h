@@ -0,0 +1,149 @@
+#ifndef HEAT_SOLVER_H
+#define HEAT_SOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "grid_io.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Kinds of boundary conditions supported by the 1D heat solvers.
+ */
+enum class BoundaryType {
+    Dirichlet,  ///< Fixed temperatures T(a) = left, T(b) = right.
+    Neumann,    ///< Fixed gradients dT/dx(a) = left, dT/dx(b) = right.
+    Periodic    ///< The rod wraps around with period b - a: T(b) is a copy of T(a); left and right are unused.
+};
+
+/**
+ * @brief Boundary condition at both ends of the rod.
+ */
+struct BoundaryCondition {
+    BoundaryType type = BoundaryType::Dirichlet;  ///< Kind of boundary condition.
+    double left = 0.0;                            ///< Value at x = a.
+    double right = 0.0;                           ///< Value at x = b.
+};
+
+/**
+ * @brief Parses a boundary condition of the form "dirichlet[:TL:TR]", "neumann[:gL:gR]" or "periodic".
+ *
+ * A Dirichlet condition without values keeps the end temperatures of the initial grid;
+ * a Neumann condition without values is insulated (zero gradient).
+ *
+ * @param spec The specification string.
+ * @param u The initial temperatures, used for the default Dirichlet values.
+ * @param N The number of grid points.
+ * @return The parsed boundary condition.
+ */
+BoundaryCondition parse_boundary_condition(const std::string& spec, const double* u, std::uint64_t N);
+
+/**
+ * @brief Applies the 3-point FTCS update out[i] = u[i] + r * (u[i-1] - 2 u[i] + u[i+1]) for i in [begin, end).
+ *
+ * The loop is vectorized with AVX or SSE2 intrinsics when available. The caller must guarantee
+ * that u[begin - 1] and u[end] are valid.
+ *
+ * @param u Temperatures at the current time level.
+ * @param out Temperatures at the next time level.
+ * @param begin First interior index to update.
+ * @param end One past the last interior index to update.
+ * @param r The mesh ratio alpha * dt / dx^2.
+ */
+void ftcs_stencil(const double* u, double* out, std::size_t begin, std::size_t end, double r);
+
+/**
+ * @class ExplicitHeatSolver
+ * @brief Forward-time, centered-space solver for u_t = alpha * u_xx on a uniform 1D grid.
+ */
+class ExplicitHeatSolver {
+public:
+    /**
+     * @brief Sets up the solver from an initial grid.
+     * @param initial The initial temperatures (copied into the solver).
+     * @param N The number of grid points (at least 3).
+     * @param a The lower bound of x.
+     * @param b The upper bound of x.
+     * @param alpha The thermal diffusivity.
+     * @param dt The time step; must satisfy alpha * dt / dx^2 <= 1/2.
+     * @param bc The boundary condition.
+     * @param pool The thread pool used to split the rod.
+     * @param first_step Steps already taken when `initial` was saved (non-zero when resuming a checkpoint).
+     * @param start_time Simulated time when `initial` was saved; the steps before it may have used another dt.
+     */
+    ExplicitHeatSolver(const double* initial, std::uint64_t N, double a, double b, double alpha, double dt,
+                       const BoundaryCondition& bc, ThreadPool& pool, std::uint64_t first_step = 0,
+                       double start_time = 0.0);
+
+    /**
+     * @brief Advances the solution by one time step.
+     */
+    void step();
+
+    /**
+     * @brief The temperatures at the current time level.
+     */
+    const std::vector<double>& field() const { return u_; }
+
+    /**
+     * @brief Number of steps taken so far.
+     */
+    std::uint64_t steps_taken() const { return steps_; }
+
+    /**
+     * @brief Simulated time reached so far.
+     */
+    double time() const { return start_time_ + (steps_ - first_step_) * dt_; }
+
+    /**
+     * @brief The mesh ratio alpha * dt / dx^2.
+     */
+    double mesh_ratio() const { return r_; }
+
+    /**
+     * @brief Solver state to store with a snapshot so that the run can be resumed from it.
+     */
+    GridCheckpointInfo checkpoint_info() const;
+
+private:
+    void apply_boundaries();  ///< Updates the two end points of u_next_.
+
+    std::vector<double> u_;       ///< Current time level.
+    std::vector<double> u_next_;  ///< Next time level.
+    double dx_;                   ///< Grid spacing.
+    double alpha_;                ///< Thermal diffusivity.
+    double dt_;                   ///< Time step.
+    double r_;                    ///< Mesh ratio alpha * dt / dx^2.
+    BoundaryCondition bc_;        ///< Boundary condition.
+    ThreadPool& pool_;            ///< Threads used for the interior update.
+    std::uint64_t steps_;         ///< Steps taken so far.
+    std::uint64_t first_step_;    ///< Steps taken before this solver started.
+    double start_time_;           ///< Simulated time at first_step_.
+};
+
+/**
+ * @brief Writes a snapshot of the temperatures as a binary grid file, as (x, T) rows for ".csv" names,
+ *        or as a compressed field with a single "T" column for ".fpc" names.
+ *
+ * @param filename The output file name.
+ * @param u The temperatures.
+ * @param N The number of grid points.
+ * @param a The lower bound of x.
+ * @param b The upper bound of x.
+ * @param pool Threads that compress ".fpc" snapshots.
+ * @param checkpoint Optional solver state stored with binary grid snapshots, which makes them restart points.
+ */
+void write_snapshot(const std::string& filename, const double* u, std::uint64_t N, double a, double b,
+                    ThreadPool& pool, const GridCheckpointInfo* checkpoint = nullptr);
+
+/**
+ * @brief Recovers the boundary condition stored in a checkpoint.
+ *
+ * @param checkpoint The checkpoint block of a grid file.
+ * @return The boundary condition of the run that wrote it.
+ */
+BoundaryCondition boundary_from_checkpoint(const GridCheckpointInfo& checkpoint);
+
+#endif // HEAT_SOLVER_H
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "grid_io.h"
+#include "heat_solver.h"
+#include "snapshot_writer.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Builds the file name of the snapshot taken after `step` steps.
+ *
+ * @param prefix The snapshot file prefix.
+ * @param step The step number.
+ * @param extension The file extension, which selects the snapshot format.
+ * @return The snapshot file name, e.g. "prefix_00000100.grid".
+ */
+std::string snapshot_name(const std::string& prefix, std::uint64_t step, const std::string& extension) {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "_%08llu", static_cast<unsigned long long>(step));
+    return prefix + suffix + extension;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    std::string bc_spec = "dirichlet";
+    double dt = 0.0;            // 0 selects a stable default
+    std::uint64_t every = 0;    // 0 writes only the initial and final snapshots
+    std::uint64_t checkpoint_every = 0;  // 0 writes a checkpoint only at the end
+    std::size_t buffers = 3;    // 0 writes snapshots synchronously on the compute thread
+    bool bc_given = false;
+    unsigned threads = 0;       // 0 selects the hardware concurrency
+    std::string extension = ".grid";
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--dt=", 0) == 0) {
+                dt = std::stod(arg.substr(5));
+            } else if (arg.rfind("--every=", 0) == 0) {
+                every = std::stoull(arg.substr(8));
+            } else if (arg.rfind("--bc=", 0) == 0) {
+                bc_spec = arg.substr(5);
+                bc_given = true;
+            } else if (arg.rfind("--checkpoint=", 0) == 0) {
+                checkpoint_every = std::stoull(arg.substr(13));
+            } else if (arg.rfind("--buffers=", 0) == 0) {
+                buffers = std::stoul(arg.substr(10));
+            } else if (arg.rfind("--threads=", 0) == 0) {
+                threads = static_cast<unsigned>(std::stoul(arg.substr(10)));
+            } else if (arg == "--csv") {
+                extension = ".csv";
+            } else if (arg == "--compressed") {
+                extension = ".fpc";
+            } else {
+                args.push_back(arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (args.size() != 4) {
+        std::cerr << "Usage: " << argv[0] << " <input_grid> <alpha> <steps> <snapshot_prefix>"
+                  << " [--dt=<dt>] [--every=<k>] [--bc=<spec>] [--threads=<n>] [--csv|--compressed]"
+                  << " [--checkpoint=<k>] [--buffers=<n>]\n";
+        std::cerr << "       <input_grid> is a binary grid file written by generate_grid.x; its bounds define x.\n";
+        std::cerr << "       If it is a checkpoint (or a .grid snapshot), the run resumes from it and continues to <steps>.\n";
+        std::cerr << "       --bc accepts dirichlet[:TL:TR], neumann[:gL:gR] or periodic (default: dirichlet).\n";
+        std::cerr << "       --compressed writes losslessly compressed .fpc snapshots.\n";
+        std::cerr << "       --checkpoint=k writes <prefix>_checkpoint.grid every k steps and at the end.\n";
+        std::cerr << "       --buffers=n writes on a background thread with n snapshot buffers (default 3, 0 = synchronous).\n";
+        return 1;
+    }
+
+    try {
+        std::string input_file = args[0];
+        double alpha = std::stod(args[1]);
+        std::uint64_t steps = std::stoull(args[2]);
+        std::string prefix = args[3];
+
+        MappedGrid grid(input_file);
+        const std::uint64_t N = grid.size();
+        const double a = grid.lower();
+        const double b = grid.upper();
+        if (N < 2 || !(b > a)) {
+            throw std::invalid_argument("The input grid needs at least 2 points and bounds a < b.");
+        }
+        const double dx = (b - a) / (N - 1);
+        // A grid written by the solver carries its state, so the run continues where it stopped
+        const GridCheckpointInfo* resume = grid.checkpoint();
+        std::uint64_t first_step = resume ? resume->step : 0;
+        if (resume && dt <= 0.0) {
+            dt = resume->dt;
+        }
+        if (dt <= 0.0) {
+            dt = 0.4 * dx * dx / alpha;  // Safely inside the stability limit 1/2
+        }
+
+        BoundaryCondition bc = (resume && !bc_given) ? boundary_from_checkpoint(*resume)
+                                                     : parse_boundary_condition(bc_spec, grid.data(), N);
+        ThreadPool pool(threads);
+        ExplicitHeatSolver solver(grid.data(), N, a, b, alpha, dt, bc, pool, first_step, resume ? resume->time : 0.0);
+
+        if (resume) {
+            std::cout << "Resuming from step " << first_step << " (t = " << resume->time << ")\n";
+            if (resume->alpha != alpha) {
+                std::cout << "Warning: the checkpoint was written with alpha = " << resume->alpha << "\n";
+            }
+            if (resume->dt != dt) {
+                // The time keeps counting from the checkpoint; only the steps after it use the new dt
+                std::cout << "Warning: the checkpoint was written with dt = " << resume->dt
+                          << "; continuing from t = " << resume->time << " with dt = " << dt << "\n";
+            }
+        }
+        std::cout << "Evolving " << N << " points on [" << a << ", " << b << "] up to step " << steps << "\n";
+        std::cout << "dt = " << dt << ", alpha * dt / dx^2 = " << solver.mesh_ratio()
+                  << ", threads = " << pool.size() << "\n";
+
+        // Snapshots and checkpoints go through the same writer: a background I/O thread, or the
+        // compute thread itself with --buffers=0
+        std::unique_ptr<AsyncSnapshotWriter> writer;
+        if (buffers > 0) {
+            writer = std::make_unique<AsyncSnapshotWriter>(N, a, b, buffers);
+        }
+        const std::string checkpoint_file = prefix + "_checkpoint.grid";
+        double io_seconds = 0.0;
+        auto output = [&](const std::string& name, bool checkpoint) {
+            auto start = std::chrono::steady_clock::now();
+            GridCheckpointInfo info = solver.checkpoint_info();
+            const double* u = solver.field().data();
+            if (writer) {
+                writer->submit(name, u, info, checkpoint);
+            } else if (checkpoint) {
+                write_checkpoint(name, u, N, a, b, info);
+            } else {
+                write_snapshot(name, u, N, a, b, pool, &info);
+            }
+            io_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        if (!resume) {
+            output(snapshot_name(prefix, 0, extension), false);
+        }
+        for (std::uint64_t s = first_step + 1; s <= steps; ++s) {
+            solver.step();
+            if ((every > 0 && s % every == 0) || s == steps) {
+                output(snapshot_name(prefix, s, extension), false);
+            }
+            if ((checkpoint_every > 0 && s % checkpoint_every == 0) || s == steps) {
+                output(checkpoint_file, true);
+            }
+        }
+        double loop_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double compute_seconds = loop_seconds - io_seconds;
+        if (writer) {
+            writer->close();
+        }
+        double total_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        steps = std::max(steps, first_step);
+        double updates = static_cast<double>(N) * (steps - first_step);
+        std::cout << "Reached t = " << solver.time() << " after " << solver.steps_taken() << " steps\n";
+        std::cout << "Compute time: " << compute_seconds << " s, snapshot time on the compute thread: " << io_seconds
+                  << " s, total: " << total_seconds << " s\n";
+        if (writer) {
+            std::cout << "Background writes: " << writer->written() << " files in " << writer->write_seconds()
+                      << " s, compute thread stalled for " << writer->stall_seconds() << " s\n";
+        }
+        std::cout << "Cell updates per second: " << (compute_seconds > 0.0 ? updates / compute_seconds : 0.0)
+                  << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
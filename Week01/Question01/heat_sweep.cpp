@@ -0,0 +1,105 @@
+#include "heat_sweep.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "grid_io.h"
+#include "heat_distribution.h"
+
+namespace {
+
+const char SWEEP_MAGIC[8] = {'H', 'E', 'A', 'T', 'S', 'W', 'E', 'P'};
+
+static_assert(sizeof(std::pair<double, double>) == 2 * sizeof(double) &&
+                  std::is_standard_layout<std::pair<double, double>>::value,
+              "(x, T) pairs are written to disk as two raw doubles.");
+
+// Writes a whole buffer at a file offset, retrying on short writes
+void write_at(int fd, const void* data, std::size_t bytes, std::uint64_t offset) {
+    const char* p = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t n = ::pwrite(fd, p, bytes, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::ios_base::failure("Error: Failed while writing sweep file: " + std::string(std::strerror(errno)));
+        }
+        p += n;
+        bytes -= static_cast<std::size_t>(n);
+        offset += static_cast<std::uint64_t>(n);
+    }
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+std::vector<SweepCaseEntry> run_sweep(const std::vector<RodSpec>& cases, const std::string& filename,
+                                      ThreadPool& pool) {
+    // Payload offsets are known up front, so cases can finish and be written in any order
+    std::vector<SweepCaseEntry> table(cases.size());
+    const std::uint64_t table_offset = sizeof(SweepFileHeader);
+    const std::uint64_t payload_offset = table_offset + cases.size() * sizeof(SweepCaseEntry);
+    std::uint64_t offset = payload_offset;
+    for (std::size_t i = 0; i < cases.size(); ++i) {
+        table[i] = SweepCaseEntry{cases[i].N, cases[i].T_initial, cases[i].a, cases[i].b, offset, 0.0, 0.0, 0.0};
+        offset += cases[i].N * sizeof(std::pair<double, double>);
+    }
+
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::ios_base::failure("Error: Could not open file for writing.");
+    }
+
+    try {
+        // Largest cases first keeps the tail of the sweep short
+        std::vector<std::size_t> order(cases.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&](std::size_t x, std::size_t y) { return cases[x].N > cases[y].N; });
+
+        pool.run(order.size(), [&](std::size_t task) {
+            SweepCaseEntry& entry = table[order[task]];
+
+            auto start = std::chrono::steady_clock::now();
+            auto grid = generate_initial_grid(static_cast<std::int64_t>(entry.N), entry.T_initial);
+            entry.generate_seconds = seconds_since(start);
+
+            start = std::chrono::steady_clock::now();
+            auto heat_distribution = compute_heat_distribution(grid.size(), entry.a, entry.b);
+            entry.compute_seconds = seconds_since(start);
+
+            start = std::chrono::steady_clock::now();
+            write_at(fd, heat_distribution.data(), heat_distribution.size() * sizeof(heat_distribution[0]),
+                     entry.payload_offset);
+            entry.write_seconds = seconds_since(start);
+        });
+
+        SweepFileHeader header{};
+        std::memcpy(header.magic, SWEEP_MAGIC, sizeof(SWEEP_MAGIC));
+        header.version = SWEEP_FORMAT_VERSION;
+        header.endian_tag = GRID_ENDIAN_TAG;
+        header.case_count = cases.size();
+        header.table_offset = table_offset;
+        header.payload_offset = payload_offset;
+        write_at(fd, &header, sizeof(header), 0);
+        write_at(fd, table.data(), table.size() * sizeof(SweepCaseEntry), table_offset);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+
+    if (::close(fd) != 0) {
+        throw std::ios_base::failure("Error: Failed while closing sweep file.");
+    }
+    return table;
+}
@@ -0,0 +1,62 @@
+#ifndef HEAT_SWEEP_H
+#define HEAT_SWEEP_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "heat_distribution.h"
+#include "thread_pool.h"
+
+/// Current version of the sweep result format.
+constexpr std::uint32_t SWEEP_FORMAT_VERSION = 1;
+
+/**
+ * @brief Fixed 64-byte header of a sweep result file.
+ *
+ * The header is followed by `case_count` SweepCaseEntry records starting at `table_offset`.
+ * Each entry points to its payload: N (x, T) pairs of doubles.
+ */
+struct SweepFileHeader {
+    char magic[8];                 ///< Always "HEATSWEP".
+    std::uint32_t version;         ///< Format version (SWEEP_FORMAT_VERSION).
+    std::uint32_t endian_tag;      ///< GRID_ENDIAN_TAG in the writer's byte order.
+    std::uint64_t case_count;      ///< Number of cases.
+    std::uint64_t table_offset;    ///< Byte offset of the case table.
+    std::uint64_t payload_offset;  ///< Byte offset of the first payload.
+    std::uint64_t reserved[3];     ///< Zero; reserved for future versions.
+};
+
+/**
+ * @brief One 64-byte entry of the case table of a sweep result file.
+ */
+struct SweepCaseEntry {
+    std::uint64_t N;                ///< Number of grid points.
+    double T_initial;               ///< Initial temperature.
+    double a;                       ///< Lower bound of x.
+    double b;                       ///< Upper bound of x.
+    std::uint64_t payload_offset;   ///< Byte offset of the N (x, T) pairs of this case.
+    double generate_seconds;        ///< Time spent generating the initial grid.
+    double compute_seconds;         ///< Time spent computing the heat distribution.
+    double write_seconds;           ///< Time spent writing the payload.
+};
+
+static_assert(sizeof(SweepFileHeader) == 64, "SweepFileHeader must be exactly 64 bytes.");
+static_assert(sizeof(SweepCaseEntry) == 64, "SweepCaseEntry must be exactly 64 bytes.");
+
+/**
+ * @brief Runs every case of a parameter sweep in this process and writes all results to one indexed file.
+ *
+ * Each case generates its initial grid and computes its heat distribution in memory; no
+ * intermediate files are written. Cases are distributed dynamically over the pool, largest
+ * first, and every worker writes its payload directly at its precomputed offset.
+ *
+ * @param cases The sweep cases (N, T_initial, a, b).
+ * @param filename The output file name.
+ * @param pool Threads that run the cases.
+ * @return The case table, including the per-case timings, in input order.
+ */
+std::vector<SweepCaseEntry> run_sweep(const std::vector<RodSpec>& cases, const std::string& filename,
+                                      ThreadPool& pool);
+
+#endif // HEAT_SWEEP_H
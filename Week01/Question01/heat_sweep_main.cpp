@@ -0,0 +1,68 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "heat_distribution.h"
+#include "heat_sweep.h"
+#include "thread_pool.h"
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    unsigned threads = 0;  // 0 selects the hardware concurrency
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--threads=", 0) == 0) {
+                threads = static_cast<unsigned>(std::stoul(arg.substr(10)));
+            } else {
+                args.push_back(arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (args.size() != 2) {
+        std::cerr << "Usage: " << argv[0] << " <sweep_file> <output_file> [--threads=<n>]\n";
+        std::cerr << "       <sweep_file> lists one case per line as \"N T_initial a b\".\n";
+        return 1;
+    }
+
+    try {
+        std::string sweep_file = args[0];
+        std::string output_file = args[1];
+
+        std::vector<RodSpec> cases = read_rod_specs(sweep_file);
+        if (cases.empty()) {
+            throw std::invalid_argument("No cases in " + sweep_file + ".");
+        }
+
+        ThreadPool pool(threads);
+        std::cout << "Running " << cases.size() << " cases on " << pool.size() << " threads\n";
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<SweepCaseEntry> table = run_sweep(cases, output_file, pool);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("%8s %12s %12s %12s %12s\n", "case", "N", "generate_s", "compute_s", "write_s");
+        double busy = 0.0;
+        for (std::size_t i = 0; i < table.size(); ++i) {
+            const SweepCaseEntry& e = table[i];
+            std::printf("%8zu %12llu %12.6f %12.6f %12.6f\n", i, static_cast<unsigned long long>(e.N),
+                        e.generate_seconds, e.compute_seconds, e.write_seconds);
+            busy += e.generate_seconds + e.compute_seconds + e.write_seconds;
+        }
+        std::cout << "Wall time: " << seconds << " s, summed case time: " << busy << " s\n";
+        std::cout << "Results written to " << output_file << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
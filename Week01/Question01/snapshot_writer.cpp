@@ -0,0 +1,150 @@
+#include "snapshot_writer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "heat_solver.h"
+
+void write_checkpoint(const std::string& filename, const double* u, std::uint64_t N, double a, double b,
+                      const GridCheckpointInfo& info) {
+    const std::string temporary = filename + ".tmp";
+    GridFileWriter writer(temporary, N, a, b, &info);
+    writer.append(u, N);
+    writer.close();
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+        throw std::ios_base::failure("Error: Could not rename " + temporary + " to " + filename + ".");
+    }
+}
+
+AsyncSnapshotWriter::AsyncSnapshotWriter(std::uint64_t N, double a, double b, std::size_t buffers)
+    : N_(N), a_(a), b_(b), busy_(false), stop_(false), stall_seconds_(0.0), write_seconds_(0.0), written_(0),
+      io_pool_(1) {
+    if (buffers == 0) {
+        throw std::invalid_argument("The snapshot writer needs at least one buffer.");
+    }
+    buffers_.assign(buffers, std::vector<double>(N));
+    for (std::size_t i = 0; i < buffers; ++i) {
+        free_.push_back(i);
+    }
+    thread_ = std::thread(&AsyncSnapshotWriter::run, this);
+}
+
+AsyncSnapshotWriter::~AsyncSnapshotWriter() {
+    try {
+        close();
+    } catch (...) {
+        // Destructors must not throw; call close() to observe write errors
+    }
+}
+
+void AsyncSnapshotWriter::submit(const std::string& filename, const double* u, const GridCheckpointInfo& info,
+                                 bool atomic) {
+    std::size_t buffer;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        rethrow_error();
+        if (stop_) {
+            throw std::logic_error("Snapshot submitted after the writer was closed.");
+        }
+        if (free_.empty()) {
+            auto start = std::chrono::steady_clock::now();
+            done_cv_.wait(lock, [this] { return !free_.empty() || error_; });
+            stall_seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            rethrow_error();
+        }
+        buffer = free_.back();
+        free_.pop_back();
+    }
+
+    // The copy runs outside the lock so the I/O thread can keep writing
+    std::memcpy(buffers_[buffer].data(), u, N_ * sizeof(double));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back({filename, buffer, info, atomic});
+    }
+    work_cv_.notify_one();
+}
+
+void AsyncSnapshotWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return (queue_.empty() && !busy_) || error_; });
+    rethrow_error();
+}
+
+void AsyncSnapshotWriter::close() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_one();
+    thread_.join();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    rethrow_error();
+}
+
+double AsyncSnapshotWriter::write_seconds() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return write_seconds_;
+}
+
+std::uint64_t AsyncSnapshotWriter::written() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return written_;
+}
+
+void AsyncSnapshotWriter::run() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [this] { return !queue_.empty() || stop_; });
+            if (queue_.empty()) {
+                return;  // Stopped and drained
+            }
+            job = std::move(queue_.front());
+            queue_.pop_front();
+            busy_ = true;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        std::exception_ptr error;
+        try {
+            if (job.atomic) {
+                write_checkpoint(job.filename, buffers_[job.buffer].data(), N_, a_, b_, job.info);
+            } else {
+                write_snapshot(job.filename, buffers_[job.buffer].data(), N_, a_, b_, io_pool_, &job.info);
+            }
+        } catch (...) {
+            error = std::current_exception();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_.push_back(job.buffer);
+            busy_ = false;
+            write_seconds_ += seconds;
+            if (error && !error_) {
+                error_ = error;
+            } else if (!error) {
+                ++written_;
+            }
+        }
+        done_cv_.notify_all();
+    }
+}
+
+void AsyncSnapshotWriter::rethrow_error() {
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;  // Report each error once
+        std::rethrow_exception(error);
+    }
+}
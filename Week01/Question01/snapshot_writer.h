@@ -0,0 +1,126 @@
+#ifndef SNAPSHOT_WRITER_H
+#define SNAPSHOT_WRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "grid_io.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Writes a binary grid checkpoint through a temporary file that is renamed into place.
+ *
+ * @param filename The checkpoint file name.
+ * @param u The temperatures.
+ * @param N The number of grid points.
+ * @param a The lower bound of x.
+ * @param b The upper bound of x.
+ * @param info Solver state stored with the grid.
+ */
+void write_checkpoint(const std::string& filename, const double* u, std::uint64_t N, double a, double b,
+                      const GridCheckpointInfo& info);
+
+/**
+ * @class AsyncSnapshotWriter
+ * @brief Writes snapshots and checkpoints of a 1D field on a dedicated I/O thread.
+ *
+ * The field is copied into one of a few preallocated buffers and queued; the I/O thread
+ * writes it (see write_snapshot) while the caller keeps computing. The caller only waits
+ * when every buffer is still queued. Checkpoints are written to a temporary file and renamed
+ * into place, so an interrupted run always leaves the previous checkpoint intact.
+ */
+class AsyncSnapshotWriter {
+public:
+    /**
+     * @brief Allocates the buffers and starts the I/O thread.
+     * @param N The number of grid points.
+     * @param a The lower bound of x.
+     * @param b The upper bound of x.
+     * @param buffers Number of snapshot buffers (2 = double, 3 = triple buffering).
+     */
+    AsyncSnapshotWriter(std::uint64_t N, double a, double b, std::size_t buffers = 3);
+
+    /**
+     * @brief Writes the queued snapshots and stops the I/O thread; errors are only reported by close().
+     */
+    ~AsyncSnapshotWriter();
+
+    AsyncSnapshotWriter(const AsyncSnapshotWriter&) = delete;
+    AsyncSnapshotWriter& operator=(const AsyncSnapshotWriter&) = delete;
+
+    /**
+     * @brief Copies a field into a free buffer and queues it for writing.
+     *
+     * Rethrows the first error of an earlier write.
+     *
+     * @param filename The output file name; the extension selects the format as in write_snapshot.
+     * @param u The temperatures (N values); may be modified as soon as submit returns.
+     * @param info Solver state stored with binary grid files.
+     * @param atomic Whether to write a binary checkpoint through write_checkpoint (any extension).
+     */
+    void submit(const std::string& filename, const double* u, const GridCheckpointInfo& info, bool atomic = false);
+
+    /**
+     * @brief Waits until every queued snapshot has been written, rethrowing the first write error.
+     */
+    void flush();
+
+    /**
+     * @brief Flushes the queue and stops the I/O thread.
+     */
+    void close();
+
+    /**
+     * @brief Time submit() spent waiting for a free buffer, in seconds.
+     */
+    double stall_seconds() const { return stall_seconds_; }
+
+    /**
+     * @brief Time the I/O thread spent writing, in seconds.
+     */
+    double write_seconds() const;
+
+    /**
+     * @brief Number of snapshots written so far.
+     */
+    std::uint64_t written() const;
+
+private:
+    /// One queued snapshot.
+    struct Job {
+        std::string filename;     ///< Output file name.
+        std::size_t buffer;       ///< Buffer holding the field.
+        GridCheckpointInfo info;  ///< Solver state.
+        bool atomic;              ///< Write a checkpoint through a temporary file.
+    };
+
+    void run();                   ///< Loop of the I/O thread.
+    void rethrow_error();         ///< Rethrows a stored write error; caller holds mutex_.
+
+    std::uint64_t N_;                          ///< Number of grid points.
+    double a_;                                 ///< Lower bound of x.
+    double b_;                                 ///< Upper bound of x.
+    std::vector<std::vector<double>> buffers_; ///< Snapshot buffers.
+    std::vector<std::size_t> free_;            ///< Buffers that can be filled.
+    std::deque<Job> queue_;                    ///< Snapshots waiting to be written.
+    bool busy_;                                ///< Whether the I/O thread is writing.
+    bool stop_;                                ///< Set by close().
+    std::exception_ptr error_;                 ///< First write error.
+    double stall_seconds_;                     ///< Time submit() waited for a buffer.
+    double write_seconds_;                     ///< Time spent writing.
+    std::uint64_t written_;                    ///< Snapshots written.
+    ThreadPool io_pool_;                       ///< Single-thread pool for compressed output.
+    mutable std::mutex mutex_;                 ///< Guards the queue and the statistics.
+    std::condition_variable work_cv_;          ///< Signals queued work or stop_.
+    std::condition_variable done_cv_;          ///< Signals a written snapshot.
+    std::thread thread_;                       ///< The I/O thread.
+};
+
+#endif // SNAPSHOT_WRITER_H
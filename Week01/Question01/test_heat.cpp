@@ -0,0 +1,76 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "heat_solver.h"
+#include "text_io.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Checks that a single sine mode on a periodic rod decays as exp(-alpha k^2 t).
+ *
+ * The rod holds exactly one period of sin(k x) with k = 2 pi / (b - a); a wrong period
+ * leaves a kink at the wrap-around point and changes the decay.
+ */
+bool test_periodic_decay(ThreadPool& pool) {
+    const double pi = std::acos(-1.0);
+    const std::uint64_t N = 201;
+    const double a = -0.5, b = 1.5, alpha = 0.5;
+    const double dx = (b - a) / (N - 1), dt = 0.25 * dx * dx / alpha;
+    const double k = 2.0 * pi / (b - a);
+
+    std::vector<double> initial(N);
+    for (std::uint64_t i = 0; i < N; ++i) {
+        initial[i] = std::sin(k * (a + i * dx));
+    }
+    BoundaryCondition bc;
+    bc.type = BoundaryType::Periodic;
+    ExplicitHeatSolver solver(initial.data(), N, a, b, alpha, dt, bc, pool);
+    for (int s = 0; s < 8000; ++s) {
+        solver.step();
+    }
+
+    const double decay = std::exp(-alpha * k * k * solver.time());
+    double error = 0.0;
+    for (std::uint64_t i = 0; i < N; ++i) {
+        error = std::max(error, std::fabs(solver.field()[i] - decay * initial[i]));
+    }
+    bool ok = error < 1e-3 * decay && solver.field().front() == solver.field().back();
+    std::cout << "Periodic sine mode: amplitude " << decay << " after t = " << solver.time() << ", max error "
+              << error << (ok ? " (ok)\n" : " (FAILED)\n");
+    return ok;
+}
+
+/**
+ * @brief Checks that the CSV parser accepts what the iostream reader did: spaces and tabs
+ * around fields, "\r\n" line endings and blank lines, including trailing ones.
+ */
+bool test_csv_whitespace(ThreadPool& pool) {
+    const char* text = "x,T\n0, 1.5\n\t2 ,\t3\r\n\n  \r\n4,5\n\n";
+    std::vector<std::vector<double>> columns = parse_csv_columns(text, std::strlen(text), 2, {0, 1}, true, pool);
+    bool ok = columns[0] == std::vector<double>{0.0, 2.0, 4.0} && columns[1] == std::vector<double>{1.5, 3.0, 5.0};
+
+    const char* malformed = "x,T\n0,,1\n";
+    try {
+        parse_csv_columns(malformed, std::strlen(malformed), 2, {0, 1}, true, pool);
+        ok = false;
+    } catch (const std::runtime_error&) {
+    }
+    std::cout << "CSV whitespace and blank lines" << (ok ? " (ok)\n" : " (FAILED)\n");
+    return ok;
+}
+
+/**
+ * @brief Runs the solver tests; the exit status is non-zero if any of them fails.
+ */
+int main() {
+    ThreadPool pool(2);
+    bool ok = true;
+    ok = test_periodic_decay(pool) && ok;
+    ok = test_csv_whitespace(pool) && ok;
+    std::cout << (ok ? "All tests passed.\n" : "Some tests FAILED.\n");
+    return ok ? 0 : 1;
+}
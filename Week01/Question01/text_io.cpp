@@ -0,0 +1,213 @@
+#include "text_io.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "grid_io.h"
+
+TextWriter::TextWriter(const std::string& filename, std::size_t capacity)
+    : fd_(::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)), buffer_(std::max<std::size_t>(capacity, 64)),
+      pos_(0) {
+    if (fd_ < 0) {
+        throw std::ios_base::failure("Error: Could not open file for writing.");
+    }
+}
+
+TextWriter::~TextWriter() {
+    if (fd_ >= 0) {
+        try {
+            flush();
+        } catch (...) {
+            // Destructors must not throw; call close() to observe write errors
+        }
+        ::close(fd_);
+    }
+}
+
+void TextWriter::write(std::string_view text) {
+    while (!text.empty()) {
+        if (pos_ == buffer_.size()) flush();
+        std::size_t n = std::min(text.size(), buffer_.size() - pos_);
+        std::memcpy(buffer_.data() + pos_, text.data(), n);
+        pos_ += n;
+        text.remove_prefix(n);
+    }
+}
+
+void TextWriter::write_fixed(double value, int precision) {
+    // 310 integer digits cover the largest double; the rest is sign, point and fraction
+    reserve(320 + static_cast<std::size_t>(precision));
+    auto result = std::to_chars(buffer_.data() + pos_, buffer_.data() + buffer_.size(), value,
+                                std::chars_format::fixed, precision);
+    if (result.ec != std::errc()) {
+        throw std::runtime_error("Error: Could not format " + std::to_string(value) + ".");
+    }
+    pos_ = result.ptr - buffer_.data();
+}
+
+void TextWriter::close() {
+    if (fd_ < 0) {
+        return;
+    }
+    flush();
+    int fd = fd_;
+    fd_ = -1;
+    if (::close(fd) != 0) {
+        throw std::ios_base::failure("Error: Failed while closing output file.");
+    }
+}
+
+void TextWriter::reserve(std::size_t bytes) {
+    if (pos_ + bytes > buffer_.size()) {
+        flush();
+        if (bytes > buffer_.size()) {
+            buffer_.resize(bytes);
+        }
+    }
+}
+
+void TextWriter::flush() {
+    const char* p = buffer_.data();
+    std::size_t left = pos_;
+    while (left > 0) {
+        ssize_t n = ::write(fd_, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::ios_base::failure("Error: Failed while writing: " + std::string(std::strerror(errno)));
+        }
+        p += n;
+        left -= static_cast<std::size_t>(n);
+    }
+    pos_ = 0;
+}
+
+namespace {
+
+// Chunks per thread; a few more than one keeps threads busy when chunks parse at different speeds
+constexpr std::size_t CHUNKS_PER_THREAD = 4;
+
+// Moves past spaces and tabs, which may surround a field
+const char* skip_spaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    return p;
+}
+
+// Moves past blank lines (only spaces, tabs and '\r'), which hold no row
+const char* skip_blank_lines(const char* p, const char* end) {
+    while (p < end) {
+        const char* q = p;
+        while (q < end && (*q == ' ' || *q == '\t' || *q == '\r')) {
+            ++q;
+        }
+        if (q < end && *q != '\n') {
+            return p;
+        }
+        p = q < end ? q + 1 : end;
+    }
+    return p;
+}
+
+// Number of rows in [begin, end): lines that are not blank, including a final one without a newline
+std::size_t count_rows(const char* begin, const char* end) {
+    std::size_t rows = 0;
+    for (const char* p = skip_blank_lines(begin, end); p < end; p = skip_blank_lines(p, end)) {
+        ++rows;
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        p = newline ? newline + 1 : end;
+    }
+    return rows;
+}
+
+} // namespace
+
+std::vector<std::vector<double>> parse_csv_columns(const char* text, std::size_t size, std::size_t columns,
+                                                   const std::vector<std::size_t>& keep, bool skip_header,
+                                                   ThreadPool& pool) {
+    if (columns == 0) {
+        throw std::invalid_argument("A CSV row needs at least one column.");
+    }
+    for (std::size_t c : keep) {
+        if (c >= columns) {
+            throw std::invalid_argument("Requested CSV column " + std::to_string(c) + " does not exist.");
+        }
+    }
+
+    const char* begin = text;
+    const char* end = text + size;
+    if (skip_header && begin != end) {
+        const char* newline = static_cast<const char*>(std::memchr(begin, '\n', size));
+        begin = newline ? newline + 1 : end;
+    }
+
+    // Newline-aligned chunk boundaries: each boundary moves forward to the start of the next line
+    const std::size_t chunks = std::max<std::size_t>(1, pool.size() * CHUNKS_PER_THREAD);
+    std::vector<const char*> bounds(chunks + 1, end);
+    bounds[0] = begin;
+    const std::size_t body = end - begin;
+    for (std::size_t c = 1; c < chunks; ++c) {
+        const char* p = std::max(begin + body * c / chunks, bounds[c - 1]);
+        if (p > begin && p < end && p[-1] != '\n') {
+            const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            p = newline ? newline + 1 : end;
+        }
+        bounds[c] = p;
+    }
+
+    // Pass 1: rows per chunk, turned into the index of each chunk's first row
+    std::vector<std::size_t> first_row(chunks + 1, 0);
+    pool.run(chunks, [&](std::size_t c) { first_row[c + 1] = count_rows(bounds[c], bounds[c + 1]); });
+    for (std::size_t c = 0; c < chunks; ++c) {
+        first_row[c + 1] += first_row[c];
+    }
+    const std::size_t rows = first_row[chunks];
+
+    std::vector<std::vector<double>> result(keep.size(), std::vector<double>(rows));
+    std::vector<int> slot(columns, -1);  // Output vector of every input column, or -1
+    for (std::size_t k = 0; k < keep.size(); ++k) {
+        slot[keep[k]] = static_cast<int>(k);
+    }
+
+    // Pass 2: parse every chunk straight into its rows of the output
+    pool.run(chunks, [&](std::size_t c) {
+        const char* p = bounds[c];
+        const char* stop = bounds[c + 1];
+        for (std::size_t row = first_row[c]; row < first_row[c + 1]; ++row) {
+            p = skip_blank_lines(p, stop);
+            for (std::size_t col = 0; col < columns; ++col) {
+                double value;
+                auto parsed = std::from_chars(skip_spaces(p, stop), stop, value);
+                bool ok = parsed.ec == std::errc();
+                p = skip_spaces(parsed.ptr, stop);
+                char expected = (col + 1 < columns) ? ',' : '\n';
+                if (ok && expected == '\n' && p < stop && *p == '\r') {
+                    ++p;
+                }
+                if (!ok || (p < stop && *p != expected) || (p == stop && expected == ',')) {
+                    throw std::runtime_error("Error: Malformed CSV data in row " +
+                                             std::to_string(row + (skip_header ? 2 : 1)) + ".");
+                }
+                if (p < stop) {
+                    ++p;  // Skip the separator
+                }
+                if (slot[col] >= 0) {
+                    result[slot[col]][row] = value;
+                }
+            }
+        }
+    });
+
+    return result;
+}
+
+std::vector<std::vector<double>> read_csv_columns(const std::string& filename, std::size_t columns,
+                                                  const std::vector<std::size_t>& keep, ThreadPool& pool) {
+    MappedFile file(filename);
+    return parse_csv_columns(file.data(), file.size(), columns, keep, true, pool);
+}
@@ -0,0 +1,112 @@
+#ifndef TEXT_IO_H
+#define TEXT_IO_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "thread_pool.h"
+
+/**
+ * @class TextWriter
+ * @brief Buffered text output that formats numbers with std::to_chars.
+ *
+ * Numbers are formatted straight into a large buffer without locale handling or stream
+ * state, and the buffer is handed to the operating system in a single write when full.
+ */
+class TextWriter {
+public:
+    /**
+     * @brief Creates (or truncates) the output file.
+     * @param filename The output file name.
+     * @param capacity Size of the output buffer in bytes.
+     */
+    explicit TextWriter(const std::string& filename, std::size_t capacity = 1 << 20);
+
+    /**
+     * @brief Flushes and closes the file; errors are only reported by close().
+     */
+    ~TextWriter();
+
+    TextWriter(const TextWriter&) = delete;
+    TextWriter& operator=(const TextWriter&) = delete;
+
+    /**
+     * @brief Appends a string.
+     */
+    void write(std::string_view text);
+
+    /**
+     * @brief Appends a single character.
+     */
+    void put(char c) {
+        if (pos_ == buffer_.size()) flush();
+        buffer_[pos_++] = c;
+    }
+
+    /**
+     * @brief Appends an integer in decimal notation.
+     */
+    template <typename Integer>
+    void write_integer(Integer value) {
+        reserve(24);
+        auto result = std::to_chars(buffer_.data() + pos_, buffer_.data() + buffer_.size(), value);
+        pos_ = result.ptr - buffer_.data();
+    }
+
+    /**
+     * @brief Appends a double in fixed notation, like std::fixed << std::setprecision(precision).
+     */
+    void write_fixed(double value, int precision = 6);
+
+    /**
+     * @brief Flushes the buffer and closes the file.
+     */
+    void close();
+
+private:
+    void reserve(std::size_t bytes);  ///< Flushes unless `bytes` more characters fit.
+    void flush();                     ///< Writes the buffered characters to the file.
+
+    int fd_;                    ///< Output file descriptor (-1 once closed).
+    std::vector<char> buffer_;  ///< Output buffer.
+    std::size_t pos_;           ///< Number of buffered characters.
+};
+
+/**
+ * @brief Parses the numeric rows of a CSV file in parallel.
+ *
+ * The text is split into newline-aligned chunks, one set per thread; each chunk counts its
+ * rows, the counts are turned into row offsets, and every chunk then parses its rows with
+ * std::from_chars directly into the output. Rows must have exactly `columns` fields separated
+ * by commas. Spaces and tabs around a field, blank lines and "\r\n" line endings are accepted,
+ * as with the iostream reader.
+ *
+ * @param text The file contents.
+ * @param size Length of the file contents in bytes.
+ * @param columns Number of fields per row.
+ * @param keep Indices of the columns to return.
+ * @param skip_header Whether the first line is a header.
+ * @param pool Threads that parse the chunks.
+ * @return One vector per kept column, in the order given by `keep`.
+ */
+std::vector<std::vector<double>> parse_csv_columns(const char* text, std::size_t size, std::size_t columns,
+                                                   const std::vector<std::size_t>& keep, bool skip_header,
+                                                   ThreadPool& pool);
+
+/**
+ * @brief Maps a CSV file and parses selected columns in parallel (see parse_csv_columns).
+ *
+ * @param filename The input CSV file name.
+ * @param columns Number of fields per row.
+ * @param keep Indices of the columns to return.
+ * @param pool Threads that parse the chunks.
+ * @return One vector per kept column.
+ */
+std::vector<std::vector<double>> read_csv_columns(const std::string& filename, std::size_t columns,
+                                                  const std::vector<std::size_t>& keep, ThreadPool& pool);
+
+#endif // TEXT_IO_H
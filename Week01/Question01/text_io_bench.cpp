@@ -0,0 +1,162 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "grid_io.h"
+#include "text_io.h"
+#include "thread_pool.h"
+
+/**
+ * @brief Writes (x, T) rows the way the original CSV writers did, with ofstream and setprecision.
+ */
+void write_rows_iostream(const std::string& filename, const std::vector<double>& x, const std::vector<double>& T) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        throw std::ios_base::failure("Error: Could not open file for writing.");
+    }
+
+    file << "x,T\n";
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        file << std::fixed << std::setprecision(6) << x[i] << "," << T[i] << "\n";
+    }
+
+    file.close();
+}
+
+/**
+ * @brief Writes (x, T) rows with TextWriter.
+ */
+void write_rows_text_io(const std::string& filename, const std::vector<double>& x, const std::vector<double>& T) {
+    TextWriter file(filename);
+
+    file.write("x,T\n");
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        file.write_fixed(x[i], 6);
+        file.put(',');
+        file.write_fixed(T[i], 6);
+        file.put('\n');
+    }
+
+    file.close();
+}
+
+/**
+ * @brief Reads (x, T) rows the way the original CSV reader did, with getline and istringstream.
+ */
+std::vector<std::vector<double>> read_rows_iostream(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::ios_base::failure("Error: Could not open file for reading.");
+    }
+
+    std::vector<std::vector<double>> columns(2);
+    std::string line;
+    std::getline(file, line);
+
+    while (std::getline(file, line)) {
+        std::istringstream ss(line);
+        double x, T;
+        char comma;
+        ss >> x >> comma >> T;
+        columns[0].push_back(x);
+        columns[1].push_back(T);
+    }
+
+    return columns;
+}
+
+/**
+ * @brief Runs a function once and returns its wall-clock time in seconds.
+ */
+template <typename Function>
+double time_seconds(Function&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args;
+    unsigned threads = 0;  // 0 selects the hardware concurrency
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.rfind("--threads=", 0) == 0) {
+                threads = static_cast<unsigned>(std::stoul(arg.substr(10)));
+            } else {
+                args.push_back(arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    if (args.size() > 1) {
+        std::cerr << "Usage: " << argv[0] << " [<rows>] [--threads=<n>]\n";
+        std::cerr << "       Writes and reads an (x, T) CSV file of <rows> rows (default 1e8) with iostreams\n";
+        std::cerr << "       and with the text_io layer, and reports the throughput of both.\n";
+        return 1;
+    }
+
+    try {
+        std::uint64_t rows = args.empty() ? 100000000 : static_cast<std::uint64_t>(std::stod(args[0]));
+        const std::string reference_file = "text_io_bench_ref.csv";
+        const std::string output_file = "text_io_bench.csv";
+
+        // Same (x, 1 - x^2) rows as generate_heat_distribution.x on [-1, 1]
+        std::vector<double> x(rows), T(rows);
+        for (std::uint64_t i = 0; i < rows; ++i) {
+            x[i] = -1.0 + i * (2.0 / (rows > 1 ? rows - 1 : 1));
+            T[i] = 1.0 - x[i] * x[i];
+        }
+
+        ThreadPool pool(threads);
+        std::cout << "Benchmarking " << rows << " rows with " << pool.size() << " thread(s)\n";
+
+        double old_write = time_seconds([&] { write_rows_iostream(reference_file, x, T); });
+        double new_write = time_seconds([&] { write_rows_text_io(output_file, x, T); });
+
+        double bytes;
+        {
+            MappedFile reference(reference_file);
+            MappedFile output(output_file);
+            if (reference.size() != output.size() ||
+                std::memcmp(reference.data(), output.data(), output.size()) != 0) {
+                throw std::runtime_error("text_io output differs from the iostream output.");
+            }
+            bytes = static_cast<double>(output.size());
+        }
+
+        std::vector<std::vector<double>> old_columns, new_columns;
+        double old_read = time_seconds([&] { old_columns = read_rows_iostream(reference_file); });
+        double new_read = time_seconds([&] { new_columns = read_csv_columns(output_file, 2, {0, 1}, pool); });
+        if (old_columns != new_columns) {
+            throw std::runtime_error("text_io parser disagrees with the iostream parser.");
+        }
+
+        std::remove(reference_file.c_str());
+        std::remove(output_file.c_str());
+
+        double mb = bytes / 1e6;
+        std::cout << "File size: " << mb << " MB (outputs identical)\n";
+        std::cout << "Write: iostream " << mb / old_write << " MB/s, text_io " << mb / new_write
+                  << " MB/s, speedup " << old_write / new_write << "x\n";
+        std::cout << "Read:  iostream " << mb / old_read << " MB/s, text_io " << mb / new_read
+                  << " MB/s, speedup " << old_read / new_read << "x\n";
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
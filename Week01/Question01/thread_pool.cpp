@@ -0,0 +1,107 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 1; i < threads; ++i) {
+        workers_.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run(std::size_t tasks, const std::function<void(std::size_t)>& body) {
+    if (tasks == 0) {
+        return;
+    }
+    if (workers_.empty() || tasks == 1) {
+        for (std::size_t t = 0; t < tasks; ++t) {
+            body(t);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        body_ = &body;
+        tasks_ = tasks;
+        next_.store(0);
+        active_ = workers_.size();
+        error_ = nullptr;
+        ++generation_;
+    }
+    start_cv_.notify_all();
+
+    drain();  // The caller works on the batch as well
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    done_cv_.wait(lock, [this] { return active_ == 0; });
+    body_ = nullptr;
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void ThreadPool::parallel_for(std::size_t begin, std::size_t end,
+                              const std::function<void(std::size_t, std::size_t)>& body) {
+    if (end <= begin) {
+        return;
+    }
+    std::size_t count = end - begin;
+    std::size_t chunks = std::min<std::size_t>(size(), count);
+    run(chunks, [&](std::size_t c) {
+        std::size_t lo = begin + count * c / chunks;
+        std::size_t hi = begin + count * (c + 1) / chunks;
+        body(lo, hi);
+    });
+}
+
+void ThreadPool::worker_loop() {
+    std::size_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            start_cv_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+        }
+
+        drain();
+
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (--active_ == 0) {
+            done_cv_.notify_one();
+        }
+    }
+}
+
+void ThreadPool::drain() {
+    while (true) {
+        std::size_t t = next_.fetch_add(1);
+        if (t >= tasks_) {
+            return;
+        }
+        try {
+            (*body_)(t);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+        }
+    }
+}
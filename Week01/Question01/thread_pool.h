@@ -0,0 +1,79 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads that execute batches of indexed tasks.
+ *
+ * The calling thread takes part in every batch, so a pool of size n runs n - 1
+ * background workers. Workers sleep between batches and are reused, which keeps
+ * the per-batch cost low enough to dispatch one batch per time step.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Starts the worker threads.
+     * @param threads Total number of threads including the caller (0 selects the hardware concurrency).
+     */
+    explicit ThreadPool(unsigned threads = 0);
+
+    /**
+     * @brief Stops and joins the worker threads.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Number of threads that execute a batch, including the caller.
+     */
+    unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+    /**
+     * @brief Runs body(t) for every t in [0, tasks) and waits for all of them to finish.
+     *
+     * Tasks are handed out dynamically, one at a time, so uneven tasks balance across threads.
+     * The first exception thrown by a task is rethrown in the caller.
+     *
+     * @param tasks Number of tasks.
+     * @param body Function called with each task index.
+     */
+    void run(std::size_t tasks, const std::function<void(std::size_t)>& body);
+
+    /**
+     * @brief Splits [begin, end) into one contiguous chunk per thread and runs body(chunk_begin, chunk_end) on each.
+     *
+     * @param begin First index of the range.
+     * @param end One past the last index of the range.
+     * @param body Function called with the bounds of each chunk.
+     */
+    void parallel_for(std::size_t begin, std::size_t end, const std::function<void(std::size_t, std::size_t)>& body);
+
+private:
+    void worker_loop();  ///< Waits for batches and drains them.
+    void drain();        ///< Executes tasks of the current batch until none are left.
+
+    std::vector<std::thread> workers_;                        ///< Background workers.
+    std::mutex mtx_;                                          ///< Protects the batch state below.
+    std::condition_variable start_cv_;                        ///< Signals a new batch or shutdown.
+    std::condition_variable done_cv_;                         ///< Signals that all workers left the batch.
+    const std::function<void(std::size_t)>* body_ = nullptr;  ///< Task body of the current batch.
+    std::size_t tasks_ = 0;                                   ///< Number of tasks in the current batch.
+    std::atomic<std::size_t> next_{0};                        ///< Next task index to hand out.
+    std::size_t generation_ = 0;                              ///< Incremented for every batch.
+    std::size_t active_ = 0;                                  ///< Workers still inside the current batch.
+    std::exception_ptr error_;                                ///< First exception raised by a task.
+    bool stop_ = false;                                       ///< Set when the pool shuts down.
+};
+
+#endif // THREAD_POOL_H
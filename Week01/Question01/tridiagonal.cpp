@@ -0,0 +1,56 @@
+#include "tridiagonal.h"
+
+#include <stdexcept>
+
+namespace {
+
+constexpr std::size_t W = TRIDIAGONAL_BATCH_WIDTH;
+
+} // namespace
+
+void thomas_factor_batched(const double* lower, const double* diag, const double* upper, std::size_t rows,
+                           double* upper_prime, double* inv_pivot) {
+    for (std::size_t l = 0; l < W; ++l) {
+        if (diag[l] == 0.0) {
+            throw std::runtime_error("Zero pivot in tridiagonal factorization.");
+        }
+        inv_pivot[l] = 1.0 / diag[l];
+        upper_prime[l] = upper[l] * inv_pivot[l];
+    }
+    for (std::size_t i = 1; i < rows; ++i) {
+        const std::size_t row = i * W;
+        const std::size_t prev = row - W;
+        for (std::size_t l = 0; l < W; ++l) {
+            double pivot = diag[row + l] - lower[row + l] * upper_prime[prev + l];
+            if (pivot == 0.0) {
+                throw std::runtime_error("Zero pivot in tridiagonal factorization.");
+            }
+            inv_pivot[row + l] = 1.0 / pivot;
+            upper_prime[row + l] = upper[row + l] * inv_pivot[row + l];
+        }
+    }
+}
+
+void thomas_solve_batched(const double* __restrict lower, const double* __restrict upper_prime,
+                          const double* __restrict inv_pivot, std::size_t rows, double* __restrict x) {
+    // Forward substitution: d'_i = (d_i - a_i d'_{i-1}) / pivot_i, one row of all systems at a time
+    for (std::size_t l = 0; l < W; ++l) {
+        x[l] *= inv_pivot[l];
+    }
+    for (std::size_t i = 1; i < rows; ++i) {
+        const std::size_t row = i * W;
+        const std::size_t prev = row - W;
+        for (std::size_t l = 0; l < W; ++l) {
+            x[row + l] = (x[row + l] - lower[row + l] * x[prev + l]) * inv_pivot[row + l];
+        }
+    }
+
+    // Back substitution: x_i = d'_i - c'_i x_{i+1}
+    for (std::size_t i = rows - 1; i-- > 0;) {
+        const std::size_t row = i * W;
+        const std::size_t next = row + W;
+        for (std::size_t l = 0; l < W; ++l) {
+            x[row + l] -= upper_prime[row + l] * x[next + l];
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef TRIDIAGONAL_H
+#define TRIDIAGONAL_H
+
+#include <cstddef>
+
+/// Number of independent systems solved side by side in an interleaved batch.
+constexpr std::size_t TRIDIAGONAL_BATCH_WIDTH = 8;
+
+/**
+ * @brief Factorizes a batch of tridiagonal systems with the Thomas algorithm.
+ *
+ * All arrays are interleaved: entry (row i, system l) is stored at index
+ * i * TRIDIAGONAL_BATCH_WIDTH + l, so each row holds one value per system and
+ * the loops over systems vectorize. Row i of system l reads
+ * lower[i] * x[i-1] + diag[i] * x[i] + upper[i] * x[i+1] = rhs[i],
+ * where lower of row 0 and upper of the last row must be zero.
+ *
+ * The factorization does not depend on the right-hand side, so it is computed once
+ * and reused by thomas_solve_batched for every time step.
+ *
+ * @param lower Sub-diagonal coefficients.
+ * @param diag Diagonal coefficients.
+ * @param upper Super-diagonal coefficients.
+ * @param rows Number of rows of every system in the batch.
+ * @param upper_prime Output: modified super-diagonal c'_i.
+ * @param inv_pivot Output: reciprocal pivots 1 / (b_i - a_i c'_{i-1}).
+ */
+void thomas_factor_batched(const double* lower, const double* diag, const double* upper, std::size_t rows,
+                           double* upper_prime, double* inv_pivot);
+
+/**
+ * @brief Solves a batch of factorized tridiagonal systems in place.
+ *
+ * @param lower Sub-diagonal coefficients (as passed to thomas_factor_batched).
+ * @param upper_prime Modified super-diagonal from thomas_factor_batched.
+ * @param inv_pivot Reciprocal pivots from thomas_factor_batched.
+ * @param rows Number of rows of every system in the batch.
+ * @param x On input the right-hand sides, on output the solutions (interleaved).
+ */
+void thomas_solve_batched(const double* lower, const double* upper_prime, const double* inv_pivot, std::size_t rows,
+                          double* x);
+
+#endif // TRIDIAGONAL_H
@@ -1,8 +1,13 @@
 import matplotlib.pyplot as plt
 import csv
+import os
 
-# File to read the heat distribution data
-input_file = 'heat_distribution.csv'
+from fpc_reader import read_fpc
+
+# File to read the heat distribution data: the most recently written of the compressed and CSV outputs,
+# so a stale file from an earlier run is not plotted
+candidates = [name for name in ('heat_distribution.fpc', 'heat_distribution.csv') if os.path.exists(name)]
+input_file = max(candidates, key=os.path.getmtime) if candidates else 'heat_distribution.csv'
 
 # Initialize lists for x and T(x)
 x = []
@@ -11,13 +16,19 @@ T = []
 
 print(f"Reading data from {input_file}...")
 
-# Read data from CSV file
-with open(input_file, 'r') as file:
-    reader = csv.reader(file)
-    next(reader)  
-    for row in reader:
-        x.append(float(row[0]))
-        T.append(float(row[1]))
+if input_file.endswith('.fpc'):
+    # Decode the compressed columns with libheatfpc.so (built by make)
+    columns, a, b = read_fpc(input_file)
+    x = columns['x']
+    T = columns['T']
+else:
+    # Read data from CSV file
+    with open(input_file, 'r') as file:
+        reader = csv.reader(file)
+        next(reader)  
+        for row in reader:
+            x.append(float(row[0]))
+            T.append(float(row[1]))
 
 
 print(f"Data read successfully. Number of points: {len(x)}")
@@ -0,0 +1,474 @@
+#ifndef BARNES_HUT_H
+#define BARNES_HUT_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "morton.h"
+#include "parallel_for.h"
+#include "particle_system.h"
+
+/**
+ * Pairwise gravitational force law shared by BarnesHut and DirectSum:
+ * F_i = G m_i sum_j m_j (x_j - x_i) / (|x_j - x_i|^2 + eps^2)^(3/2).
+ * A negative G gives a repulsive inverse-square force, i.e. Coulomb forces between like charges,
+ * with the masses standing in for the charges.
+ */
+struct GravityParameters {
+    double G = 1.0;         // Coupling constant
+    double softening = 0.0; // Plummer softening length eps, which keeps close encounters finite
+};
+
+/**
+ * Force model summing the pairwise forces directly, in O(n^2) operations per evaluation.
+ * It is the accuracy reference for BarnesHut and is practical for a few thousand particles.
+ */
+template <std::size_t N>
+class DirectSum {
+public:
+    explicit DirectSum(GravityParameters parameters = GravityParameters()) : parameters_(parameters) {}
+
+    void computeForces(ParticleSystem<N>& system, double) const {
+        parallelFor(system.size(), system.pool(), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const Vector<double, N> force = forceOn(system, i);
+                for (std::size_t d = 0; d < N; ++d) {
+                    system.forces(d)[i] = force[d];
+                }
+            }
+        });
+    }
+
+    /**
+     * Computes the force on a single particle, e.g. to check another force model on a sample of particles.
+     * @param system The particles.
+     * @param i The index of the particle.
+     * @return The force on particle i.
+     */
+    Vector<double, N> forceOn(const ParticleSystem<N>& system, std::size_t i) const {
+        const double eps2 = parameters_.softening * parameters_.softening;
+        std::array<double, N> xi, force{};
+        for (std::size_t d = 0; d < N; ++d) {
+            xi[d] = system.positions(d)[i];
+        }
+        for (std::size_t j = 0; j < system.size(); ++j) {
+            if (j == i) {
+                continue;
+            }
+            std::array<double, N> dx;
+            double r2 = eps2;
+            for (std::size_t d = 0; d < N; ++d) {
+                dx[d] = system.positions(d)[j] - xi[d];
+                r2 += dx[d] * dx[d];
+            }
+            const double scale = system.masses()[j] / (r2 * std::sqrt(r2));
+            for (std::size_t d = 0; d < N; ++d) {
+                force[d] += scale * dx[d];
+            }
+        }
+        Vector<double, N> result;
+        const double gm = parameters_.G * system.masses()[i];
+        for (std::size_t d = 0; d < N; ++d) {
+            result[d] = gm * force[d];
+        }
+        return result;
+    }
+
+private:
+    GravityParameters parameters_; // Force law
+};
+
+/**
+ * Force model computing the pairwise forces with the Barnes-Hut algorithm in O(n log n) operations:
+ * an octree (quadtree in 2D) is built over the particles, and a cell of side s whose centre of mass is
+ * at distance r from a particle is replaced by a point mass when s / r < theta. theta = 0 reproduces
+ * DirectSum up to rounding; 0.5 is a common compromise between accuracy and speed.
+ *
+ * The tree is rebuilt from scratch on every computeForces call:
+ *   1. the particles are sorted by the Morton code of their position (parallelSort), so every cell of
+ *      the tree is a contiguous range of the sorted particles;
+ *   2. subtrees below level `splitLevel` are built on separate threads and spliced into one array of
+ *      nodes in depth-first order; each node stores the index of the node after its subtree, so the
+ *      force walk is a forward scan through that array without a stack;
+ *   3. the force on each particle is accumulated by walking the tree, in Morton order so that
+ *      consecutive particles (and threads' blocks) visit the same nodes.
+ * The tree does not depend on the number of threads, so neither do the forces.
+ */
+template <std::size_t N>
+class BarnesHut {
+public:
+    /**
+     * Constructor for a Barnes-Hut force model.
+     * @param theta The opening angle; smaller is more accurate and slower.
+     * @param parameters The force law.
+     * @param leafSize The maximum number of particles in a leaf cell.
+     */
+    explicit BarnesHut(double theta = 0.5, GravityParameters parameters = GravityParameters(),
+                       std::size_t leafSize = 8)
+        : theta_(theta), parameters_(parameters), leafSize_(leafSize) {
+        if (!(theta >= 0.0)) {
+            throw std::invalid_argument("The Barnes-Hut opening angle must be non-negative.");
+        }
+        if (leafSize == 0) {
+            throw std::invalid_argument("The Barnes-Hut leaf size must be positive.");
+        }
+    }
+
+    /**
+     * Returns the opening angle.
+     */
+    double theta() const {
+        return theta_;
+    }
+
+    /**
+     * Sets the opening angle.
+     * @param theta The opening angle; smaller is more accurate and slower.
+     */
+    void setTheta(double theta) {
+        if (!(theta >= 0.0)) {
+            throw std::invalid_argument("The Barnes-Hut opening angle must be non-negative.");
+        }
+        theta_ = theta;
+    }
+
+    /**
+     * Returns the number of nodes of the tree built by the last computeForces call.
+     */
+    std::size_t nodeCount() const {
+        return nodes_.size();
+    }
+
+    /**
+     * Returns the number of particle-particle and particle-cell interactions of the last computeForces call.
+     */
+    std::uint64_t interactions() const {
+        return interactions_;
+    }
+
+    void computeForces(ParticleSystem<N>& system, double) {
+        const std::size_t count = system.size();
+        if (count > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::length_error("Too many particles for the Barnes-Hut tree.");
+        }
+        interactions_ = 0;
+        nodes_.clear();
+        if (count == 0) {
+            return;
+        }
+        sortParticles(system);
+        buildTree(system.pool());
+        walkTree(system);
+    }
+
+private:
+    // One cell of the tree; leaves hold the sorted particles [begin, end)
+    struct Node {
+        std::array<double, N> center; // Centre of mass
+        double mass;                  // Total mass
+        double size;                  // Side length of the cell
+        std::uint32_t next;           // Index of the first node after this subtree
+        std::uint32_t begin;          // First sorted particle in the cell
+        std::uint32_t end;            // One past the last sorted particle in the cell
+        std::uint32_t leaf;           // Whether the cell has no children
+    };
+
+    // Sort key: Morton code, then original index
+    struct Key {
+        std::uint64_t code;
+        std::uint32_t index;
+    };
+
+    // Levels built serially above the parallel subtrees: 8^2 = 64 subtrees in 3D, 4^3 = 64 in 2D
+    static constexpr unsigned splitLevel = N == 3 ? 2 : 3;
+
+    void sortParticles(const ParticleSystem<N>& system) {
+        const std::size_t count = system.size();
+        ThreadPool& pool = system.pool();
+
+        // Bounding cube
+        std::array<double, N> lower, upper;
+        for (std::size_t d = 0; d < N; ++d) {
+            const double* x = system.positions(d);
+            lower[d] = upper[d] = x[0];
+            for (std::size_t i = 1; i < count; ++i) {
+                lower[d] = std::min(lower[d], x[i]);
+                upper[d] = std::max(upper[d], x[i]);
+            }
+        }
+        double side = 0.0;
+        for (std::size_t d = 0; d < N; ++d) {
+            side = std::max(side, upper[d] - lower[d]);
+        }
+        side = side > 0.0 ? side * (1.0 + 1e-12) : 1.0;  // Keep the upper corner inside the box
+        side_ = side;
+        const MortonGrid<N> grid(lower, side);
+
+        keys_.resize(count);
+        parallelFor(count, pool, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                std::array<double, N> x;
+                for (std::size_t d = 0; d < N; ++d) {
+                    x[d] = system.positions(d)[i];
+                }
+                keys_[i] = {grid.code(x), static_cast<std::uint32_t>(i)};
+            }
+        });
+        parallelSort(keys_, [](const Key& a, const Key& b) { return a.code < b.code; }, pool);
+
+        // Copies of the positions and masses in Morton order, read by the tree build and the walk
+        codes_.resize(count);
+        mass_.resize(count);
+        for (std::size_t d = 0; d < N; ++d) {
+            position_[d].resize(count);
+        }
+        parallelFor(count, pool, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t s = begin; s < end; ++s) {
+                const std::uint32_t i = keys_[s].index;
+                codes_[s] = keys_[s].code;
+                mass_[s] = system.masses()[i];
+                for (std::size_t d = 0; d < N; ++d) {
+                    position_[d][s] = system.positions(d)[i];
+                }
+            }
+        });
+    }
+
+    // Splits the sorted particles [begin, end) of a cell at `level` into its non-empty children
+    void childRanges(std::size_t begin, std::size_t end, unsigned level,
+                     std::vector<std::pair<std::size_t, std::size_t>>& children) const {
+        const unsigned shift = (mortonBits<N>() - level - 1) * N;
+        const std::size_t childCount = std::size_t(1) << N;
+        children.clear();
+        std::size_t first = begin;
+        while (first < end) {
+            const std::uint64_t child = (codes_[first] >> shift) & (childCount - 1);
+            // Codes are sorted, so the child's particles end where the next child's prefix starts
+            const std::uint64_t limit = ((codes_[first] >> shift) + 1) << shift;
+            std::size_t last = child + 1 == childCount
+                                   ? end
+                                   : std::lower_bound(codes_.begin() + first, codes_.begin() + end, limit) -
+                                         codes_.begin();
+            children.emplace_back(first, last);
+            first = last;
+        }
+    }
+
+    bool isLeaf(std::size_t begin, std::size_t end, unsigned level) const {
+        return end - begin <= leafSize_ || level == mortonBits<N>();
+    }
+
+    // Sets the mass and centre of mass of a leaf from its particles
+    void finishLeaf(Node& node) const {
+        node.mass = 0.0;
+        node.center = {};
+        for (std::uint32_t s = node.begin; s < node.end; ++s) {
+            node.mass += mass_[s];
+            for (std::size_t d = 0; d < N; ++d) {
+                node.center[d] += mass_[s] * position_[d][s];
+            }
+        }
+        for (std::size_t d = 0; d < N; ++d) {
+            node.center[d] /= node.mass;
+        }
+    }
+
+    // Sets the mass and centre of mass of an internal node from its children
+    static void finishInternal(Node& node, const std::vector<Node>& nodes,
+                               const std::vector<std::size_t>& children) {
+        node.mass = 0.0;
+        node.center = {};
+        for (std::size_t c : children) {
+            node.mass += nodes[c].mass;
+            for (std::size_t d = 0; d < N; ++d) {
+                node.center[d] += nodes[c].mass * nodes[c].center[d];
+            }
+        }
+        for (std::size_t d = 0; d < N; ++d) {
+            node.center[d] /= node.mass;
+        }
+    }
+
+    // Appends the subtree of the cell [begin, end) at `level` to `nodes` in depth-first order
+    void buildSubtree(std::vector<Node>& nodes, std::size_t begin, std::size_t end, unsigned level) const {
+        const std::size_t index = nodes.size();
+        Node node{};
+        node.size = std::ldexp(side_, -static_cast<int>(level));
+        node.begin = static_cast<std::uint32_t>(begin);
+        node.end = static_cast<std::uint32_t>(end);
+        node.leaf = isLeaf(begin, end, level);
+        nodes.push_back(node);
+
+        if (node.leaf) {
+            finishLeaf(nodes[index]);
+        } else {
+            std::vector<std::pair<std::size_t, std::size_t>> ranges;
+            childRanges(begin, end, level, ranges);
+            std::vector<std::size_t> children;
+            for (const auto& range : ranges) {
+                children.push_back(nodes.size());
+                buildSubtree(nodes, range.first, range.second, level + 1);
+            }
+            finishInternal(nodes[index], nodes, children);
+        }
+        nodes[index].next = static_cast<std::uint32_t>(nodes.size());
+    }
+
+    // Builds the levels above splitLevel, splicing in the subtrees built in parallel
+    void buildTop(std::size_t begin, std::size_t end, unsigned level, std::size_t& task) {
+        if (level == splitLevel || isLeaf(begin, end, level)) {
+            // Subtrees are consumed in the same depth-first order in which they were collected
+            const std::vector<Node>& subtree = subtrees_[task++];
+            const std::uint32_t offset = static_cast<std::uint32_t>(nodes_.size());
+            for (Node node : subtree) {
+                node.next += offset;
+                nodes_.push_back(node);
+            }
+            return;
+        }
+
+        const std::size_t index = nodes_.size();
+        Node node{};
+        node.size = std::ldexp(side_, -static_cast<int>(level));
+        node.begin = static_cast<std::uint32_t>(begin);
+        node.end = static_cast<std::uint32_t>(end);
+        node.leaf = 0;
+        nodes_.push_back(node);
+
+        std::vector<std::pair<std::size_t, std::size_t>> ranges;
+        childRanges(begin, end, level, ranges);
+        std::vector<std::size_t> children;
+        for (const auto& range : ranges) {
+            children.push_back(nodes_.size());
+            buildTop(range.first, range.second, level + 1, task);
+        }
+        finishInternal(nodes_[index], nodes_, children);
+        nodes_[index].next = static_cast<std::uint32_t>(nodes_.size());
+    }
+
+    // Collects the cells at which buildTop stops, in depth-first order
+    void collectTasks(std::size_t begin, std::size_t end, unsigned level,
+                      std::vector<std::array<std::size_t, 3>>& tasks) const {
+        if (level == splitLevel || isLeaf(begin, end, level)) {
+            tasks.push_back({begin, end, level});
+            return;
+        }
+        std::vector<std::pair<std::size_t, std::size_t>> ranges;
+        childRanges(begin, end, level, ranges);
+        for (const auto& range : ranges) {
+            collectTasks(range.first, range.second, level + 1, tasks);
+        }
+    }
+
+    void buildTree(ThreadPool& pool) {
+        const std::size_t count = codes_.size();
+        std::vector<std::array<std::size_t, 3>> tasks;
+        collectTasks(0, count, 0, tasks);
+
+        subtrees_.resize(tasks.size());
+        parallelFor(tasks.size(), pool, [&](std::size_t first, std::size_t last) {
+            for (std::size_t t = first; t < last; ++t) {
+                subtrees_[t].clear();
+                buildSubtree(subtrees_[t], tasks[t][0], tasks[t][1], static_cast<unsigned>(tasks[t][2]));
+            }
+        }, 1);
+
+        std::size_t task = 0;
+        buildTop(0, count, 0, task);
+    }
+
+    // Adds the force of the sorted particles of a leaf on sorted particle s (skipping s itself)
+    void addLeaf(const Node& node, std::size_t s, const std::array<double, N>& x, double eps2,
+                 std::array<double, N>& force) const {
+        for (std::uint32_t j = node.begin; j < node.end; ++j) {
+            if (j == s) {
+                continue;
+            }
+            std::array<double, N> dx;
+            double r2 = eps2;
+            for (std::size_t d = 0; d < N; ++d) {
+                dx[d] = position_[d][j] - x[d];
+                r2 += dx[d] * dx[d];
+            }
+            const double scale = mass_[j] / (r2 * std::sqrt(r2));
+            for (std::size_t d = 0; d < N; ++d) {
+                force[d] += scale * dx[d];
+            }
+        }
+    }
+
+    void walkTree(ParticleSystem<N>& system) {
+        const std::size_t count = codes_.size();
+        const double eps2 = parameters_.softening * parameters_.softening;
+        const double theta2 = theta_ * theta_;
+        const std::uint32_t nodeCount = static_cast<std::uint32_t>(nodes_.size());
+
+        // Threads write the forces of disjoint particles; only the interaction count is shared
+        std::mutex countMutex;
+        parallelFor(count, system.pool(), [&](std::size_t begin, std::size_t end) {
+            std::uint64_t local = 0;
+            for (std::size_t s = begin; s < end; ++s) {
+                std::array<double, N> x, force{};
+                for (std::size_t d = 0; d < N; ++d) {
+                    x[d] = position_[d][s];
+                }
+                std::uint32_t n = 0;
+                while (n < nodeCount) {
+                    const Node& node = nodes_[n];
+                    std::array<double, N> dx;
+                    double d2 = 0.0;
+                    for (std::size_t d = 0; d < N; ++d) {
+                        dx[d] = node.center[d] - x[d];
+                        d2 += dx[d] * dx[d];
+                    }
+                    const bool contains = node.begin <= s && s < node.end;
+                    if (!contains && node.size * node.size < theta2 * d2) {
+                        // Far enough away: the whole cell acts as a point mass at its centre of mass
+                        const double r2 = d2 + eps2;
+                        const double scale = node.mass / (r2 * std::sqrt(r2));
+                        for (std::size_t d = 0; d < N; ++d) {
+                            force[d] += scale * dx[d];
+                        }
+                        ++local;
+                        n = node.next;
+                    } else if (node.leaf) {
+                        addLeaf(node, s, x, eps2, force);
+                        local += node.end - node.begin - (contains ? 1 : 0);
+                        n = node.next;
+                    } else {
+                        ++n;  // Open the cell: its first child follows it
+                    }
+                }
+                const std::uint32_t i = keys_[s].index;
+                const double gm = parameters_.G * mass_[s];
+                for (std::size_t d = 0; d < N; ++d) {
+                    system.forces(d)[i] = gm * force[d];
+                }
+            }
+            std::lock_guard<std::mutex> lock(countMutex);
+            interactions_ += local;
+        });
+    }
+
+    double theta_;                              // Opening angle
+    GravityParameters parameters_;              // Force law
+    std::size_t leafSize_;                      // Maximum particles per leaf
+    double side_ = 1.0;                         // Side of the root cell
+    std::vector<Key> keys_;                     // Morton codes and original indices, sorted
+    std::vector<std::uint64_t> codes_;          // Sorted Morton codes
+    std::array<std::vector<double>, N> position_;  // Positions in Morton order
+    std::vector<double> mass_;                  // Masses in Morton order
+    std::vector<Node> nodes_;                   // The tree in depth-first order
+    std::vector<std::vector<Node>> subtrees_;   // Subtrees built in parallel
+    std::uint64_t interactions_ = 0;            // Interactions of the last walk
+};
+
+#endif // BARNES_HUT_H
@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "barnes_hut.h"
+
+using namespace std;
+
+/**
+ * Seconds elapsed since `start`.
+ */
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Benchmarks the Barnes-Hut force model on a Plummer-like cluster of 3D particles for several
+ * opening angles, and checks its accuracy against direct summation on a sample of particles.
+ * The error is |F_bh - F_direct| / |F_direct| averaged over the sample (and its maximum).
+ * Usage: bench_barnes_hut.x [particles] [threads] [samples]
+ */
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 100000;
+    unsigned threads = argc > 2 ? atoi(argv[2]) : 0;
+    size_t samples = argc > 3 ? strtoull(argv[3], nullptr, 10) : 200;
+
+    GravityParameters gravity;
+    gravity.G = 1.0 / count;  // Total mass 1 in units of G
+    gravity.softening = 1e-3;
+
+    ParticleSystem<3> system(count, threads);
+    mt19937_64 rng(2024);
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+    for (size_t i = 0; i < count; ++i) {
+        // Plummer sphere radius from the inverse cumulative mass, random direction
+        double r = 1.0 / sqrt(pow(uniform(rng) * 0.999, -2.0 / 3.0) - 1.0);
+        double z = 2.0 * uniform(rng) - 1.0, phi = 2.0 * M_PI * uniform(rng);
+        double rho = r * sqrt(1.0 - z * z);
+        system.setParticle(i, 1.0, Vector(rho * cos(phi), rho * sin(phi), r * z), Vector(0.0, 0.0, 0.0));
+    }
+    cout << count << " particles, " << system.threads() << " thread(s)" << endl;
+
+    DirectSum<3> direct(gravity);
+    vector<size_t> sample(samples);
+    vector<Vector<double, 3>> reference(samples);
+    auto start = chrono::steady_clock::now();
+    for (size_t k = 0; k < samples; ++k) {
+        sample[k] = (k * count) / samples;
+        reference[k] = direct.forceOn(system, sample[k]);
+    }
+    double direct_seconds = secondsSince(start) * count / samples;
+    cout << "Direct sum: " << direct_seconds << " s per evaluation (extrapolated from " << samples << " particles)"
+         << endl;
+
+    for (double theta : {0.3, 0.5, 0.7, 1.0}) {
+        BarnesHut<3> tree(theta, gravity);
+        system.computeForces(tree, 0.0);  // Warm-up
+        start = chrono::steady_clock::now();
+        system.computeForces(tree, 0.0);
+        double seconds = secondsSince(start);
+
+        double mean_error = 0.0, max_error = 0.0;
+        for (size_t k = 0; k < samples; ++k) {
+            Vector<double, 3> error = system.getForce(sample[k]) - reference[k];
+            double relative = sqrt((error * error) / (reference[k] * reference[k]));
+            mean_error += relative / samples;
+            max_error = max(max_error, relative);
+        }
+        cout << "theta = " << theta << ": " << seconds << " s per evaluation ("
+             << static_cast<double>(tree.interactions()) / count << " interactions per particle, "
+             << tree.nodeCount() << " nodes), speedup over direct " << direct_seconds / seconds
+             << "x, relative error mean " << mean_error << " max " << max_error << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "ensemble.h"
+
+using namespace std;
+
+// Array-of-structures layout of Particle<3> (without its logging), the baseline for the benchmark
+struct ParticleRecord {
+    double mass;
+    Vector<double, 3> position, velocity, force;
+};
+
+/**
+ * Seconds elapsed since `start`.
+ */
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Whether every particle of the system is at the position of the matching record.
+ */
+static bool samePositions(const ParticleSystem<3>& system, const vector<ParticleRecord>& records) {
+    for (size_t i = 0; i < records.size(); ++i) {
+        for (size_t d = 0; d < 3; ++d) {
+            if (system.getPosition(i)[d] != records[i].position[d]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Benchmarks an ensemble of independent 3D particles in the sinusoidal external field, with the
+ * mean and variance of the positions taken after every step:
+ * an array of Particle-like records that each evaluate the force, ParticleSystem<3>::stepEuler
+ * (one force evaluation and one pass over the arrays per step), and runEnsemble from a force table
+ * (each thread takes its particles through all the steps) on 1, 2, 4, ... threads.
+ * Usage: bench_ensemble.x [particles] [steps] [max_threads]
+ */
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 100000;
+    size_t steps = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000;
+    unsigned max_threads = resolveThreadCount(argc > 3 ? atoi(argv[3]) : 0);
+    const double dt = 0.02;
+
+    cout << count << " particles, " << steps << " steps, up to " << max_threads << " threads" << endl;
+
+    auto initialPosition = [](size_t i) { return Vector<double, 3>(1e-6 * i, -2e-6 * i, 0.5); };
+    auto initialVelocity = [](size_t i) { return Vector<double, 3>(0.0, 1e-7 * i, -1.0); };
+
+    vector<ParticleRecord> records(count);
+    RunningStatistics<3> record_final;
+    {
+        for (size_t i = 0; i < count; ++i) {
+            records[i] = {1.0, initialPosition(i), initialVelocity(i), Vector<double, 3>()};
+        }
+        auto start = chrono::steady_clock::now();
+        double t = 0.0;
+        for (size_t s = 0; s < steps; ++s) {
+            RunningStatistics<3> statistics;
+            for (ParticleRecord& p : records) {
+                p.force = externalForce<3>(t);
+                p.velocity = p.velocity + p.force * (1.0 / p.mass) * dt;
+                p.position = p.position + p.velocity * dt;
+                statistics.add(p.position);
+            }
+            record_final = statistics;
+            t += dt;
+        }
+        double seconds = secondsSince(start);
+        cout << "Array of Particle records, Welford statistics: " << count * steps / seconds
+             << " particle steps/s" << endl;
+    }
+
+    ParticleSystem<3> system(count, 1);
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        system.setThreads(threads);
+        for (size_t i = 0; i < count; ++i) {
+            system.setParticle(i, 1.0, initialPosition(i), initialVelocity(i));
+        }
+        RunningStatistics<3> statistics;
+        auto start = chrono::steady_clock::now();
+        double t = 0.0;
+        for (size_t s = 0; s < steps; ++s) {
+            system.stepEuler(ExternalField<3>(), t, dt);
+            statistics = RunningStatistics<3>();
+            for (size_t i = 0; i < count; ++i) {
+                statistics.add(system.getPosition(i));
+            }
+            t += dt;
+        }
+        double seconds = secondsSince(start);
+        cout << "ParticleSystem<3>::stepEuler, Welford statistics, " << threads << " thread(s): "
+             << count * steps / seconds << " particle steps/s"
+             << (samePositions(system, records) ? "" : " (POSITIONS DIFFER)")
+             << (statistics.mean()[0] == record_final.mean()[0] ? "" : " (STATISTICS DIFFER)") << endl;
+    }
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        system.setThreads(threads);
+        for (size_t i = 0; i < count; ++i) {
+            system.setParticle(i, 1.0, initialPosition(i), initialVelocity(i));
+        }
+        auto start = chrono::steady_clock::now();
+        ForceTable<3> table(0.0, dt, steps);
+        vector<EnsembleSample<3>> samples = runEnsemble(system, table);
+        double seconds = secondsSince(start);
+
+        const RunningStatistics<3>& last = samples.back().statistics;
+        Vector<double, 3> difference = last.mean() - record_final.mean();
+        cout << "runEnsemble with a force table, " << threads << " thread(s): " << count * steps / seconds
+             << " particle steps/s" << (samePositions(system, records) ? "" : " (POSITIONS DIFFER)")
+             << ", final mean differs from Welford by " << sqrt(difference * difference) << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "integrator.h"
+#include "particle.h"
+
+using namespace std;
+
+/**
+ * Integrates x'' = F(t) / m from t = 0 to t_end in steps of at most dt and returns the position error
+ * against exactMotion.
+ */
+static double positionError(Integrator<3>& integrator, double dt, double t_end) {
+    const double mass = 2.0;
+    const Vector<double, 3> x0(1.0, -0.5, 0.25), v0(0.0, 0.5, -1.0);
+    auto acceleration = [mass](double t, const Vector<double, 3>&, const Vector<double, 3>&) {
+        return Vector<double, 3>(externalForce<3>(t) * (1.0 / mass));
+    };
+    Vector<double, 3> x = x0, v = v0;
+    double t = 0.0;
+    while (t < t_end) {
+        t += integrator.step(acceleration, t, clampStep(t, t_end, dt), x, v);
+    }
+    Vector<double, 3> exact_x, exact_v;
+    exactMotion<3>(t_end, mass, x0, v0, exact_x, exact_v);
+    Vector<double, 3> error = x - exact_x;
+    return sqrt(error * error);
+}
+
+/**
+ * Reports, for each integrator, the force evaluations needed to bring the position error of a 3D
+ * particle (mass 2) at t = 40 below a target: fixed-step methods halve dt until the target is met,
+ * down to dt = 2^-19, Dormand-Prince tightens its tolerance by factors of 10.
+ * Usage: bench_integrators.x [target_error]
+ */
+int main(int argc, char* argv[]) {
+    const double target = argc > 1 ? atof(argv[1]) : 1e-6;
+    const double t_end = 40.0;
+    cout << "Force evaluations to reach a position error below " << target << " at t = " << t_end << endl;
+
+    vector<function<unique_ptr<Integrator<3>>()>> factories = {
+        [] { return make_unique<EulerIntegrator<3>>(); },
+        [] { return make_unique<VelocityVerletIntegrator<3>>(); },
+        [] { return make_unique<LeapfrogIntegrator<3>>(); },
+        [] { return make_unique<RK4Integrator<3>>(); },
+    };
+    for (const auto& factory : factories) {
+        unique_ptr<Integrator<3>> integrator;
+        double dt = 0.5, error = 0.0;
+        for (int halvings = 0; halvings <= 18; ++halvings, dt /= 2.0) {
+            integrator = factory();
+            error = positionError(*integrator, dt, t_end);
+            if (error < target) break;
+        }
+        cout << "  " << integrator->name() << ": dt = " << dt << ", " << integrator->getForceEvaluations()
+             << " evaluations, error " << error << (error < target ? "" : " (target not reached)") << endl;
+    }
+
+    for (double tolerance = 1e-3; tolerance > 1e-14; tolerance /= 10.0) {
+        DormandPrinceIntegrator<3> integrator(tolerance, tolerance);
+        double error = positionError(integrator, t_end, t_end);
+        if (error < target) {
+            cout << "  " << integrator.name() << ": tolerance " << tolerance << ", "
+                 << integrator.getForceEvaluations() << " evaluations (" << integrator.getAcceptedSteps()
+                 << " steps, " << integrator.getRejectedSteps() << " rejected), error " << error << endl;
+            break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "neighbor_list.h"
+
+using namespace std;
+
+/**
+ * Seconds elapsed since `start`.
+ */
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Places `count` particles on a cubic lattice at the given number density, with random velocities.
+ */
+static void setUpFluid(ParticleSystem<3>& system, size_t count, double density) {
+    size_t side = static_cast<size_t>(ceil(cbrt(static_cast<double>(count))));
+    double spacing = cbrt(1.0 / density);
+    mt19937_64 rng(7);
+    normal_distribution<double> velocity(0.0, 1.0);
+    system.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        size_t ix = i % side, iy = (i / side) % side, iz = i / (side * side);
+        system.setParticle(i, 1.0, Vector(ix * spacing, iy * spacing, iz * spacing),
+                           Vector(velocity(rng), velocity(rng), velocity(rng)));
+    }
+}
+
+/**
+ * Runs velocity Verlet steps of a Lennard-Jones fluid with the cell list / Verlet list force model,
+ * with and without Morton reordering, and reports the pair interactions evaluated per second.
+ * Usage: bench_neighbor_list.x [particles] [steps] [threads]
+ */
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 200000;
+    long steps = argc > 2 ? atol(argv[2]) : 20;
+    unsigned threads = argc > 3 ? atoi(argv[3]) : 0;
+    const double dt = 0.002, density = 0.8;
+
+    for (bool reorder : {false, true}) {
+        ParticleSystem<3> system(0, threads);
+        setUpFluid(system, count, density);
+        if (!reorder) {
+            // Start from a random memory order, as particles end up after mixing for a while
+            vector<size_t> order(count);
+            for (size_t i = 0; i < count; ++i) {
+                order[i] = i;
+            }
+            shuffle(order.begin(), order.end(), mt19937_64(11));
+            system.permute(order);
+        }
+
+        LennardJonesParameters parameters;
+        parameters.reorder = reorder;
+        LennardJones<3> lj(parameters);
+
+        auto start = chrono::steady_clock::now();
+        system.computeForces(lj, 0.0);
+        double build_seconds = secondsSince(start);
+
+        double pairs = 0.0;
+        start = chrono::steady_clock::now();
+        for (long s = 0; s < steps; ++s) {
+            system.stepVerlet(lj, s * dt, dt);
+            pairs += lj.pairsEvaluated();
+        }
+        double seconds = secondsSince(start);
+
+        cout << count << " particles, " << system.threads() << " thread(s), Morton reorder "
+             << (reorder ? "on" : "off") << ": first build " << build_seconds << " s, " << steps << " steps in "
+             << seconds << " s, " << pairs / seconds << " pairs/s, "
+             << lj.neighborList().pairCount() / static_cast<double>(count) << " neighbours per particle, "
+             << lj.neighborList().rebuilds() << " list builds" << endl;
+    }
+
+    return 0;
+}
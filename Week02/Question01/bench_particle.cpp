@@ -0,0 +1,269 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "vector.h"
+#include "particle.h"
+
+using namespace std;
+
+// Original heap-backed Vector class, kept verbatim (renamed) as the baseline for the benchmark
+class LegacyVector {
+private:
+    vector<double> components_; // Holds the components of the vector
+
+public:
+    /**
+     * Constructor to initialize the vector with a given set of components.
+     * @param components A vector of doubles representing the components of the vector.
+     */
+    LegacyVector(vector<double> components) : components_(components) {}
+
+    /**
+     * Constructor to initialize a 2D vector with x and y components.
+     * @param x The x component of the vector.
+     * @param y The y component of the vector.
+     */
+    LegacyVector(double x, double y) : components_{x, y} {}
+
+    /**
+     * Constructor to initialize a 3D vector with x, y, and z components.
+     * @param x The x component of the vector.
+     * @param y The y component of the vector.
+     * @param z The z component of the vector.
+     */
+    LegacyVector(double x, double y, double z) : components_{x, y, z} {}
+
+    /**
+     * Destructor for the Vector class.
+     */
+    ~LegacyVector() {}
+
+    /**
+     * Returns the number of components in the vector (size).
+     * @return The size of the vector as a size_t.
+     */
+    size_t size() const {
+        return components_.size();  // Return the number of components
+    }
+
+    /**
+     * Returns the components of the vector as a reference.
+     * @return A reference to the vector of components.
+     */
+    const vector<double>& getComponents() const {
+        return components_;
+    }
+
+    /**
+     * Overloaded addition operator to add two vectors element-wise.
+     * Throws an error if the vector sizes do not match.
+     * @param other The vector to add to the current vector.
+     * @return A new vector that is the element-wise sum of the two vectors.
+     */
+    LegacyVector operator+(const LegacyVector &other) const {
+        if (components_.size() != other.size()) {
+            throw runtime_error("Vector sizes must match for addition.");
+        }
+        vector<double> result(components_.size());
+        for (size_t i = 0; i < components_.size(); ++i) {
+            result[i] = components_[i] + other.components_[i];
+        }
+        return LegacyVector(result);
+    }
+
+    /**
+     * Overloaded subtraction operator to subtract one vector from another element-wise.
+     * Throws an error if the vector sizes do not match.
+     * @param other The vector to subtract from the current vector.
+     * @return A new vector that is the element-wise difference of the two vectors.
+     */
+    LegacyVector operator-(const LegacyVector &other) const {
+        if (components_.size() != other.size()) {
+            throw runtime_error("Vector sizes must match for subtraction.");
+        }
+        vector<double> result(components_.size());
+        for (size_t i = 0; i < components_.size(); ++i) {
+            result[i] = components_[i] - other.components_[i];
+        }
+        return LegacyVector(result);
+    }
+
+    /**
+     * Overloaded multiplication operator to scale a vector by a scalar.
+     * @param scalar The scalar value to multiply each component of the vector by.
+     * @return A new vector with each component scaled by the scalar.
+     */
+    LegacyVector operator*(const double &scalar) const {
+        vector<double> result(components_.size());
+        for (size_t i = 0; i < components_.size(); ++i) {
+            result[i] = components_[i] * scalar;
+        }
+        return LegacyVector(result);
+    }
+
+    /**
+     * Overloaded multiplication operator to compute the dot product of two vectors.
+     * Throws an error if the vector sizes do not match.
+     * @param other The vector to compute the dot product with.
+     * @return The scalar result of the dot product.
+     */
+    double operator*(const LegacyVector &other) const {
+        if (components_.size() != other.size()) {
+            throw runtime_error("Vector sizes must match for dot product.");
+        }
+        double result = 0.0;
+        for (size_t i = 0; i < components_.size(); ++i) {
+            result += components_[i] * other.components_[i];
+        }
+        return result;
+    }
+
+    /**
+     * Overloaded output stream operator to print the vector in the form (x, y) or (x, y, z).
+     * @param os The output stream.
+     * @param v The vector to be printed.
+     * @return The output stream with the formatted vector.
+     */
+    friend ostream &operator<<(ostream &os, const LegacyVector &v) {
+        os << "(";
+        for (size_t i = 0; i < v.size(); ++i) {
+            os << v.components_[i];
+            if (i < v.size() - 1) os << ", ";
+        }
+        os << ")";
+        return os;
+    }
+};
+
+// Original Particle class using LegacyVector
+class LegacyParticle {
+public:
+    /**
+     * Constructor to initialize a particle with its mass, position, velocity, and force.
+     * @param mass The mass of the particle.
+     * @param position The initial position vector of the particle.
+     * @param velocity The initial velocity vector of the particle.
+     * @param force The initial force vector acting on the particle.
+     */
+    LegacyParticle(double mass, const LegacyVector &position, const LegacyVector &velocity, const LegacyVector &force)
+        : mass_(mass), position_(position), velocity_(velocity), force_(force) {
+        cout << "Particle created at position " << position_ << endl;
+    }
+
+    /**
+     * Destructor for the Particle class.
+     */
+    ~LegacyParticle() {
+        cout << "Particle destroyed at position " << position_ << endl;
+    }
+
+    /**
+     * Updates the particle's position using Euler's method.
+     * The new position is computed based on the velocity and time step.
+     * @param dt The time step for updating the position.
+     */
+    void updatePosition(double dt) {
+        position_ = position_ + velocity_ * dt;  // Update position using velocity and time step
+    }
+
+    /**
+     * Prints the current state of the particle, including its position and velocity.
+     */
+    void printState() const {
+        cout << "Particle - Position: " << position_ << ", Velocity: " << velocity_ << endl;
+    }
+
+    /**
+     * Updates the particle's velocity and position based on sinusoidal forces.
+     * For 2D particles, the force follows the pattern (sin(2t), cos(2t)).
+     * For 3D particles, the force follows the pattern (sin(2t), cos(2t), cos(1.5t)).
+     * @param t The current time.
+     * @param dt The time step for updating velocity and position.
+     */
+    void update(double t, double dt) {
+        // Set sinusoidal force based on the dimension (2D or 3D)
+        if (position_.size() == 2) {
+            force_ = LegacyVector(sin(2.0 * t), cos(2.0 * t));  // 2D case
+        } else if (position_.size() == 3) {
+            force_ = LegacyVector(sin(2.0 * t), cos(2.0 * t), cos(1.5 * t));  // 3D case
+        }
+
+        // Update velocity using Euler's method: v_{n+1} = v_n + dt * F_n
+        velocity_ = velocity_ + force_ * dt;
+
+        // Update position using Euler's method: P_{n+1} = P_n + dt * v_n
+        updatePosition(dt);
+    }
+
+    /**
+     * Returns the current position of the particle.
+     * @return A reference to the position vector of the particle.
+     */
+    const LegacyVector& getPosition() const {
+        return position_;
+    }
+
+private:
+    double mass_;     // The mass of the particle
+    LegacyVector position_; // The current position of the particle
+    LegacyVector velocity_; // The current velocity of the particle
+    LegacyVector force_;    // The force acting on the particle
+};
+
+/**
+ * Times `steps` calls of update() on a particle and returns the steps per second.
+ * @param particle The particle to advance.
+ * @param steps The number of time steps.
+ * @param dt The time step.
+ * @param checksum Receives the sum of the final position components, so the work cannot be optimized away.
+ */
+template <typename ParticleType>
+double stepsPerSecond(ParticleType& particle, long steps, double dt, double& checksum) {
+    auto start = chrono::steady_clock::now();
+    double t = 0.0;
+    for (long s = 0; s < steps; ++s) {
+        particle.update(t, dt);
+        t += dt;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    checksum = 0.0;
+    for (double comp : particle.getPosition().getComponents()) {
+        checksum += comp;
+    }
+    return steps / seconds;
+}
+
+/**
+ * Benchmarks Particle::update with the heap-backed LegacyVector and with Vector<double, N>.
+ * Usage: bench_particle.x [steps]
+ */
+int main(int argc, char* argv[]) {
+    long steps = argc > 1 ? atol(argv[1]) : 10000000;
+    const double dt = 0.02;
+
+    double legacy_sum, fixed_sum;
+
+    LegacyParticle legacy2D(1.0, LegacyVector(0.0, 0.0), LegacyVector(0.0, 0.0), LegacyVector(0.0, 0.0));
+    Particle fixed2D(1.0, Vector(0.0, 0.0), Vector(0.0, 0.0), Vector(0.0, 0.0));
+    double legacy2D_rate = stepsPerSecond(legacy2D, steps, dt, legacy_sum);
+    double fixed2D_rate = stepsPerSecond(fixed2D, steps, dt, fixed_sum);
+    cout << "2D: heap Vector " << legacy2D_rate << " steps/s, Vector<double, 2> " << fixed2D_rate
+         << " steps/s, speedup " << fixed2D_rate / legacy2D_rate << "x"
+         << (legacy_sum == fixed_sum ? " (same trajectory)" : " (TRAJECTORIES DIFFER)") << endl;
+
+    LegacyParticle legacy3D(1.0, LegacyVector(0.0, 0.0, 0.0), LegacyVector(0.0, 0.0, 0.0),
+                            LegacyVector(0.0, 0.0, 0.0));
+    Particle fixed3D(1.0, Vector(0.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0));
+    double legacy3D_rate = stepsPerSecond(legacy3D, steps, dt, legacy_sum);
+    double fixed3D_rate = stepsPerSecond(fixed3D, steps, dt, fixed_sum);
+    cout << "3D: heap Vector " << legacy3D_rate << " steps/s, Vector<double, 3> " << fixed3D_rate
+         << " steps/s, speedup " << fixed3D_rate / legacy3D_rate << "x"
+         << (legacy_sum == fixed_sum ? " (same trajectory)" : " (TRAJECTORIES DIFFER)") << endl;
+
+    return 0;
+}
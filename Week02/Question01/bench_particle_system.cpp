@@ -0,0 +1,101 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "particle_system.h"
+
+using namespace std;
+
+// Array-of-structures layout of Particle<3> (without its logging), the baseline for the benchmark
+struct ParticleRecord {
+    double mass;
+    Vector<double, 3> position, velocity, force;
+};
+
+/**
+ * Seconds elapsed since `start`.
+ */
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Benchmarks stepping a population of 3D particles in the sinusoidal external field:
+ * an array of Particle-like records updated one at a time, and ParticleSystem<3> with the
+ * Euler and velocity Verlet kernels on 1, 2, 4, ... threads.
+ * Usage: bench_particle_system.x [particles] [steps] [max_threads]
+ */
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    long steps = argc > 2 ? atol(argv[2]) : 10;
+    unsigned max_threads = resolveThreadCount(argc > 3 ? atoi(argv[3]) : 0);
+    const double dt = 0.02;
+
+    cout << count << " particles, " << steps << " steps, up to " << max_threads << " threads" << endl;
+
+    // Initial conditions shared by both layouts
+    auto initialPosition = [](size_t i) { return Vector<double, 3>(1e-6 * i, -2e-6 * i, 0.5); };
+    auto initialVelocity = [](size_t i) { return Vector<double, 3>(0.0, 1e-7 * i, -1.0); };
+
+    double aos_sum = 0.0;
+    {
+        vector<ParticleRecord> particles(count);
+        for (size_t i = 0; i < count; ++i) {
+            particles[i] = {1.0, initialPosition(i), initialVelocity(i), Vector<double, 3>()};
+        }
+        auto start = chrono::steady_clock::now();
+        double t = 0.0;
+        for (long s = 0; s < steps; ++s) {
+            for (ParticleRecord& p : particles) {
+                p.force = externalForce<3>(t);
+                p.velocity = p.velocity + p.force * dt;
+                p.position = p.position + p.velocity * dt;
+            }
+            t += dt;
+        }
+        double seconds = secondsSince(start);
+        for (const ParticleRecord& p : particles) {
+            aos_sum += p.position[0] + p.position[1] + p.position[2];
+        }
+        cout << "Array of Particle records, Euler: " << count * steps / seconds << " particle steps/s" << endl;
+    }
+
+    ParticleSystem<3> system(count, 1);
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        system.setThreads(threads);
+        for (const char* method : {"Euler", "Verlet"}) {
+            bool euler = string(method) == "Euler";
+            for (size_t i = 0; i < count; ++i) {
+                system.setParticle(i, 1.0, initialPosition(i), initialVelocity(i));
+            }
+
+            auto start = chrono::steady_clock::now();
+            double t = 0.0;
+            for (long s = 0; s < steps; ++s) {
+                if (euler) {
+                    system.stepEuler(ExternalField<3>(), t, dt);
+                } else {
+                    system.stepVerlet(ExternalField<3>(), t, dt);
+                }
+                t += dt;
+            }
+            double seconds = secondsSince(start);
+
+            double sum = 0.0;
+            for (size_t i = 0; i < count; ++i) {
+                Vector<double, 3> x = system.getPosition(i);
+                sum += x[0] + x[1] + x[2];
+            }
+            cout << "ParticleSystem<3>, " << method << ", " << threads << " thread(s): "
+                 << count * steps / seconds << " particle steps/s";
+            if (euler) {
+                cout << (sum == aos_sum ? " (same positions as the records)" : " (POSITIONS DIFFER)");
+            }
+            cout << endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "particle.h"
+#include "trajectory.h"
+
+using namespace std;
+
+/**
+ * Seconds elapsed since `start`.
+ */
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Size of a file in bytes.
+ */
+static long long fileSize(const string& filename) {
+    ifstream file(filename, ios::binary | ios::ate);
+    return static_cast<long long>(file.tellg());
+}
+
+/**
+ * Writes a 3D trajectory as text, the way simulateAndPlot does, and returns the seconds taken.
+ */
+static double writeText(const string& filename, long steps, double dt) {
+    Particle particle(1.0, Vector(0.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0));
+    auto start = chrono::steady_clock::now();
+    ofstream file(filename);
+    file << "time,x,y,z\n";
+    double t = 0.0;
+    for (long s = 0; s < steps; ++s) {
+        particle.update(t, dt);
+        file << t;
+        for (double comp : particle.getPosition().getComponents()) {
+            file << "," << comp;
+        }
+        file << "\n";
+        t += dt;
+    }
+    file.close();
+    return secondsSince(start);
+}
+
+/**
+ * Writes a 3D trajectory through TrajectoryWriter and returns the seconds taken.
+ */
+static double writeBinary(const string& filename, long steps, double dt, const TrajectoryOptions& options,
+                          uint64_t& frames) {
+    Particle particle(1.0, Vector(0.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0));
+    auto start = chrono::steady_clock::now();
+    TrajectoryWriter<3> writer(filename, options);
+    writer.write(0, 0.0, particle.getPosition(), particle.getVelocity());
+    double t = 0.0;
+    for (long s = 0; s < steps; ++s) {
+        particle.update(t, dt);
+        t += dt;
+        writer.write(s + 1, t, particle.getPosition(), particle.getVelocity());
+    }
+    writer.close();
+    frames = writer.framesWritten();
+    return secondsSince(start);
+}
+
+/**
+ * Benchmarks writing the trajectory of a 3D particle: text through ofstream (as simulateAndPlot),
+ * and the binary trajectory file without loss, decimated and downsampled to an error bound.
+ * Also times random access to single steps of the downsampled file.
+ * Usage: bench_trajectory.x [steps]
+ */
+int main(int argc, char* argv[]) {
+    long steps = argc > 1 ? atol(argv[1]) : 2000000;
+    const double dt = 0.002;
+
+    double seconds = writeText("bench_trajectory.txt", steps, dt);
+    cout << "Text (ofstream, 6 digits): " << steps / seconds << " steps/s, "
+         << fileSize("bench_trajectory.txt") << " bytes" << endl;
+    remove("bench_trajectory.txt");
+
+    struct Setting {
+        const char* name;
+        uint64_t every;
+        double tolerance;
+    };
+    for (Setting setting : {Setting{"all frames", 1, 0.0}, Setting{"every 10th frame", 10, 0.0},
+                            Setting{"tolerance 1e-4", 1, 1e-4}, Setting{"tolerance 1e-3", 1, 1e-3}}) {
+        TrajectoryOptions options;
+        options.every = setting.every;
+        options.tolerance = setting.tolerance;
+        uint64_t frames = 0;
+        seconds = writeBinary("bench_trajectory.traj", steps, dt, options, frames);
+        cout << "Binary, " << setting.name << ": " << steps / seconds << " steps/s, " << frames << " frames, "
+             << fileSize("bench_trajectory.traj") << " bytes" << endl;
+    }
+
+    // Random access by step number in the last (downsampled) file
+    TrajectoryReader<3> reader("bench_trajectory.traj");
+    const long lookups = 100000;
+    double sum = 0.0;
+    auto start = chrono::steady_clock::now();
+    for (long i = 0; i < lookups; ++i) {
+        sum += reader.positionAt(static_cast<uint64_t>((i * 7919) % (steps + 1)))[0];
+    }
+    seconds = secondsSince(start);
+    cout << "positionAt: " << seconds / lookups * 1e6 << " us per random step (checksum " << sum << ")" << endl;
+    remove("bench_trajectory.traj");
+
+    return 0;
+}
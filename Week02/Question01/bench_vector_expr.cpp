@@ -0,0 +1,150 @@
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "vector.h"
+
+using namespace std;
+
+// Previous fixed-size Vector, kept (renamed) as the baseline: every operator returns a new vector
+template <typename T, size_t N>
+class EagerVector {
+private:
+    array<T, N> components_; // Holds the components of the vector
+
+public:
+    EagerVector() : components_{} {}
+
+    T& operator[](size_t i) {
+        return components_[i];
+    }
+
+    const T& operator[](size_t i) const {
+        return components_[i];
+    }
+
+    EagerVector operator+(const EagerVector& other) const {
+        EagerVector result;
+        for (size_t i = 0; i < N; ++i) {
+            result.components_[i] = components_[i] + other.components_[i];
+        }
+        return result;
+    }
+
+    EagerVector operator-(const EagerVector& other) const {
+        EagerVector result;
+        for (size_t i = 0; i < N; ++i) {
+            result.components_[i] = components_[i] - other.components_[i];
+        }
+        return result;
+    }
+
+    EagerVector operator*(const T& scalar) const {
+        EagerVector result;
+        for (size_t i = 0; i < N; ++i) {
+            result.components_[i] = components_[i] * scalar;
+        }
+        return result;
+    }
+};
+
+// The kernels evaluate out = a + b * s - c * u for every vector in the arrays. They are extern "C" and
+// never inlined, so `make asm` can show each one under its own label in bench_vector_expr.s.
+extern "C" {
+
+__attribute__((noinline)) void eager_kernel_3(EagerVector<double, 3>* out, const EagerVector<double, 3>* a,
+                                              const EagerVector<double, 3>* b, const EagerVector<double, 3>* c,
+                                              size_t count, double s, double u) {
+    for (size_t k = 0; k < count; ++k) {
+        out[k] = a[k] + b[k] * s - c[k] * u;
+    }
+}
+
+__attribute__((noinline)) void fused_kernel_3(Vector<double, 3>* out, const Vector<double, 3>* a,
+                                              const Vector<double, 3>* b, const Vector<double, 3>* c,
+                                              size_t count, double s, double u) {
+    for (size_t k = 0; k < count; ++k) {
+        out[k] = a[k] + b[k] * s - c[k] * u;
+    }
+}
+
+__attribute__((noinline)) void eager_kernel_1024(EagerVector<double, 1024>* out, const EagerVector<double, 1024>* a,
+                                                 const EagerVector<double, 1024>* b,
+                                                 const EagerVector<double, 1024>* c, size_t count, double s,
+                                                 double u) {
+    for (size_t k = 0; k < count; ++k) {
+        out[k] = a[k] + b[k] * s - c[k] * u;
+    }
+}
+
+__attribute__((noinline)) void fused_kernel_1024(Vector<double, 1024>* out, const Vector<double, 1024>* a,
+                                                 const Vector<double, 1024>* b, const Vector<double, 1024>* c,
+                                                 size_t count, double s, double u) {
+    for (size_t k = 0; k < count; ++k) {
+        out[k] = a[k] + b[k] * s - c[k] * u;
+    }
+}
+
+}
+
+/**
+ * Fills the operands, times `repeats` calls of a kernel and returns nanoseconds per vector component.
+ * @param kernel The kernel to time.
+ * @param count The number of vectors in each array.
+ * @param repeats The number of kernel calls.
+ * @param checksum Receives the sum of the results, to compare the two implementations.
+ */
+template <typename V, size_t N, typename Kernel>
+double nsPerComponent(Kernel kernel, size_t count, long repeats, double& checksum) {
+    vector<V> out(count), a(count), b(count), c(count);
+    for (size_t k = 0; k < count; ++k) {
+        for (size_t i = 0; i < N; ++i) {
+            a[k][i] = 0.5 * i + k;
+            b[k][i] = 1.0 / (i + k + 1.0);
+            c[k][i] = 0.25 * i - 0.125 * k;
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
+    for (long r = 0; r < repeats; ++r) {
+        kernel(out.data(), a.data(), b.data(), c.data(), count, 0.5 + 1e-9 * r, 0.25);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    checksum = 0.0;
+    for (size_t k = 0; k < count; ++k) {
+        for (size_t i = 0; i < N; ++i) {
+            checksum += out[k][i];
+        }
+    }
+    return 1e9 * seconds / (static_cast<double>(repeats) * count * N);
+}
+
+/**
+ * Compares out = a + b * s - c * u evaluated with one temporary per operator (EagerVector) and with
+ * expression templates (Vector), for 3-component vectors and for 1024-component vectors.
+ * Usage: bench_vector_expr.x [repeats]
+ */
+int main(int argc, char* argv[]) {
+    long repeats = argc > 1 ? atol(argv[1]) : 2000;
+    double eager_sum, fused_sum;
+
+    const size_t count3 = 10000;
+    double eager3 = nsPerComponent<EagerVector<double, 3>, 3>(eager_kernel_3, count3, repeats, eager_sum);
+    double fused3 = nsPerComponent<Vector<double, 3>, 3>(fused_kernel_3, count3, repeats, fused_sum);
+    cout << "N = 3:    eager " << eager3 << " ns/component, fused " << fused3 << " ns/component, speedup "
+         << eager3 / fused3 << "x" << (eager_sum == fused_sum ? " (same results)" : " (RESULTS DIFFER)") << endl;
+
+    const size_t count1024 = 30;
+    double eager1024 = nsPerComponent<EagerVector<double, 1024>, 1024>(eager_kernel_1024, count1024, repeats,
+                                                                       eager_sum);
+    double fused1024 = nsPerComponent<Vector<double, 1024>, 1024>(fused_kernel_1024, count1024, repeats, fused_sum);
+    cout << "N = 1024: eager " << eager1024 << " ns/component, fused " << fused1024 << " ns/component, speedup "
+         << eager1024 / fused1024 << "x" << (eager_sum == fused_sum ? " (same results)" : " (RESULTS DIFFER)")
+         << endl;
+
+    return 0;
+}
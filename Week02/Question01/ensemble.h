@@ -0,0 +1,331 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "parallel_for.h"
+#include "particle.h"
+#include "particle_system.h"
+#include "vector.h"
+
+/**
+ * The sinusoidal external force tabulated at the times of a fixed-step simulation. The force
+ * depends only on t, so one table built before a run replaces the sin/cos calls of every particle
+ * at every step. Times are accumulated (t += dt) exactly as simulateAndPlot() does, so a run from
+ * the table is bit-identical to Particle::update. Each component is stored contiguously.
+ */
+template <std::size_t N>
+class ForceTable {
+public:
+    using VectorN = Vector<double, N>;
+
+    /**
+     * Constructor to tabulate the force at t0, t0 + dt, ..., after `steps` accumulated steps.
+     * @param t0 The start time.
+     * @param dt The time step.
+     * @param steps The number of time steps; the table holds steps + 1 samples.
+     */
+    ForceTable(double t0, double dt, std::size_t steps) : dt_(dt) {
+        time_.resize(steps + 1);
+        for (std::size_t d = 0; d < N; ++d) {
+            force_[d].resize(steps + 1);
+        }
+        double t = t0;
+        for (std::size_t k = 0; k <= steps; ++k) {
+            const VectorN force = externalForce<N>(t);
+            time_[k] = t;
+            for (std::size_t d = 0; d < N; ++d) {
+                force_[d][k] = force[d];
+            }
+            t += dt;
+        }
+    }
+
+    /**
+     * Returns the number of time steps covered by the table.
+     * @return The number of steps (one less than the number of samples).
+     */
+    std::size_t steps() const {
+        return time_.size() - 1;
+    }
+
+    /**
+     * Returns the time step.
+     * @return The time step.
+     */
+    double timeStep() const {
+        return dt_;
+    }
+
+    /**
+     * Returns the time of sample k.
+     * @param k The sample index, 0 <= k <= steps().
+     * @return The time.
+     */
+    double time(std::size_t k) const {
+        return time_[k];
+    }
+
+    /**
+     * Returns the force at sample k.
+     * @param k The sample index, 0 <= k <= steps().
+     * @return The force vector.
+     */
+    VectorN operator[](std::size_t k) const {
+        VectorN force;
+        for (std::size_t d = 0; d < N; ++d) {
+            force[d] = force_[d][k];
+        }
+        return force;
+    }
+
+    /**
+     * Direct access to component d of the force at every sample.
+     * @param d The component (0 = x, 1 = y, 2 = z).
+     * @return A pointer to steps() + 1 contiguous values.
+     */
+    const double* column(std::size_t d) const {
+        return force_[d].data();
+    }
+
+private:
+    double dt_;                                // The time step
+    std::vector<double> time_;                 // Time of each sample
+    std::array<std::vector<double>, N> force_; // Force at each sample, one array per component
+};
+
+/**
+ * Mean and variance of a stream of vectors, per component, without storing the stream.
+ * Values are added one at a time with Welford's update, and the statistics of two disjoint
+ * streams are combined with the pairwise formula of Chan, Golub and LeVeque; both avoid the
+ * cancellation of the sum-of-squares formula.
+ */
+template <std::size_t N>
+class RunningStatistics {
+public:
+    using VectorN = Vector<double, N>;
+
+    /**
+     * Default constructor; no values.
+     */
+    RunningStatistics() : count_(0) {}
+
+    /**
+     * Constructor from the statistics of a block of values computed elsewhere.
+     * @param count The number of values.
+     * @param mean The mean of the values.
+     * @param m2 The sum of squared deviations from the mean.
+     */
+    RunningStatistics(std::size_t count, const VectorN& mean, const VectorN& m2)
+        : count_(count), mean_(mean), m2_(m2) {}
+
+    /**
+     * Adds a value (Welford's update).
+     * @param x The value.
+     */
+    void add(const VectorN& x) {
+        ++count_;
+        for (std::size_t d = 0; d < N; ++d) {
+            const double delta = x[d] - mean_[d];
+            mean_[d] += delta / count_;
+            m2_[d] += delta * (x[d] - mean_[d]);
+        }
+    }
+
+    /**
+     * Adds the values summarized by other, as if they had been added one by one.
+     * @param other The statistics of a disjoint set of values.
+     */
+    void merge(const RunningStatistics& other) {
+        if (other.count_ == 0) {
+            return;
+        }
+        if (count_ == 0) {
+            *this = other;
+            return;
+        }
+        const double n_a = static_cast<double>(count_);
+        const double n_b = static_cast<double>(other.count_);
+        const double n = n_a + n_b;
+        for (std::size_t d = 0; d < N; ++d) {
+            const double delta = other.mean_[d] - mean_[d];
+            mean_[d] += delta * (n_b / n);
+            m2_[d] += other.m2_[d] + delta * delta * (n_a * n_b / n);
+        }
+        count_ += other.count_;
+    }
+
+    /**
+     * Returns the number of values added.
+     * @return The count.
+     */
+    std::size_t count() const {
+        return count_;
+    }
+
+    /**
+     * Returns the mean of the values.
+     * @return The mean, per component.
+     */
+    const VectorN& mean() const {
+        return mean_;
+    }
+
+    /**
+     * Returns the (population) variance of the values, the sum of squared deviations over the count.
+     * @return The variance, per component; zero when no values were added.
+     */
+    VectorN variance() const {
+        return count_ == 0 ? VectorN() : VectorN(m2_ * (1.0 / count_));
+    }
+
+private:
+    std::size_t count_; // Number of values
+    VectorN mean_;      // Mean of the values
+    VectorN m2_;        // Sum of squared deviations from the mean
+};
+
+// Statistics of the ensemble positions at one time
+template <std::size_t N>
+struct EnsembleSample {
+    double time;                     // Time of the sample
+    RunningStatistics<N> statistics; // Mean and variance of the positions
+};
+
+/**
+ * Advances every particle of an ensemble in the external field by the table's steps with Euler's method,
+ * as Particle::update does (v_{n+1} = v_n + F_n / m * dt, x_{n+1} = x_n + v_{n+1} * dt), and returns the
+ * mean and variance of the positions at the start, after every `sampleEvery` steps and at the end.
+ *
+ * The particles do not interact, so they are split across the system's threads once, in ranges of
+ * whole tiles, and each thread takes its particles through all the steps, one tile at a time: a tile
+ * stays in L1 for the whole run and the force comes from the shared table. Each tile's statistics are computed from the tile in two
+ * passes and merged into a per-thread partial result; the partial results are merged in thread order
+ * at the end. No trajectory is stored, only one RunningStatistics per sample and thread.
+ *
+ * @param system The ensemble; positions and velocities are advanced in place.
+ * @param table The force at the times of the run.
+ * @param sampleEvery The number of steps between samples (at least 1).
+ * @return The statistics of the positions at each sample time.
+ */
+template <std::size_t N>
+std::vector<EnsembleSample<N>> runEnsemble(ParticleSystem<N>& system, const ForceTable<N>& table,
+                                           std::size_t sampleEvery = 1) {
+    if (sampleEvery == 0) {
+        throw std::invalid_argument("The sampling interval must be at least one step.");
+    }
+    constexpr std::size_t TILE = 256;
+    const std::size_t steps = table.steps();
+    const double dt = table.timeStep();
+
+    // Step counts after which the statistics are taken
+    std::vector<std::size_t> sampleSteps;
+    for (std::size_t k = 0; k < steps; k += sampleEvery) {
+        sampleSteps.push_back(k);
+    }
+    sampleSteps.push_back(steps);
+
+    // Contiguous ranges of whole tiles, one per thread, each with its own partial statistics
+    const std::size_t count = system.size();
+    const std::size_t tiles = (count + TILE - 1) / TILE;
+    const std::size_t workers = std::min<std::size_t>(system.threads(), tiles);
+    std::vector<std::vector<RunningStatistics<N>>> partial(workers,
+                                                           std::vector<RunningStatistics<N>>(sampleSteps.size()));
+
+    std::array<double*, N> position, velocity;
+    std::array<const double*, N> force;
+    for (std::size_t d = 0; d < N; ++d) {
+        position[d] = system.positions(d);
+        velocity[d] = system.velocities(d);
+        force[d] = table.column(d);
+    }
+    const double* mass = system.masses();
+
+    auto advance = [&](std::size_t worker) {
+        std::vector<RunningStatistics<N>>& statistics = partial[worker];
+        const std::size_t begin = tiles * worker / workers * TILE;
+        const std::size_t end = std::min(count, tiles * (worker + 1) / workers * TILE);
+        double inverseMass[TILE];
+
+        // Merges the statistics of the tile [tile, tile + n) into sample s. The sums use LANES
+        // independent accumulators, so they vectorize and are not bound by the latency of one add.
+        auto sample = [&](std::size_t s, std::size_t tile, std::size_t n) {
+            constexpr std::size_t LANES = 4;
+            Vector<double, N> mean, m2;
+            for (std::size_t d = 0; d < N; ++d) {
+                const double* __restrict x = position[d] + tile;
+                double sum[LANES] = {};
+                std::size_t i = 0;
+                for (; i + LANES <= n; i += LANES) {
+                    for (std::size_t lane = 0; lane < LANES; ++lane) {
+                        sum[lane] += x[i + lane];
+                    }
+                }
+                for (; i < n; ++i) {
+                    sum[0] += x[i];
+                }
+                mean[d] = ((sum[0] + sum[1]) + (sum[2] + sum[3])) / n;
+
+                const double center = mean[d];
+                double squares[LANES] = {};
+                for (i = 0; i + LANES <= n; i += LANES) {
+                    for (std::size_t lane = 0; lane < LANES; ++lane) {
+                        const double deviation = x[i + lane] - center;
+                        squares[lane] += deviation * deviation;
+                    }
+                }
+                for (; i < n; ++i) {
+                    squares[0] += (x[i] - center) * (x[i] - center);
+                }
+                m2[d] = (squares[0] + squares[1]) + (squares[2] + squares[3]);
+            }
+            statistics[s].merge(RunningStatistics<N>(n, mean, m2));
+        };
+
+        for (std::size_t tile = begin; tile < end; tile += TILE) {
+            const std::size_t n = std::min(end, tile + TILE) - tile;
+            for (std::size_t i = 0; i < n; ++i) {
+                inverseMass[i] = 1.0 / mass[tile + i];
+            }
+
+            std::size_t s = 0;
+            sample(s++, tile, n);
+            for (std::size_t k = 0; k < steps; ++k) {
+                for (std::size_t d = 0; d < N; ++d) {
+                    double* __restrict x = position[d] + tile;
+                    double* __restrict v = velocity[d] + tile;
+                    const double f = force[d][k];
+                    for (std::size_t i = 0; i < n; ++i) {
+                        const double speed = v[i] + f * inverseMass[i] * dt;
+                        v[i] = speed;
+                        x[i] = x[i] + speed * dt;
+                    }
+                }
+                if (k + 1 == sampleSteps[s]) {
+                    sample(s++, tile, n);
+                }
+            }
+        }
+    };
+    parallelFor(workers, system.pool(), [&advance](std::size_t first, std::size_t last) {
+        for (std::size_t worker = first; worker < last; ++worker) {
+            advance(worker);
+        }
+    }, 1);
+    system.invalidateForces();
+
+    std::vector<EnsembleSample<N>> samples(sampleSteps.size());
+    for (std::size_t s = 0; s < sampleSteps.size(); ++s) {
+        samples[s].time = table.time(sampleSteps[s]);
+        for (std::size_t worker = 0; worker < workers; ++worker) {
+            samples[s].statistics.merge(partial[worker][s]);
+        }
+    }
+    return samples;
+}
+
+#endif // ENSEMBLE_H
@@ -1,237 +1,104 @@
 #include <iostream>
-#include <vector>
-#include <cmath>
+#include <string>
 #include <fstream>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <stdexcept>
 
-using namespace std;
-
-// Vector class to represent both 2D and 3D vectors
-class Vector {
-private:
-    vector<double> components_; // Holds the components of the vector
-
-public:
-    /**
-     * Constructor to initialize the vector with a given set of components.
-     * @param components A vector of doubles representing the components of the vector.
-     */
-    Vector(vector<double> components) : components_(components) {}
-
-    /**
-     * Constructor to initialize a 2D vector with x and y components.
-     * @param x The x component of the vector.
-     * @param y The y component of the vector.
-     */
-    Vector(double x, double y) : components_{x, y} {}
-
-    /**
-     * Constructor to initialize a 3D vector with x, y, and z components.
-     * @param x The x component of the vector.
-     * @param y The y component of the vector.
-     * @param z The z component of the vector.
-     */
-    Vector(double x, double y, double z) : components_{x, y, z} {}
-
-    /**
-     * Destructor for the Vector class.
-     */
-    ~Vector() {}
-
-    /**
-     * Returns the number of components in the vector (size).
-     * @return The size of the vector as a size_t.
-     */
-    size_t size() const {
-        return components_.size();  // Return the number of components
-    }
-
-    /**
-     * Returns the components of the vector as a reference.
-     * @return A reference to the vector of components.
-     */
-    const vector<double>& getComponents() const {
-        return components_;
-    }
+#include "vector.h"
+#include "particle.h"
+#include "ensemble.h"
+#include "trajectory.h"
 
-    /**
-     * Overloaded addition operator to add two vectors element-wise.
-     * Throws an error if the vector sizes do not match.
-     * @param other The vector to add to the current vector.
-     * @return A new vector that is the element-wise sum of the two vectors.
-     */
-    Vector operator+(const Vector &other) const {
-        if (components_.size() != other.size()) {
-            throw runtime_error("Vector sizes must match for addition.");
-        }
-        vector<double> result(components_.size());
-        for (size_t i = 0; i < components_.size(); ++i) {
-            result[i] = components_[i] + other.components_[i];
-        }
-        return Vector(result);
-    }
+using namespace std;
 
-    /**
-     * Overloaded subtraction operator to subtract one vector from another element-wise.
-     * Throws an error if the vector sizes do not match.
-     * @param other The vector to subtract from the current vector.
-     * @return A new vector that is the element-wise difference of the two vectors.
-     */
-    Vector operator-(const Vector &other) const {
-        if (components_.size() != other.size()) {
-            throw runtime_error("Vector sizes must match for subtraction.");
-        }
-        vector<double> result(components_.size());
-        for (size_t i = 0; i < components_.size(); ++i) {
-            result[i] = components_[i] - other.components_[i];
-        }
-        return Vector(result);
-    }
+/**
+ * Simulates the motion of a particle and writes the trajectory to a file.
+ * @tparam N The dimension of the particle (2 or 3).
+ * @param filename The name of the file to write the trajectory data to.
+ * @param particle The particle object being simulated.
+ * @param dt The time step for the simulation.
+ * @param t_end The end time for the simulation.
+ */
+template <size_t N>
+void simulateAndPlot(const string& filename, Particle<N>& particle, double dt, double t_end) {
+    ofstream file(filename);  // Open the file to write data
 
-    /**
-     * Overloaded multiplication operator to scale a vector by a scalar.
-     * @param scalar The scalar value to multiply each component of the vector by.
-     * @return A new vector with each component scaled by the scalar.
-     */
-    Vector operator*(const double &scalar) const {
-        vector<double> result(components_.size());
-        for (size_t i = 0; i < components_.size(); ++i) {
-            result[i] = components_[i] * scalar;
-        }
-        return Vector(result);
+    // Write the header (time, x, y[, z]) for the particle's dimension
+    if constexpr (N == 2) {
+        file << "time,x,y\n";  // 2D case
+    } else {
+        file << "time,x,y,z\n";  // 3D case
     }
 
-    /**
-     * Overloaded multiplication operator to compute the dot product of two vectors.
-     * Throws an error if the vector sizes do not match.
-     * @param other The vector to compute the dot product with.
-     * @return The scalar result of the dot product.
-     */
-    double operator*(const Vector &other) const {
-        if (components_.size() != other.size()) {
-            throw runtime_error("Vector sizes must match for dot product.");
-        }
-        double result = 0.0;
-        for (size_t i = 0; i < components_.size(); ++i) {
-            result += components_[i] * other.components_[i];
-        }
-        return result;
-    }
+    // Loop over time and update the particle's position and velocity
+    for (double t = 0.0; t <= t_end; t += dt) {
+        particle.update(t, dt);  // Update the particle's state
 
-    /**
-     * Overloaded output stream operator to print the vector in the form (x, y) or (x, y, z).
-     * @param os The output stream.
-     * @param v The vector to be printed.
-     * @return The output stream with the formatted vector.
-     */
-    friend ostream &operator<<(ostream &os, const Vector &v) {
-        os << "(";
-        for (size_t i = 0; i < v.size(); ++i) {
-            os << v.components_[i];
-            if (i < v.size() - 1) os << ", ";
+        const auto& pos = particle.getPosition().getComponents();  // Get the current position
+        file << t;  // Write the current time
+        for (double comp : pos) {
+            file << "," << comp;  // Write each position component
         }
-        os << ")";
-        return os;
-    }
-};
-
-// Particle class for simulating motion in 2D or 3D
-class Particle {
-public:
-    /**
-     * Constructor to initialize a particle with its mass, position, velocity, and force.
-     * @param mass The mass of the particle.
-     * @param position The initial position vector of the particle.
-     * @param velocity The initial velocity vector of the particle.
-     * @param force The initial force vector acting on the particle.
-     */
-    Particle(double mass, const Vector &position, const Vector &velocity, const Vector &force)
-        : mass_(mass), position_(position), velocity_(velocity), force_(force) {
-        cout << "Particle created at position " << position_ << endl;
-    }
-
-    /**
-     * Destructor for the Particle class.
-     */
-    ~Particle() {
-        cout << "Particle destroyed at position " << position_ << endl;
-    }
-
-    /**
-     * Updates the particle's position using Euler's method.
-     * The new position is computed based on the velocity and time step.
-     * @param dt The time step for updating the position.
-     */
-    void updatePosition(double dt) {
-        position_ = position_ + velocity_ * dt;  // Update position using velocity and time step
-    }
-
-    /**
-     * Prints the current state of the particle, including its position and velocity.
-     */
-    void printState() const {
-        cout << "Particle - Position: " << position_ << ", Velocity: " << velocity_ << endl;
+        file << "\n";  // Newline for the next time step
     }
+    file.close();  // Close the file after writing
+}
 
-    /**
-     * Updates the particle's velocity and position based on sinusoidal forces.
-     * For 2D particles, the force follows the pattern (sin(2t), cos(2t)).
-     * For 3D particles, the force follows the pattern (sin(2t), cos(2t), cos(1.5t)).
-     * @param t The current time.
-     * @param dt The time step for updating velocity and position.
-     */
-    void update(double t, double dt) {
-        // Set sinusoidal force based on the dimension (2D or 3D)
-        if (position_.size() == 2) {
-            force_ = Vector(sin(2.0 * t), cos(2.0 * t));  // 2D case
-        } else if (position_.size() == 3) {
-            force_ = Vector(sin(2.0 * t), cos(2.0 * t), cos(1.5 * t));  // 3D case
-        }
-
-        // Update velocity using Euler's method: v_{n+1} = v_n + dt * F_n
-        velocity_ = velocity_ + force_ * dt;
-
-        // Update position using Euler's method: P_{n+1} = P_n + dt * v_n
-        updatePosition(dt);
-    }
+/**
+ * Simulates the motion of a particle and writes the trajectory to a binary trajectory file. Frame k
+ * holds the exact state after k steps (frame 0 is the initial state); the writer decides which frames
+ * are kept (see TrajectoryOptions) and writes them on a background thread. The writer is closed at the end.
+ * @tparam N The dimension of the particle (2 or 3).
+ * @param writer The trajectory file.
+ * @param particle The particle object being simulated.
+ * @param dt The time step for the simulation.
+ * @param t_end The end time for the simulation.
+ */
+template <size_t N>
+void simulateAndPlot(TrajectoryWriter<N>& writer, Particle<N>& particle, double dt, double t_end) {
+    uint64_t step = 0;
+    writer.write(step, 0.0, particle.getPosition(), particle.getVelocity());
 
-    /**
-     * Returns the current position of the particle.
-     * @return A reference to the position vector of the particle.
-     */
-    const Vector& getPosition() const {
-        return position_;
+    // The same steps as the text output
+    for (double t = 0.0; t <= t_end; t += dt) {
+        particle.update(t, dt);
+        writer.write(++step, t + dt, particle.getPosition(), particle.getVelocity());
     }
-
-private:
-    double mass_;     // The mass of the particle
-    Vector position_; // The current position of the particle
-    Vector velocity_; // The current velocity of the particle
-    Vector force_;    // The force acting on the particle
-};
+    writer.close();  // Write the last frame and report any write error
+}
 
 /**
- * Simulates the motion of a particle and writes the trajectory to a file.
+ * Simulates the motion of a particle with a given time integrator and writes the trajectory to a file.
+ * Each row holds the time after a step and the position at that time; adaptive integrators choose
+ * their own (variable) steps, up to dt. The last step ends exactly at t_end.
+ * @tparam N The dimension of the particle (2 or 3).
  * @param filename The name of the file to write the trajectory data to.
  * @param particle The particle object being simulated.
- * @param dt The time step for the simulation.
+ * @param integrator The time integrator.
+ * @param dt The time step (for adaptive integrators, the largest step).
  * @param t_end The end time for the simulation.
  */
-void simulateAndPlot(const string& filename, Particle& particle, double dt, double t_end) {
+template <size_t N>
+void simulateAndPlot(const string& filename, Particle<N>& particle, Integrator<N>& integrator, double dt,
+                     double t_end) {
     ofstream file(filename);  // Open the file to write data
+    file.precision(17);
 
-    // Write the header (time, x, y[, z]) depending on whether it's 2D or 3D
-    if (particle.getPosition().size() == 2) {
+    // Write the header (time, x, y[, z]) for the particle's dimension
+    if constexpr (N == 2) {
         file << "time,x,y\n";  // 2D case
     } else {
         file << "time,x,y,z\n";  // 3D case
     }
 
-    // Loop over time and update the particle's position and velocity
-    for (double t = 0.0; t <= t_end; t += dt) {
-        particle.update(t, dt);  // Update the particle's state
+    double t = 0.0;
+    while (t < t_end) {
+        t += particle.update(t, clampStep(t, t_end, dt), integrator);
 
         const auto& pos = particle.getPosition().getComponents();  // Get the current position
-        file << t;  // Write the current time
+        file << t;  // Write the time after the step
         for (double comp : pos) {
             file << "," << comp;  // Write each position component
         }
@@ -240,11 +107,153 @@ void simulateAndPlot(const string& filename, Particle& particle, double dt, doub
     file.close();  // Close the file after writing
 }
 
+/**
+ * Advances an ensemble of particles in the external field and writes the mean and variance of the
+ * positions over time to a file, one row per step; the trajectories themselves are not stored.
+ * @tparam N The dimension of the particles (2 or 3).
+ * @param filename The name of the file to write the statistics to.
+ * @param system The ensemble, advanced in place.
+ * @param dt The time step for the simulation.
+ * @param t_end The end time for the simulation.
+ */
+template <size_t N>
+void simulateEnsemble(const string& filename, ParticleSystem<N>& system, double dt, double t_end) {
+    ForceTable<N> table(0.0, dt, static_cast<size_t>(llround(t_end / dt)));
+    vector<EnsembleSample<N>> samples = runEnsemble(system, table);
+
+    ofstream file(filename);  // Open the file to write data
+    const char* axes = "xyz";
+    file << "time";
+    for (size_t d = 0; d < N; ++d) {
+        file << ",mean_" << axes[d];
+    }
+    for (size_t d = 0; d < N; ++d) {
+        file << ",var_" << axes[d];
+    }
+    file << "\n";
+    for (const EnsembleSample<N>& sample : samples) {
+        file << sample.time;
+        for (size_t d = 0; d < N; ++d) {
+            file << "," << sample.statistics.mean()[d];
+        }
+        for (size_t d = 0; d < N; ++d) {
+            file << "," << sample.statistics.variance()[d];
+        }
+        file << "\n";
+    }
+    file.close();  // Close the file after writing
+}
+
+/**
+ * Creates the integrator named on the command line.
+ * @param name One of euler, verlet, leapfrog, rk4, rk45.
+ * @param tolerance The error tolerance of rk45 (absolute and relative).
+ * @return The integrator.
+ */
+template <size_t N>
+unique_ptr<Integrator<N>> makeIntegrator(const string& name, double tolerance) {
+    if (name == "euler") return make_unique<EulerIntegrator<N>>();
+    if (name == "verlet") return make_unique<VelocityVerletIntegrator<N>>();
+    if (name == "leapfrog") return make_unique<LeapfrogIntegrator<N>>();
+    if (name == "rk4") return make_unique<RK4Integrator<N>>();
+    if (name == "rk45") return make_unique<DormandPrinceIntegrator<N>>(tolerance, tolerance);
+    throw invalid_argument("Unknown integrator " + name + " (use euler, verlet, leapfrog, rk4 or rk45).");
+}
+
 #ifndef TEST_MODE
 /**
  * Main function to create and simulate 2D and 3D particles.
+ * Usage: homework2.x [integrator [dt [tolerance]]]
+ *        homework2.x ensemble [particles [threads]]
+ *        homework2.x binary [every [tolerance]]
+ * Without arguments the particles are advanced by Particle::update (Euler, dt = 0.02). With an
+ * integrator (euler, verlet, leapfrog, rk4, rk45) the trajectories are written with that method and
+ * the force evaluations and error at t = 4 against the exact solution are printed. The ensemble mode
+ * advances many 3D particles with normally distributed initial positions and velocities and writes
+ * the mean and variance of their positions to ensemble_3d.txt. The binary mode writes the default
+ * trajectories to traject_2d.traj and traject_3d.traj instead, keeping every `every`-th step and, with
+ * a tolerance, only the frames needed to interpolate the others to that accuracy.
  */
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "ensemble") {
+        try {
+            const long long count = argc > 2 ? stoll(argv[2]) : 10000;
+            const int threads = argc > 3 ? stoi(argv[3]) : 0;
+            if (count < 0 || threads < 0) {
+                throw invalid_argument("The number of particles and threads must not be negative.");
+            }
+
+            ParticleSystem<3> ensemble(count, threads);
+            mt19937_64 generator(2024);
+            normal_distribution<double> spread(0.0, 0.1);
+            for (size_t i = 0; i < ensemble.size(); ++i) {
+                Vector<double, 3> position(spread(generator), spread(generator), spread(generator));
+                Vector<double, 3> velocity(spread(generator), spread(generator), spread(generator));
+                ensemble.setParticle(i, 1.0, position, velocity);
+            }
+            simulateEnsemble("ensemble_3d.txt", ensemble, 0.02, 4.0);
+            cout << count << " particles written to ensemble_3d.txt" << endl;
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (argc > 1 && string(argv[1]) == "binary") {
+        try {
+            TrajectoryOptions options;
+            const long long every = argc > 2 ? stoll(argv[2]) : 1;
+            if (every <= 0) {
+                throw invalid_argument("The decimation must be a positive number of steps.");
+            }
+            options.every = static_cast<uint64_t>(every);
+            options.tolerance = argc > 3 ? stod(argv[3]) : 0.0;
+
+            Particle particle2D(1.0, Vector(0.0, 0.0), Vector(0.0, 0.0), Vector(0.0, 0.0));
+            TrajectoryWriter<2> writer2D("traject_2d.traj", options);
+            simulateAndPlot(writer2D, particle2D, 0.02, 4.0);
+
+            Particle particle3D(1.0, Vector(0.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0));
+            TrajectoryWriter<3> writer3D("traject_3d.traj", options);
+            simulateAndPlot(writer3D, particle3D, 0.02, 4.0);
+            cout << writer2D.framesWritten() << " of " << writer2D.framesOffered()
+                 << " frames written to traject_2d.traj, " << writer3D.framesWritten() << " of "
+                 << writer3D.framesOffered() << " to traject_3d.traj" << endl;
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (argc > 1) {
+        try {
+            const string name = argv[1];
+            const double dt = argc > 2 ? stod(argv[2]) : 0.02;
+            const double tolerance = argc > 3 ? stod(argv[3]) : 1e-8;
+            const double t_end = 4.0;
+
+            Particle particle2D(1.0, Vector(0.0, 0.0), Vector(0.0, 0.0), Vector(0.0, 0.0));
+            auto integrator2D = makeIntegrator<2>(name, tolerance);
+            simulateAndPlot("traject_2d.txt", particle2D, *integrator2D, dt, t_end);
+
+            Particle particle3D(1.0, Vector(0.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0));
+            auto integrator3D = makeIntegrator<3>(name, tolerance);
+            simulateAndPlot("traject_3d.txt", particle3D, *integrator3D, dt, t_end);
+
+            Vector<double, 3> x, v;
+            exactMotion<3>(t_end, 1.0, Vector(0.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0), x, v);
+            Vector<double, 3> error = particle3D.getPosition() - x;
+            cout << integrator3D->name() << ": " << integrator3D->getForceEvaluations()
+                 << " force evaluations, 3D position error at t = " << t_end << ": " << sqrt(error * error) << endl;
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
     // Create and simulate 2D particle
     Particle particle2D(1.0, Vector(0.0, 0.0), Vector(0.0, 0.0), Vector(0.0, 0.0));
     simulateAndPlot("traject_2d.txt", particle2D, 0.02, 4.0);
@@ -0,0 +1,328 @@
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+#include "vector.h"
+
+/**
+ * Returns the step to take from t toward t_end: dt, or the remaining time when that is at most dt
+ * (up to rounding), so that accumulated steps land exactly on t_end without a final sliver of a step.
+ * @param t The current time.
+ * @param t_end The end time.
+ * @param dt The step size.
+ * @return The step size to use.
+ */
+inline double clampStep(double t, double t_end, double dt) {
+    const double remaining = t_end - t;
+    return remaining <= dt * (1.0 + 1e-9) ? remaining : dt;
+}
+
+/**
+ * Base class for time integrators of a particle's equation of motion x'' = a(t, x, v), where the
+ * acceleration is F / m. Each call of step() advances the position and velocity by one step and
+ * counts the acceleration (force) evaluations, the usual measure of an integrator's cost.
+ */
+template <std::size_t N>
+class Integrator {
+public:
+    using VectorN = Vector<double, N>;
+    using Acceleration = std::function<VectorN(double t, const VectorN& x, const VectorN& v)>;
+
+    virtual ~Integrator() {}
+
+    /**
+     * Advances the position and velocity from time t by a step of at most dt.
+     * @param acceleration The acceleration a(t, x, v) = F / m.
+     * @param t The current time.
+     * @param dt The step size (for adaptive integrators, the largest allowed step).
+     * @param x The position, updated in place.
+     * @param v The velocity, updated in place.
+     * @return The step actually taken; fixed-step integrators always take dt.
+     */
+    virtual double step(const Acceleration& acceleration, double t, double dt, VectorN& x, VectorN& v) = 0;
+
+    /**
+     * Returns the name of the method.
+     */
+    virtual std::string name() const = 0;
+
+    /**
+     * Returns the number of acceleration evaluations so far.
+     */
+    std::uint64_t getForceEvaluations() const { return forceEvaluations_; }
+
+protected:
+    // Evaluates the acceleration and counts the evaluation
+    VectorN evaluate(const Acceleration& acceleration, double t, const VectorN& x, const VectorN& v) {
+        ++forceEvaluations_;
+        return acceleration(t, x, v);
+    }
+
+    std::uint64_t forceEvaluations_ = 0; // Acceleration evaluations so far
+};
+
+/**
+ * Semi-implicit (symplectic) Euler, the method of Particle::update: v += dt a(t, x, v), then x += dt v.
+ * First order, one evaluation per step.
+ */
+template <std::size_t N>
+class EulerIntegrator : public Integrator<N> {
+public:
+    using typename Integrator<N>::VectorN;
+    using typename Integrator<N>::Acceleration;
+
+    double step(const Acceleration& acceleration, double t, double dt, VectorN& x, VectorN& v) override {
+        const VectorN a = this->evaluate(acceleration, t, x, v);
+        v = v + a * dt;
+        x = x + v * dt;
+        return dt;
+    }
+
+    std::string name() const override { return "Euler"; }
+};
+
+/**
+ * Velocity Verlet: x += dt v + dt^2/2 a(t), v += dt/2 (a(t) + a(t + dt)). Second order and symplectic
+ * for forces that do not depend on the velocity. The acceleration at the end of a step is reused at
+ * the start of the next one, so each step costs one evaluation.
+ */
+template <std::size_t N>
+class VelocityVerletIntegrator : public Integrator<N> {
+public:
+    using typename Integrator<N>::VectorN;
+    using typename Integrator<N>::Acceleration;
+
+    double step(const Acceleration& acceleration, double t, double dt, VectorN& x, VectorN& v) override {
+        if (!cached_ || cachedTime_ != t || !samePosition(x)) {
+            cachedAcceleration_ = this->evaluate(acceleration, t, x, v);
+        }
+        const VectorN a0 = cachedAcceleration_;
+        x = x + v * dt + a0 * (0.5 * dt * dt);
+        // The velocity passed for a(t + dt) is a first-order prediction
+        const VectorN a1 = this->evaluate(acceleration, t + dt, x, v + a0 * dt);
+        v = v + (a0 + a1) * (0.5 * dt);
+
+        cached_ = true;
+        cachedTime_ = t + dt;
+        cachedPosition_ = x;
+        cachedAcceleration_ = a1;
+        return dt;
+    }
+
+    std::string name() const override { return "velocity Verlet"; }
+
+private:
+    bool samePosition(const VectorN& x) const {
+        for (std::size_t d = 0; d < N; ++d) {
+            if (x[d] != cachedPosition_[d]) return false;
+        }
+        return true;
+    }
+
+    bool cached_ = false;         // Whether cachedAcceleration_ is set
+    double cachedTime_ = 0.0;     // Time of the cached acceleration
+    VectorN cachedPosition_;      // Position of the cached acceleration
+    VectorN cachedAcceleration_;  // Acceleration at the end of the last step
+};
+
+/**
+ * Leapfrog in drift-kick-drift form: x_{1/2} = x + dt/2 v, v += dt a(t + dt/2, x_{1/2}), x = x_{1/2} + dt/2 v.
+ * Second order and symplectic, one evaluation per step, no state carried between steps.
+ */
+template <std::size_t N>
+class LeapfrogIntegrator : public Integrator<N> {
+public:
+    using typename Integrator<N>::VectorN;
+    using typename Integrator<N>::Acceleration;
+
+    double step(const Acceleration& acceleration, double t, double dt, VectorN& x, VectorN& v) override {
+        const double half = 0.5 * dt;
+        x = x + v * half;
+        const VectorN a = this->evaluate(acceleration, t + half, x, v);
+        v = v + a * dt;
+        x = x + v * half;
+        return dt;
+    }
+
+    std::string name() const override { return "leapfrog"; }
+};
+
+/**
+ * Classical fourth-order Runge-Kutta on the state (x, v), four evaluations per step.
+ */
+template <std::size_t N>
+class RK4Integrator : public Integrator<N> {
+public:
+    using typename Integrator<N>::VectorN;
+    using typename Integrator<N>::Acceleration;
+
+    double step(const Acceleration& acceleration, double t, double dt, VectorN& x, VectorN& v) override {
+        const double half = 0.5 * dt;
+        const VectorN k1x = v;
+        const VectorN k1v = this->evaluate(acceleration, t, x, v);
+        const VectorN k2x = v + k1v * half;
+        const VectorN k2v = this->evaluate(acceleration, t + half, x + k1x * half, k2x);
+        const VectorN k3x = v + k2v * half;
+        const VectorN k3v = this->evaluate(acceleration, t + half, x + k2x * half, k3x);
+        const VectorN k4x = v + k3v * dt;
+        const VectorN k4v = this->evaluate(acceleration, t + dt, x + k3x * dt, k4x);
+        x = x + (k1x + k2x * 2.0 + k3x * 2.0 + k4x) * (dt / 6.0);
+        v = v + (k1v + k2v * 2.0 + k3v * 2.0 + k4v) * (dt / 6.0);
+        return dt;
+    }
+
+    std::string name() const override { return "RK4"; }
+};
+
+/**
+ * Adaptive Dormand-Prince RK5(4) with the "first same as last" property: every attempt, accepted or
+ * rejected, costs six evaluations (k2 to k7), since k1 is evaluated once per call and reused by the
+ * retries. A call costs one more evaluation for k1 only on the first step, or when the state passed in
+ * is not the one the previous step ended with. The embedded fourth-order solution
+ * estimates the local error; a step is accepted when, for every component y of x and v,
+ * |error| <= absTol + relTol |y| (in the root-mean-square sense), and the next step size is chosen
+ * from the error estimate.
+ */
+template <std::size_t N>
+class DormandPrinceIntegrator : public Integrator<N> {
+public:
+    using typename Integrator<N>::VectorN;
+    using typename Integrator<N>::Acceleration;
+
+    /**
+     * Constructor for an adaptive integrator.
+     * @param absTol The absolute error tolerance per step.
+     * @param relTol The relative error tolerance per step.
+     */
+    DormandPrinceIntegrator(double absTol, double relTol) : absTol_(absTol), relTol_(relTol) {
+        if (!(absTol > 0.0) || !(relTol >= 0.0)) {
+            throw std::invalid_argument("Dormand-Prince needs a positive absolute and non-negative relative tolerance.");
+        }
+    }
+
+    double step(const Acceleration& acceleration, double t, double dt, VectorN& x, VectorN& v) override {
+        if (!(dt > 0.0)) {
+            throw std::invalid_argument("The step size must be positive.");
+        }
+        // Reuse the last stage of the previous step when it was evaluated at this state
+        VectorN k1v;
+        if (fsal_ && fsalTime_ == t && same(fsalX_, x) && same(fsalV_, v)) {
+            k1v = fsalA_;
+        } else {
+            k1v = this->evaluate(acceleration, t, x, v);
+        }
+        const VectorN k1x = v;
+
+        double h = nextStep_ > 0.0 ? std::min(dt, nextStep_) : dt;
+        for (;;) {
+            const VectorN x2 = x + k1x * (h * (1.0 / 5.0));
+            const VectorN v2 = v + k1v * (h * (1.0 / 5.0));
+            const VectorN k2x = v2, k2v = this->evaluate(acceleration, t + h / 5.0, x2, v2);
+
+            const VectorN x3 = x + (k1x * (3.0 / 40.0) + k2x * (9.0 / 40.0)) * h;
+            const VectorN v3 = v + (k1v * (3.0 / 40.0) + k2v * (9.0 / 40.0)) * h;
+            const VectorN k3x = v3, k3v = this->evaluate(acceleration, t + 0.3 * h, x3, v3);
+
+            const VectorN x4 = x + (k1x * (44.0 / 45.0) - k2x * (56.0 / 15.0) + k3x * (32.0 / 9.0)) * h;
+            const VectorN v4 = v + (k1v * (44.0 / 45.0) - k2v * (56.0 / 15.0) + k3v * (32.0 / 9.0)) * h;
+            const VectorN k4x = v4, k4v = this->evaluate(acceleration, t + 0.8 * h, x4, v4);
+
+            const VectorN x5 = x + (k1x * (19372.0 / 6561.0) - k2x * (25360.0 / 2187.0) + k3x * (64448.0 / 6561.0) -
+                                    k4x * (212.0 / 729.0)) * h;
+            const VectorN v5 = v + (k1v * (19372.0 / 6561.0) - k2v * (25360.0 / 2187.0) + k3v * (64448.0 / 6561.0) -
+                                    k4v * (212.0 / 729.0)) * h;
+            const VectorN k5x = v5, k5v = this->evaluate(acceleration, t + h * (8.0 / 9.0), x5, v5);
+
+            const VectorN x6 = x + (k1x * (9017.0 / 3168.0) - k2x * (355.0 / 33.0) + k3x * (46732.0 / 5247.0) +
+                                    k4x * (49.0 / 176.0) - k5x * (5103.0 / 18656.0)) * h;
+            const VectorN v6 = v + (k1v * (9017.0 / 3168.0) - k2v * (355.0 / 33.0) + k3v * (46732.0 / 5247.0) +
+                                    k4v * (49.0 / 176.0) - k5v * (5103.0 / 18656.0)) * h;
+            const VectorN k6x = v6, k6v = this->evaluate(acceleration, t + h, x6, v6);
+
+            // Fifth-order solution
+            const VectorN xNew = x + (k1x * (35.0 / 384.0) + k3x * (500.0 / 1113.0) + k4x * (125.0 / 192.0) -
+                                      k5x * (2187.0 / 6784.0) + k6x * (11.0 / 84.0)) * h;
+            const VectorN vNew = v + (k1v * (35.0 / 384.0) + k3v * (500.0 / 1113.0) + k4v * (125.0 / 192.0) -
+                                      k5v * (2187.0 / 6784.0) + k6v * (11.0 / 84.0)) * h;
+            const VectorN k7x = vNew, k7v = this->evaluate(acceleration, t + h, xNew, vNew);
+
+            // Difference between the fifth- and fourth-order solutions
+            const VectorN ex = (k1x * (71.0 / 57600.0) - k3x * (71.0 / 16695.0) + k4x * (71.0 / 1920.0) -
+                                k5x * (17253.0 / 339200.0) + k6x * (22.0 / 525.0) - k7x * (1.0 / 40.0)) * h;
+            const VectorN ev = (k1v * (71.0 / 57600.0) - k3v * (71.0 / 16695.0) + k4v * (71.0 / 1920.0) -
+                                k5v * (17253.0 / 339200.0) + k6v * (22.0 / 525.0) - k7v * (1.0 / 40.0)) * h;
+            const double error = errorNorm(ex, x, xNew, ev, v, vNew);
+
+            // Standard step size control with safety factor 0.9, growth limited to [0.2, 5]
+            const double factor = error == 0.0 ? 5.0 : std::min(5.0, std::max(0.2, 0.9 * std::pow(error, -0.2)));
+            if (error <= 1.0) {
+                x = xNew;
+                v = vNew;
+                fsal_ = true;
+                fsalTime_ = t + h;
+                fsalX_ = xNew;
+                fsalV_ = vNew;
+                fsalA_ = k7v;
+                nextStep_ = h * factor;
+                ++accepted_;
+                return h;
+            }
+            ++rejected_;
+            h *= std::min(1.0, factor);
+            if (t + h == t) {
+                throw std::runtime_error("Dormand-Prince step size underflow.");
+            }
+        }
+    }
+
+    std::string name() const override { return "Dormand-Prince RK45"; }
+
+    /**
+     * Returns the number of accepted steps.
+     */
+    std::uint64_t getAcceptedSteps() const { return accepted_; }
+
+    /**
+     * Returns the number of rejected steps.
+     */
+    std::uint64_t getRejectedSteps() const { return rejected_; }
+
+private:
+    static bool same(const VectorN& a, const VectorN& b) {
+        for (std::size_t d = 0; d < N; ++d) {
+            if (a[d] != b[d]) return false;
+        }
+        return true;
+    }
+
+    // Root-mean-square of the error scaled by the tolerance, over the 2N components of (x, v)
+    double errorNorm(const VectorN& ex, const VectorN& x0, const VectorN& x1, const VectorN& ev,
+                     const VectorN& v0, const VectorN& v1) const {
+        double sum = 0.0;
+        for (std::size_t d = 0; d < N; ++d) {
+            const double sx = absTol_ + relTol_ * std::max(std::fabs(x0[d]), std::fabs(x1[d]));
+            const double sv = absTol_ + relTol_ * std::max(std::fabs(v0[d]), std::fabs(v1[d]));
+            sum += (ex[d] / sx) * (ex[d] / sx) + (ev[d] / sv) * (ev[d] / sv);
+        }
+        return std::sqrt(sum / (2 * N));
+    }
+
+    double absTol_;             // Absolute tolerance
+    double relTol_;             // Relative tolerance
+    double nextStep_ = 0.0;     // Suggested size of the next step (0 before the first step)
+    bool fsal_ = false;         // Whether the fsal* members hold the last stage of the previous step
+    double fsalTime_ = 0.0;     // Time of the last stage
+    VectorN fsalX_, fsalV_;     // State of the last stage
+    VectorN fsalA_;             // Acceleration of the last stage
+    std::uint64_t accepted_ = 0; // Accepted steps
+    std::uint64_t rejected_ = 0; // Rejected steps
+};
+
+#endif // INTEGRATOR_H
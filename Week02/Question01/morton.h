@@ -0,0 +1,107 @@
+#ifndef MORTON_H
+#define MORTON_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Bits per coordinate in a 64-bit Morton code: 31 in 2D, 21 in 3D
+template <std::size_t N>
+constexpr unsigned mortonBits() {
+    static_assert(N == 2 || N == 3, "Morton codes are defined in 2D and 3D only.");
+    return 63 / N;
+}
+
+/**
+ * Spreads the low bits of x so that there are N - 1 zero bits between consecutive bits.
+ * @param x The value to spread (mortonBits<N>() significant bits).
+ * @return The spread value.
+ */
+template <std::size_t N>
+inline std::uint64_t spreadBits(std::uint64_t x) {
+    if constexpr (N == 2) {
+        x &= 0x7fffffffULL;
+        x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+        x = (x | (x << 8)) & 0x00ff00ff00ff00ffULL;
+        x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+        x = (x | (x << 2)) & 0x3333333333333333ULL;
+        x = (x | (x << 1)) & 0x5555555555555555ULL;
+    } else {
+        x &= 0x1fffffULL;
+        x = (x | (x << 32)) & 0x001f00000000ffffULL;
+        x = (x | (x << 16)) & 0x001f0000ff0000ffULL;
+        x = (x | (x << 8)) & 0x100f00f00f00f00fULL;
+        x = (x | (x << 4)) & 0x10c30c30c30c30c3ULL;
+        x = (x | (x << 2)) & 0x1249249249249249ULL;
+    }
+    return x;
+}
+
+/**
+ * Interleaves the bits of N cell coordinates into a Morton (Z-order) code. Cells that are close in
+ * space usually have close codes, and the top N * L bits of a code identify the cell containing it
+ * at level L of an octree (quadtree in 2D).
+ * @param cell The integer cell coordinates, each below 2^mortonBits<N>().
+ * @return The Morton code.
+ */
+template <std::size_t N>
+inline std::uint64_t mortonEncode(const std::array<std::uint64_t, N>& cell) {
+    std::uint64_t code = 0;
+    for (std::size_t d = 0; d < N; ++d) {
+        code |= spreadBits<N>(cell[d]) << (N - 1 - d);
+    }
+    return code;
+}
+
+/**
+ * Maps points of a cubic box (square in 2D) onto the 2^mortonBits<N>() cells per axis of the
+ * finest Morton grid.
+ */
+template <std::size_t N>
+class MortonGrid {
+public:
+    /**
+     * Constructor for the box [lower, lower + side) in every dimension.
+     * @param lower The lower corner of the box.
+     * @param side The side length of the box (positive).
+     */
+    MortonGrid(const std::array<double, N>& lower, double side)
+        : lower_(lower), side_(side), scale_(static_cast<double>(std::uint64_t(1) << mortonBits<N>()) / side) {}
+
+    /**
+     * Returns the Morton code of the finest cell containing a point; points outside the box are clamped.
+     * @param x The coordinates of the point.
+     * @return The Morton code.
+     */
+    std::uint64_t code(const std::array<double, N>& x) const {
+        const std::uint64_t top = (std::uint64_t(1) << mortonBits<N>()) - 1;
+        std::array<std::uint64_t, N> cell;
+        for (std::size_t d = 0; d < N; ++d) {
+            double c = (x[d] - lower_[d]) * scale_;
+            cell[d] = c <= 0.0 ? 0 : std::min(top, static_cast<std::uint64_t>(c));
+        }
+        return mortonEncode<N>(cell);
+    }
+
+    /**
+     * Returns the lower corner of the box.
+     */
+    const std::array<double, N>& lower() const {
+        return lower_;
+    }
+
+    /**
+     * Returns the side length of the box.
+     */
+    double side() const {
+        return side_;
+    }
+
+private:
+    std::array<double, N> lower_; // Lower corner of the box
+    double side_;                 // Side length of the box
+    double scale_;                // Finest cells per unit length
+};
+
+#endif // MORTON_H
@@ -0,0 +1,406 @@
+#ifndef NEIGHBOR_LIST_H
+#define NEIGHBOR_LIST_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "morton.h"
+#include "parallel_for.h"
+#include "particle_system.h"
+
+/**
+ * Verlet neighbour list for short-range interactions: for every particle, the particles closer than
+ * cutoff + skin. The list stays valid until some particle has moved more than skin / 2 since it was
+ * built, because until then no pair outside the list can have come within the cutoff; update()
+ * checks that and only rebuilds when needed.
+ *
+ * A rebuild bins the particles into a uniform grid of cells at least cutoff + skin wide (a cell list),
+ * so each particle is only compared with the particles of its own and the adjacent cells: the cost is
+ * linear in the number of particles. With `reorder`, the rebuild also sorts the particles of the
+ * system by the Morton code of their cell (ParticleSystem::permute), so neighbours are close in memory.
+ *
+ * The list is stored in compressed rows: the neighbours of particle i are
+ * neighbors()[offsets()[i]] ... neighbors()[offsets()[i + 1] - 1]. Every pair appears in the lists of
+ * both particles, so the force loop can be split across threads without write conflicts.
+ */
+template <std::size_t N>
+class NeighborList {
+public:
+    /**
+     * Constructor for a neighbour list.
+     * @param cutoff The interaction range.
+     * @param skin The extra distance that lets the list be reused while particles move.
+     * @param reorder Whether to sort the particles by cell in Morton order at every rebuild.
+     */
+    NeighborList(double cutoff, double skin, bool reorder = true)
+        : cutoff_(cutoff), skin_(skin), reorder_(reorder), orderVersion_(0), rebuilds_(0), built_(false) {
+        if (!(cutoff > 0.0) || !(skin >= 0.0)) {
+            throw std::invalid_argument("The neighbour list needs a positive cutoff and a non-negative skin.");
+        }
+    }
+
+    /**
+     * Rebuilds the list if the particles were added, removed or reordered, or if one of them moved
+     * more than skin / 2 since the last build.
+     * @param system The particles; reordered when the list is rebuilt with `reorder`.
+     * @return Whether the list was rebuilt.
+     */
+    bool update(ParticleSystem<N>& system) {
+        if (built_ && system.orderVersion() == orderVersion_ && system.size() + 1 == offsets_.size() &&
+            maxDisplacement2(system) <= 0.25 * skin_ * skin_) {
+            return false;
+        }
+        build(system);
+        return true;
+    }
+
+    /**
+     * Returns the interaction range.
+     */
+    double cutoff() const {
+        return cutoff_;
+    }
+
+    /**
+     * Returns the start of each particle's neighbours in neighbors(), size() + 1 entries.
+     */
+    const std::vector<std::size_t>& offsets() const {
+        return offsets_;
+    }
+
+    /**
+     * Returns the neighbours of all particles, one row per particle.
+     */
+    const std::vector<std::uint32_t>& neighbors() const {
+        return neighbors_;
+    }
+
+    /**
+     * Returns the number of (ordered) pairs in the list.
+     */
+    std::size_t pairCount() const {
+        return neighbors_.size();
+    }
+
+    /**
+     * Returns the number of rebuilds so far.
+     */
+    std::uint64_t rebuilds() const {
+        return rebuilds_;
+    }
+
+private:
+    // Largest squared displacement of any particle since the last build
+    double maxDisplacement2(const ParticleSystem<N>& system) const {
+        double result = 0.0;
+        std::mutex resultMutex;
+        parallelFor(system.size(), system.pool(), [&](std::size_t begin, std::size_t end) {
+            double local = 0.0;
+            for (std::size_t i = begin; i < end; ++i) {
+                double r2 = 0.0;
+                for (std::size_t d = 0; d < N; ++d) {
+                    double dx = system.positions(d)[i] - reference_[d][i];
+                    r2 += dx * dx;
+                }
+                local = std::max(local, r2);
+            }
+            std::lock_guard<std::mutex> lock(resultMutex);
+            result = std::max(result, local);
+        });
+        return result;
+    }
+
+    // Cell coordinates of a particle
+    std::array<std::size_t, N> cellOf(const ParticleSystem<N>& system, std::size_t i) const {
+        std::array<std::size_t, N> cell;
+        for (std::size_t d = 0; d < N; ++d) {
+            double c = (system.positions(d)[i] - lower_[d]) / cellSide_[d];
+            cell[d] = c <= 0.0 ? 0 : std::min(dims_[d] - 1, static_cast<std::size_t>(c));
+        }
+        return cell;
+    }
+
+    std::size_t linearCell(const std::array<std::size_t, N>& cell) const {
+        std::size_t index = 0;
+        for (std::size_t d = N; d-- > 0;) {
+            index = index * dims_[d] + cell[d];
+        }
+        return index;
+    }
+
+    void setUpGrid(const ParticleSystem<N>& system) {
+        const std::size_t count = system.size();
+        const double range = cutoff_ + skin_;
+        std::size_t cells = 1;
+        for (std::size_t d = 0; d < N; ++d) {
+            const double* x = system.positions(d);
+            double lo = count ? x[0] : 0.0, hi = lo;
+            for (std::size_t i = 1; i < count; ++i) {
+                lo = std::min(lo, x[i]);
+                hi = std::max(hi, x[i]);
+            }
+            lower_[d] = lo;
+            extent_[d] = hi - lo;
+            dims_[d] = std::max<std::size_t>(1, static_cast<std::size_t>(extent_[d] / range));
+            cells *= dims_[d];
+        }
+        // A sparse system would have mostly empty cells: use larger cells, at most about two per particle
+        const double limit = 2.0 * count + 1.0;
+        if (cells > limit) {
+            const double shrink = std::pow(limit / cells, 1.0 / N);
+            for (std::size_t d = 0; d < N; ++d) {
+                dims_[d] = std::max<std::size_t>(1, static_cast<std::size_t>(dims_[d] * shrink));
+            }
+        }
+        for (std::size_t d = 0; d < N; ++d) {
+            cellSide_[d] = extent_[d] > 0.0 ? extent_[d] / dims_[d] : range;
+        }
+    }
+
+    void build(ParticleSystem<N>& system) {
+        const std::size_t count = system.size();
+        if (count > std::size_t(UINT32_MAX)) {
+            throw std::length_error("Too many particles for the neighbour list.");
+        }
+        setUpGrid(system);
+
+        if (reorder_ && count > 1) {
+            // Sort the particles by the Morton code of their cell
+            std::vector<std::pair<std::uint64_t, std::size_t>> keys(count);
+            parallelFor(count, system.pool(), [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    std::array<std::size_t, N> cell = cellOf(system, i);
+                    std::array<std::uint64_t, N> coordinates;
+                    for (std::size_t d = 0; d < N; ++d) {
+                        coordinates[d] = cell[d];
+                    }
+                    keys[i] = {mortonEncode<N>(coordinates), i};
+                }
+            });
+            parallelSort(keys, [](const auto& a, const auto& b) { return a.first < b.first; }, system.pool());
+            std::vector<std::size_t> order(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                order[i] = keys[i].second;
+            }
+            system.permute(order);
+        }
+
+        // Cell list: the particles of each cell, grouped by a counting sort
+        std::size_t cells = 1;
+        for (std::size_t d = 0; d < N; ++d) {
+            cells *= dims_[d];
+        }
+        std::vector<std::size_t> cellIndex(count);
+        cellStart_.assign(cells + 1, 0);
+        for (std::size_t i = 0; i < count; ++i) {
+            cellIndex[i] = linearCell(cellOf(system, i));
+            ++cellStart_[cellIndex[i] + 1];
+        }
+        for (std::size_t c = 0; c < cells; ++c) {
+            cellStart_[c + 1] += cellStart_[c];
+        }
+        cellParticles_.resize(count);
+        std::vector<std::size_t> fill(cellStart_.begin(), cellStart_.end() - 1);
+        for (std::size_t i = 0; i < count; ++i) {
+            cellParticles_[fill[cellIndex[i]]++] = static_cast<std::uint32_t>(i);
+        }
+
+        // Neighbour list in two passes: count each row, then fill it
+        const double range2 = (cutoff_ + skin_) * (cutoff_ + skin_);
+        offsets_.assign(count + 1, 0);
+        parallelFor(count, system.pool(), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                std::size_t found = 0;
+                forEachCandidate(system, i, range2, [&found](std::uint32_t) { ++found; });
+                offsets_[i + 1] = found;
+            }
+        });
+        for (std::size_t i = 0; i < count; ++i) {
+            offsets_[i + 1] += offsets_[i];
+        }
+        neighbors_.resize(offsets_[count]);
+        parallelFor(count, system.pool(), [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                std::uint32_t* row = neighbors_.data() + offsets_[i];
+                forEachCandidate(system, i, range2, [&row](std::uint32_t j) { *row++ = j; });
+            }
+        });
+
+        for (std::size_t d = 0; d < N; ++d) {
+            reference_[d].assign(system.positions(d), system.positions(d) + count);
+        }
+        orderVersion_ = system.orderVersion();
+        built_ = true;
+        ++rebuilds_;
+    }
+
+    // Calls found(j) for every particle j != i of the adjacent cells closer than sqrt(range2)
+    template <typename Found>
+    void forEachCandidate(const ParticleSystem<N>& system, std::size_t i, double range2, Found found) const {
+        const std::array<std::size_t, N> home = cellOf(system, i);
+        std::array<double, N> xi;
+        for (std::size_t d = 0; d < N; ++d) {
+            xi[d] = system.positions(d)[i];
+        }
+
+        // Visit the 3^N cells around the home cell (fewer at the edges of the grid)
+        std::array<std::size_t, N> low, high, cell;
+        for (std::size_t d = 0; d < N; ++d) {
+            low[d] = home[d] > 0 ? home[d] - 1 : 0;
+            high[d] = std::min(dims_[d] - 1, home[d] + 1);
+        }
+        cell = low;
+        for (;;) {
+            const std::size_t c = linearCell(cell);
+            for (std::size_t k = cellStart_[c]; k < cellStart_[c + 1]; ++k) {
+                const std::uint32_t j = cellParticles_[k];
+                if (j == i) {
+                    continue;
+                }
+                double r2 = 0.0;
+                for (std::size_t d = 0; d < N; ++d) {
+                    double dx = system.positions(d)[j] - xi[d];
+                    r2 += dx * dx;
+                }
+                if (r2 < range2) {
+                    found(j);
+                }
+            }
+            // Next cell, odometer style
+            std::size_t d = 0;
+            while (d < N && cell[d] == high[d]) {
+                cell[d] = low[d];
+                ++d;
+            }
+            if (d == N) {
+                break;
+            }
+            ++cell[d];
+        }
+    }
+
+    double cutoff_;                               // Interaction range
+    double skin_;                                 // Extra range that lets the list be reused
+    bool reorder_;                                // Sort particles by cell in Morton order on rebuild
+    std::array<double, N> lower_{};               // Lower corner of the cell grid
+    std::array<double, N> extent_{};              // Size of the cell grid
+    std::array<double, N> cellSide_{};            // Side of a cell in each dimension
+    std::array<std::size_t, N> dims_{};           // Cells in each dimension
+    std::vector<std::size_t> cellStart_;          // Start of each cell in cellParticles_
+    std::vector<std::uint32_t> cellParticles_;    // Particles grouped by cell
+    std::vector<std::size_t> offsets_;            // Start of each particle's row in neighbors_
+    std::vector<std::uint32_t> neighbors_;        // Neighbour rows
+    std::array<std::vector<double>, N> reference_; // Positions at the last build
+    std::uint64_t orderVersion_;                  // ParticleSystem::orderVersion() at the last build
+    std::uint64_t rebuilds_;                      // Number of builds
+    bool built_;                                  // Whether the list has been built
+};
+
+/**
+ * Parameters of the Lennard-Jones potential U(r) = 4 epsilon ((sigma / r)^12 - (sigma / r)^6),
+ * truncated at r = cutoff (in units of length, not of sigma).
+ */
+struct LennardJonesParameters {
+    double epsilon = 1.0; // Depth of the potential well
+    double sigma = 1.0;   // Distance at which the potential is zero
+    double cutoff = 2.5;  // Interaction range
+    double skin = 0.3;    // Neighbour list skin
+    bool reorder = true;  // Sort particles by cell in Morton order when the list is rebuilt
+};
+
+/**
+ * Force model for particles interacting through a truncated Lennard-Jones potential, using a
+ * NeighborList that is rebuilt only when the particles have moved far enough.
+ */
+template <std::size_t N>
+class LennardJones {
+public:
+    explicit LennardJones(LennardJonesParameters parameters = LennardJonesParameters())
+        : parameters_(parameters), list_(parameters.cutoff, parameters.skin, parameters.reorder),
+          energy_(0.0), pairsEvaluated_(0) {}
+
+    void computeForces(ParticleSystem<N>& system, double) {
+        list_.update(system);
+
+        const double cutoff2 = parameters_.cutoff * parameters_.cutoff;
+        const double sigma2 = parameters_.sigma * parameters_.sigma;
+        const double epsilon = parameters_.epsilon;
+        const std::vector<std::size_t>& offsets = list_.offsets();
+        const std::vector<std::uint32_t>& neighbors = list_.neighbors();
+        const ParticleSystem<N>& particles = system;  // Read-only view for the worker threads
+        double energy = 0.0;
+        std::mutex energyMutex;
+        parallelFor(system.size(), system.pool(), [&](std::size_t begin, std::size_t end) {
+            std::array<const double*, N> x;
+            for (std::size_t d = 0; d < N; ++d) {
+                x[d] = particles.positions(d);
+            }
+            double local = 0.0;
+            for (std::size_t i = begin; i < end; ++i) {
+                std::array<double, N> force{};
+                for (std::size_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+                    const std::uint32_t j = neighbors[k];
+                    std::array<double, N> dx;
+                    double r2 = 0.0;
+                    for (std::size_t d = 0; d < N; ++d) {
+                        dx[d] = x[d][i] - x[d][j];
+                        r2 += dx[d] * dx[d];
+                    }
+                    if (r2 >= cutoff2) {
+                        continue;
+                    }
+                    const double s2 = sigma2 / r2;
+                    const double s6 = s2 * s2 * s2;
+                    // F = -dU/dr along (x_i - x_j) / r, written in powers of sigma^2 / r^2
+                    const double scale = 24.0 * epsilon * s6 * (2.0 * s6 - 1.0) / r2;
+                    for (std::size_t d = 0; d < N; ++d) {
+                        force[d] += scale * dx[d];
+                    }
+                    local += 2.0 * epsilon * s6 * (s6 - 1.0);  // Half of U: the pair is visited twice
+                }
+                for (std::size_t d = 0; d < N; ++d) {
+                    system.forces(d)[i] = force[d];
+                }
+            }
+            std::lock_guard<std::mutex> lock(energyMutex);
+            energy += local;
+        });
+        energy_ = energy;
+        pairsEvaluated_ = neighbors.size();
+    }
+
+    /**
+     * Returns the potential energy of the last computeForces call.
+     */
+    double potentialEnergy() const {
+        return energy_;
+    }
+
+    /**
+     * Returns the number of (ordered) pairs evaluated by the last computeForces call.
+     */
+    std::size_t pairsEvaluated() const {
+        return pairsEvaluated_;
+    }
+
+    /**
+     * Returns the neighbour list.
+     */
+    const NeighborList<N>& neighborList() const {
+        return list_;
+    }
+
+private:
+    LennardJonesParameters parameters_; // Potential and neighbour list settings
+    NeighborList<N> list_;              // Neighbour list
+    double energy_;                     // Potential energy of the last evaluation
+    std::size_t pairsEvaluated_;        // Pairs evaluated by the last evaluation
+};
+
+#endif // NEIGHBOR_LIST_H
@@ -0,0 +1,243 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Returns the number of worker threads to use when none is requested.
+ * @param requested The requested number of threads; 0 means one per hardware thread.
+ * @return The number of threads, at least 1.
+ */
+inline unsigned resolveThreadCount(unsigned requested) {
+    if (requested != 0) {
+        return requested;
+    }
+    unsigned hardware = std::thread::hardware_concurrency();
+    return hardware != 0 ? hardware : 1;
+}
+
+/**
+ * A fixed set of worker threads that run batches of tasks. The workers are started once and
+ * sleep between batches, so a batch costs a wake-up instead of creating and joining threads,
+ * which matters for kernels that run every time step. The calling thread takes part in every
+ * batch, so a pool of n threads has n - 1 workers.
+ */
+class ThreadPool {
+public:
+    /**
+     * Constructor to start the workers.
+     * @param threads The number of threads including the caller; 0 means one per hardware thread.
+     */
+    explicit ThreadPool(unsigned threads = 0) {
+        const unsigned total = resolveThreadCount(threads);
+        workers_.reserve(total - 1);
+        for (unsigned w = 1; w < total; ++w) {
+            workers_.emplace_back([this, w] { workerLoop(w); });
+        }
+    }
+
+    /**
+     * Destructor to stop and join the workers.
+     */
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        start_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Returns the number of threads that run a batch, including the caller.
+     * @return The number of threads.
+     */
+    unsigned size() const {
+        return static_cast<unsigned>(workers_.size()) + 1;
+    }
+
+    /**
+     * Calls task(t) for every t in [0, tasks) and waits for all of them. Thread k runs tasks k,
+     * k + size(), k + 2 size(), ..., and the caller is thread 0. If the pool is already running a
+     * batch (a nested call from a task, or a call from another thread), the tasks run one after
+     * another on the caller instead. The first exception thrown by a task, in task order, is rethrown.
+     * @param tasks The number of tasks.
+     * @param task The function called with each task index.
+     */
+    template <typename Task>
+    void run(std::size_t tasks, Task task) {
+        bool idle = false;
+        if (tasks <= 1 || size() == 1 || !busy_.compare_exchange_strong(idle, true, std::memory_order_acquire)) {
+            for (std::size_t t = 0; t < tasks; ++t) {
+                task(t);
+            }
+            return;
+        }
+        // Marks the pool idle again when the batch ends, also when a task throws
+        struct Release {
+            std::atomic<bool>& busy;
+            ~Release() {
+                busy.store(false, std::memory_order_release);
+            }
+        } release{busy_};
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            invoke_ = [](void* context, std::size_t t) { (*static_cast<Task*>(context))(t); };
+            context_ = &task;
+            tasks_ = tasks;
+            threads_ = std::min<std::size_t>(tasks, size());
+            pending_ = threads_ - 1;
+            errors_.assign(tasks, nullptr);
+            ++generation_;
+        }
+        start_.notify_all();
+        execute(0);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return pending_ == 0; });
+        for (const std::exception_ptr& error : errors_) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+private:
+    // Runs the tasks of thread k in the current batch, keeping their exceptions for the caller
+    void execute(std::size_t k) {
+        for (std::size_t t = k; t < tasks_; t += threads_) {
+            try {
+                invoke_(context_, t);
+            } catch (...) {
+                errors_[t] = std::current_exception();
+            }
+        }
+    }
+
+    // Waits for batches and runs the tasks of thread w in each batch that has some
+    void workerLoop(std::size_t w) {
+        std::uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+                if (stop_) {
+                    return;
+                }
+                seen = generation_;
+                if (w >= threads_) {
+                    continue;
+                }
+            }
+            execute(w);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--pending_ == 0) {
+                done_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;               // Background workers, threads 1 to size() - 1
+    std::atomic<bool> busy_{false};                  // Set while a batch runs
+    std::mutex mutex_;                               // Protects the batch state below
+    std::condition_variable start_;                  // Signals a new batch or shutdown
+    std::condition_variable done_;                   // Signals that the workers finished the batch
+    void (*invoke_)(void*, std::size_t) = nullptr;   // Calls the task of the current batch
+    void* context_ = nullptr;                        // The task of the current batch
+    std::size_t tasks_ = 0;                          // Number of tasks in the current batch
+    std::size_t threads_ = 0;                        // Threads that take part in the current batch
+    std::size_t pending_ = 0;                        // Worker tasks of the current batch still running
+    std::uint64_t generation_ = 0;                   // Incremented for every batch
+    std::vector<std::exception_ptr> errors_;         // Exception thrown by each task, if any
+    bool stop_ = false;                              // Set when the pool shuts down
+};
+
+/**
+ * Splits the index range [0, count) into one contiguous block per thread of the pool and calls
+ * body(begin, end) for each block. The calling thread processes the first block.
+ * Blocks are aligned to `grain` indices so that threads do not share cache lines of the
+ * arrays they write (use 8 for arrays of double).
+ * @param count The number of indices.
+ * @param pool The threads that run the blocks.
+ * @param body The function called with each block.
+ * @param grain The alignment of block boundaries, in indices.
+ */
+template <typename Body>
+void parallelFor(std::size_t count, ThreadPool& pool, Body body, std::size_t grain = 8) {
+    std::size_t blocks = std::min<std::size_t>(pool.size(), (count + grain - 1) / grain);
+    if (blocks <= 1) {
+        if (count != 0) {
+            body(std::size_t(0), count);
+        }
+        return;
+    }
+
+    // Block size rounded up to a multiple of the grain
+    std::size_t block = ((count + blocks - 1) / blocks + grain - 1) / grain * grain;
+    pool.run(blocks, [&body, count, block](std::size_t b) {
+        std::size_t begin = std::min(count, b * block);
+        std::size_t end = std::min(count, begin + block);
+        if (begin < end) {
+            body(begin, end);
+        }
+    });
+}
+
+/**
+ * Sorts a vector in parallel: contiguous blocks are sorted by separate threads, then merged
+ * pairwise, with the merges of each round running in parallel. The result is the same as
+ * std::stable_sort for any number of threads.
+ * @param values The values to sort.
+ * @param less The strict weak ordering.
+ * @param pool The threads that sort and merge the blocks.
+ */
+template <typename T, typename Allocator, typename Less>
+void parallelSort(std::vector<T, Allocator>& values, Less less, ThreadPool& pool) {
+    const std::size_t count = values.size();
+    const std::size_t blocks = std::min<std::size_t>(pool.size(), count / 4096 + 1);
+    if (blocks <= 1) {
+        std::stable_sort(values.begin(), values.end(), less);
+        return;
+    }
+
+    std::vector<std::size_t> bounds(blocks + 1);
+    for (std::size_t b = 0; b <= blocks; ++b) {
+        bounds[b] = count * b / blocks;
+    }
+    parallelFor(blocks, pool, [&](std::size_t first, std::size_t last) {
+        for (std::size_t b = first; b < last; ++b) {
+            std::stable_sort(values.begin() + bounds[b], values.begin() + bounds[b + 1], less);
+        }
+    }, 1);
+
+    std::vector<T, Allocator> buffer(count);
+    for (std::size_t width = 1; width < blocks; width *= 2) {
+        std::size_t pairs = (blocks + 2 * width - 1) / (2 * width);
+        parallelFor(pairs, pool, [&](std::size_t first, std::size_t last) {
+            for (std::size_t p = first; p < last; ++p) {
+                std::size_t lo = bounds[2 * width * p];
+                std::size_t mid = bounds[std::min(blocks, 2 * width * p + width)];
+                std::size_t hi = bounds[std::min(blocks, 2 * width * (p + 1))];
+                std::merge(values.begin() + lo, values.begin() + mid, values.begin() + mid, values.begin() + hi,
+                           buffer.begin() + lo, less);
+            }
+        }, 1);
+        values.swap(buffer);
+    }
+}
+
+#endif // PARALLEL_FOR_H
@@ -0,0 +1,164 @@
+#ifndef PARTICLE_H
+#define PARTICLE_H
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+
+#include "integrator.h"
+#include "vector.h"
+
+/**
+ * Sinusoidal external force at time t: (sin(2t), cos(2t)) in 2D, (sin(2t), cos(2t), cos(1.5t)) in 3D.
+ * The dimension is a template parameter, so the choice is made at compile time.
+ * @param t The current time.
+ * @return The force vector.
+ */
+template <std::size_t N>
+Vector<double, N> externalForce(double t) {
+    static_assert(N == 2 || N == 3, "The external force is defined in 2D and 3D only.");
+    if constexpr (N == 2) {
+        return Vector<double, 2>(std::sin(2.0 * t), std::cos(2.0 * t));
+    } else {
+        return Vector<double, 3>(std::sin(2.0 * t), std::cos(2.0 * t), std::cos(1.5 * t));
+    }
+}
+
+/**
+ * Exact motion of a particle of mass m under externalForce(): integrating F(t) / m twice from t = 0
+ * gives, per component, v(t) = v0 + (1 - cos 2t) / (2m), sin(2t) / (2m), sin(1.5t) / (1.5m) and
+ * x(t) = x0 + v0 t + (t / 2 - sin(2t) / 4) / m, (1 - cos 2t) / (4m), (1 - cos 1.5t) / (2.25m).
+ * Used to measure the error of the time integrators.
+ * @param t The time.
+ * @param mass The mass of the particle.
+ * @param x0 The position at t = 0.
+ * @param v0 The velocity at t = 0.
+ * @param x Receives the position at t.
+ * @param v Receives the velocity at t.
+ */
+template <std::size_t N>
+void exactMotion(double t, double mass, const Vector<double, N>& x0, const Vector<double, N>& v0,
+                 Vector<double, N>& x, Vector<double, N>& v) {
+    static_assert(N == 2 || N == 3, "The external force is defined in 2D and 3D only.");
+    Vector<double, N> dv, dx;
+    dv[0] = (1.0 - std::cos(2.0 * t)) / 2.0;
+    dx[0] = t / 2.0 - std::sin(2.0 * t) / 4.0;
+    dv[1] = std::sin(2.0 * t) / 2.0;
+    dx[1] = (1.0 - std::cos(2.0 * t)) / 4.0;
+    if constexpr (N == 3) {
+        dv[2] = std::sin(1.5 * t) / 1.5;
+        dx[2] = (1.0 - std::cos(1.5 * t)) / 2.25;
+    }
+    v = v0 + dv * (1.0 / mass);
+    x = x0 + v0 * t + dx * (1.0 / mass);
+}
+
+// Particle class for simulating motion in N dimensions (2D or 3D)
+template <std::size_t N>
+class Particle {
+public:
+    using VectorN = Vector<double, N>;
+
+    /**
+     * Constructor to initialize a particle with its mass, position, velocity, and force.
+     * @param mass The mass of the particle (must be positive).
+     * @param position The initial position vector of the particle.
+     * @param velocity The initial velocity vector of the particle.
+     * @param force The initial force vector acting on the particle.
+     */
+    Particle(double mass, const VectorN& position, const VectorN& velocity, const VectorN& force)
+        : mass_(mass), position_(position), velocity_(velocity), force_(force) {
+        if (!(mass > 0.0)) {
+            throw std::invalid_argument("Particle mass must be positive.");
+        }
+        std::cout << "Particle created at position " << position_ << std::endl;
+    }
+
+    /**
+     * Destructor for the Particle class.
+     */
+    ~Particle() {
+        std::cout << "Particle destroyed at position " << position_ << std::endl;
+    }
+
+    /**
+     * Updates the particle's position using Euler's method.
+     * The new position is computed based on the velocity and time step.
+     * @param dt The time step for updating the position.
+     */
+    void updatePosition(double dt) {
+        position_ = position_ + velocity_ * dt;  // Update position using velocity and time step
+    }
+
+    /**
+     * Prints the current state of the particle, including its position and velocity.
+     */
+    void printState() const {
+        std::cout << "Particle - Position: " << position_ << ", Velocity: " << velocity_ << std::endl;
+    }
+
+    /**
+     * Updates the particle's velocity and position based on the sinusoidal external force.
+     * @param t The current time.
+     * @param dt The time step for updating velocity and position.
+     */
+    void update(double t, double dt) {
+        // Sinusoidal force for this dimension; no allocation, no runtime branch
+        force_ = externalForce<N>(t);
+
+        // Update velocity using Euler's method: v_{n+1} = v_n + dt * F_n / m
+        velocity_ = velocity_ + force_ * (1.0 / mass_) * dt;
+
+        // Update position using Euler's method: P_{n+1} = P_n + dt * v_n
+        updatePosition(dt);
+    }
+
+    /**
+     * Advances the particle by one step of the given integrator under the sinusoidal external force,
+     * with acceleration F / m.
+     * @param t The current time.
+     * @param dt The step size (for adaptive integrators, the largest allowed step).
+     * @param integrator The time integrator.
+     * @return The step actually taken.
+     */
+    double update(double t, double dt, Integrator<N>& integrator) {
+        auto acceleration = [this](double time, const VectorN&, const VectorN&) {
+            force_ = externalForce<N>(time);  // The force at the last evaluation
+            return VectorN(force_ * (1.0 / mass_));
+        };
+        return integrator.step(acceleration, t, dt, position_, velocity_);
+    }
+
+    /**
+     * Returns the mass of the particle.
+     * @return The mass.
+     */
+    double getMass() const {
+        return mass_;
+    }
+
+    /**
+     * Returns the current position of the particle.
+     * @return A reference to the position vector of the particle.
+     */
+    const VectorN& getPosition() const {
+        return position_;
+    }
+
+    /**
+     * Returns the current velocity of the particle.
+     * @return A reference to the velocity vector of the particle.
+     */
+    const VectorN& getVelocity() const {
+        return velocity_;
+    }
+
+private:
+    double mass_;      // The mass of the particle (a = F / m)
+    VectorN position_; // The current position of the particle
+    VectorN velocity_; // The current velocity of the particle
+    VectorN force_;    // The force acting on the particle
+};
+
+#endif // PARTICLE_H
@@ -0,0 +1,492 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "parallel_for.h"
+#include "particle.h"
+#include "vector.h"
+
+// Allocator returning memory aligned to `Alignment` bytes, so the per-component arrays start on a cache line
+template <typename T, std::size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, std::size_t) {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const {
+        return false;
+    }
+};
+
+// Detects force models that apply the same force to every particle through a member
+//     Vector<double, N> uniformForce(double t) const
+// The kernels then use that force directly instead of filling and reading the force arrays.
+template <typename ForceModel, typename = void>
+struct HasUniformForce : std::false_type {};
+
+template <typename ForceModel>
+struct HasUniformForce<ForceModel, std::void_t<decltype(std::declval<const std::decay_t<ForceModel>&>().uniformForce(0.0))>>
+    : std::true_type {};
+
+/**
+ * A population of particles in N dimensions stored as a structure of arrays: one contiguous,
+ * 64-byte aligned array per component of the positions, velocities and forces, plus one for the
+ * masses. The whole population is advanced at once by loops over these arrays, which the compiler
+ * vectorizes, and the loops are split in contiguous blocks across a thread pool that the system owns,
+ * so the kernels of every step reuse the same threads. Copies of a system share its pool.
+ *
+ * Forces come from a force model, any object with a member
+ *     void computeForces(ParticleSystem<N>& system, double t)
+ * that fills system.forces(d) for every dimension d from the current positions (see ExternalField).
+ * Models whose force is the same for every particle may also provide uniformForce(t) (see HasUniformForce).
+ */
+template <std::size_t N>
+class ParticleSystem {
+public:
+    using VectorN = Vector<double, N>;
+    using Column = std::vector<double, AlignedAllocator<double>>;
+
+    /**
+     * Constructor to create `count` particles of unit mass at rest at the origin.
+     * @param count The number of particles.
+     * @param threads The number of threads used by the kernels; 0 means one per hardware thread.
+     */
+    explicit ParticleSystem(std::size_t count = 0, unsigned threads = 0)
+        : pool_(std::make_shared<ThreadPool>(threads)), orderVersion_(0), forcesValid_(false), forceTime_(0.0) {
+        resize(count);
+    }
+
+    /**
+     * Returns the number of particles.
+     * @return The number of particles.
+     */
+    std::size_t size() const {
+        return mass_.size();
+    }
+
+    /**
+     * Returns the number of threads used by the kernels.
+     * @return The number of threads.
+     */
+    unsigned threads() const {
+        return pool_->size();
+    }
+
+    /**
+     * Sets the number of threads used by the kernels, starting a new pool if the number changes.
+     * @param threads The number of threads; 0 means one per hardware thread.
+     */
+    void setThreads(unsigned threads) {
+        if (resolveThreadCount(threads) != pool_->size()) {
+            pool_ = std::make_shared<ThreadPool>(threads);
+        }
+    }
+
+    /**
+     * Returns the thread pool that runs the kernels, for algorithms that split work over the particles.
+     * @return The thread pool.
+     */
+    ThreadPool& pool() const {
+        return *pool_;
+    }
+
+    /**
+     * Changes the number of particles; new particles have unit mass and are at rest at the origin.
+     * @param count The new number of particles.
+     */
+    void resize(std::size_t count) {
+        for (std::size_t d = 0; d < N; ++d) {
+            position_[d].resize(count, 0.0);
+            velocity_[d].resize(count, 0.0);
+            force_[d].resize(count, 0.0);
+        }
+        std::size_t old = id_.size();
+        mass_.resize(count, 1.0);
+        inverseMass_.resize(count, 1.0);
+        id_.resize(count);
+        for (std::size_t i = old; i < count; ++i) {
+            id_[i] = i;
+        }
+        ++orderVersion_;
+        forcesValid_ = false;
+    }
+
+    /**
+     * Appends a particle.
+     * @param mass The mass of the particle (must be positive).
+     * @param position The initial position.
+     * @param velocity The initial velocity.
+     * @return The index of the new particle.
+     */
+    std::size_t addParticle(double mass, const VectorN& position, const VectorN& velocity) {
+        std::size_t i = size();
+        resize(i + 1);
+        setParticle(i, mass, position, velocity);
+        return i;
+    }
+
+    /**
+     * Sets the state of particle i.
+     * @param i The index of the particle.
+     * @param mass The mass of the particle (must be positive).
+     * @param position The position.
+     * @param velocity The velocity.
+     */
+    void setParticle(std::size_t i, double mass, const VectorN& position, const VectorN& velocity) {
+        if (!(mass > 0.0)) {
+            throw std::invalid_argument("Particle mass must be positive.");
+        }
+        mass_[i] = mass;
+        inverseMass_[i] = 1.0 / mass;
+        for (std::size_t d = 0; d < N; ++d) {
+            position_[d][i] = position[d];
+            velocity_[d][i] = velocity[d];
+        }
+        forcesValid_ = false;
+    }
+
+    /**
+     * Returns the position of particle i.
+     * @param i The index of the particle.
+     * @return The position vector.
+     */
+    VectorN getPosition(std::size_t i) const {
+        return gather(position_, i);
+    }
+
+    /**
+     * Returns the velocity of particle i.
+     * @param i The index of the particle.
+     * @return The velocity vector.
+     */
+    VectorN getVelocity(std::size_t i) const {
+        return gather(velocity_, i);
+    }
+
+    /**
+     * Returns the force last computed for particle i.
+     * @param i The index of the particle.
+     * @return The force vector.
+     */
+    VectorN getForce(std::size_t i) const {
+        return gather(force_, i);
+    }
+
+    /**
+     * Returns the mass of particle i.
+     * @param i The index of the particle.
+     * @return The mass.
+     */
+    double getMass(std::size_t i) const {
+        return mass_[i];
+    }
+
+    /**
+     * Returns the identifier of particle i: the index it was created with, which permute() keeps.
+     * @param i The index of the particle.
+     * @return The identifier.
+     */
+    std::size_t getId(std::size_t i) const {
+        return id_[i];
+    }
+
+    /**
+     * Returns a counter that changes whenever particles are added, removed or reordered, so force
+     * models can tell when per-particle data they cached (e.g. neighbour lists) refers to stale indices.
+     * @return The order version.
+     */
+    std::uint64_t orderVersion() const {
+        return orderVersion_;
+    }
+
+    /**
+     * Reorders the particles so that the new particle i is the old particle order[i]; all arrays,
+     * including the forces and identifiers, move together. Used to keep particles that are close in
+     * space close in memory (e.g. sorted by Morton code).
+     * @param order A permutation of 0, ..., size() - 1.
+     */
+    void permute(const std::vector<std::size_t>& order) {
+        const std::size_t count = size();
+        if (order.size() != count) {
+            throw std::invalid_argument("The permutation must have one entry per particle.");
+        }
+        std::vector<bool> seen(count, false);
+        for (std::size_t i : order) {
+            if (i >= count || seen[i]) {
+                throw std::invalid_argument("The order is not a permutation of the particles.");
+            }
+            seen[i] = true;
+        }
+
+        Column scratch(count);
+        auto gatherColumn = [&](Column& column) {
+            parallelFor(count, *pool_, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    scratch[i] = column[order[i]];
+                }
+            });
+            column.swap(scratch);
+        };
+        for (std::size_t d = 0; d < N; ++d) {
+            gatherColumn(position_[d]);
+            gatherColumn(velocity_[d]);
+            gatherColumn(force_[d]);
+        }
+        gatherColumn(mass_);
+        gatherColumn(inverseMass_);
+
+        std::vector<std::size_t> ids(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            ids[i] = id_[order[i]];
+        }
+        id_.swap(ids);
+        ++orderVersion_;
+    }
+
+    /**
+     * Direct access to component d of all positions, for force models and output.
+     * Call invalidateForces() after moving particles through the non-const overload.
+     * @param d The component (0 = x, 1 = y, 2 = z).
+     * @return A pointer to size() contiguous values.
+     */
+    double* positions(std::size_t d) {
+        return position_[d].data();
+    }
+    const double* positions(std::size_t d) const {
+        return position_[d].data();
+    }
+
+    /**
+     * Direct access to component d of all velocities.
+     * @param d The component.
+     * @return A pointer to size() contiguous values.
+     */
+    double* velocities(std::size_t d) {
+        return velocity_[d].data();
+    }
+    const double* velocities(std::size_t d) const {
+        return velocity_[d].data();
+    }
+
+    /**
+     * Direct access to component d of all forces; force models write here.
+     * @param d The component.
+     * @return A pointer to size() contiguous values.
+     */
+    double* forces(std::size_t d) {
+        return force_[d].data();
+    }
+    const double* forces(std::size_t d) const {
+        return force_[d].data();
+    }
+
+    /**
+     * Direct access to the masses (read-only; use setParticle to change a mass).
+     * @return A pointer to size() contiguous values.
+     */
+    const double* masses() const {
+        return mass_.data();
+    }
+
+    /**
+     * Marks the stored forces as stale, so the next Verlet step recomputes them first.
+     */
+    void invalidateForces() {
+        forcesValid_ = false;
+    }
+
+    /**
+     * Fills the forces for the current positions at time t.
+     * @param model The force model.
+     * @param t The current time.
+     */
+    template <typename ForceModel>
+    void computeForces(ForceModel&& model, double t) {
+        model.computeForces(*this, t);
+        forcesValid_ = true;
+        forceTime_ = t;
+    }
+
+    /**
+     * Advances every particle by one step of Euler's method, as Particle::update does:
+     * v_{n+1} = v_n + dt * F(x_n, t) / m, then x_{n+1} = x_n + dt * v_{n+1}.
+     * @param model The force model.
+     * @param t The current time.
+     * @param dt The time step.
+     */
+    template <typename ForceModel>
+    void stepEuler(ForceModel&& model, double t, double dt) {
+        if constexpr (HasUniformForce<ForceModel>::value) {
+            // The same force for every particle: keep it in registers instead of the force arrays
+            const VectorN force = model.uniformForce(t);
+            forEachTile([&](std::size_t d, std::size_t begin, std::size_t end) {
+                kickDrift(d, begin, end, UniformColumn{force[d]}, dt, dt);
+            });
+        } else {
+            computeForces(model, t);
+            forEachTile([&](std::size_t d, std::size_t begin, std::size_t end) {
+                kickDrift(d, begin, end, force_[d].data(), dt, dt);
+            });
+        }
+        forcesValid_ = false;
+    }
+
+    /**
+     * Advances every particle by one step of the velocity Verlet method (kick, drift, kick):
+     * v_{n+1/2} = v_n + dt/2 * F_n / m, x_{n+1} = x_n + dt * v_{n+1/2}, v_{n+1} = v_{n+1/2} + dt/2 * F_{n+1} / m.
+     * The forces at the end of a step are reused by the next one, so each step costs one force evaluation.
+     * @param model The force model.
+     * @param t The current time.
+     * @param dt The time step.
+     */
+    template <typename ForceModel>
+    void stepVerlet(ForceModel&& model, double t, double dt) {
+        const double half = 0.5 * dt;
+        if constexpr (HasUniformForce<ForceModel>::value) {
+            // Both forces are known up front, so the whole step is a single pass
+            const VectorN start = model.uniformForce(t);
+            const VectorN finish = model.uniformForce(t + dt);
+            forEachTile([&](std::size_t d, std::size_t begin, std::size_t end) {
+                kickDrift(d, begin, end, UniformColumn{start[d]}, half, dt);
+                kick(d, begin, end, UniformColumn{finish[d]}, half);
+            });
+            forcesValid_ = false;
+        } else {
+            if (!forcesValid_ || forceTime_ != t) {
+                computeForces(model, t);
+            }
+            forEachTile([&](std::size_t d, std::size_t begin, std::size_t end) {
+                kickDrift(d, begin, end, force_[d].data(), half, dt);
+            });
+            computeForces(model, t + dt);
+            forEachTile([&](std::size_t d, std::size_t begin, std::size_t end) {
+                kick(d, begin, end, force_[d].data(), half);
+            });
+        }
+    }
+
+private:
+    // Particles per tile: the tile's inverse masses stay in L1 while its N components are processed
+    static constexpr std::size_t TILE = 1024;
+
+    // Force column whose entries are all the same value
+    struct UniformColumn {
+        double value;
+        double operator[](std::size_t) const {
+            return value;
+        }
+    };
+
+    // Calls body(d, begin, end) for every component d of every tile, tiles split across the threads
+    template <typename Body>
+    void forEachTile(Body body) {
+        parallelFor(size(), *pool_, [&body](std::size_t begin, std::size_t end) {
+            for (std::size_t tile = begin; tile < end; tile += TILE) {
+                std::size_t tile_end = std::min(end, tile + TILE);
+                for (std::size_t d = 0; d < N; ++d) {
+                    body(d, tile, tile_end);
+                }
+            }
+        });
+    }
+
+    // v += kick_dt * F / m, then x += drift_dt * v, over particles [begin, end) of component d
+    template <typename Forces>
+    void kickDrift(std::size_t d, std::size_t begin, std::size_t end, Forces f, double kick_dt, double drift_dt) {
+        double* __restrict x = position_[d].data();
+        double* __restrict v = velocity_[d].data();
+        const double* __restrict w = inverseMass_.data();
+        for (std::size_t i = begin; i < end; ++i) {
+            double velocity = v[i] + f[i] * (kick_dt * w[i]);
+            v[i] = velocity;
+            x[i] = x[i] + velocity * drift_dt;
+        }
+    }
+
+    // v += kick_dt * F / m over particles [begin, end) of component d
+    template <typename Forces>
+    void kick(std::size_t d, std::size_t begin, std::size_t end, Forces f, double kick_dt) {
+        double* __restrict v = velocity_[d].data();
+        const double* __restrict w = inverseMass_.data();
+        for (std::size_t i = begin; i < end; ++i) {
+            v[i] = v[i] + f[i] * (kick_dt * w[i]);
+        }
+    }
+
+    VectorN gather(const std::array<Column, N>& columns, std::size_t i) const {
+        VectorN result;
+        for (std::size_t d = 0; d < N; ++d) {
+            result[d] = columns[d][i];
+        }
+        return result;
+    }
+
+    std::array<Column, N> position_;   // Positions, one array per component
+    std::array<Column, N> velocity_;   // Velocities, one array per component
+    std::array<Column, N> force_;      // Forces, one array per component
+    Column mass_;                      // Masses
+    Column inverseMass_;               // 1 / mass, so the kernels multiply instead of divide
+    std::vector<std::size_t> id_;      // Index each particle was created with
+    std::shared_ptr<ThreadPool> pool_; // Threads used by the kernels
+    std::uint64_t orderVersion_;       // Changed when particles are added, removed or reordered
+    bool forcesValid_;                 // Whether force_ matches the current positions at forceTime_
+    double forceTime_;                 // Time at which force_ was computed
+};
+
+/**
+ * Force model applying the sinusoidal external force of externalForce() to every particle.
+ * The force depends only on t, so it is evaluated once per call and broadcast.
+ */
+template <std::size_t N>
+struct ExternalField {
+    Vector<double, N> uniformForce(double t) const {
+        return externalForce<N>(t);
+    }
+
+    void computeForces(ParticleSystem<N>& system, double t) const {
+        const Vector<double, N> force = externalForce<N>(t);
+        parallelFor(system.size(), system.pool(), [&system, &force](std::size_t begin, std::size_t end) {
+            for (std::size_t d = 0; d < N; ++d) {
+                double* f = system.forces(d);
+                const double value = force[d];
+                for (std::size_t i = begin; i < end; ++i) {
+                    f[i] = value;
+                }
+            }
+        });
+    }
+};
+
+#endif // PARTICLE_SYSTEM_H
@@ -1,6 +1,15 @@
 #include <iostream>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <type_traits>
 #include "homework2.cpp"  
+#include "parallel_for.h"
+#include "particle_system.h"
+#include "barnes_hut.h"
+#include "neighbor_list.h"
+#include "ensemble.h"
+#include "trajectory.h"
 
 using namespace std;
 
@@ -37,6 +46,690 @@ void test_vector_operations() {
     cout << "Vector operations tests passed!" << endl;
 }
 
+// Test function to validate the fixed-size Vector<T, N>
+void test_fixed_dimension_vector() {
+    cout << "Running fixed-dimension vector tests..." << endl;
+
+    // The dimension is deduced from the constructor arguments and known at compile time
+    Vector v2(1.0, 2.0);
+    Vector v3(1.0, 2.0, 3.0);
+    static_assert(is_same<decltype(v2), Vector<double, 2>>::value, "Vector(x, y) must be 2D");
+    static_assert(is_same<decltype(v3), Vector<double, 3>>::value, "Vector(x, y, z) must be 3D");
+    static_assert(decltype(v3)::size() == 3, "size() must be a compile-time constant");
+    static_assert(sizeof(Vector<double, 3>) == 3 * sizeof(double), "Vector must store its components inline");
+
+    // 3D arithmetic
+    Vector<double, 3> w(4.0, 5.0, 6.0);
+    Vector<double, 3> sum = v3 + w;
+    assert(sum[0] == 5.0 && sum[1] == 7.0 && sum[2] == 9.0);
+    Vector<double, 3> diff = w - v3;
+    assert(diff[0] == 3.0 && diff[1] == 3.0 && diff[2] == 3.0);
+    assert(v3 * w == 32.0);
+    assert((w * 0.5)[2] == 3.0);
+
+    // Default construction is zero
+    Vector<double, 3> zero;
+    assert(zero[0] == 0.0 && zero[1] == 0.0 && zero[2] == 0.0);
+
+    cout << "Fixed-dimension vector tests passed!" << endl;
+}
+
+// Test function to validate the expression templates behind the Vector operators
+void test_vector_expressions() {
+    cout << "Running vector expression tests..." << endl;
+
+    Vector<double, 3> a(1.0, 2.0, 3.0), b(4.0, 5.0, 6.0), c(0.5, 0.25, 0.125);
+
+    // Operators build unevaluated expressions; a Vector is only produced on assignment
+    static_assert(!is_same<decay_t<decltype(a + b)>, Vector<double, 3>>::value, "a + b must be an expression");
+    static_assert(is_same<decltype(a * b), double>::value, "Vector * Vector must stay the dot product");
+
+    // A compound expression is evaluated in one pass with the same rounding as step-by-step evaluation
+    Vector<double, 3> r = a + b * 2.0 - c * 4.0;
+    for (size_t i = 0; i < 3; ++i) {
+        assert(r[i] == (a[i] + b[i] * 2.0) - c[i] * 4.0);
+    }
+    Vector deduced = (a - b) * 0.5;
+    static_assert(is_same<decltype(deduced), Vector<double, 3>>::value, "Evaluating an expression gives a Vector");
+    assert(deduced[0] == -1.5 && deduced[2] == -1.5);
+
+    // Scalar on either side, integer scalars, and dot products of expressions
+    assert((2.0 * a)[1] == 4.0 && (a * 2)[1] == 4.0);
+    assert((a + b) * (a - b) == a * a - b * b);
+
+    // The target may appear on both sides of the assignment
+    Vector<double, 3> v = a;
+    v = v + b * 0.5;
+    assert(v[0] == 3.0 && v[1] == 4.5 && v[2] == 6.0);
+    v -= a + c;
+    v *= 2.0;
+    v += b;
+    assert(v[0] == 7.0 && v[1] == 9.5 && v[2] == 11.75);
+
+    cout << "Vector expression tests passed!" << endl;
+}
+
+// Test function to validate one Euler step against the closed-form update
+void test_particle_euler_step() {
+    cout << "Running particle Euler step test..." << endl;
+
+    const double t = 1.0, dt = 0.02;
+    Particle particle(1.0, Vector(0.5, -0.5), Vector(1.0, 2.0), Vector(0.0, 0.0));
+    particle.update(t, dt);
+
+    // v1 = v0 + dt * F(t), x1 = x0 + dt * v1
+    double vx = 1.0 + dt * sin(2.0 * t), vy = 2.0 + dt * cos(2.0 * t);
+    assert(particle.getVelocity()[0] == vx && particle.getVelocity()[1] == vy);
+    assert(particle.getPosition()[0] == 0.5 + vx * dt && particle.getPosition()[1] == -0.5 + vy * dt);
+
+    cout << "Particle Euler step test passed!" << endl;
+}
+
+// External field evaluated through the force arrays instead of the uniform-force shortcut
+template <size_t N>
+struct ExternalFieldArrays {
+    void computeForces(ParticleSystem<N>& system, double t) const {
+        ExternalField<N>().computeForces(system, t);
+    }
+};
+
+// Test function for the persistent thread pool behind parallelFor
+void test_thread_pool() {
+    ThreadPool pool(3);
+
+    // More tasks than threads: every task runs exactly once
+    vector<int> runs(10, 0);
+    pool.run(runs.size(), [&runs](size_t t) { ++runs[t]; });
+    for (int count : runs) {
+        assert(count == 1);
+    }
+
+    // Nested calls from every block, including the caller's, run serially on the calling thread
+    vector<size_t> covered(1000, 0);
+    parallelFor(covered.size(), pool, [&](size_t begin, size_t end) {
+        parallelFor(end - begin, pool, [&](size_t first, size_t last) {
+            for (size_t i = begin + first; i < begin + last; ++i) {
+                ++covered[i];
+            }
+        }, 1);
+    });
+    for (size_t count : covered) {
+        assert(count == 1);
+    }
+
+    // The first exception in task order reaches the caller, and the pool stays usable
+    string message;
+    try {
+        pool.run(7, [](size_t t) {
+            if (t == 4 || t == 5) {
+                throw runtime_error("task " + to_string(t));
+            }
+        });
+    } catch (const runtime_error& error) {
+        message = error.what();
+    }
+    assert(message == "task 4");
+    vector<double> values(100000);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<double>((i * 7919) % 100003);
+    }
+    parallelSort(values, less<double>(), pool);
+    assert(is_sorted(values.begin(), values.end()));
+
+    cout << "Thread pool tests passed!" << endl;
+}
+
+// Steps a ParticleSystem and individual Particles side by side and checks they agree exactly
+template <size_t N>
+void check_particle_system_matches_particles() {
+    const double dt = 0.02;
+    const size_t count = 37;  // Not a multiple of the thread blocks
+    ParticleSystem<N> uniform(count, 4), arrays(count, 3);
+    vector<Particle<N>> particles;
+    particles.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        Vector<double, N> position, velocity;
+        for (size_t d = 0; d < N; ++d) {
+            position[d] = 0.1 * i - 0.3 * d;
+            velocity[d] = 0.01 * i * (d + 1);
+        }
+        uniform.setParticle(i, 1.0, position, velocity);
+        arrays.setParticle(i, 1.0, position, velocity);
+        particles.emplace_back(1.0, position, velocity, Vector<double, N>());
+    }
+
+    for (int step = 0; step < 10; ++step) {
+        double t = step * dt;
+        uniform.stepEuler(ExternalField<N>(), t, dt);
+        arrays.stepEuler(ExternalFieldArrays<N>(), t, dt);
+        for (Particle<N>& p : particles) {
+            p.update(t, dt);
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t d = 0; d < N; ++d) {
+            assert(uniform.getPosition(i)[d] == particles[i].getPosition()[d]);
+            assert(uniform.getVelocity(i)[d] == particles[i].getVelocity()[d]);
+            assert(arrays.getPosition(i)[d] == particles[i].getPosition()[d]);
+        }
+    }
+}
+
+// Test function to validate the structure-of-arrays ParticleSystem
+void test_particle_system() {
+    cout << "Running particle system tests..." << endl;
+
+    check_particle_system_matches_particles<2>();
+    check_particle_system_matches_particles<3>();
+
+    // Velocity Verlet is exact for a constant force: x(t) = x0 + v0 t + F t^2 / (2m), v(t) = v0 + F t / m
+    struct ConstantForce {
+        void computeForces(ParticleSystem<2>& system, double) const {
+            for (size_t i = 0; i < system.size(); ++i) {
+                system.forces(0)[i] = 1.0;
+                system.forces(1)[i] = -2.0;
+            }
+        }
+    };
+    ParticleSystem<2> system(0, 2);
+    system.addParticle(2.0, Vector(1.0, 0.0), Vector(0.0, 1.0));
+    system.addParticle(0.5, Vector(0.0, 0.0), Vector(-1.0, 0.0));
+    const double dt = 0.125;  // Exactly representable, so the only error is rounding
+    for (int step = 0; step < 8; ++step) {
+        system.stepVerlet(ConstantForce(), step * dt, dt);
+    }
+    for (size_t i = 0; i < system.size(); ++i) {
+        double m = system.getMass(i);
+        Vector<double, 2> x0 = i == 0 ? Vector(1.0, 0.0) : Vector(0.0, 0.0);
+        Vector<double, 2> v0 = i == 0 ? Vector(0.0, 1.0) : Vector(-1.0, 0.0);
+        Vector<double, 2> force(1.0, -2.0);
+        Vector<double, 2> x = x0 + v0 * 1.0 + force * (0.5 / m);
+        Vector<double, 2> v = v0 + force * (1.0 / m);
+        for (size_t d = 0; d < 2; ++d) {
+            assert(fabs(system.getPosition(i)[d] - x[d]) < 1e-12);
+            assert(fabs(system.getVelocity(i)[d] - v[d]) < 1e-12);
+        }
+    }
+
+    // Invalid masses are rejected
+    bool threw = false;
+    try {
+        system.setParticle(0, 0.0, Vector(0.0, 0.0), Vector(0.0, 0.0));
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    cout << "Particle system tests passed!" << endl;
+}
+
+// Checks Barnes-Hut forces against direct summation for a random cluster
+template <size_t N>
+void check_barnes_hut_against_direct_sum() {
+    const size_t count = 600;
+    ParticleSystem<N> reference(count, 1), tree_single(count, 1), tree_threads(count, 4);
+    unsigned long long state = 12345;
+    auto random = [&state]() {  // Deterministic uniform numbers in [0, 1)
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (state >> 11) * (1.0 / 9007199254740992.0);
+    };
+    for (size_t i = 0; i < count; ++i) {
+        Vector<double, N> x;
+        for (size_t d = 0; d < N; ++d) {
+            x[d] = random() * random() - 0.25;  // Denser near the centre
+        }
+        double mass = 0.5 + random();
+        reference.setParticle(i, mass, x, Vector<double, N>());
+        tree_single.setParticle(i, mass, x, Vector<double, N>());
+        tree_threads.setParticle(i, mass, x, Vector<double, N>());
+    }
+    GravityParameters gravity;
+    gravity.softening = 1e-3;
+    reference.computeForces(DirectSum<N>(gravity), 0.0);
+
+    // theta = 0 opens every cell, so only the summation order differs from the direct sum
+    BarnesHut<N> exact(0.0, gravity);
+    tree_single.computeForces(exact, 0.0);
+    assert(exact.interactions() == count * (count - 1));
+    for (size_t i = 0; i < count; ++i) {
+        Vector<double, N> error = tree_single.getForce(i) - reference.getForce(i);
+        assert(sqrt(error * error) <= 1e-10 * sqrt(reference.getForce(i) * reference.getForce(i)));
+    }
+
+    // theta = 0.5 approximates distant cells; the tree and forces do not depend on the thread count
+    BarnesHut<N> single(0.5, gravity), threaded(0.5, gravity);
+    tree_single.computeForces(single, 0.0);
+    tree_threads.computeForces(threaded, 0.0);
+    assert(single.interactions() < count * (count - 1));
+    double mean_error = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        Vector<double, N> error = tree_single.getForce(i) - reference.getForce(i);
+        mean_error += sqrt((error * error) / (reference.getForce(i) * reference.getForce(i))) / count;
+        for (size_t d = 0; d < N; ++d) {
+            assert(tree_single.getForce(i)[d] == tree_threads.getForce(i)[d]);
+        }
+    }
+    cout << "Barnes-Hut (" << N << "D, theta = 0.5) mean relative force error: " << mean_error << endl;
+    assert(mean_error < 2e-2);
+}
+
+// Test function to validate the Barnes-Hut force model
+void test_barnes_hut() {
+    cout << "Running Barnes-Hut tests..." << endl;
+
+    check_barnes_hut_against_direct_sum<2>();
+    check_barnes_hut_against_direct_sum<3>();
+
+    // Two unit masses at distance 2 attract with G m m / r^2 = 0.25
+    ParticleSystem<3> pair(0, 1);
+    pair.addParticle(1.0, Vector(-1.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0));
+    pair.addParticle(1.0, Vector(1.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0));
+    pair.computeForces(BarnesHut<3>(), 0.0);
+    assert(pair.getForce(0)[0] == 0.25 && pair.getForce(1)[0] == -0.25);
+
+    cout << "Barnes-Hut tests passed!" << endl;
+}
+
+// Lennard-Jones forces by direct summation over all pairs, indexed by particle identifier
+template <size_t N>
+vector<Vector<double, N>> lennard_jones_direct(const ParticleSystem<N>& system, const LennardJonesParameters& p) {
+    vector<Vector<double, N>> forces(system.size());
+    for (size_t i = 0; i < system.size(); ++i) {
+        for (size_t j = 0; j < system.size(); ++j) {
+            Vector<double, N> dx = system.getPosition(i) - system.getPosition(j);
+            double r2 = dx * dx;
+            if (i == j || r2 >= p.cutoff * p.cutoff) {
+                continue;
+            }
+            double s6 = pow(p.sigma * p.sigma / r2, 3);
+            forces[system.getId(i)] += dx * (24.0 * p.epsilon * s6 * (2.0 * s6 - 1.0) / r2);
+        }
+    }
+    return forces;
+}
+
+// Test function to validate the cell list / Verlet neighbour list and the Lennard-Jones model
+void test_neighbor_list() {
+    cout << "Running neighbour list tests..." << endl;
+
+    // A jittered 3D lattice with spacing 1.1, so each particle has neighbours in several cells
+    const size_t side = 7, count = side * side * side;
+    ParticleSystem<3> system(count, 3);
+    unsigned long long state = 99;
+    auto jitter = [&state]() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return ((state >> 11) * (1.0 / 9007199254740992.0) - 0.5) * 0.1;
+    };
+    for (size_t i = 0; i < count; ++i) {
+        Vector<double, 3> x(1.1 * (i % side) + jitter(), 1.1 * (i / side % side) + jitter(),
+                            1.1 * (i / (side * side)) + jitter());
+        system.setParticle(i, 1.0, x, Vector(0.0, 0.0, 0.0));
+    }
+
+    LennardJonesParameters parameters;
+    parameters.skin = 0.4;
+    LennardJones<3> lj(parameters);
+    system.computeForces(lj, 0.0);
+    assert(lj.neighborList().rebuilds() == 1);
+
+    // Reordering keeps every particle's identity: each identifier appears exactly once
+    vector<bool> seen(count, false);
+    for (size_t i = 0; i < count; ++i) {
+        assert(!seen[system.getId(i)]);
+        seen[system.getId(i)] = true;
+    }
+
+    auto check_against_direct = [&]() {
+        vector<Vector<double, 3>> reference = lennard_jones_direct(system, parameters);
+        for (size_t i = 0; i < count; ++i) {
+            Vector<double, 3> error = system.getForce(i) - reference[system.getId(i)];
+            assert(sqrt(error * error) < 1e-9 * (1.0 + sqrt(reference[system.getId(i)] * reference[system.getId(i)])));
+        }
+    };
+    check_against_direct();
+
+    // Moving every particle by less than skin / 2 reuses the list, and the forces stay exact
+    for (size_t i = 0; i < count; ++i) {
+        system.setParticle(i, 1.0, system.getPosition(i) + Vector(0.1, -0.1, 0.05), Vector(0.0, 0.0, 0.0));
+    }
+    system.computeForces(lj, 0.0);
+    assert(lj.neighborList().rebuilds() == 1);
+    check_against_direct();
+
+    // Moving one particle further forces a rebuild
+    system.setParticle(0, 1.0, system.getPosition(0) + Vector(0.3, 0.0, 0.0), Vector(0.0, 0.0, 0.0));
+    system.computeForces(lj, 0.0);
+    assert(lj.neighborList().rebuilds() == 2);
+    check_against_direct();
+
+    // Permuting the particles invalidates the list
+    vector<size_t> reversed(count);
+    for (size_t i = 0; i < count; ++i) {
+        reversed[i] = count - 1 - i;
+    }
+    system.permute(reversed);
+    system.computeForces(lj, 0.0);
+    assert(lj.neighborList().rebuilds() == 3);
+    check_against_direct();
+
+    // Two particles at the potential minimum r = 2^(1/6) sigma feel no force and have energy -epsilon
+    ParticleSystem<2> pair(0, 1);
+    pair.addParticle(1.0, Vector(0.0, 0.0), Vector(0.0, 0.0));
+    pair.addParticle(1.0, Vector(pow(2.0, 1.0 / 6.0), 0.0), Vector(0.0, 0.0));
+    LennardJones<2> lj2;
+    pair.computeForces(lj2, 0.0);
+    assert(fabs(pair.getForce(0)[0]) < 1e-12 && fabs(lj2.potentialEnergy() + 1.0) < 1e-12);
+
+    cout << "Neighbour list tests passed!" << endl;
+}
+
+// Position error at t_end of a 3D particle of mass 2 advanced with the given integrator
+double integration_error(Integrator<3>& integrator, double dt, double t_end) {
+    Particle particle(2.0, Vector(1.0, -0.5, 0.25), Vector(0.0, 0.5, -1.0), Vector(0.0, 0.0, 0.0));
+    double t = 0.0;
+    while (t < t_end) {
+        t += particle.update(t, clampStep(t, t_end, dt), integrator);
+    }
+    Vector<double, 3> x, v;
+    exactMotion<3>(t_end, 2.0, Vector(1.0, -0.5, 0.25), Vector(0.0, 0.5, -1.0), x, v);
+    Vector<double, 3> error = particle.getPosition() - x;
+    return sqrt(error * error);
+}
+
+// Test function to validate the time integrators
+void test_integrators() {
+    cout << "Running integrator tests..." << endl;
+
+    // The Euler integrator is exactly Particle::update, including the use of the mass
+    Particle direct(2.0, Vector(0.5, 0.5), Vector(1.0, 0.0), Vector(0.0, 0.0));
+    Particle stepped(2.0, Vector(0.5, 0.5), Vector(1.0, 0.0), Vector(0.0, 0.0));
+    EulerIntegrator<2> euler;
+    for (int n = 0; n < 5; ++n) {
+        direct.update(n * 0.02, 0.02);
+        stepped.update(n * 0.02, 0.02, euler);
+    }
+    assert(direct.getPosition()[0] == stepped.getPosition()[0] && direct.getVelocity()[1] == stepped.getVelocity()[1]);
+    assert(euler.getForceEvaluations() == 5);
+
+    // Halving dt divides the error by about 2^order
+    auto observed_order = [](auto make) {
+        auto coarse = make(), fine = make();
+        return log2(integration_error(*coarse, 0.1, 4.0) / integration_error(*fine, 0.05, 4.0));
+    };
+    assert(fabs(observed_order([] { return make_unique<EulerIntegrator<3>>(); }) - 1.0) < 0.2);
+    assert(fabs(observed_order([] { return make_unique<VelocityVerletIntegrator<3>>(); }) - 2.0) < 0.2);
+    assert(fabs(observed_order([] { return make_unique<LeapfrogIntegrator<3>>(); }) - 2.0) < 0.2);
+    assert(fabs(observed_order([] { return make_unique<RK4Integrator<3>>(); }) - 4.0) < 0.3);
+
+    // Evaluations per step: Verlet reuses the end-of-step acceleration, RK4 needs four
+    VelocityVerletIntegrator<3> verlet;
+    RK4Integrator<3> rk4;
+    integration_error(verlet, 0.1, 4.0);
+    integration_error(rk4, 0.1, 4.0);
+    assert(verlet.getForceEvaluations() == 41);
+    assert(rk4.getForceEvaluations() == 160);
+
+    // The adaptive integrator meets its tolerance with far fewer evaluations than RK4 at equal accuracy
+    DormandPrinceIntegrator<3> rk45(1e-8, 1e-8);
+    double adaptive_error = integration_error(rk45, 4.0, 4.0);
+    assert(adaptive_error < 1e-6);
+    // One evaluation for the first stage, then six new stages per attempted step (the last stage is reused)
+    assert(rk45.getForceEvaluations() == 6 * (rk45.getAcceptedSteps() + rk45.getRejectedSteps()) + 1);
+    RK4Integrator<3> rk4_fine;
+    double rk4_error = integration_error(rk4_fine, 0.05, 4.0);
+    cout << "RK45: " << rk45.getForceEvaluations() << " evaluations, error " << adaptive_error << "; RK4: "
+         << rk4_fine.getForceEvaluations() << " evaluations, error " << rk4_error << endl;
+    assert(rk4_error > adaptive_error && rk45.getForceEvaluations() < rk4_fine.getForceEvaluations());
+
+    // Masses must be positive
+    bool threw = false;
+    try {
+        Particle invalid(0.0, Vector(0.0, 0.0), Vector(0.0, 0.0), Vector(0.0, 0.0));
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    cout << "Integrator tests passed!" << endl;
+}
+
+// Runs an ensemble from the force table and checks it against individual Particles and two-pass statistics
+template <size_t N>
+void check_ensemble_matches_particles() {
+    const double dt = 0.02;
+    const size_t count = 600;  // Two full tiles and a partial one
+    const size_t steps = 10;
+    ParticleSystem<N> serial(count, 1), threaded(count, 3);
+    auto initial = [](size_t i, Vector<double, N>& position, Vector<double, N>& velocity) {
+        for (size_t d = 0; d < N; ++d) {
+            position[d] = 0.01 * i - 0.3 * d;
+            velocity[d] = 0.001 * ((i * (d + 7)) % 13);
+        }
+    };
+    for (size_t i = 0; i < count; ++i) {
+        Vector<double, N> position, velocity;
+        initial(i, position, velocity);
+        serial.setParticle(i, 1.0 + 0.25 * (i % 4), position, velocity);
+        threaded.setParticle(i, 1.0 + 0.25 * (i % 4), position, velocity);
+    }
+
+    ForceTable<N> table(0.0, dt, steps);
+    vector<EnsembleSample<N>> serial_samples = runEnsemble(serial, table, 4);
+    vector<EnsembleSample<N>> threaded_samples = runEnsemble(threaded, table, 4);
+
+    // Samples at the start, after 4 and 8 steps, and at the end
+    assert(serial_samples.size() == 4 && threaded_samples.size() == 4);
+    assert(serial_samples[1].time == table.time(4) && serial_samples[3].time == table.time(steps));
+
+    // Every particle follows Particle::update exactly, whatever the number of threads
+    for (size_t i : {size_t(0), size_t(255), size_t(256), count - 1}) {
+        Vector<double, N> position, velocity;
+        initial(i, position, velocity);
+        Particle<N> particle(1.0 + 0.25 * (i % 4), position, velocity, Vector<double, N>());
+        double t = 0.0;
+        for (size_t k = 0; k < steps; ++k) {
+            particle.update(t, dt);
+            t += dt;
+        }
+        for (size_t d = 0; d < N; ++d) {
+            assert(serial.getPosition(i)[d] == particle.getPosition()[d]);
+            assert(threaded.getPosition(i)[d] == particle.getPosition()[d]);
+            assert(threaded.getVelocity(i)[d] == particle.getVelocity()[d]);
+        }
+    }
+
+    // The streamed statistics of the final positions match the two-pass formulas
+    for (size_t d = 0; d < N; ++d) {
+        double mean = 0.0, variance = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            mean += serial.getPosition(i)[d];
+        }
+        mean /= count;
+        for (size_t i = 0; i < count; ++i) {
+            variance += (serial.getPosition(i)[d] - mean) * (serial.getPosition(i)[d] - mean);
+        }
+        variance /= count;
+        for (const auto& samples : {serial_samples, threaded_samples}) {
+            const RunningStatistics<N>& last = samples.back().statistics;
+            assert(last.count() == count);
+            assert(fabs(last.mean()[d] - mean) < 1e-12 * (1.0 + fabs(mean)));
+            assert(fabs(last.variance()[d] - variance) < 1e-12 * variance);
+        }
+    }
+}
+
+// Test function to validate the ensemble force table and streaming statistics
+void test_ensemble() {
+    cout << "Running ensemble tests..." << endl;
+
+    // The table holds the force at accumulated times, as simulateAndPlot steps them
+    ForceTable<3> table(0.0, 0.1, 30);
+    double t = 0.0;
+    for (size_t k = 0; k <= table.steps(); ++k) {
+        assert(table.time(k) == t);
+        for (size_t d = 0; d < 3; ++d) {
+            assert(table[k][d] == externalForce<3>(t)[d] && table.column(d)[k] == table[k][d]);
+        }
+        t += 0.1;
+    }
+
+    // Merging the statistics of two halves gives the statistics of the whole; the large offset
+    // would cancel catastrophically in the sum-of-squares formula
+    RunningStatistics<2> all, first, second;
+    for (int i = 0; i < 100; ++i) {
+        Vector<double, 2> x(1e8 + 0.5 * i, -0.01 * i * i);
+        all.add(x);
+        (i < 37 ? first : second).add(x);
+    }
+    first.merge(second);
+    assert(first.count() == 100);
+    assert(fabs(all.mean()[0] - (1e8 + 24.75)) < 1e-6);
+    assert(fabs(all.variance()[0] - 0.25 * (100.0 * 100.0 - 1.0) / 12.0) < 1e-6);
+    for (size_t d = 0; d < 2; ++d) {
+        assert(fabs(first.mean()[d] - all.mean()[d]) < 1e-8 * fabs(all.mean()[d]));
+        assert(fabs(first.variance()[d] - all.variance()[d]) < 1e-10 * all.variance()[d]);
+    }
+
+    check_ensemble_matches_particles<2>();
+    check_ensemble_matches_particles<3>();
+
+    // The sampling interval must be positive
+    ParticleSystem<2> system(4, 1);
+    bool threw = false;
+    try {
+        runEnsemble(system, ForceTable<2>(0.0, 0.1, 2), 0);
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    cout << "Ensemble tests passed!" << endl;
+}
+
+// Test function to validate the binary trajectory writer and reader
+void test_trajectory() {
+    cout << "Running trajectory file tests..." << endl;
+    const string filename = "test_trajectory.traj";
+
+    // Lossless: every state is stored exactly, across several small buffers
+    vector<Vector<double, 2>> positions;
+    {
+        TrajectoryOptions options;
+        options.bufferFrames = 7;
+        TrajectoryWriter<2> writer(filename, options);
+        Particle particle(2.0, Vector(0.5, 0.0), Vector(0.0, 1.0), Vector(0.0, 0.0));
+        double t = 0.0;
+        for (uint64_t step = 0; step < 50; ++step) {
+            if (step != 0) {
+                particle.update(t, 0.02);
+                t += 0.02;
+            }
+            writer.write(step, t, particle.getPosition(), particle.getVelocity());
+            positions.push_back(particle.getPosition());
+            if (step == 20) {
+                // Flushed frames are visible to readers, with an up-to-date count in the header
+                writer.flush();
+                TrajectoryReader<2> partial(filename);
+                assert(partial.frameCount() == 21 && partial.header().frame_count == 21);
+            }
+        }
+        writer.close();
+        assert(writer.framesWritten() == 50);
+    }
+    TrajectoryReader<2> reader(filename);
+    assert(reader.frameCount() == 50 && reader.header().frame_count == 50);
+    for (uint64_t step : {0, 1, 6, 7, 33, 49}) {
+        TrajectoryFrame<2> frame = reader.frame(step);
+        assert(frame.step == step && reader.findStep(step) == step);
+        assert(frame.position[0] == positions[step][0] && frame.position[1] == positions[step][1]);
+    }
+
+    // Decimation keeps every third frame, and the last one
+    {
+        TrajectoryOptions options;
+        options.every = 3;
+        TrajectoryWriter<2> writer(filename, options);
+        for (uint64_t step = 0; step < 20; ++step) {
+            writer.write(step, 0.1 * step, Vector(double(step), 0.0), Vector(1.0, 0.0));
+        }
+    }
+    TrajectoryReader<2> decimated(filename);
+    assert(decimated.frameCount() == 8);
+    assert(decimated.frame(6).step == 18 && decimated.frame(7).step == 19);
+    assert(decimated.findStep(17) == 5 && decimated.positionAt(17)[0] == 17.0);
+
+    // Error-bounded downsampling: every step is recovered to within the tolerance by interpolation
+    const double tolerance = 1e-4;
+    vector<Vector<double, 3>> exact;
+    uint64_t written = 0;
+    {
+        TrajectoryOptions options;
+        options.tolerance = tolerance;
+        TrajectoryWriter<3> writer(filename, options);
+        Particle particle(1.0, Vector(0.0, 0.0, 0.0), Vector(0.1, 0.0, -0.2), Vector(0.0, 0.0, 0.0));
+        double t = 0.0;
+        for (uint64_t step = 0; step <= 2000; ++step) {
+            if (step != 0) {
+                particle.update(t, 0.002);
+                t += 0.002;
+            }
+            writer.write(step, t, particle.getPosition(), particle.getVelocity());
+            exact.push_back(particle.getPosition());
+        }
+        writer.close();
+        written = writer.framesWritten();
+    }
+    TrajectoryReader<3> downsampled(filename);
+    assert(downsampled.frameCount() == written && written < 200);
+    assert(downsampled.frame(written - 1).step == 2000);
+    for (uint64_t step = 0; step <= 2000; ++step) {
+        Vector<double, 3> error = downsampled.positionAt(step) - exact[step];
+        for (size_t d = 0; d < 3; ++d) {
+            assert(fabs(error[d]) <= tolerance * (1.0 + 1e-12));
+        }
+    }
+
+    // Steps must increase, and other files are rejected
+    bool threw = false;
+    try {
+        TrajectoryWriter<2> writer(filename);
+        writer.write(5, 0.0, Vector(0.0, 0.0), Vector(0.0, 0.0));
+        writer.write(5, 0.0, Vector(0.0, 0.0), Vector(0.0, 0.0));
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        TrajectoryReader<3> wrong_dimension(filename);
+    } catch (const runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    // Writing or flushing a closed trajectory is an error, not a hang
+    TrajectoryWriter<2> closed(filename);
+    closed.write(0, 0.0, Vector(0.0, 0.0), Vector(0.0, 0.0));
+    closed.close();
+    threw = false;
+    try {
+        closed.flush();
+    } catch (const logic_error&) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        closed.write(1, 0.0, Vector(0.0, 0.0), Vector(0.0, 0.0));
+    } catch (const logic_error&) {
+        threw = true;
+    }
+    assert(threw);
+
+    remove(filename.c_str());
+    cout << "Trajectory file tests passed!" << endl;
+}
+
 // Test function to validate 2D particle motion
 void test_particle_motion_2d() {
     cout << "Running 2D particle motion test..." << endl;
@@ -75,12 +768,42 @@ int main() {
     // Run the vector operation tests
     test_vector_operations();
 
+    // Run the fixed-dimension vector tests
+    test_fixed_dimension_vector();
+
+    // Run the vector expression tests
+    test_vector_expressions();
+
     // Run the 2D particle motion tests
     test_particle_motion_2d();
 
     // Run the 3D particle motion tests
     test_particle_motion_3d();
 
+    // Run the Euler step test
+    test_particle_euler_step();
+
+    // Run the thread pool tests
+    test_thread_pool();
+
+    // Run the particle system tests
+    test_particle_system();
+
+    // Run the Barnes-Hut tests
+    test_barnes_hut();
+
+    // Run the neighbour list tests
+    test_neighbor_list();
+
+    // Run the integrator tests
+    test_integrators();
+
+    // Run the ensemble tests
+    test_ensemble();
+
+    // Run the trajectory file tests
+    test_trajectory();
+
     cout << "All tests passed successfully!" << endl;
 
     return 0;
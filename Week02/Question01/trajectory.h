@@ -0,0 +1,536 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <ios>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "vector.h"
+
+// Current version of the binary trajectory format
+constexpr std::uint32_t TRAJECTORY_FORMAT_VERSION = 1;
+
+// Tag written in native byte order; a mismatch on read means the file came from a machine with different endianness
+constexpr std::uint32_t TRAJECTORY_ENDIAN_TAG = 0x01020304u;
+
+/**
+ * Fixed 64-byte header of a binary trajectory file. It is followed, at payload_offset, by
+ * fixed-size frames (TrajectoryFrame<dimension>) in increasing step order, so frame k starts at
+ * payload_offset + k * frame_bytes and the whole payload can be memory-mapped as an array of records.
+ * frame_count is brought up to date by flush() and close(); readers derive the number of frames
+ * from the file size, so the frames of an interrupted run can still be read.
+ */
+struct TrajectoryFileHeader {
+    char magic[8];               // Always "PARTTRAJ"
+    std::uint32_t version;       // Format version (TRAJECTORY_FORMAT_VERSION)
+    std::uint32_t dimension;     // Number of components of the positions and velocities
+    std::uint64_t frame_count;   // Number of frames written
+    std::uint64_t frame_bytes;   // Size of one frame
+    std::uint64_t payload_offset; // Byte offset of the first frame
+    std::uint64_t every;         // Decimation: only every `every`-th offered frame was considered
+    double tolerance;            // Largest position error of the interpolated frames (0 = none dropped)
+    std::uint32_t endian_tag;    // TRAJECTORY_ENDIAN_TAG in the writer's byte order
+    std::uint32_t reserved;      // Zero; reserved for future versions
+};
+
+static_assert(sizeof(TrajectoryFileHeader) == 64, "TrajectoryFileHeader must be exactly 64 bytes.");
+
+// One frame of a binary trajectory file: the state after `step` time steps
+template <std::size_t N>
+struct TrajectoryFrame {
+    std::uint64_t step;   // Number of time steps taken
+    double time;          // Simulated time
+    double position[N];   // Position
+    double velocity[N];   // Velocity
+};
+
+static_assert(sizeof(TrajectoryFrame<3>) == 8 * 8, "TrajectoryFrame must not contain padding.");
+
+// Settings of a TrajectoryWriter
+struct TrajectoryOptions {
+    std::uint64_t every = 1;        // Keep every `every`-th frame (the first and last frames are always kept)
+    double tolerance = 0.0;         // If positive, drop frames that linear interpolation reproduces to this accuracy
+    std::size_t maxGap = 256;       // Most consecutive frames dropped by the tolerance test
+    std::size_t bufferFrames = 4096; // Frames collected before a buffer is handed to the I/O thread
+};
+
+/**
+ * Linear interpolation of the position between two frames, by step number.
+ * @param a The earlier frame.
+ * @param b The later frame.
+ * @param step The step, a.step <= step <= b.step.
+ * @param d The component.
+ * @return The interpolated component of the position.
+ */
+template <std::size_t N>
+double interpolatePosition(const TrajectoryFrame<N>& a, const TrajectoryFrame<N>& b, std::uint64_t step,
+                           std::size_t d) {
+    if (b.step == a.step) {
+        return a.position[d];
+    }
+    const double lambda = double(step - a.step) / double(b.step - a.step);
+    return a.position[d] + lambda * (b.position[d] - a.position[d]);
+}
+
+/**
+ * Writes a trajectory to a binary, frame-indexed file (see TrajectoryFileHeader) on a background thread.
+ *
+ * Frames are offered one per step. Decimation keeps every `every`-th of them. With a positive
+ * tolerance, these candidates are then thinned out: a candidate is only written when the next one
+ * could not be reached from the last written frame by linear interpolation (by step number) that
+ * reproduces every candidate in between to within the tolerance, in every component of the
+ * position. Smooth stretches of a trajectory thus take few frames, and TrajectoryReader::positionAt
+ * recovers every candidate to within the tolerance. The first and last offered frames are always written.
+ *
+ * Written frames are collected in a buffer; a full buffer is queued for the I/O thread and the
+ * caller continues with another one, only waiting when every buffer is queued.
+ */
+template <std::size_t N>
+class TrajectoryWriter {
+public:
+    using VectorN = Vector<double, N>;
+    using Frame = TrajectoryFrame<N>;
+
+    /**
+     * Creates the file, writes its header and starts the I/O thread.
+     * @param filename The name of the trajectory file.
+     * @param options Decimation, error bound and buffering.
+     */
+    explicit TrajectoryWriter(const std::string& filename, const TrajectoryOptions& options = TrajectoryOptions())
+        : options_(options), offered_(0), written_(0), last_(), anchor_(), anchored_(false), busy_(false),
+          stop_(false), closed_(false), flushRequested_(false), flushedFrames_(0) {
+        if (options_.every == 0 || options_.bufferFrames == 0 || !(options_.tolerance >= 0.0)) {
+            throw std::invalid_argument("Invalid trajectory options (every and bufferFrames must be positive, "
+                                        "tolerance must not be negative).");
+        }
+        options_.maxGap = std::max<std::size_t>(options_.maxGap, 1);
+        file_.open(filename, std::ios::binary | std::ios::trunc);
+        if (!file_) {
+            throw std::ios_base::failure("Error: Could not open " + filename + " for writing.");
+        }
+        writeHeader(0);
+        if (!file_) {
+            throw std::ios_base::failure("Error: Could not write the header of " + filename + ".");
+        }
+
+        buffers_.assign(3, std::vector<Frame>());
+        for (std::size_t b = 0; b < buffers_.size(); ++b) {
+            buffers_[b].reserve(options_.bufferFrames);
+            free_.push_back(b);
+        }
+        current_ = free_.back();
+        free_.pop_back();
+        thread_ = std::thread(&TrajectoryWriter::run, this);
+    }
+
+    /**
+     * Writes the remaining frames and stops the I/O thread; errors are only reported by close().
+     */
+    ~TrajectoryWriter() {
+        try {
+            close();
+        } catch (...) {
+            // Destructors must not throw; call close() to observe write errors
+        }
+    }
+
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+    /**
+     * Offers the state after `step` time steps. Steps must increase from one call to the next.
+     * @param step The number of time steps taken.
+     * @param time The simulated time.
+     * @param position The position.
+     * @param velocity The velocity.
+     */
+    void write(std::uint64_t step, double time, const VectorN& position, const VectorN& velocity) {
+        if (closed_) {
+            throw std::logic_error("Frame written after the trajectory was closed.");
+        }
+        if (offered_ != 0 && step <= last_.step) {
+            throw std::invalid_argument("Trajectory steps must increase.");
+        }
+        Frame frame;
+        frame.step = step;
+        frame.time = time;
+        for (std::size_t d = 0; d < N; ++d) {
+            frame.position[d] = position[d];
+            frame.velocity[d] = velocity[d];
+        }
+        last_ = frame;
+        if (offered_++ % options_.every == 0) {
+            consider(frame);
+        }
+    }
+
+    /**
+     * Hands the collected frames to the I/O thread, waits until they are on disk and updates the
+     * frame count in the header, so readers see every frame kept so far. The last offered frame may
+     * still be held back by decimation or the tolerance test until close().
+     */
+    void flush() {
+        if (closed_) {
+            throw std::logic_error("Trajectory flushed after it was closed.");
+        }
+        submitCurrent();
+        std::unique_lock<std::mutex> lock(mutex_);
+        flushRequested_ = true;
+        work_cv_.notify_one();
+        done_cv_.wait(lock, [this] { return (queue_.empty() && !busy_ && !flushRequested_) || error_; });
+        rethrowError();
+    }
+
+    /**
+     * Writes the last offered frame and any frames still buffered, updates the header and closes the file.
+     * Rethrows the first write error.
+     */
+    void close() {
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+        if (offered_ != 0 && anchor_.step != last_.step) {
+            // The last frame is always kept; the window must still be reproduced from the anchor
+            if (!window_.empty() && window_.back().step != last_.step && !reproduces(last_)) {
+                emit(window_.back());
+            }
+            emit(last_);
+        }
+        submitCurrent();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        work_cv_.notify_one();
+        thread_.join();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        rethrowError();
+    }
+
+    /**
+     * Returns the number of frames offered through write().
+     * @return The number of frames offered.
+     */
+    std::uint64_t framesOffered() const {
+        return offered_;
+    }
+
+    /**
+     * Returns the number of frames kept for the file so far (written or buffered).
+     * @return The number of frames kept.
+     */
+    std::uint64_t framesWritten() const {
+        return written_;
+    }
+
+private:
+    // Applies the tolerance test to a frame that passed decimation. The window holds the frames
+    // since the anchor that were not written; its last frame is the one written next if `frame`
+    // cannot be reached by interpolation from the anchor.
+    void consider(const Frame& frame) {
+        if (!anchored_ || options_.tolerance == 0.0) {
+            emit(frame);
+            return;
+        }
+        if (!window_.empty() && (window_.size() >= options_.maxGap || !reproduces(frame))) {
+            emit(window_.back());
+        }
+        window_.push_back(frame);
+    }
+
+    // Whether interpolating from the anchor to `frame` reproduces every frame of the window
+    bool reproduces(const Frame& frame) const {
+        for (const Frame& skipped : window_) {
+            for (std::size_t d = 0; d < N; ++d) {
+                if (std::fabs(interpolatePosition(anchor_, frame, skipped.step, d) - skipped.position[d]) >
+                    options_.tolerance) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Appends a frame to the file (through the current buffer) and makes it the interpolation anchor
+    void emit(const Frame& frame) {
+        anchor_ = frame;
+        anchored_ = true;
+        window_.clear();
+        buffers_[current_].push_back(frame);
+        ++written_;
+        if (buffers_[current_].size() == options_.bufferFrames) {
+            submitCurrent();
+        }
+    }
+
+    // Queues the current buffer for the I/O thread (if it holds frames) and takes a free one
+    void submitCurrent() {
+        if (buffers_[current_].empty()) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        rethrowError();
+        queue_.push_back(current_);
+        work_cv_.notify_one();
+        done_cv_.wait(lock, [this] { return !free_.empty() || error_; });
+        rethrowError();
+        current_ = free_.back();
+        free_.pop_back();
+    }
+
+    // Writes the header with the given frame count at the start of the file; used by the I/O thread
+    void writeHeader(std::uint64_t frames) {
+        TrajectoryFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "PARTTRAJ", 8);
+        header.version = TRAJECTORY_FORMAT_VERSION;
+        header.dimension = static_cast<std::uint32_t>(N);
+        header.frame_count = frames;
+        header.frame_bytes = sizeof(Frame);
+        header.payload_offset = sizeof(TrajectoryFileHeader);
+        header.every = options_.every;
+        header.tolerance = options_.tolerance;
+        header.endian_tag = TRAJECTORY_ENDIAN_TAG;
+        const std::streampos end = file_.tellp();
+        file_.seekp(0);
+        file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (end > std::streampos(sizeof(header))) {
+            file_.seekp(end);
+        }
+    }
+
+    // Loop of the I/O thread
+    void run() {
+        for (;;) {
+            std::size_t buffer = 0;
+            bool haveBuffer = false;
+            bool updateHeader = false;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                work_cv_.wait(lock, [this] { return !queue_.empty() || stop_ || flushRequested_; });
+                if (!queue_.empty()) {
+                    buffer = queue_.front();
+                    queue_.pop_front();
+                    haveBuffer = true;
+                } else if (flushRequested_ || stop_) {
+                    updateHeader = true;
+                }
+                busy_ = true;
+            }
+
+            std::exception_ptr error;
+            try {
+                if (haveBuffer) {
+                    const std::vector<Frame>& frames = buffers_[buffer];
+                    file_.write(reinterpret_cast<const char*>(frames.data()),
+                                static_cast<std::streamsize>(frames.size() * sizeof(Frame)));
+                    flushedFrames_ += frames.size();
+                } else if (updateHeader) {
+                    writeHeader(flushedFrames_);
+                    file_.flush();
+                }
+                if (!file_) {
+                    throw std::ios_base::failure("Error: Could not write the trajectory file.");
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            bool finished = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (haveBuffer) {
+                    buffers_[buffer].clear();
+                    free_.push_back(buffer);
+                } else if (updateHeader) {
+                    flushRequested_ = false;
+                    finished = stop_;
+                }
+                busy_ = false;
+                if (error && !error_) {
+                    error_ = error;
+                }
+            }
+            done_cv_.notify_all();
+            if (finished) {
+                file_.close();
+                return;
+            }
+        }
+    }
+
+    // Rethrows a stored write error; the caller holds mutex_
+    void rethrowError() {
+        if (error_) {
+            std::exception_ptr error = error_;
+            error_ = nullptr;  // Report each error once
+            std::rethrow_exception(error);
+        }
+    }
+
+    TrajectoryOptions options_;  // Decimation, error bound and buffering
+    std::uint64_t offered_;      // Frames offered through write()
+    std::uint64_t written_;      // Frames kept for the file
+    Frame last_;                 // Last offered frame
+    Frame anchor_;               // Last kept frame, the start of the interpolation
+    bool anchored_;              // Whether a frame was kept
+    std::vector<Frame> window_;  // Frames since the anchor that passed decimation but were not kept
+
+    std::ofstream file_;                      // The trajectory file; used by the I/O thread after construction
+    std::vector<std::vector<Frame>> buffers_; // Frame buffers
+    std::size_t current_;                     // Buffer being filled by the caller
+    std::vector<std::size_t> free_;           // Buffers that can be filled
+    std::deque<std::size_t> queue_;           // Buffers waiting to be written
+    bool busy_;                               // Whether the I/O thread is writing
+    bool stop_;                               // Set by close()
+    bool closed_;                             // Whether close() was called
+    bool flushRequested_;                     // Set by flush(); the header is rewritten once the queue is empty
+    std::uint64_t flushedFrames_;             // Frames written to the file by the I/O thread
+    std::exception_ptr error_;                // First write error
+    std::mutex mutex_;                        // Guards the queue, the free list and the flags
+    std::condition_variable work_cv_;         // Signals queued work, a flush or stop_
+    std::condition_variable done_cv_;         // Signals a written buffer or header
+    std::thread thread_;                      // The I/O thread
+};
+
+/**
+ * Random access to a binary trajectory file written by TrajectoryWriter.
+ */
+template <std::size_t N>
+class TrajectoryReader {
+public:
+    using VectorN = Vector<double, N>;
+    using Frame = TrajectoryFrame<N>;
+
+    /**
+     * Opens a trajectory file and checks its header.
+     * @param filename The name of the trajectory file.
+     */
+    explicit TrajectoryReader(const std::string& filename) {
+        // Unbuffered: each frame is one small read, instead of refilling a buffer after every seek
+        file_.rdbuf()->pubsetbuf(nullptr, 0);
+        file_.open(filename, std::ios::binary);
+        if (!file_) {
+            throw std::ios_base::failure("Error: Could not open " + filename + " for reading.");
+        }
+        file_.read(reinterpret_cast<char*>(&header_), sizeof(header_));
+        if (!file_ || std::memcmp(header_.magic, "PARTTRAJ", 8) != 0) {
+            throw std::runtime_error(filename + " is not a trajectory file.");
+        }
+        if (header_.endian_tag != TRAJECTORY_ENDIAN_TAG || header_.version != TRAJECTORY_FORMAT_VERSION ||
+            header_.dimension != N || header_.frame_bytes != sizeof(Frame)) {
+            throw std::runtime_error(filename + " has an unsupported version, byte order or dimension.");
+        }
+        file_.seekg(0, std::ios::end);
+        const std::uint64_t size = static_cast<std::uint64_t>(file_.tellg());
+        frames_ = size > header_.payload_offset ? (size - header_.payload_offset) / header_.frame_bytes : 0;
+    }
+
+    /**
+     * Returns the header of the file.
+     * @return The header.
+     */
+    const TrajectoryFileHeader& header() const {
+        return header_;
+    }
+
+    /**
+     * Returns the number of complete frames in the file.
+     * @return The number of frames.
+     */
+    std::uint64_t frameCount() const {
+        return frames_;
+    }
+
+    /**
+     * Reads frame k.
+     * @param k The frame index, k < frameCount().
+     * @return The frame.
+     */
+    Frame frame(std::uint64_t k) {
+        if (k >= frames_) {
+            throw std::out_of_range("Trajectory frame index out of range.");
+        }
+        Frame result;
+        file_.seekg(static_cast<std::streamoff>(header_.payload_offset + k * header_.frame_bytes));
+        file_.read(reinterpret_cast<char*>(&result), sizeof(result));
+        if (!file_) {
+            throw std::ios_base::failure("Error: Could not read a trajectory frame.");
+        }
+        return result;
+    }
+
+    /**
+     * Finds the last frame at or before a step, by binary search over the frames on disk.
+     * @param step The step number.
+     * @return The index of the frame; the step must not precede the first frame.
+     */
+    std::uint64_t findStep(std::uint64_t step) {
+        if (frames_ == 0 || frame(0).step > step) {
+            throw std::out_of_range("The trajectory has no frame at or before this step.");
+        }
+        std::uint64_t lo = 0, hi = frames_;  // frame(lo).step <= step < frame(hi).step
+        while (hi - lo > 1) {
+            std::uint64_t mid = lo + (hi - lo) / 2;
+            if (frame(mid).step <= step) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    /**
+     * Returns the position after a given number of steps: the stored frame, or for a step dropped
+     * by the writer, the linear interpolation between the neighbouring frames (accurate to the
+     * writer's tolerance).
+     * @param step The step number, between the first and the last frame.
+     * @return The position.
+     */
+    VectorN positionAt(std::uint64_t step) {
+        const std::uint64_t k = findStep(step);
+        const Frame a = frame(k);
+        if (a.step == step) {
+            return gather(a.position);
+        }
+        if (k + 1 == frames_) {
+            throw std::out_of_range("The step is past the last frame of the trajectory.");
+        }
+        const Frame b = frame(k + 1);
+        VectorN result;
+        for (std::size_t d = 0; d < N; ++d) {
+            result[d] = interpolatePosition(a, b, step, d);
+        }
+        return result;
+    }
+
+private:
+    static VectorN gather(const double (&values)[N]) {
+        VectorN result;
+        for (std::size_t d = 0; d < N; ++d) {
+            result[d] = values[d];
+        }
+        return result;
+    }
+
+    std::ifstream file_;          // The trajectory file
+    TrajectoryFileHeader header_; // Its header
+    std::uint64_t frames_;        // Number of complete frames
+};
+
+#endif // TRAJECTORY_H
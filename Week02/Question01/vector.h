@@ -0,0 +1,342 @@
+#ifndef VECTOR_H
+#define VECTOR_H
+
+#include <array>
+#include <cstddef>
+#include <ostream>
+#include <type_traits>
+
+template <typename T, std::size_t N>
+class Vector;
+
+/**
+ * Base class of every vector expression (a Vector or an unevaluated sum, difference or scaling).
+ * E is the derived expression type (CRTP), so operator[] is resolved at compile time and the
+ * compiler can inline a whole expression tree into the loop that evaluates it.
+ */
+template <typename E, typename T, std::size_t N>
+class VectorExpr {
+public:
+    using value_type = T;
+
+    /**
+     * Returns the dimension of the expression, known at compile time.
+     * @return The size of the expression as a size_t.
+     */
+    static constexpr std::size_t size() {
+        return N;
+    }
+
+    /**
+     * Evaluates a single component of the expression.
+     * @param i The index of the component.
+     * @return The component.
+     */
+    T operator[](std::size_t i) const {
+        return self()[i];
+    }
+
+    /**
+     * Returns the expression as its derived type.
+     * @return A reference to the derived expression.
+     */
+    const E& self() const {
+        return static_cast<const E&>(*this);
+    }
+};
+
+// Operands of an expression node: vectors are held by reference, nested expression nodes by value.
+// Nodes are only meant to live until the end of the full expression that creates them.
+template <typename E>
+struct VectorOperand {
+    using type = const E;
+};
+
+template <typename T, std::size_t N>
+struct VectorOperand<Vector<T, N>> {
+    using type = const Vector<T, N>&;
+};
+
+// Fixed-size vector of N components of type T, stored inline (no heap allocation).
+// Arithmetic builds expression nodes; assigning or constructing a Vector from an expression
+// evaluates it in one loop, so v = v + f * dt makes no intermediate Vector.
+template <typename T, std::size_t N>
+class Vector : public VectorExpr<Vector<T, N>, T, N> {
+private:
+    std::array<T, N> components_; // Holds the components of the vector
+
+public:
+    /**
+     * Default constructor; all components are zero.
+     */
+    Vector() : components_{} {}
+
+    /**
+     * Constructor to initialize the vector with a given set of components.
+     * @param components An array holding the N components of the vector.
+     */
+    Vector(const std::array<T, N>& components) : components_(components) {}
+
+    /**
+     * Constructor to initialize the vector from its N components, e.g. Vector(x, y) or Vector(x, y, z).
+     * @param components The components of the vector, one argument per dimension.
+     */
+    template <typename... Ts, typename = std::enable_if_t<sizeof...(Ts) == N && N != 0 &&
+                                                          (std::is_convertible_v<Ts, T> && ...)>>
+    Vector(Ts... components) : components_{static_cast<T>(components)...} {}
+
+    /**
+     * Constructor that evaluates a vector expression, e.g. Vector<double, 3> v = a + b * s.
+     * @param expr The expression to evaluate.
+     */
+    template <typename E>
+    Vector(const VectorExpr<E, T, N>& expr) {
+        assign(expr.self());
+    }
+
+    /**
+     * Evaluates a vector expression into this vector in a single loop.
+     * Each component of the result only reads the same component of the operands,
+     * so the vector may appear on both sides (v = v + f * dt).
+     * @param expr The expression to evaluate.
+     * @return A reference to this vector.
+     */
+    template <typename E>
+    Vector& operator=(const VectorExpr<E, T, N>& expr) {
+        assign(expr.self());
+        return *this;
+    }
+
+    /**
+     * Adds a vector expression to this vector in place.
+     * @param expr The expression to add.
+     * @return A reference to this vector.
+     */
+    template <typename E>
+    Vector& operator+=(const VectorExpr<E, T, N>& expr) {
+        const E& e = expr.self();
+#pragma GCC unroll 4
+        for (std::size_t i = 0; i < N; ++i) {
+            components_[i] += e[i];
+        }
+        return *this;
+    }
+
+    /**
+     * Subtracts a vector expression from this vector in place.
+     * @param expr The expression to subtract.
+     * @return A reference to this vector.
+     */
+    template <typename E>
+    Vector& operator-=(const VectorExpr<E, T, N>& expr) {
+        const E& e = expr.self();
+#pragma GCC unroll 4
+        for (std::size_t i = 0; i < N; ++i) {
+            components_[i] -= e[i];
+        }
+        return *this;
+    }
+
+    /**
+     * Scales this vector in place.
+     * @param scalar The scalar value to multiply each component by.
+     * @return A reference to this vector.
+     */
+    Vector& operator*=(const T& scalar) {
+#pragma GCC unroll 4
+        for (std::size_t i = 0; i < N; ++i) {
+            components_[i] *= scalar;
+        }
+        return *this;
+    }
+
+    /**
+     * Returns the number of components in the vector (its dimension), known at compile time.
+     * @return The size of the vector as a size_t.
+     */
+    static constexpr std::size_t size() {
+        return N;
+    }
+
+    /**
+     * Returns the components of the vector as a reference.
+     * @return A reference to the array of components.
+     */
+    const std::array<T, N>& getComponents() const {
+        return components_;
+    }
+
+    /**
+     * Accesses a single component.
+     * @param i The index of the component.
+     * @return A reference to the component.
+     */
+    T& operator[](std::size_t i) {
+        return components_[i];
+    }
+
+    /**
+     * Accesses a single component (read-only).
+     * @param i The index of the component.
+     * @return The component.
+     */
+    const T& operator[](std::size_t i) const {
+        return components_[i];
+    }
+
+private:
+    template <typename E>
+    void assign(const E& e) {
+        // Unrolled so that 2D and 3D expressions compile to straight-line code
+#pragma GCC unroll 4
+        for (std::size_t i = 0; i < N; ++i) {
+            components_[i] = e[i];
+        }
+    }
+};
+
+// Element-wise sum of two expressions, evaluated on access
+template <typename L, typename R, typename T, std::size_t N>
+class VectorSum : public VectorExpr<VectorSum<L, R, T, N>, T, N> {
+private:
+    typename VectorOperand<L>::type lhs_;
+    typename VectorOperand<R>::type rhs_;
+
+public:
+    VectorSum(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs) {}
+
+    T operator[](std::size_t i) const {
+        return lhs_[i] + rhs_[i];
+    }
+};
+
+// Element-wise difference of two expressions, evaluated on access
+template <typename L, typename R, typename T, std::size_t N>
+class VectorDifference : public VectorExpr<VectorDifference<L, R, T, N>, T, N> {
+private:
+    typename VectorOperand<L>::type lhs_;
+    typename VectorOperand<R>::type rhs_;
+
+public:
+    VectorDifference(const L& lhs, const R& rhs) : lhs_(lhs), rhs_(rhs) {}
+
+    T operator[](std::size_t i) const {
+        return lhs_[i] - rhs_[i];
+    }
+};
+
+// Expression scaled by a scalar, evaluated on access
+template <typename E, typename T, std::size_t N>
+class VectorScaled : public VectorExpr<VectorScaled<E, T, N>, T, N> {
+private:
+    typename VectorOperand<E>::type expr_;
+    T scalar_;
+
+public:
+    VectorScaled(const E& expr, const T& scalar) : expr_(expr), scalar_(scalar) {}
+
+    T operator[](std::size_t i) const {
+        return expr_[i] * scalar_;
+    }
+};
+
+// Keeps the scalar argument of operator* out of template argument deduction, so v * 2 works for a double vector
+template <typename T>
+struct VectorScalar {
+    using type = T;
+};
+
+/**
+ * Overloaded addition operator to add two vectors (or vector expressions) element-wise.
+ * Both operands have the same dimension by construction.
+ * @param lhs The first operand.
+ * @param rhs The second operand.
+ * @return An expression for the element-wise sum, evaluated when assigned to a Vector.
+ */
+template <typename L, typename R, typename T, std::size_t N>
+VectorSum<L, R, T, N> operator+(const VectorExpr<L, T, N>& lhs, const VectorExpr<R, T, N>& rhs) {
+    return VectorSum<L, R, T, N>(lhs.self(), rhs.self());
+}
+
+/**
+ * Overloaded subtraction operator to subtract one vector (or vector expression) from another element-wise.
+ * @param lhs The first operand.
+ * @param rhs The operand to subtract.
+ * @return An expression for the element-wise difference, evaluated when assigned to a Vector.
+ */
+template <typename L, typename R, typename T, std::size_t N>
+VectorDifference<L, R, T, N> operator-(const VectorExpr<L, T, N>& lhs, const VectorExpr<R, T, N>& rhs) {
+    return VectorDifference<L, R, T, N>(lhs.self(), rhs.self());
+}
+
+/**
+ * Overloaded multiplication operator to scale a vector (or vector expression) by a scalar.
+ * @param expr The vector to scale.
+ * @param scalar The scalar value to multiply each component by.
+ * @return An expression for the scaled vector, evaluated when assigned to a Vector.
+ */
+template <typename E, typename T, std::size_t N>
+VectorScaled<E, T, N> operator*(const VectorExpr<E, T, N>& expr, const typename VectorScalar<T>::type& scalar) {
+    return VectorScaled<E, T, N>(expr.self(), scalar);
+}
+
+/**
+ * Overloaded multiplication operator to scale a vector (or vector expression) by a scalar from the left.
+ * @param scalar The scalar value to multiply each component by.
+ * @param expr The vector to scale.
+ * @return An expression for the scaled vector, evaluated when assigned to a Vector.
+ */
+template <typename E, typename T, std::size_t N>
+VectorScaled<E, T, N> operator*(const typename VectorScalar<T>::type& scalar, const VectorExpr<E, T, N>& expr) {
+    return VectorScaled<E, T, N>(expr.self(), scalar);
+}
+
+/**
+ * Overloaded multiplication operator to compute the dot product of two vectors (or vector expressions).
+ * The reduction is evaluated immediately, in a single loop over both operands.
+ * @param lhs The first operand.
+ * @param rhs The second operand.
+ * @return The scalar result of the dot product.
+ */
+template <typename L, typename R, typename T, std::size_t N>
+T operator*(const VectorExpr<L, T, N>& lhs, const VectorExpr<R, T, N>& rhs) {
+    const L& l = lhs.self();
+    const R& r = rhs.self();
+    T result = T();
+#pragma GCC unroll 4
+    for (std::size_t i = 0; i < N; ++i) {
+        result += l[i] * r[i];
+    }
+    return result;
+}
+
+/**
+ * Overloaded output stream operator to print a vector (or vector expression) in the form (x, y) or (x, y, z).
+ * @param os The output stream.
+ * @param expr The vector to be printed.
+ * @return The output stream with the formatted vector.
+ */
+template <typename E, typename T, std::size_t N>
+std::ostream& operator<<(std::ostream& os, const VectorExpr<E, T, N>& expr) {
+    const E& e = expr.self();
+    os << "(";
+    for (std::size_t i = 0; i < N; ++i) {
+        os << e[i];
+        if (i < N - 1) os << ", ";
+    }
+    os << ")";
+    return os;
+}
+
+// Deduces the dimension from the number of components: Vector(0.0, 0.0) is a Vector<double, 2>
+template <typename T, typename... Ts, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+Vector(T, Ts...) -> Vector<T, 1 + sizeof...(Ts)>;
+
+template <typename T, std::size_t N>
+Vector(std::array<T, N>) -> Vector<T, N>;
+
+// Evaluating an expression gives a vector of the same type and dimension: Vector v = a + b
+template <typename E, typename T, std::size_t N>
+Vector(VectorExpr<E, T, N>) -> Vector<T, N>;
+
+#endif // VECTOR_H
@@ -1,7 +1,73 @@
+import os
+import numpy as np
 import pandas as pd
 import matplotlib.pyplot as plt
 from mpl_toolkits.mplot3d import Axes3D
 
+# Layout of the 64-byte header of a binary trajectory file (see trajectory.h)
+TRAJECTORY_HEADER = np.dtype([('magic', 'S8'), ('version', '<u4'), ('dimension', '<u4'), ('frame_count', '<u8'),
+                              ('frame_bytes', '<u8'), ('payload_offset', '<u8'), ('every', '<u8'),
+                              ('tolerance', '<f8'), ('endian_tag', '<u4'), ('reserved', '<u4')])
+ENDIAN_TAG = 0x01020304
+
+
+def read_trajectory(filename):
+    """
+    Memory-maps a binary trajectory file written by TrajectoryWriter (see trajectory.h).
+    Nothing is read until the arrays are used, so single frames of long runs are cheap to access.
+
+    Args:
+        filename (str): The name of the trajectory file.
+
+    Returns:
+        dict: 'step', 'time', 'x', 'y' (and 'z' in 3D) arrays backed by the file, one entry per frame.
+
+    Raises:
+        ValueError: If the file is not a little-endian trajectory file of a supported version.
+    """
+    header = np.fromfile(filename, dtype=TRAJECTORY_HEADER, count=1)[0]
+    if header['magic'] != b'PARTTRAJ' or header['endian_tag'] != ENDIAN_TAG or header['version'] != 1:
+        raise ValueError(f"{filename} is not a supported trajectory file")
+    n = int(header['dimension'])
+    frame = np.dtype([('step', '<u8'), ('time', '<f8'), ('position', '<f8', (n,)), ('velocity', '<f8', (n,))])
+    offset = int(header['payload_offset'])
+    # Frames of an interrupted run are still valid, so count them from the file size
+    count = (os.path.getsize(filename) - offset) // frame.itemsize
+    frames = np.memmap(filename, dtype=frame, mode='r', offset=offset, shape=(count,))
+    data = {'step': frames['step'], 'time': frames['time']}
+    for d, axis in enumerate('xyz'[:n]):
+        data[axis] = frames['position'][:, d]
+    return data
+
+
+def load_trajectory(filename):
+    """
+    Loads a trajectory written by homework2.x: memory-mapped for binary .traj files, parsed for CSV text.
+
+    Args:
+        filename (str): The name of the trajectory file.
+
+    Returns:
+        The trajectory, indexable by column name ('x', 'y', 'z').
+    """
+    if filename.endswith('.traj'):
+        return read_trajectory(filename)
+    return pd.read_csv(filename)
+
+def newest_file(candidates):
+    """
+    Picks the most recently modified of the existing files, so a stale trajectory from an earlier run
+    is not plotted instead of a newer one in the other format.
+
+    Args:
+        candidates (list): File names, the fallback last.
+
+    Returns:
+        str: The newest existing file, or the last candidate if none exists.
+    """
+    existing = [name for name in candidates if os.path.exists(name)]
+    return max(existing, key=os.path.getmtime) if existing else candidates[-1]
+
 # Function to plot 2D particle trajectory from a CSV file
 def plot_2d_trajectory(file_2d):
     """
@@ -16,7 +82,7 @@ def plot_2d_trajectory(file_2d):
     """
     try:
         print(f"Reading 2D trajectory data from {file_2d}...")
-        data_2d = pd.read_csv(file_2d)  # Load the 2D trajectory data
+        data_2d = load_trajectory(file_2d)  # Load the 2D trajectory data
         print(f"Data loaded successfully.")
         
         # Plot the 2D trajectory
@@ -49,7 +115,7 @@ def plot_3d_trajectory(file_3d):
     """
     try:
         print(f"Reading 3D trajectory data from {file_3d}...")
-        data_3d = pd.read_csv(file_3d)  # Load the 3D trajectory data
+        data_3d = load_trajectory(file_3d)  # Load the 3D trajectory data
         print(f"Data loaded successfully.")
         
         # Create a 3D plot
@@ -77,15 +143,15 @@ def plot_3d_trajectory(file_3d):
 if __name__ == "__main__":
     """
     Main script to read and plot both 2D and 3D particle trajectories. 
-    The trajectory data is read from two files: 'traject_2d.txt' and 'traject_3d.txt'. 
+    The trajectory data is read from two files: 'traject_2d.txt' and 'traject_3d.txt', or the binary
+    'traject_2d.traj' and 'traject_3d.traj' written by `homework2.x binary` when those are newer.
     The plots are saved as images in the 'images' directory.
     """
-    # Define the file names
-    file_2d = 'traject_2d.txt'  # Name of the 2D data file
-    file_3d = 'traject_3d.txt'  # Name of the 3D data file
+    # Define the file names, taking the newer of the binary and text trajectories
+    file_2d = newest_file(['traject_2d.traj', 'traject_2d.txt'])  # Name of the 2D data file
+    file_3d = newest_file(['traject_3d.traj', 'traject_3d.txt'])  # Name of the 3D data file
     
     # Create a directory for images if it doesn't exist
-    import os
     if not os.path.exists('images'):
         os.makedirs('images')  # Create 'images' folder for saving the plots
 
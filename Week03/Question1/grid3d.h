@@ -0,0 +1,759 @@
+#ifndef __GRID3D_H__
+#define __GRID3D_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "grid_expression.h"
+#include "grid_simd.h"
+#include "grid_view.h"
+
+/**
+ * @brief Row-major layout: k varies fastest, then j, then i (the layout of the original Grid1).
+ *
+ * Every layout policy is constructed from the grid dimensions and provides
+ * storageSize(), the number of elements to allocate (at least nx * ny * nz),
+ * offset(i, j, k), the position of grid point (i, j, k) in that storage, and
+ * forEachRun(begin, end, f), which calls f(first, last) for the runs of storage positions in
+ * [begin, end) that hold grid points, in increasing order, skipping the padding.
+ */
+class RowMajor
+{
+public:
+    static const char* name() { return "row-major"; }
+
+    /// The storage position is i * si + j * sj + k * sk, so grids of this layout have views.
+    static constexpr bool strided = true;
+
+    RowMajor(int nx_, int ny_, int nz_) : ny(ny_), nz(nz_), size(std::size_t(nx_) * ny_ * nz_) {}
+
+    std::size_t storageSize() const { return size; }
+
+    std::size_t offset(int i, int j, int k) const {
+        return (std::size_t(i) * ny + j) * nz + k;
+    }
+
+    StridedMapping strides() const {
+        return StridedMapping{std::ptrdiff_t(ny * nz), std::ptrdiff_t(nz), 1};
+    }
+
+    template <typename F>
+    void forEachRun(std::size_t begin, std::size_t end, F f) const {
+        if (begin < end) {
+            f(begin, end);  // No padding
+        }
+    }
+
+private:
+    std::size_t ny, nz;  ///< Extents of the two fastest dimensions.
+    std::size_t size;    ///< Number of grid points.
+};
+
+/**
+ * @brief Column-major layout: i varies fastest, then j, then k (Fortran order).
+ */
+class ColumnMajor
+{
+public:
+    static const char* name() { return "column-major"; }
+
+    static constexpr bool strided = true;
+
+    ColumnMajor(int nx_, int ny_, int nz_) : nx(nx_), ny(ny_), size(std::size_t(nx_) * ny_ * nz_) {}
+
+    std::size_t storageSize() const { return size; }
+
+    std::size_t offset(int i, int j, int k) const {
+        return (std::size_t(k) * ny + j) * nx + i;
+    }
+
+    StridedMapping strides() const {
+        return StridedMapping{1, std::ptrdiff_t(nx), std::ptrdiff_t(nx * ny)};
+    }
+
+    template <typename F>
+    void forEachRun(std::size_t begin, std::size_t end, F f) const {
+        if (begin < end) {
+            f(begin, end);  // No padding
+        }
+    }
+
+private:
+    std::size_t nx, ny;  ///< Extents of the two fastest dimensions.
+    std::size_t size;    ///< Number of grid points.
+};
+
+/**
+ * @brief Tiled layout: the grid is cut into B x B x B tiles stored one after the other
+ * (tiles in row-major order, points row-major within a tile), so neighbours in all three
+ * directions are usually in the same few cache lines. Each extent is padded to a multiple of B.
+ * @tparam B The tile edge; a power of two.
+ */
+template <int B = 8>
+class Tiled3D
+{
+    static_assert(B > 0 && (B & (B - 1)) == 0, "The tile edge must be a power of two.");
+
+public:
+    static const char* name() { return "tiled"; }
+
+    static constexpr bool strided = false;
+
+    Tiled3D(int nx_, int ny_, int nz_)
+        : nx(nx_), ny(ny_), nz(nz_), tilesY(tiles(ny_)), tilesZ(tiles(nz_)),
+          size(tiles(nx_) * tilesY * tilesZ * B * B * B) {}
+
+    std::size_t storageSize() const { return size; }
+
+    std::size_t offset(int i, int j, int k) const {
+        std::size_t tile = (std::size_t(i / B) * tilesY + j / B) * tilesZ + k / B;
+        return tile * (B * B * B) + (std::size_t(i % B) * B + j % B) * B + k % B;
+    }
+
+    template <typename F>
+    void forEachRun(std::size_t begin, std::size_t end, F f) const {
+        // Row by row of B positions along k; adjacent rows of full tiles merge into one run
+        std::size_t first = begin, last = begin;
+        for (std::size_t row = begin / B; row * B < end; ++row) {
+            const std::size_t tile = row / (B * B), local = row % (B * B);
+            const std::size_t i = tile / (tilesY * tilesZ) * B + local / B;
+            const std::size_t j = tile / tilesZ % tilesY * B + local % B;
+            const std::size_t k = tile % tilesZ * B;
+            if (i >= nx || j >= ny) {
+                continue;
+            }
+            const std::size_t runBegin = std::max(begin, row * B);
+            const std::size_t runEnd = std::min(end, row * B + std::min<std::size_t>(B, nz - k));
+            if (runBegin >= runEnd) {
+                continue;
+            }
+            if (runBegin != last) {
+                if (first < last) {
+                    f(first, last);
+                }
+                first = runBegin;
+            }
+            last = runEnd;
+        }
+        if (first < last) {
+            f(first, last);
+        }
+    }
+
+private:
+    static std::size_t tiles(int n) { return (std::size_t(n) + B - 1) / B; }
+
+    std::size_t nx, ny, nz;      ///< Dimensions of the grid.
+    std::size_t tilesY, tilesZ;  ///< Number of tiles in y and z.
+    std::size_t size;            ///< Number of elements including the padding of partial tiles.
+};
+
+/**
+ * @brief Morton (Z-order) layout: the offset interleaves the bits of i, j and k, so every
+ * aligned 2^m x 2^m x 2^m block is contiguous at every scale m. Each extent is padded to a
+ * power of two; once the shorter extents run out of bits, the remaining bits of the longer
+ * ones follow, so the storage is the product of the padded extents (no padding to a cube).
+ * The code is the OR of one precomputed table entry per axis.
+ */
+class Morton
+{
+public:
+    static const char* name() { return "Morton"; }
+
+    static constexpr bool strided = false;
+
+    Morton(int nx_, int ny_, int nz_) {
+        int bits[3] = {log2Ceil(nx_), log2Ceil(ny_), log2Ceil(nz_)};
+        int extents[3] = {nx_, ny_, nz_};
+        // Output bit of every input bit: level by level, k first (lowest), then j, then i
+        std::vector<int> position[3];
+        int next = 0;
+        for (int level = 0; level < std::max(bits[0], std::max(bits[1], bits[2])); ++level) {
+            for (int axis = 2; axis >= 0; --axis) {
+                if (level < bits[axis]) {
+                    position[axis].push_back(next++);
+                }
+            }
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            spread[axis].resize(extents[axis]);
+            for (int v = 0; v < extents[axis]; ++v) {
+                std::size_t code = 0;
+                for (int b = 0; b < bits[axis]; ++b) {
+                    if ((v >> b) & 1) {
+                        code |= std::size_t(1) << position[axis][b];
+                    }
+                }
+                spread[axis][v] = code;
+            }
+            last[axis] = spread[axis][extents[axis] - 1];
+            mask[axis] = 0;
+            for (int b = 0; b < bits[axis]; ++b) {
+                mask[axis] |= std::size_t(1) << position[axis][b];
+            }
+        }
+        size = std::size_t(1) << next;
+    }
+
+    std::size_t storageSize() const { return size; }
+
+    std::size_t offset(int i, int j, int k) const {
+        return spread[0][i] | spread[1][j] | spread[2][k];
+    }
+
+    template <typename F>
+    void forEachRun(std::size_t begin, std::size_t end, F f) const {
+        // The spread codes increase with the index, so p holds a grid point if the bits of each
+        // axis do not exceed the code of the last index of that axis
+        std::size_t first = begin;
+        bool inside = false;
+        for (std::size_t p = begin; p < end; ++p) {
+            const bool valid = (p & mask[0]) <= last[0] && (p & mask[1]) <= last[1] && (p & mask[2]) <= last[2];
+            if (valid && !inside) {
+                first = p;
+            } else if (!valid && inside) {
+                f(first, p);
+            }
+            inside = valid;
+        }
+        if (inside) {
+            f(first, end);
+        }
+    }
+
+private:
+    static int log2Ceil(int n) {
+        int bits = 0;
+        while ((1 << bits) < n) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    std::vector<std::size_t> spread[3];  ///< Bits contributed by each value of i, j and k.
+    std::size_t mask[3];                 ///< All the bits of each axis.
+    std::size_t last[3];                 ///< Bits of the last index of each axis.
+    std::size_t size;                    ///< Product of the padded extents.
+};
+
+/**
+ * @class Grid
+ * @brief A 3D grid of values of type T, stored in a single 64-byte aligned allocation in the
+ * order given by the Layout policy (RowMajor, ColumnMajor, Tiled3D<B> or Morton).
+ *
+ * The logical interface does not depend on the layout, so the layout can be chosen per
+ * workload: RowMajor for sweeps along k, ColumnMajor for sweeps along i, Tiled3D or Morton
+ * for stencils and other accesses that move in all three directions.
+ */
+template <typename T, typename Layout = RowMajor>
+class Grid
+{
+    static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value,
+                  "Grid stores plain values (numbers or simple structs) in raw aligned storage.");
+
+public:
+    /// Alignment of the storage in bytes (one cache line).
+    static constexpr std::size_t ALIGNMENT = 64;
+
+    /**
+     * @brief Constructor to initialize the 3D grid; all values start at zero.
+     * @param nx_ Number of grid points in the x direction.
+     * @param ny_ Number of grid points in the y direction.
+     * @param nz_ Number of grid points in the z direction.
+     */
+    Grid(int nx_=1, int ny_=1, int nz_=1)
+        : nx(nx_), ny(ny_), nz(nz_), layout(checkDimensions(nx_, ny_, nz_)), data(nullptr) {
+        allocate();
+        std::fill(data, data + layout.storageSize(), T());
+    }
+
+    /// Tag of the constructor that leaves the values uninitialized.
+    struct Uninitialized {};
+
+    /**
+     * @brief Constructor that allocates the storage without touching it, so that the threads that
+     * will work on the grid can write it first (see parallel::fill in grid_parallel.h).
+     * @param nx_ Number of grid points in the x direction.
+     * @param ny_ Number of grid points in the y direction.
+     * @param nz_ Number of grid points in the z direction.
+     */
+    Grid(int nx_, int ny_, int nz_, Uninitialized)
+        : nx(nx_), ny(ny_), nz(nz_), layout(checkDimensions(nx_, ny_, nz_)), data(nullptr) {
+        allocate();
+    }
+
+    /**
+     * @brief Copy constructor: a deep copy with the same dimensions and layout.
+     * @param grid The grid to copy.
+     */
+    Grid(const Grid& grid) : nx(grid.nx), ny(grid.ny), nz(grid.nz), layout(grid.layout), data(nullptr) {
+        if (grid.data) {
+            allocate();
+            std::copy(grid.data, grid.data + layout.storageSize(), data);
+        }
+    }
+
+    /**
+     * @brief Move constructor: takes over the storage; the moved-from grid is left empty.
+     * @param grid The grid to move from.
+     */
+    Grid(Grid&& grid) noexcept
+        : nx(grid.nx), ny(grid.ny), nz(grid.nz), layout(std::move(grid.layout)), data(grid.data) {
+        grid.data = nullptr;
+        grid.nx = grid.ny = grid.nz = 0;
+    }
+
+    /**
+     * @brief Constructor that evaluates a grid expression such as `a + b * c` in a single pass;
+     * only the new grid is allocated.
+     * @param expression The expression (see grid_expression.h).
+     */
+    template <typename E>
+    Grid(const GridExpression<E>& expression)
+        : Grid(expression.derived().shape(), Uninitialized()) {
+        evaluate(expression.derived());
+    }
+
+    /**
+     * @brief Copy and move assignment (copy-and-swap).
+     * @param grid The grid to assign.
+     * @return A reference to this grid.
+     */
+    Grid& operator=(Grid grid) noexcept {
+        swap(grid);
+        return *this;
+    }
+
+    /**
+     * @brief Assigns a grid expression, evaluated in a single pass. The storage is reused when the
+     * dimensions match; the expression may refer to this grid (`a = a + b`).
+     * @param expression The expression.
+     * @return A reference to this grid.
+     */
+    template <typename E>
+    Grid& operator=(const GridExpression<E>& expression) {
+        if (expression.derived().shape() == shape()) {
+            evaluate(expression.derived());
+        } else {
+            Grid result(expression);
+            swap(result);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Adds a grid or expression in place, in a single pass and without allocating.
+     * @param other A grid or expression of the same dimensions.
+     * @return A reference to this grid.
+     */
+    template <typename R, typename B = typename GridOperand<R>::type>
+    Grid& operator+=(const R& other) {
+        evaluate(GridBinary<GridAdd, GridLeaf<T, Layout>, B>(expression(), GridOperand<R>::make(other)));
+        return *this;
+    }
+
+    /**
+     * @brief Subtracts a grid or expression in place, in a single pass and without allocating.
+     * @param other A grid or expression of the same dimensions.
+     * @return A reference to this grid.
+     */
+    template <typename R, typename B = typename GridOperand<R>::type>
+    Grid& operator-=(const R& other) {
+        evaluate(GridBinary<GridSubtract, GridLeaf<T, Layout>, B>(expression(), GridOperand<R>::make(other)));
+        return *this;
+    }
+
+    /**
+     * @brief Multiplies element-wise by a grid or expression in place.
+     * @param other A grid or expression of the same dimensions.
+     * @return A reference to this grid.
+     */
+    template <typename R, typename B = typename GridOperand<R>::type>
+    Grid& operator*=(const R& other) {
+        evaluate(GridBinary<GridMultiply, GridLeaf<T, Layout>, B>(expression(), GridOperand<R>::make(other)));
+        return *this;
+    }
+
+    /**
+     * @brief Multiplies every value by a scalar in place.
+     * @param alpha The factor.
+     * @return A reference to this grid.
+     */
+    Grid& operator*=(const T& alpha) {
+        scale(alpha);
+        return *this;
+    }
+
+    /**
+     * @brief Destructor to free the storage.
+     */
+    ~Grid() {
+        ::operator delete(data, std::align_val_t(ALIGNMENT));
+    }
+
+    /**
+     * @brief Exchanges the contents of two grids.
+     * @param grid The other grid.
+     */
+    void swap(Grid& grid) noexcept {
+        std::swap(nx, grid.nx);
+        std::swap(ny, grid.ny);
+        std::swap(nz, grid.nz);
+        std::swap(layout, grid.layout);
+        std::swap(data, grid.data);
+    }
+
+    /**
+     * @brief Get the total number of elements in the grid.
+     * @return Total number of elements in the grid.
+     */
+    std::size_t getSize() const {
+        return std::size_t(nx) * ny * nz;
+    }
+
+    /**
+     * @brief Get the total memory used by the grid (in bytes), including any padding of the layout.
+     * @return Memory usage of the grid in bytes.
+     */
+    std::size_t getMemory() const {
+        return data ? layout.storageSize() * sizeof(T) : 0;
+    }
+
+    /**
+     * @brief Get the number of grid points in the x direction.
+     */
+    int getNx() const { return nx; }
+
+    /**
+     * @brief Get the number of grid points in the y direction.
+     */
+    int getNy() const { return ny; }
+
+    /**
+     * @brief Get the number of grid points in the z direction.
+     */
+    int getNz() const { return nz; }
+
+    /**
+     * @brief Overloaded () operator to get the value at a specific grid point. The indices are
+     * checked only if GRID_CHECK_BOUNDS is set (by default in builds without NDEBUG).
+     * @param i The x index.
+     * @param j The y index.
+     * @param k The z index.
+     * @return The value at the grid point (i, j, k).
+     */
+    const T& operator()(int i, int j, int k) const {
+#if GRID_CHECK_BOUNDS
+        checkGridIndex(i, j, k, nx, ny, nz);
+#endif
+        return data[layout.offset(i, j, k)];
+    }
+
+    /**
+     * @brief Overloaded () operator to access the value at a specific grid point. The indices are
+     * checked only if GRID_CHECK_BOUNDS is set (by default in builds without NDEBUG).
+     * @param i The x index.
+     * @param j The y index.
+     * @param k The z index.
+     * @return A reference to the value at the grid point (i, j, k).
+     */
+    T& operator()(int i, int j, int k) {
+#if GRID_CHECK_BOUNDS
+        checkGridIndex(i, j, k, nx, ny, nz);
+#endif
+        return data[layout.offset(i, j, k)];
+    }
+
+    /**
+     * @brief Access to a grid point with the indices always checked.
+     * @param i The x index.
+     * @param j The y index.
+     * @param k The z index.
+     * @return A reference to the value at the grid point (i, j, k).
+     * @throws std::out_of_range for an invalid index.
+     */
+    T& at(int i, int j, int k) {
+        checkGridIndex(i, j, k, nx, ny, nz);
+        return data[layout.offset(i, j, k)];
+    }
+
+    const T& at(int i, int j, int k) const {
+        checkGridIndex(i, j, k, nx, ny, nz);
+        return data[layout.offset(i, j, k)];
+    }
+
+    /**
+     * @brief Set the value at a specific grid point (checked like operator()).
+     * @param i The x index.
+     * @param j The y index.
+     * @param k The z index.
+     * @param value The value to set.
+     */
+    void set(int i, int j, int k, const T& value) {
+        (*this)(i, j, k) = value;
+    }
+
+    /// Iterators over the grid points in (i, j, k) order, k fastest; plain pointers for RowMajor grids.
+    typedef typename std::conditional<std::is_same<Layout, RowMajor>::value, T*,
+                                      GridIterator<T, LayoutMapping<Layout>>>::type iterator;
+    typedef typename std::conditional<std::is_same<Layout, RowMajor>::value, const T*,
+                                      GridIterator<const T, LayoutMapping<Layout>>>::type const_iterator;
+
+    iterator begin() { return makeIterator<iterator>(data, 0); }
+    iterator end() { return makeIterator<iterator>(data, getSize()); }
+    const_iterator begin() const { return makeIterator<const_iterator>(data, 0); }
+    const_iterator end() const { return makeIterator<const_iterator>(data, getSize()); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    /**
+     * @brief The storage as a span, getLayout().storageSize() values in the order of the layout
+     * (padding included).
+     */
+    GridSpan<T> span() { return GridSpan<T>(data, data ? layout.storageSize() : 0); }
+    GridSpan<const T> span() const { return GridSpan<const T>(data, data ? layout.storageSize() : 0); }
+
+    /**
+     * @brief A view of the whole grid, from which sub-boxes, strided selections and planes can be
+     * taken without copying (GridView::sub and GridView::plane). Only for strided layouts
+     * (RowMajor and ColumnMajor).
+     */
+    GridView<T> view() {
+        static_assert(Layout::strided, "Views need a strided layout (RowMajor or ColumnMajor).");
+        const StridedMapping strides = layout.strides();
+        return GridView<T>(data, nx, ny, nz, strides.si, strides.sj, strides.sk);
+    }
+
+    GridView<const T> view() const {
+        static_assert(Layout::strided, "Views need a strided layout (RowMajor or ColumnMajor).");
+        const StridedMapping strides = layout.strides();
+        return GridView<const T>(data, nx, ny, nz, strides.si, strides.sj, strides.sk);
+    }
+
+    /**
+     * @brief Multiplies every value by a scalar, in place.
+     * @param alpha The factor.
+     */
+    void scale(const T& alpha) {
+        if constexpr (std::is_same<T, double>::value) {
+            simd::scale(data, alpha, data, layout.storageSize());
+        } else {
+            for (std::size_t p = 0; p < layout.storageSize(); ++p) {
+                data[p] = alpha * data[p];
+            }
+        }
+    }
+
+    /**
+     * @brief Adds a multiple of another grid, in place: this = this + alpha * x.
+     * @param alpha The factor.
+     * @param x The grid to add (same dimensions).
+     */
+    void axpy(const T& alpha, const Grid& x) {
+        checkSameDimensions(x, "axpy");
+        if constexpr (std::is_same<T, double>::value) {
+            simd::axpy(alpha, x.data, data, layout.storageSize());
+        } else {
+            for (std::size_t p = 0; p < layout.storageSize(); ++p) {
+                data[p] = data[p] + alpha * x.data[p];
+            }
+        }
+    }
+
+    /**
+     * @brief Adds the element-wise product of two grids, in place and rounded once: this = a * b + this.
+     * @param a The first factor (same dimensions).
+     * @param b The second factor (same dimensions).
+     */
+    void multiplyAdd(const Grid& a, const Grid& b) {
+        checkSameDimensions(a, "multiply-add");
+        checkSameDimensions(b, "multiply-add");
+        if constexpr (std::is_same<T, double>::value) {
+            simd::fma(a.data, b.data, data, data, layout.storageSize());
+        } else {
+            for (std::size_t p = 0; p < layout.storageSize(); ++p) {
+                data[p] = a.data[p] * b.data[p] + data[p];
+            }
+        }
+    }
+
+    /**
+     * @brief Sum of all values. For double grids the order of the additions is fixed (see grid_simd.h),
+     * so the result does not depend on the instruction set.
+     * @return The sum.
+     */
+    T sum() const {
+        if constexpr (std::is_same<T, double>::value) {
+            return simd::sum(data, layout.storageSize());
+        } else {
+            T total = T();
+            for (std::size_t p = 0; p < layout.storageSize(); ++p) {
+                total = total + data[p];
+            }
+            return total;
+        }
+    }
+
+    /**
+     * @brief Dot product with another grid, the sum of the element-wise products.
+     * @param grid The other grid (same dimensions).
+     * @return The dot product.
+     */
+    T dot(const Grid& grid) const {
+        checkSameDimensions(grid, "the dot product");
+        if constexpr (std::is_same<T, double>::value) {
+            return simd::dot(data, grid.data, layout.storageSize());
+        } else {
+            T total = T();
+            for (std::size_t p = 0; p < layout.storageSize(); ++p) {
+                total = total + data[p] * grid.data[p];
+            }
+            return total;
+        }
+    }
+
+    /**
+     * @brief The storage, getLayout().storageSize() values in the order of the layout (padding included).
+     */
+    T* storage() { return data; }
+    const T* storage() const { return data; }
+
+    /**
+     * @brief The layout policy that maps grid points to storage positions.
+     */
+    const Layout& getLayout() const { return layout; }
+
+    /**
+     * @brief This grid as an operand of a grid expression.
+     */
+    GridLeaf<T, Layout> expression() const {
+        return GridLeaf<T, Layout>(data, shape());
+    }
+
+    /**
+     * @brief Evaluates a grid expression at the storage positions [begin, end) only, for example one
+     * thread's share of the storage (see parallel::assign in grid_parallel.h). Sums, differences and
+     * multiples of grids and axpy updates go to the SIMD kernels; any other expression is evaluated
+     * in one fused loop.
+     * @param expression An expression of the same dimensions.
+     * @param begin First storage position.
+     * @param end One past the last storage position (at most getLayout().storageSize()).
+     */
+    template <typename E>
+    void evaluateRange(E expression, std::size_t begin, std::size_t end) {
+        static_assert(std::is_same<typename E::value_type, T>::value, "The expression has another value type.");
+        static_assert(std::is_same<typename E::layout_type, Layout>::value, "The expression has another layout.");
+        if (!(expression.shape() == shape())) {
+            throw std::invalid_argument("Grid dimensions must match in an expression.");
+        }
+        end = std::min(end, layout.storageSize());
+        if (begin >= end) {
+            return;
+        }
+        const std::size_t n = end - begin;
+        T* out = data + begin;
+        typedef GridLeaf<T, Layout> Leaf;
+        if constexpr (std::is_same<T, double>::value && std::is_same<E, GridBinary<GridAdd, Leaf, Leaf>>::value) {
+            simd::add(expression.leftOperand().storage() + begin, expression.rightOperand().storage() + begin, out, n);
+        } else if constexpr (std::is_same<T, double>::value
+                             && std::is_same<E, GridBinary<GridSubtract, Leaf, Leaf>>::value) {
+            simd::sub(expression.leftOperand().storage() + begin, expression.rightOperand().storage() + begin, out, n);
+        } else if constexpr (std::is_same<T, double>::value && std::is_same<E, GridScaled<Leaf>>::value) {
+            simd::scale(expression.scaledOperand().storage() + begin, expression.factor(), out, n);
+        } else if constexpr (std::is_same<T, double>::value
+                             && std::is_same<E, GridBinary<GridAdd, Leaf, GridScaled<Leaf>>>::value) {
+            if (expression.leftOperand().storage() == data) {
+                // y += alpha * x
+                const GridScaled<Leaf>& scaled = expression.rightOperand();
+                simd::axpy(scaled.factor(), scaled.scaledOperand().storage() + begin, out, n);
+                return;
+            }
+            for (std::size_t p = begin; p < end; ++p) {
+                data[p] = expression[p];
+            }
+        } else {
+            for (std::size_t p = begin; p < end; ++p) {
+                data[p] = expression[p];
+            }
+        }
+    }
+
+    /**
+     * @brief Overloaded << operator for printing the grid in (i, j, k) order, whatever the layout.
+     * @param os The output stream.
+     * @param grid The grid to print.
+     * @return The output stream with grid data.
+     */
+    friend std::ostream& operator<<(std::ostream& os, const Grid& grid) {
+        for (int i = 0; i < grid.nx; ++i) {
+            for (int j = 0; j < grid.ny; ++j) {
+                for (int k = 0; k < grid.nz; ++k) {
+                    os << grid(i, j, k) << " ";
+                }
+                os << std::endl;
+            }
+            os << std::endl;
+        }
+        return os;
+    }
+
+private:
+    Grid(const GridShape& shape_, Uninitialized)
+        : nx(shape_.nx), ny(shape_.ny), nz(shape_.nz), layout(nx, ny, nz), data(nullptr) {
+        allocate();
+    }
+
+    GridShape shape() const {
+        return GridShape{nx, ny, nz, layout.storageSize()};
+    }
+
+    /**
+     * @brief Stores the value of an expression of the same dimensions at every storage position.
+     * The expression is taken by value so that the compiler knows the stores cannot change the
+     * operand pointers it holds.
+     */
+    template <typename E>
+    void evaluate(E expression) {
+        evaluateRange(expression, 0, layout.storageSize());
+    }
+
+    static Layout checkDimensions(int nx_, int ny_, int nz_) {
+        if (nx_ <= 0 || ny_ <= 0 || nz_ <= 0) {
+            throw std::invalid_argument("Grid dimensions must be positive.");
+        }
+        return Layout(nx_, ny_, nz_);
+    }
+
+    void checkSameDimensions(const Grid& grid, const char* operation) const {
+        if (nx != grid.nx || ny != grid.ny || nz != grid.nz) {
+            throw std::invalid_argument(std::string("Grid dimensions must match for ") + operation + ".");
+        }
+    }
+
+    template <typename Iterator, typename U>
+    Iterator makeIterator(U* base, std::size_t index) const {
+        if constexpr (std::is_pointer<Iterator>::value) {
+            return base + index;
+        } else {
+            return Iterator(base, LayoutMapping<Layout>{&layout}, ny, nz, static_cast<std::ptrdiff_t>(index));
+        }
+    }
+
+    void allocate() {
+        data = static_cast<T*>(::operator new(layout.storageSize() * sizeof(T), std::align_val_t(ALIGNMENT)));
+    }
+
+    int nx, ny, nz;  ///< Dimensions of the grid.
+    Layout layout;   ///< Maps (i, j, k) to a position in the storage.
+    T* data;         ///< Storage, one aligned allocation of layout.storageSize() values.
+};
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef __GRID_EXPRESSION_H__
+#define __GRID_EXPRESSION_H__
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+/**
+ * @brief Expression templates for element-wise grid arithmetic.
+ *
+ * `a + b`, `a - b`, `a * b` (element-wise), `-a`, `alpha * a` and `a * alpha` on grids do not compute
+ * anything: they return a small expression object that records the operation and holds the
+ * operands by value (an operand grid is held as a pointer to its storage). Assigning the expression
+ * to a Grid, or constructing a Grid from it, evaluates the whole expression point by point in a
+ * single pass, so `Grid1 d = a + b + c;` reads each operand once, writes the result once and
+ * allocates no temporary grid. Each point is computed with the same operations in the same order
+ * as with one pass per operator, so the results are identical.
+ *
+ * An expression refers to the storage of its grids: it must be evaluated while they exist.
+ * All grids of an expression must have the same value type, layout and dimensions.
+ */
+
+template <typename T, typename Layout>
+class Grid;
+
+/**
+ * @brief Dimensions of the grids of an expression, and the number of values in their storage.
+ */
+struct GridShape
+{
+    int nx, ny, nz;    ///< Dimensions of the grid.
+    std::size_t size;  ///< Number of values in the storage (the layout's storageSize()).
+
+    bool operator==(const GridShape& shape) const {
+        return nx == shape.nx && ny == shape.ny && nz == shape.nz && size == shape.size;
+    }
+};
+
+/**
+ * @brief Base of every grid expression E (the curiously recurring template pattern). Every E has the
+ * types value_type and layout_type, shape() and operator[](p), the value at storage position p.
+ */
+template <typename E>
+class GridExpression
+{
+public:
+    const E& derived() const { return static_cast<const E&>(*this); }
+};
+
+/**
+ * @brief A grid in an expression: a pointer to its storage.
+ */
+template <typename T, typename Layout>
+class GridLeaf : public GridExpression<GridLeaf<T, Layout>>
+{
+public:
+    typedef T value_type;
+    typedef Layout layout_type;
+
+    GridLeaf(const T* data_, const GridShape& shape_) : data(data_), dims(shape_) {}
+
+    const GridShape& shape() const { return dims; }
+
+    T operator[](std::size_t p) const { return data[p]; }
+
+    /// The storage of the grid.
+    const T* storage() const { return data; }
+
+private:
+    const T* data;    ///< Storage of the grid.
+    GridShape dims;   ///< Dimensions of the grid.
+};
+
+/// Element-wise operations of GridBinary.
+struct GridAdd { template <typename T> static T apply(const T& a, const T& b) { return a + b; } };
+struct GridSubtract { template <typename T> static T apply(const T& a, const T& b) { return a - b; } };
+struct GridMultiply { template <typename T> static T apply(const T& a, const T& b) { return a * b; } };
+
+/**
+ * @brief An element-wise operation (GridAdd, GridSubtract or GridMultiply) on two expressions.
+ */
+template <typename Op, typename L, typename R>
+class GridBinary : public GridExpression<GridBinary<Op, L, R>>
+{
+    static_assert(std::is_same<typename L::value_type, typename R::value_type>::value,
+                  "Grids in an expression must have the same value type.");
+    static_assert(std::is_same<typename L::layout_type, typename R::layout_type>::value,
+                  "Grids in an expression must have the same layout.");
+
+public:
+    typedef typename L::value_type value_type;
+    typedef typename L::layout_type layout_type;
+
+    GridBinary(const L& left_, const R& right_) : left(left_), right(right_) {
+        if (!(left.shape() == right.shape())) {
+            throw std::invalid_argument("Grid dimensions must match in an expression.");
+        }
+    }
+
+    const GridShape& shape() const { return left.shape(); }
+
+    value_type operator[](std::size_t p) const { return Op::apply(left[p], right[p]); }
+
+    const L& leftOperand() const { return left; }
+    const R& rightOperand() const { return right; }
+
+private:
+    L left;   ///< Left operand.
+    R right;  ///< Right operand.
+};
+
+/**
+ * @brief An expression multiplied by a scalar (alpha * e, or -e with alpha = -1 for negation).
+ */
+template <typename E>
+class GridScaled : public GridExpression<GridScaled<E>>
+{
+public:
+    typedef typename E::value_type value_type;
+    typedef typename E::layout_type layout_type;
+
+    GridScaled(const value_type& alpha_, const E& operand_) : alpha(alpha_), operand(operand_) {}
+
+    const GridShape& shape() const { return operand.shape(); }
+
+    value_type operator[](std::size_t p) const { return alpha * operand[p]; }
+
+    const value_type& factor() const { return alpha; }
+    const E& scaledOperand() const { return operand; }
+
+private:
+    value_type alpha;  ///< The factor.
+    E operand;         ///< The scaled expression.
+};
+
+/**
+ * @brief Maps a type that can appear in a grid expression (a Grid or an expression) to its
+ * expression type; no member `type` for any other type, which removes the operators below from
+ * overload resolution.
+ */
+template <typename X, typename = void>
+struct GridOperand
+{
+};
+
+template <typename T, typename Layout>
+struct GridOperand<Grid<T, Layout>>
+{
+    typedef GridLeaf<T, Layout> type;
+    static type make(const Grid<T, Layout>& grid) { return grid.expression(); }
+};
+
+template <typename X>
+struct GridOperand<X, typename std::enable_if<std::is_base_of<GridExpression<X>, X>::value>::type>
+{
+    typedef X type;
+    static const X& make(const X& expression) { return expression; }
+};
+
+/**
+ * @brief Element-wise sum of two grids or expressions.
+ */
+template <typename L, typename R, typename A = typename GridOperand<L>::type, typename B = typename GridOperand<R>::type>
+GridBinary<GridAdd, A, B> operator+(const L& left, const R& right)
+{
+    return GridBinary<GridAdd, A, B>(GridOperand<L>::make(left), GridOperand<R>::make(right));
+}
+
+/**
+ * @brief Element-wise difference of two grids or expressions.
+ */
+template <typename L, typename R, typename A = typename GridOperand<L>::type, typename B = typename GridOperand<R>::type>
+GridBinary<GridSubtract, A, B> operator-(const L& left, const R& right)
+{
+    return GridBinary<GridSubtract, A, B>(GridOperand<L>::make(left), GridOperand<R>::make(right));
+}
+
+/**
+ * @brief Element-wise product of two grids or expressions.
+ */
+template <typename L, typename R, typename A = typename GridOperand<L>::type, typename B = typename GridOperand<R>::type>
+GridBinary<GridMultiply, A, B> operator*(const L& left, const R& right)
+{
+    return GridBinary<GridMultiply, A, B>(GridOperand<L>::make(left), GridOperand<R>::make(right));
+}
+
+/**
+ * @brief A grid or expression multiplied by a scalar, on either side.
+ */
+template <typename E, typename A = typename GridOperand<E>::type>
+GridScaled<A> operator*(const typename A::value_type& alpha, const E& expression)
+{
+    return GridScaled<A>(alpha, GridOperand<E>::make(expression));
+}
+
+template <typename E, typename A = typename GridOperand<E>::type>
+GridScaled<A> operator*(const E& expression, const typename A::value_type& alpha)
+{
+    return GridScaled<A>(alpha, GridOperand<E>::make(expression));
+}
+
+/**
+ * @brief The negation of a grid or expression.
+ */
+template <typename E, typename A = typename GridOperand<E>::type>
+GridScaled<A> operator-(const E& expression)
+{
+    return GridScaled<A>(typename A::value_type(-1), GridOperand<E>::make(expression));
+}
+
+#endif
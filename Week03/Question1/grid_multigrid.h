@@ -0,0 +1,412 @@
+#ifndef __GRID_MULTIGRID_H__
+#define __GRID_MULTIGRID_H__
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "grid_halo.h"
+#include "grid_parallel.h"
+
+/**
+ * @brief Geometric multigrid for the Poisson equation Laplacian(u) = f on a box, with the 7-point
+ * Laplacian on a uniform grid of spacing h and Dirichlet conditions on every face.
+ *
+ * The grids are vertex-centred: the n interior points of an axis lie between two boundary points,
+ * which are the ghost cells of a HaloGrid (a Dirichlet face writes its value there). A grid with
+ * n = 2m + 1 points coarsens to m points with spacing 2h, coarse point I lying on fine point 2I + 1,
+ * so n = 2^L - 1 (64^3 cells for n = 63) gives L levels down to a single point.
+ *
+ * - Smoothing: red-black Gauss-Seidel. The points with i + j + k even (red) are updated first from
+ *   their black neighbours, then the black points from the new red values; the points of one
+ *   colour do not depend on each other, so the result does not depend on the number of threads.
+ * - Restriction: full weighting, the 27 fine points around a coarse point with weights
+ *   (1/4, 1/2, 1/4) along each axis.
+ * - Prolongation: trilinear interpolation.
+ *
+ * Every operator works on blocks of i-planes, one per thread of a GridThreadPool, at every level of
+ * the hierarchy. One V-cycle costs a fixed number of passes over the finest grid (the coarser levels
+ * add 1/8 + 1/64 + ... < 1/7 of that) and reduces the error by a factor independent of h, so the
+ * work to reach a given accuracy grows linearly with the number of points.
+ */
+namespace multigrid
+{
+
+/**
+ * @brief Parameters of the cycles.
+ */
+struct Options
+{
+    int preSmooth = 2;       ///< Red-black sweeps before the coarse-grid correction.
+    int postSmooth = 2;      ///< Red-black sweeps after it.
+    int coarseSweeps = 20;   ///< Red-black sweeps that solve the coarsest level.
+    int cyclesPerLevel = 1;  ///< V-cycles at each level of full multigrid.
+};
+
+/// Most interior points along an axis of the coarsest level, which coarseSweeps sweeps must solve.
+constexpr int MAX_COARSE_POINTS = 4;
+
+namespace detail
+{
+/**
+ * @brief Calls body(i0, i1) on every thread of the pool, with the i-planes [0, n) split into one
+ * contiguous block per thread.
+ */
+template <typename Body>
+void forPlanes(GridThreadPool& pool, int n, Body body)
+{
+    const unsigned threads = pool.size();
+    pool.run([&](unsigned t) {
+        const int i0 = static_cast<int>(std::int64_t(n) * t / threads);
+        const int i1 = static_cast<int>(std::int64_t(n) * (t + 1) / threads);
+        if (i0 < i1) {
+            body(i0, i1);
+        }
+    });
+}
+
+/**
+ * @brief One red-black Gauss-Seidel sweep (both colours) of Laplacian(u) = f; the halo of u must hold
+ * the boundary values.
+ */
+inline void smooth(GridThreadPool& pool, HaloGrid<double>& u, const Grid<double>& f, double h)
+{
+    const int ny = u.getNy(), nz = u.getNz();
+    const double h2 = h * h;
+    const std::ptrdiff_t si = u.strideI(), sj = u.strideJ();
+    for (int colour = 0; colour < 2; ++colour) {
+        forPlanes(pool, u.getNx(), [&](int i0, int i1) {
+            for (int i = i0; i < i1; ++i) {
+                for (int j = 0; j < ny; ++j) {
+                    double* c = u.row(i, j);
+                    const double* rhs = f.storage() + (std::size_t(i) * ny + j) * nz;
+                    for (int k = (i + j + colour) & 1; k < nz; k += 2) {
+                        const double sum = ((c[k - 1] + c[k + 1]) + (c[k - sj] + c[k + sj])) + (c[k - si] + c[k + si]);
+                        c[k] = (sum - h2 * rhs[k]) * simd::detail::SIXTH;
+                    }
+                }
+            }
+        });
+    }
+}
+
+/**
+ * @brief r = f - Laplacian(u) at every interior point.
+ */
+inline void residual(GridThreadPool& pool, const HaloGrid<double>& u, const Grid<double>& f, Grid<double>& r,
+                     double h)
+{
+    const int ny = u.getNy(), nz = u.getNz();
+    const double scale = 1.0 / (h * h);
+    forPlanes(pool, u.getNx(), [&](int i0, int i1) {
+        for (int i = i0; i < i1; ++i) {
+            for (int j = 0; j < ny; ++j) {
+                const std::size_t p = (std::size_t(i) * ny + j) * nz;
+                simd::laplacianRow(stencil::detail::stencilRows(u, i, j, 0), scale, r.storage() + p, nz);
+                simd::sub(f.storage() + p, r.storage() + p, r.storage() + p, nz);
+            }
+        }
+    });
+}
+
+/**
+ * @brief Full-weighting restriction of the fine grid `fine` to `coarse` (nc = (n - 1) / 2 points
+ * per axis).
+ */
+inline void restrictGrid(GridThreadPool& pool, const Grid<double>& fine, Grid<double>& coarse)
+{
+    const int ny = fine.getNy(), nz = fine.getNz();
+    const int cy = coarse.getNy(), cz = coarse.getNz();
+    const double weight[3] = {0.25, 0.5, 0.25};
+    forPlanes(pool, coarse.getNx(), [&](int i0, int i1) {
+        for (int ci = i0; ci < i1; ++ci) {
+            for (int cj = 0; cj < cy; ++cj) {
+                double* out = coarse.storage() + (std::size_t(ci) * cy + cj) * cz;
+                for (int ck = 0; ck < cz; ++ck) {
+                    double value = 0.0;
+                    for (int di = 0; di < 3; ++di) {
+                        for (int dj = 0; dj < 3; ++dj) {
+                            const double* row = fine.storage() + (std::size_t(2 * ci + di) * ny + 2 * cj + dj) * nz + 2 * ck;
+                            const double line = (weight[0] * row[0] + weight[1] * row[1]) + weight[2] * row[2];
+                            value += weight[di] * weight[dj] * line;
+                        }
+                    }
+                    out[ck] = value;
+                }
+            }
+        }
+    });
+}
+
+/**
+ * @brief Trilinear interpolation of `coarse` (with its halo filled) to the fine grid: adds it to
+ * the interior of `fine` if `add` is set, and replaces the interior otherwise.
+ */
+inline void prolong(GridThreadPool& pool, const HaloGrid<double>& coarse, HaloGrid<double>& fine, bool add)
+{
+    const int ny = fine.getNy(), nz = fine.getNz();
+    forPlanes(pool, fine.getNx(), [&](int i0, int i1) {
+        for (int i = i0; i < i1; ++i) {
+            // Fine point 2I + 1 is coarse point I; fine point 2I lies halfway between I - 1 and I.
+            const int ci = (i - 1) >> 1, ciHigh = i / 2;
+            for (int j = 0; j < ny; ++j) {
+                const int cj = (j - 1) >> 1, cjHigh = j / 2;
+                const double* a = coarse.row(ci, cj);
+                const double* b = coarse.row(ci, cjHigh);
+                const double* c = coarse.row(ciHigh, cj);
+                const double* d = coarse.row(ciHigh, cjHigh);
+                double* out = fine.row(i, j);
+                for (int k = 0; k < nz; ++k) {
+                    const int ck = (k - 1) >> 1, ckHigh = k / 2;
+                    const double value = 0.125 * (((a[ck] + a[ckHigh]) + (b[ck] + b[ckHigh]))
+                                                  + ((c[ck] + c[ckHigh]) + (d[ck] + d[ckHigh])));
+                    out[k] = add ? out[k] + value : value;
+                }
+            }
+        }
+    });
+}
+
+/**
+ * @brief Sets every interior value of u to zero.
+ */
+inline void zeroInterior(GridThreadPool& pool, HaloGrid<double>& u)
+{
+    forPlanes(pool, u.getNx(), [&](int i0, int i1) {
+        for (int i = i0; i < i1; ++i) {
+            for (int j = 0; j < u.getNy(); ++j) {
+                std::fill(u.row(i, j), u.row(i, j) + u.getNz(), 0.0);
+            }
+        }
+    });
+}
+} // namespace detail
+
+/**
+ * @class PoissonSolver
+ * @brief V-cycles and full multigrid for Laplacian(u) = f on nx x ny x nz interior points with
+ * spacing h. The solver owns the coarse levels and the residual grids; the solution u (a HaloGrid
+ * whose faces are all Dirichlet, with a halo of at least 1) and f (a Grid1 of the interior) belong
+ * to the caller and keep their dimensions between calls.
+ *
+ * Every dimension must be n = 2^L c - 1 with c = 1, 3 or 5 (for example 63 = 2^6 - 1, 95 = 2^5 3 - 1
+ * or 159 = 2^5 5 - 1),
+ * so that halving reaches a coarsest level of at most MAX_COARSE_POINTS points per axis. Other sizes
+ * would stop at a large coarsest level that the coarse sweeps cannot solve, and the work per cycle
+ * would no longer be linear in the number of points; the constructor rejects them.
+ */
+class PoissonSolver
+{
+public:
+    /**
+     * @brief Builds the hierarchy: the levels are halved while every dimension is odd and at least 3.
+     * @throws std::invalid_argument If the coarsest level has more than MAX_COARSE_POINTS points along an axis.
+     * @param pool Threads that run every operator.
+     * @param nx_ Number of interior points in the x direction.
+     * @param ny_ Number of interior points in the y direction.
+     * @param nz_ Number of interior points in the z direction.
+     * @param h_ Grid spacing of the finest level.
+     * @param options_ Smoothing sweeps and cycles.
+     */
+    PoissonSolver(GridThreadPool& pool_, int nx_, int ny_, int nz_, double h_, const Options& options_ = Options())
+        : pool(pool_), options(options_) {
+        if (nx_ <= 0 || ny_ <= 0 || nz_ <= 0 || !(h_ > 0.0)) {
+            throw std::invalid_argument("Grid dimensions and spacing must be positive.");
+        }
+        int nx = nx_, ny = ny_, nz = nz_;
+        while (coarsens(nx, ny, nz)) {
+            nx /= 2;
+            ny /= 2;
+            nz /= 2;
+        }
+        if (std::max(nx, std::max(ny, nz)) > MAX_COARSE_POINTS) {
+            throw std::invalid_argument("Multigrid needs 2^L c - 1 points along every axis with c = 1, 3 or 5; "
+                                        "this grid stops coarsening at " + std::to_string(nx) + " x "
+                                        + std::to_string(ny) + " x " + std::to_string(nz) + ".");
+        }
+
+        nx = nx_;
+        ny = ny_;
+        nz = nz_;
+        double h = h_;
+        levels.push_back(Level{HaloGrid<double>(), parallel::zeros<double>(pool, nx, ny, nz), Grid<double>(), nx, ny, nz, h});
+        while (coarsens(nx, ny, nz)) {
+            nx /= 2;
+            ny /= 2;
+            nz /= 2;
+            h *= 2.0;
+            levels.push_back(Level{HaloGrid<double>(nx, ny, nz), Grid<double>(nx, ny, nz),
+                                   Grid<double>(nx, ny, nz), nx, ny, nz, h});
+        }
+    }
+
+    /// Number of levels, the finest included.
+    int getLevels() const { return static_cast<int>(levels.size()); }
+
+    /// Memory of the coarse levels and the residual grids in bytes.
+    std::size_t getMemory() const {
+        std::size_t bytes = levels[0].r.getMemory();
+        for (std::size_t l = 1; l < levels.size(); ++l) {
+            bytes += levels[l].u.getMemory() + levels[l].f.getMemory() + levels[l].r.getMemory();
+        }
+        return bytes;
+    }
+
+    /**
+     * @brief One V-cycle on u.
+     * @return The root mean square of the residual f - Laplacian(u) after the cycle.
+     * @throws std::invalid_argument if the dimensions of u or f differ from those of the solver or a
+     * face of u is not Dirichlet.
+     */
+    double vcycle(HaloGrid<double>& u, const Grid<double>& f) {
+        check(u, f);
+        u.fillHalo();
+        cycle(0, u, f);
+        return residualNorm(u, f);
+    }
+
+    /**
+     * @brief Full multigrid: f is restricted to every level, the coarsest level is solved, and each
+     * finer level starts from the interpolated solution of the level below and runs
+     * Options::cyclesPerLevel V-cycles. The coarse levels use the boundary values of u, so one pass
+     * solves to about the accuracy of the discretization from any starting u.
+     * @return The root mean square of the residual after the pass.
+     */
+    double fullMultigrid(HaloGrid<double>& u, const Grid<double>& f) {
+        check(u, f);
+        u.fillHalo();
+        const int last = getLevels() - 1;
+        for (int l = 1; l <= last; ++l) {
+            detail::restrictGrid(pool, l == 1 ? f : levels[l - 1].f, levels[l].f);
+        }
+        for (int l = last; l >= 0; --l) {
+            HaloGrid<double>& level = l == 0 ? u : levels[l].u;
+            if (l > 0) {
+                // The problem itself at this level: the boundary values of u (the coarse levels of
+                // the V-cycles below it solve for a correction, with zero boundaries).
+                setBoundaries(level, u);
+            }
+            if (l == last) {
+                detail::zeroInterior(pool, level);
+                cycle(l, level, l == 0 ? f : levels[l].f);
+                continue;
+            }
+            detail::prolong(pool, levels[l + 1].u, level, false);
+            for (int c = 0; c < options.cyclesPerLevel; ++c) {
+                cycle(l, level, l == 0 ? f : levels[l].f);
+            }
+        }
+        return residualNorm(u, f);
+    }
+
+    /**
+     * @brief V-cycles until the residual norm falls below `tolerance` times its initial value.
+     * @return The residual norm before the first cycle and after each cycle.
+     */
+    std::vector<double> solve(HaloGrid<double>& u, const Grid<double>& f, double tolerance, int maxCycles) {
+        check(u, f);
+        u.fillHalo();
+        std::vector<double> history{residualNorm(u, f)};
+        for (int c = 0; c < maxCycles && history.back() > tolerance * history.front(); ++c) {
+            history.push_back(vcycle(u, f));
+        }
+        return history;
+    }
+
+    /**
+     * @brief The root mean square of the residual f - Laplacian(u); the halo of u must be filled.
+     */
+    double residualNorm(const HaloGrid<double>& u, const Grid<double>& f) {
+        check(u, f);
+        detail::residual(pool, u, f, levels[0].r, levels[0].h);
+        return parallel::norm(pool, levels[0].r) / std::sqrt(double(u.getSize()));
+    }
+
+private:
+    /**
+     * @brief A level of the hierarchy. The finest level uses the caller's u and f and only owns r.
+     */
+    struct Level
+    {
+        HaloGrid<double> u;  ///< Correction (solution in full multigrid), zero boundaries.
+        Grid<double> r;      ///< Residual.
+        Grid<double> f;      ///< Right-hand side: the restricted residual of the finer level.
+        int nx, ny, nz;      ///< Interior dimensions.
+        double h;            ///< Grid spacing.
+    };
+
+    /// Whether a level of these dimensions has a coarser level: every dimension odd and at least 3.
+    static bool coarsens(int nx, int ny, int nz) {
+        return nx % 2 == 1 && ny % 2 == 1 && nz % 2 == 1 && std::min(nx, std::min(ny, nz)) >= 3;
+    }
+
+    void check(const HaloGrid<double>& u, const Grid<double>& f) const {
+        const Level& top = levels[0];
+        if (u.getNx() != top.nx || u.getNy() != top.ny || u.getNz() != top.nz || f.getNx() != top.nx
+            || f.getNy() != top.ny || f.getNz() != top.nz) {
+            throw std::invalid_argument("Grid dimensions must match those of the solver.");
+        }
+        if (u.getHalo() < 1) {
+            throw std::invalid_argument("The multigrid solution needs a halo.");
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            for (int side = 0; side < 2; ++side) {
+                if (u.getBoundary(axis, side).type != BoundaryType::Dirichlet) {
+                    throw std::invalid_argument("The multigrid solver supports Dirichlet boundaries only.");
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Gives the coarse grid `level` the boundary values of the finest solution u.
+     */
+    static void setBoundaries(HaloGrid<double>& level, const HaloGrid<double>& u) {
+        for (int axis = 0; axis < 3; ++axis) {
+            for (int side = 0; side < 2; ++side) {
+                level.setBoundary(axis, side, u.getBoundary(axis, side));
+            }
+        }
+        level.fillHalo();
+    }
+
+    /**
+     * @brief A V-cycle at level l for Laplacian(u) = f, with the halo of u filled.
+     */
+    void cycle(int l, HaloGrid<double>& u, const Grid<double>& f) {
+        const int last = getLevels() - 1;
+        Level& level = levels[l];
+        if (l == last) {
+            for (int s = 0; s < options.coarseSweeps; ++s) {
+                detail::smooth(pool, u, f, level.h);
+            }
+            return;
+        }
+        for (int s = 0; s < options.preSmooth; ++s) {
+            detail::smooth(pool, u, f, level.h);
+        }
+        Level& coarse = levels[l + 1];
+        detail::residual(pool, u, f, level.r, level.h);
+        detail::restrictGrid(pool, level.r, coarse.f);
+        coarse.u.setBoundary(BoundaryCondition<double>(BoundaryType::Dirichlet, 0.0));
+        coarse.u.fillHalo();
+        detail::zeroInterior(pool, coarse.u);
+        cycle(l + 1, coarse.u, coarse.f);
+        detail::prolong(pool, coarse.u, u, true);
+        for (int s = 0; s < options.postSmooth; ++s) {
+            detail::smooth(pool, u, f, level.h);
+        }
+    }
+
+    GridThreadPool& pool;       ///< Threads of every operator.
+    Options options;            ///< Smoothing sweeps and cycles.
+    std::vector<Level> levels;  ///< The hierarchy, finest first.
+};
+
+} // namespace multigrid
+
+#endif
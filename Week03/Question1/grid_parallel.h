@@ -0,0 +1,418 @@
+#ifndef __GRID_PARALLEL_H__
+#define __GRID_PARALLEL_H__
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "grid3d.h"
+
+/**
+ * @class GridThreadPool
+ * @brief A fixed set of threads that run one task per thread: thread t always runs task t.
+ *
+ * The calling thread is thread 0, so a pool of size n starts n - 1 workers, which sleep between
+ * batches. Because the task of a thread never changes, every parallel operation below gives each
+ * thread the same part of the storage of a grid: the thread that first writes a page (see
+ * parallel::fill) is the one that later reads and writes it, so on a NUMA machine the page is
+ * placed on that thread's node by the first-touch policy and stays in that thread's caches.
+ */
+class GridThreadPool
+{
+public:
+    /**
+     * @brief Starts the worker threads.
+     * @param threads Number of threads including the caller (0 selects the hardware concurrency).
+     */
+    explicit GridThreadPool(unsigned threads = 0) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (unsigned t = 1; t < threads; ++t) {
+            workers.emplace_back(&GridThreadPool::workerLoop, this, t);
+        }
+    }
+
+    /**
+     * @brief Stops and joins the worker threads.
+     */
+    ~GridThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        startCondition.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    GridThreadPool(const GridThreadPool&) = delete;
+    GridThreadPool& operator=(const GridThreadPool&) = delete;
+
+    /**
+     * @brief Number of threads, including the caller.
+     */
+    unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    /**
+     * @brief Runs body(t) on thread t for every t < size() and waits for all of them.
+     * The first exception thrown by a task is rethrown in the caller.
+     * @param task The function called with each thread index.
+     */
+    void run(const std::function<void(unsigned)>& task) {
+        if (workers.empty()) {
+            task(0);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            body = &task;
+            active = static_cast<unsigned>(workers.size());
+            error = nullptr;
+            ++generation;
+        }
+        startCondition.notify_all();
+
+        execute(0);  // The caller is thread 0
+
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCondition.wait(lock, [this] { return active == 0; });
+        body = nullptr;
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    void workerLoop(unsigned t) {
+        std::size_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                startCondition.wait(lock, [&] { return stop || generation != seen; });
+                if (stop) {
+                    return;
+                }
+                seen = generation;
+            }
+
+            execute(t);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--active == 0) {
+                doneCondition.notify_one();
+            }
+        }
+    }
+
+    void execute(unsigned t) {
+        try {
+            (*body)(t);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;                       ///< Background workers, threads 1 to size() - 1.
+    std::mutex mutex;                                       ///< Protects the batch state below.
+    std::condition_variable startCondition;                 ///< Signals a new batch or shutdown.
+    std::condition_variable doneCondition;                  ///< Signals that all workers finished the batch.
+    const std::function<void(unsigned)>* body = nullptr;    ///< Task of the current batch.
+    std::size_t generation = 0;                             ///< Incremented for every batch.
+    unsigned active = 0;                                    ///< Workers still running the current batch.
+    std::exception_ptr error;                               ///< First exception raised by a task.
+    bool stop = false;                                      ///< Set when the pool shuts down.
+};
+
+/**
+ * @brief Parallel operations on whole grids. Each thread of the pool works on one contiguous
+ * chunk of the storage, always the same for a grid of a given size, with chunk boundaries on
+ * page boundaries (so no page, and therefore no cache line, is written by two threads). Only
+ * grid points are visited: the padding of Tiled3D and Morton grids is skipped (and kept at zero).
+ *
+ * Reductions keep one partial result per thread in its own cache line and combine the partial
+ * results in thread order, so for a given number of threads they are deterministic; sum, dot and
+ * norm can differ in the last bits between thread counts.
+ */
+namespace parallel
+{
+
+namespace detail
+{
+
+/// Page size assumed for the chunk boundaries, in bytes.
+constexpr std::size_t PAGE = 4096;
+
+/**
+ * @brief First storage position of chunk c of `chunks` over n values starting at `data`: an even
+ * split moved forward to the next page boundary.
+ */
+inline std::size_t chunkBegin(const void* data, std::size_t elementSize, std::size_t n, unsigned c, unsigned chunks)
+{
+    if (c == 0) {
+        return 0;
+    }
+    if (c >= chunks) {
+        return n;
+    }
+    std::size_t begin = n / chunks * c + n % chunks * c / chunks;
+    if (PAGE % elementSize == 0) {
+        const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(data) + begin * elementSize;
+        begin += (PAGE - address % PAGE) % PAGE / elementSize;
+    }
+    return std::min(begin, n);
+}
+
+/**
+ * @brief Runs body(t, begin, end) on every thread t of the pool with its chunk of the storage of grid.
+ */
+template <typename T, typename Layout, typename Body>
+void forChunks(GridThreadPool& pool, const Grid<T, Layout>& grid, Body body)
+{
+    const std::size_t n = grid.getMemory() / sizeof(T);
+    const unsigned chunks = pool.size();
+    pool.run([&](unsigned t) {
+        const std::size_t begin = chunkBegin(grid.storage(), sizeof(T), n, t, chunks);
+        const std::size_t end = chunkBegin(grid.storage(), sizeof(T), n, t + 1, chunks);
+        body(t, begin, end);
+    });
+}
+
+/// A partial result in a cache line of its own, so threads never write the same line.
+template <typename T>
+struct alignas(64) Slot
+{
+    T value;
+    bool found;
+};
+
+template <typename T, typename Layout>
+void checkSameDimensions(const Grid<T, Layout>& a, const Grid<T, Layout>& b)
+{
+    if (a.getNx() != b.getNx() || a.getNy() != b.getNy() || a.getNz() != b.getNz()) {
+        throw std::invalid_argument("Grid dimensions must match.");
+    }
+}
+
+/**
+ * @brief Reduces the grid points of each thread's chunk to one value per thread with
+ * reduceRun(value, first, last, found) and combines the values in thread order with combine.
+ * @return The combined value and whether any thread had a grid point.
+ */
+template <typename T, typename Layout, typename Result, typename ReduceRun, typename Combine>
+Slot<Result> reduce(GridThreadPool& pool, const Grid<T, Layout>& grid, ReduceRun reduceRun, Combine combine)
+{
+    std::vector<Slot<Result>> partial(pool.size(), Slot<Result>{Result(), false});
+    forChunks(pool, grid, [&](unsigned t, std::size_t begin, std::size_t end) {
+        Result value = Result();
+        bool found = false;
+        grid.getLayout().forEachRun(begin, end, [&](std::size_t first, std::size_t last) {
+            reduceRun(value, first, last, found);
+            found = true;
+        });
+        partial[t].value = value;
+        partial[t].found = found;
+    });
+    Slot<Result> total{Result(), false};
+    for (const Slot<Result>& slot : partial) {
+        if (slot.found) {
+            total.value = total.found ? combine(total.value, slot.value) : slot.value;
+            total.found = true;
+        }
+    }
+    return total;
+}
+
+} // namespace detail
+
+/**
+ * @brief Creates a grid whose pages are first written by the threads of the pool that will work on
+ * them in the other parallel operations (NUMA first-touch placement); all values start at zero.
+ * @param pool The threads.
+ * @param nx Number of grid points in the x direction.
+ * @param ny Number of grid points in the y direction.
+ * @param nz Number of grid points in the z direction.
+ * @return The new grid.
+ */
+template <typename T, typename Layout = RowMajor>
+Grid<T, Layout> zeros(GridThreadPool& pool, int nx, int ny, int nz)
+{
+    Grid<T, Layout> grid(nx, ny, nz, typename Grid<T, Layout>::Uninitialized());
+    detail::forChunks(pool, grid, [&](unsigned, std::size_t begin, std::size_t end) {
+        std::fill(grid.storage() + begin, grid.storage() + end, T());
+    });
+    return grid;
+}
+
+/**
+ * @brief Sets every grid point to a value (the padding is set to zero).
+ */
+template <typename T, typename Layout>
+void fill(GridThreadPool& pool, Grid<T, Layout>& grid, const T& value)
+{
+    T* data = grid.storage();
+    detail::forChunks(pool, grid, [&](unsigned, std::size_t begin, std::size_t end) {
+        std::size_t previous = begin;
+        grid.getLayout().forEachRun(begin, end, [&](std::size_t first, std::size_t last) {
+            std::fill(data + previous, data + first, T());
+            std::fill(data + first, data + last, value);
+            previous = last;
+        });
+        std::fill(data + previous, data + end, T());
+    });
+}
+
+/**
+ * @brief Calls f(value) on every grid point, with `value` a reference that f may modify.
+ */
+template <typename T, typename Layout, typename F>
+void apply(GridThreadPool& pool, Grid<T, Layout>& grid, F f)
+{
+    T* data = grid.storage();
+    detail::forChunks(pool, grid, [&](unsigned, std::size_t begin, std::size_t end) {
+        grid.getLayout().forEachRun(begin, end, [&](std::size_t first, std::size_t last) {
+            for (std::size_t p = first; p < last; ++p) {
+                f(data[p]);
+            }
+        });
+    });
+}
+
+/**
+ * @brief Sets every grid point of out to f of the same grid point of in (out may be in).
+ */
+template <typename T, typename U, typename Layout, typename F>
+void transform(GridThreadPool& pool, const Grid<T, Layout>& in, Grid<U, Layout>& out, F f)
+{
+    if (in.getNx() != out.getNx() || in.getNy() != out.getNy() || in.getNz() != out.getNz()) {
+        throw std::invalid_argument("Grid dimensions must match.");
+    }
+    const T* source = in.storage();
+    U* target = out.storage();
+    detail::forChunks(pool, out, [&](unsigned, std::size_t begin, std::size_t end) {
+        out.getLayout().forEachRun(begin, end, [&](std::size_t first, std::size_t last) {
+            for (std::size_t p = first; p < last; ++p) {
+                target[p] = f(source[p]);
+            }
+        });
+    });
+}
+
+/**
+ * @brief Evaluates a grid expression (see grid_expression.h) into a grid of the same dimensions,
+ * each thread its own chunk: `parallel::assign(pool, d, a + b * c)`.
+ */
+template <typename T, typename Layout, typename E>
+void assign(GridThreadPool& pool, Grid<T, Layout>& grid, const GridExpression<E>& expression)
+{
+    detail::forChunks(pool, grid, [&](unsigned, std::size_t begin, std::size_t end) {
+        grid.evaluateRange(expression.derived(), begin, end);
+    });
+}
+
+/**
+ * @brief Sum of all grid points.
+ */
+template <typename T, typename Layout>
+T sum(GridThreadPool& pool, const Grid<T, Layout>& grid)
+{
+    const T* data = grid.storage();
+    return detail::reduce<T, Layout, T>(pool, grid, [data](T& value, std::size_t first, std::size_t last, bool) {
+        if constexpr (std::is_same<T, double>::value) {
+            value += simd::sum(data + first, last - first);
+        } else {
+            for (std::size_t p = first; p < last; ++p) {
+                value += data[p];
+            }
+        }
+    }, [](const T& a, const T& b) { return a + b; }).value;
+}
+
+/**
+ * @brief Dot product of two grids of the same dimensions, the sum of the element-wise products.
+ */
+template <typename T, typename Layout>
+T dot(GridThreadPool& pool, const Grid<T, Layout>& a, const Grid<T, Layout>& b)
+{
+    detail::checkSameDimensions(a, b);
+    const T* x = a.storage();
+    const T* y = b.storage();
+    return detail::reduce<T, Layout, T>(pool, a, [x, y](T& value, std::size_t first, std::size_t last, bool) {
+        if constexpr (std::is_same<T, double>::value) {
+            value += simd::dot(x + first, y + first, last - first);
+        } else {
+            for (std::size_t p = first; p < last; ++p) {
+                value += x[p] * y[p];
+            }
+        }
+    }, [](const T& u, const T& v) { return u + v; }).value;
+}
+
+/**
+ * @brief Euclidean norm of a grid, the square root of the sum of the squares of the grid points.
+ */
+template <typename T, typename Layout>
+T norm(GridThreadPool& pool, const Grid<T, Layout>& grid)
+{
+    using std::sqrt;
+    return sqrt(dot(pool, grid, grid));
+}
+
+/**
+ * @brief Smallest grid point.
+ */
+template <typename T, typename Layout>
+T min(GridThreadPool& pool, const Grid<T, Layout>& grid)
+{
+    const T* data = grid.storage();
+    detail::Slot<T> result = detail::reduce<T, Layout, T>(pool, grid,
+        [data](T& value, std::size_t first, std::size_t last, bool found) {
+            T m = found ? value : data[first];
+            for (std::size_t p = first; p < last; ++p) {
+                m = data[p] < m ? data[p] : m;
+            }
+            value = m;
+        }, [](const T& a, const T& b) { return b < a ? b : a; });
+    if (!result.found) {
+        throw std::invalid_argument("The grid has no values.");
+    }
+    return result.value;
+}
+
+/**
+ * @brief Largest grid point.
+ */
+template <typename T, typename Layout>
+T max(GridThreadPool& pool, const Grid<T, Layout>& grid)
+{
+    const T* data = grid.storage();
+    detail::Slot<T> result = detail::reduce<T, Layout, T>(pool, grid,
+        [data](T& value, std::size_t first, std::size_t last, bool found) {
+            T m = found ? value : data[first];
+            for (std::size_t p = first; p < last; ++p) {
+                m = m < data[p] ? data[p] : m;
+            }
+            value = m;
+        }, [](const T& a, const T& b) { return a < b ? b : a; });
+    if (!result.found) {
+        throw std::invalid_argument("The grid has no values.");
+    }
+    return result.value;
+}
+
+} // namespace parallel
+
+#endif
@@ -0,0 +1,614 @@
+#ifndef __GRID_SIMD_H__
+#define __GRID_SIMD_H__
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define GRID_SIMD_X86 1
+#else
+#define GRID_SIMD_X86 0
+#endif
+
+/**
+ * @brief Element-wise kernels on arrays of doubles (the flat storage of a Grid), vectorized for
+ * SSE2, AVX2 and AVX-512 and dispatched at run time to the widest instruction set the CPU supports.
+ *
+ * Every instruction set computes bit-for-bit the same results as the scalar code:
+ * - add, sub, scale and axpy round each product and sum separately (no contraction to FMA),
+ * - fma rounds a * b + c once, in the scalar code through std::fma,
+ * - sum and dot accumulate element p into lane p % 8 of 8 partial sums, which are combined as
+ *   ((l0 + l1) + (l2 + l3)) + ((l4 + l5) + (l6 + l7)), whatever the vector width.
+ * The code must be compiled with -ffp-contract=off so that the compiler does not fuse a
+ * multiplication and an addition on its own in some of the paths.
+ */
+namespace simd
+{
+
+/// Instruction sets, from the narrowest to the widest.
+enum class Isa { Scalar, SSE2, AVX2, AVX512 };
+
+/**
+ * @brief Name of an instruction set.
+ */
+inline const char* isaName(Isa isa)
+{
+    switch (isa) {
+    case Isa::SSE2: return "SSE2";
+    case Isa::AVX2: return "AVX2";
+    case Isa::AVX512: return "AVX-512";
+    default: return "scalar";
+    }
+}
+
+/**
+ * @brief The widest instruction set supported by the CPU (from CPUID).
+ */
+inline Isa detectIsa()
+{
+#if GRID_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return Isa::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return Isa::AVX2;
+    }
+    return Isa::SSE2;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+namespace detail
+{
+
+/// Number of partial sums of the reductions.
+constexpr std::size_t LANES = 8;
+
+inline double combine(const double* lane)
+{
+    return ((lane[0] + lane[1]) + (lane[2] + lane[3])) + ((lane[4] + lane[5]) + (lane[6] + lane[7]));
+}
+
+// Scalar kernels, the reference for every instruction set
+
+inline void addScalar(const double* a, const double* b, double* out, std::size_t n)
+{
+    for (std::size_t p = 0; p < n; ++p) out[p] = a[p] + b[p];
+}
+
+inline void subScalar(const double* a, const double* b, double* out, std::size_t n)
+{
+    for (std::size_t p = 0; p < n; ++p) out[p] = a[p] - b[p];
+}
+
+inline void scaleScalar(const double* a, double alpha, double* out, std::size_t n)
+{
+    for (std::size_t p = 0; p < n; ++p) out[p] = alpha * a[p];
+}
+
+inline void axpyScalar(double alpha, const double* x, double* y, std::size_t n)
+{
+    for (std::size_t p = 0; p < n; ++p) y[p] = y[p] + alpha * x[p];
+}
+
+inline void fmaScalar(const double* a, const double* b, const double* c, double* out, std::size_t n)
+{
+    for (std::size_t p = 0; p < n; ++p) out[p] = std::fma(a[p], b[p], c[p]);
+}
+
+inline double sumScalar(const double* a, std::size_t n)
+{
+    double lane[LANES] = {};
+    for (std::size_t p = 0; p < n; ++p) lane[p % LANES] += a[p];
+    return combine(lane);
+}
+
+inline double dotScalar(const double* a, const double* b, std::size_t n)
+{
+    double lane[LANES] = {};
+    for (std::size_t p = 0; p < n; ++p) lane[p % LANES] += a[p] * b[p];
+    return combine(lane);
+}
+
+/// Rows of a 7-point stencil along k: the row itself (its values at k - 1 and k + 1 are the k
+/// neighbours) and the rows at i - 1, i + 1, j - 1 and j + 1.
+struct StencilRows
+{
+    const double* center;
+    const double* xm;
+    const double* xp;
+    const double* ym;
+    const double* yp;
+};
+
+/// Factor of the Jacobi update.
+constexpr double SIXTH = 1.0 / 6.0;
+
+inline void laplacianRowScalar(const StencilRows& r, double scale, double* out, std::size_t n)
+{
+    for (std::size_t p = 0; p < n; ++p) {
+        const double sum = ((r.center[p - 1] + r.center[p + 1]) + (r.ym[p] + r.yp[p])) + (r.xm[p] + r.xp[p]);
+        out[p] = (sum - 6.0 * r.center[p]) * scale;
+    }
+}
+
+inline void jacobiRowScalar(const StencilRows& r, const double* f, double h2, double* out, std::size_t n)
+{
+    for (std::size_t p = 0; p < n; ++p) {
+        const double sum = ((r.center[p - 1] + r.center[p + 1]) + (r.ym[p] + r.yp[p])) + (r.xm[p] + r.xp[p]);
+        out[p] = (sum - h2 * f[p]) * SIXTH;
+    }
+}
+
+#if GRID_SIMD_X86
+// SSE2: 2 doubles per register, 4 registers of partial sums. Part of the x86-64 baseline.
+
+inline void addSSE2(const double* a, const double* b, double* out, std::size_t n)
+{
+    std::size_t p = 0;
+    for (; p + 2 <= n; p += 2) _mm_storeu_pd(out + p, _mm_add_pd(_mm_loadu_pd(a + p), _mm_loadu_pd(b + p)));
+    addScalar(a + p, b + p, out + p, n - p);
+}
+
+inline void subSSE2(const double* a, const double* b, double* out, std::size_t n)
+{
+    std::size_t p = 0;
+    for (; p + 2 <= n; p += 2) _mm_storeu_pd(out + p, _mm_sub_pd(_mm_loadu_pd(a + p), _mm_loadu_pd(b + p)));
+    subScalar(a + p, b + p, out + p, n - p);
+}
+
+inline void scaleSSE2(const double* a, double alpha, double* out, std::size_t n)
+{
+    const __m128d s = _mm_set1_pd(alpha);
+    std::size_t p = 0;
+    for (; p + 2 <= n; p += 2) _mm_storeu_pd(out + p, _mm_mul_pd(s, _mm_loadu_pd(a + p)));
+    scaleScalar(a + p, alpha, out + p, n - p);
+}
+
+inline void axpySSE2(double alpha, const double* x, double* y, std::size_t n)
+{
+    const __m128d s = _mm_set1_pd(alpha);
+    std::size_t p = 0;
+    for (; p + 2 <= n; p += 2) {
+        _mm_storeu_pd(y + p, _mm_add_pd(_mm_loadu_pd(y + p), _mm_mul_pd(s, _mm_loadu_pd(x + p))));
+    }
+    axpyScalar(alpha, x + p, y + p, n - p);
+}
+
+inline double sumSSE2(const double* a, std::size_t n)
+{
+    __m128d s0 = _mm_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+    std::size_t p = 0;
+    for (; p + LANES <= n; p += LANES) {
+        s0 = _mm_add_pd(s0, _mm_loadu_pd(a + p));
+        s1 = _mm_add_pd(s1, _mm_loadu_pd(a + p + 2));
+        s2 = _mm_add_pd(s2, _mm_loadu_pd(a + p + 4));
+        s3 = _mm_add_pd(s3, _mm_loadu_pd(a + p + 6));
+    }
+    double lane[LANES];
+    _mm_storeu_pd(lane, s0);
+    _mm_storeu_pd(lane + 2, s1);
+    _mm_storeu_pd(lane + 4, s2);
+    _mm_storeu_pd(lane + 6, s3);
+    for (; p < n; ++p) lane[p % LANES] += a[p];
+    return combine(lane);
+}
+
+inline double dotSSE2(const double* a, const double* b, std::size_t n)
+{
+    __m128d s0 = _mm_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+    std::size_t p = 0;
+    for (; p + LANES <= n; p += LANES) {
+        s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(a + p), _mm_loadu_pd(b + p)));
+        s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(a + p + 2), _mm_loadu_pd(b + p + 2)));
+        s2 = _mm_add_pd(s2, _mm_mul_pd(_mm_loadu_pd(a + p + 4), _mm_loadu_pd(b + p + 4)));
+        s3 = _mm_add_pd(s3, _mm_mul_pd(_mm_loadu_pd(a + p + 6), _mm_loadu_pd(b + p + 6)));
+    }
+    double lane[LANES];
+    _mm_storeu_pd(lane, s0);
+    _mm_storeu_pd(lane + 2, s1);
+    _mm_storeu_pd(lane + 4, s2);
+    _mm_storeu_pd(lane + 6, s3);
+    for (; p < n; ++p) lane[p % LANES] += a[p] * b[p];
+    return combine(lane);
+}
+
+inline void laplacianRowSSE2(const StencilRows& r, double scale, double* out, std::size_t n)
+{
+    const __m128d six = _mm_set1_pd(6.0), s = _mm_set1_pd(scale);
+    std::size_t p = 0;
+    for (; p + 2 <= n; p += 2) {
+        const __m128d sum = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_loadu_pd(r.center + p - 1), _mm_loadu_pd(r.center + p + 1)), _mm_add_pd(_mm_loadu_pd(r.ym + p), _mm_loadu_pd(r.yp + p))),
+                                          _mm_add_pd(_mm_loadu_pd(r.xm + p), _mm_loadu_pd(r.xp + p)));
+        _mm_storeu_pd(out + p, _mm_mul_pd(_mm_sub_pd(sum, _mm_mul_pd(six, _mm_loadu_pd(r.center + p))), s));
+    }
+    const StencilRows rest = {r.center + p, r.xm + p, r.xp + p, r.ym + p, r.yp + p};
+    laplacianRowScalar(rest, scale, out + p, n - p);
+}
+
+inline void jacobiRowSSE2(const StencilRows& r, const double* f, double h2, double* out, std::size_t n)
+{
+    const __m128d sixth = _mm_set1_pd(SIXTH), h = _mm_set1_pd(h2);
+    std::size_t p = 0;
+    for (; p + 2 <= n; p += 2) {
+        const __m128d sum = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_loadu_pd(r.center + p - 1), _mm_loadu_pd(r.center + p + 1)), _mm_add_pd(_mm_loadu_pd(r.ym + p), _mm_loadu_pd(r.yp + p))),
+                                          _mm_add_pd(_mm_loadu_pd(r.xm + p), _mm_loadu_pd(r.xp + p)));
+        _mm_storeu_pd(out + p, _mm_mul_pd(_mm_sub_pd(sum, _mm_mul_pd(h, _mm_loadu_pd(f + p))), sixth));
+    }
+    const StencilRows rest = {r.center + p, r.xm + p, r.xp + p, r.ym + p, r.yp + p};
+    jacobiRowScalar(rest, f + p, h2, out + p, n - p);
+}
+
+// AVX2: 4 doubles per register, 2 registers of partial sums; fma also needs the FMA extension.
+
+__attribute__((target("avx2"))) inline void addAVX2(const double* a, const double* b, double* out, std::size_t n)
+{
+    std::size_t p = 0;
+    for (; p + 4 <= n; p += 4) {
+        _mm256_storeu_pd(out + p, _mm256_add_pd(_mm256_loadu_pd(a + p), _mm256_loadu_pd(b + p)));
+    }
+    addScalar(a + p, b + p, out + p, n - p);
+}
+
+__attribute__((target("avx2"))) inline void subAVX2(const double* a, const double* b, double* out, std::size_t n)
+{
+    std::size_t p = 0;
+    for (; p + 4 <= n; p += 4) {
+        _mm256_storeu_pd(out + p, _mm256_sub_pd(_mm256_loadu_pd(a + p), _mm256_loadu_pd(b + p)));
+    }
+    subScalar(a + p, b + p, out + p, n - p);
+}
+
+__attribute__((target("avx2"))) inline void scaleAVX2(const double* a, double alpha, double* out, std::size_t n)
+{
+    const __m256d s = _mm256_set1_pd(alpha);
+    std::size_t p = 0;
+    for (; p + 4 <= n; p += 4) _mm256_storeu_pd(out + p, _mm256_mul_pd(s, _mm256_loadu_pd(a + p)));
+    scaleScalar(a + p, alpha, out + p, n - p);
+}
+
+__attribute__((target("avx2"))) inline void axpyAVX2(double alpha, const double* x, double* y, std::size_t n)
+{
+    const __m256d s = _mm256_set1_pd(alpha);
+    std::size_t p = 0;
+    for (; p + 4 <= n; p += 4) {
+        _mm256_storeu_pd(y + p, _mm256_add_pd(_mm256_loadu_pd(y + p), _mm256_mul_pd(s, _mm256_loadu_pd(x + p))));
+    }
+    axpyScalar(alpha, x + p, y + p, n - p);
+}
+
+__attribute__((target("avx2,fma"))) inline void fmaAVX2(const double* a, const double* b, const double* c, double* out,
+                                                        std::size_t n)
+{
+    std::size_t p = 0;
+    for (; p + 4 <= n; p += 4) {
+        _mm256_storeu_pd(out + p, _mm256_fmadd_pd(_mm256_loadu_pd(a + p), _mm256_loadu_pd(b + p),
+                                                  _mm256_loadu_pd(c + p)));
+    }
+    for (; p < n; ++p) {
+        const __m128d r = _mm_fmadd_sd(_mm_set_sd(a[p]), _mm_set_sd(b[p]), _mm_set_sd(c[p]));
+        out[p] = _mm_cvtsd_f64(r);
+    }
+}
+
+__attribute__((target("avx2"))) inline double sumAVX2(const double* a, std::size_t n)
+{
+    __m256d s0 = _mm256_setzero_pd(), s1 = s0;
+    std::size_t p = 0;
+    for (; p + LANES <= n; p += LANES) {
+        s0 = _mm256_add_pd(s0, _mm256_loadu_pd(a + p));
+        s1 = _mm256_add_pd(s1, _mm256_loadu_pd(a + p + 4));
+    }
+    double lane[LANES];
+    _mm256_storeu_pd(lane, s0);
+    _mm256_storeu_pd(lane + 4, s1);
+    for (; p < n; ++p) lane[p % LANES] += a[p];
+    return combine(lane);
+}
+
+__attribute__((target("avx2"))) inline double dotAVX2(const double* a, const double* b, std::size_t n)
+{
+    __m256d s0 = _mm256_setzero_pd(), s1 = s0;
+    std::size_t p = 0;
+    for (; p + LANES <= n; p += LANES) {
+        s0 = _mm256_add_pd(s0, _mm256_mul_pd(_mm256_loadu_pd(a + p), _mm256_loadu_pd(b + p)));
+        s1 = _mm256_add_pd(s1, _mm256_mul_pd(_mm256_loadu_pd(a + p + 4), _mm256_loadu_pd(b + p + 4)));
+    }
+    double lane[LANES];
+    _mm256_storeu_pd(lane, s0);
+    _mm256_storeu_pd(lane + 4, s1);
+    for (; p < n; ++p) lane[p % LANES] += a[p] * b[p];
+    return combine(lane);
+}
+
+__attribute__((target("avx2"))) inline void laplacianRowAVX2(const StencilRows& r, double scale, double* out, std::size_t n)
+{
+    const __m256d six = _mm256_set1_pd(6.0), s = _mm256_set1_pd(scale);
+    std::size_t p = 0;
+    for (; p + 4 <= n; p += 4) {
+        const __m256d sum = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_loadu_pd(r.center + p - 1), _mm256_loadu_pd(r.center + p + 1)), _mm256_add_pd(_mm256_loadu_pd(r.ym + p), _mm256_loadu_pd(r.yp + p))),
+                                          _mm256_add_pd(_mm256_loadu_pd(r.xm + p), _mm256_loadu_pd(r.xp + p)));
+        _mm256_storeu_pd(out + p, _mm256_mul_pd(_mm256_sub_pd(sum, _mm256_mul_pd(six, _mm256_loadu_pd(r.center + p))), s));
+    }
+    const StencilRows rest = {r.center + p, r.xm + p, r.xp + p, r.ym + p, r.yp + p};
+    laplacianRowScalar(rest, scale, out + p, n - p);
+}
+
+__attribute__((target("avx2"))) inline void jacobiRowAVX2(const StencilRows& r, const double* f, double h2, double* out, std::size_t n)
+{
+    const __m256d sixth = _mm256_set1_pd(SIXTH), h = _mm256_set1_pd(h2);
+    std::size_t p = 0;
+    for (; p + 4 <= n; p += 4) {
+        const __m256d sum = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_loadu_pd(r.center + p - 1), _mm256_loadu_pd(r.center + p + 1)), _mm256_add_pd(_mm256_loadu_pd(r.ym + p), _mm256_loadu_pd(r.yp + p))),
+                                          _mm256_add_pd(_mm256_loadu_pd(r.xm + p), _mm256_loadu_pd(r.xp + p)));
+        _mm256_storeu_pd(out + p, _mm256_mul_pd(_mm256_sub_pd(sum, _mm256_mul_pd(h, _mm256_loadu_pd(f + p))), sixth));
+    }
+    const StencilRows rest = {r.center + p, r.xm + p, r.xp + p, r.ym + p, r.yp + p};
+    jacobiRowScalar(rest, f + p, h2, out + p, n - p);
+}
+
+// AVX-512: 8 doubles per register, one register of partial sums; the tails use masked loads.
+
+__attribute__((target("avx512f"))) inline void addAVX512(const double* a, const double* b, double* out, std::size_t n)
+{
+    std::size_t p = 0;
+    for (; p + 8 <= n; p += 8) {
+        _mm512_storeu_pd(out + p, _mm512_add_pd(_mm512_loadu_pd(a + p), _mm512_loadu_pd(b + p)));
+    }
+    const __mmask8 m = static_cast<__mmask8>((1u << (n - p)) - 1);
+    _mm512_mask_storeu_pd(out + p, m, _mm512_add_pd(_mm512_maskz_loadu_pd(m, a + p), _mm512_maskz_loadu_pd(m, b + p)));
+}
+
+__attribute__((target("avx512f"))) inline void subAVX512(const double* a, const double* b, double* out, std::size_t n)
+{
+    std::size_t p = 0;
+    for (; p + 8 <= n; p += 8) {
+        _mm512_storeu_pd(out + p, _mm512_sub_pd(_mm512_loadu_pd(a + p), _mm512_loadu_pd(b + p)));
+    }
+    const __mmask8 m = static_cast<__mmask8>((1u << (n - p)) - 1);
+    _mm512_mask_storeu_pd(out + p, m, _mm512_sub_pd(_mm512_maskz_loadu_pd(m, a + p), _mm512_maskz_loadu_pd(m, b + p)));
+}
+
+__attribute__((target("avx512f"))) inline void scaleAVX512(const double* a, double alpha, double* out, std::size_t n)
+{
+    const __m512d s = _mm512_set1_pd(alpha);
+    std::size_t p = 0;
+    for (; p + 8 <= n; p += 8) _mm512_storeu_pd(out + p, _mm512_mul_pd(s, _mm512_loadu_pd(a + p)));
+    const __mmask8 m = static_cast<__mmask8>((1u << (n - p)) - 1);
+    _mm512_mask_storeu_pd(out + p, m, _mm512_mul_pd(s, _mm512_maskz_loadu_pd(m, a + p)));
+}
+
+__attribute__((target("avx512f"))) inline void axpyAVX512(double alpha, const double* x, double* y, std::size_t n)
+{
+    const __m512d s = _mm512_set1_pd(alpha);
+    std::size_t p = 0;
+    for (; p + 8 <= n; p += 8) {
+        _mm512_storeu_pd(y + p, _mm512_add_pd(_mm512_loadu_pd(y + p), _mm512_mul_pd(s, _mm512_loadu_pd(x + p))));
+    }
+    const __mmask8 m = static_cast<__mmask8>((1u << (n - p)) - 1);
+    _mm512_mask_storeu_pd(y + p, m, _mm512_add_pd(_mm512_maskz_loadu_pd(m, y + p),
+                                                  _mm512_mul_pd(s, _mm512_maskz_loadu_pd(m, x + p))));
+}
+
+__attribute__((target("avx512f"))) inline void fmaAVX512(const double* a, const double* b, const double* c, double* out,
+                                                         std::size_t n)
+{
+    std::size_t p = 0;
+    for (; p + 8 <= n; p += 8) {
+        _mm512_storeu_pd(out + p, _mm512_fmadd_pd(_mm512_loadu_pd(a + p), _mm512_loadu_pd(b + p),
+                                                  _mm512_loadu_pd(c + p)));
+    }
+    const __mmask8 m = static_cast<__mmask8>((1u << (n - p)) - 1);
+    _mm512_mask_storeu_pd(out + p, m, _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m, a + p), _mm512_maskz_loadu_pd(m, b + p),
+                                                      _mm512_maskz_loadu_pd(m, c + p)));
+}
+
+__attribute__((target("avx512f"))) inline double sumAVX512(const double* a, std::size_t n)
+{
+    __m512d s = _mm512_setzero_pd();
+    std::size_t p = 0;
+    for (; p + LANES <= n; p += LANES) s = _mm512_add_pd(s, _mm512_loadu_pd(a + p));
+    // The masked lanes keep their partial sum, as the scalar code adds nothing to them
+    const __mmask8 m = static_cast<__mmask8>((1u << (n - p)) - 1);
+    s = _mm512_mask_add_pd(s, m, s, _mm512_maskz_loadu_pd(m, a + p));
+    double lane[LANES];
+    _mm512_storeu_pd(lane, s);
+    return combine(lane);
+}
+
+__attribute__((target("avx512f"))) inline double dotAVX512(const double* a, const double* b, std::size_t n)
+{
+    __m512d s = _mm512_setzero_pd();
+    std::size_t p = 0;
+    for (; p + LANES <= n; p += LANES) {
+        s = _mm512_add_pd(s, _mm512_mul_pd(_mm512_loadu_pd(a + p), _mm512_loadu_pd(b + p)));
+    }
+    const __mmask8 m = static_cast<__mmask8>((1u << (n - p)) - 1);
+    s = _mm512_mask_add_pd(s, m, s, _mm512_mul_pd(_mm512_maskz_loadu_pd(m, a + p), _mm512_maskz_loadu_pd(m, b + p)));
+    double lane[LANES];
+    _mm512_storeu_pd(lane, s);
+    return combine(lane);
+}
+__attribute__((target("avx512f"))) inline void laplacianRowAVX512(const StencilRows& r, double scale, double* out, std::size_t n)
+{
+    const __m512d six = _mm512_set1_pd(6.0), s = _mm512_set1_pd(scale);
+    std::size_t p = 0;
+    for (; p + 8 <= n; p += 8) {
+        const __m512d sum = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(_mm512_loadu_pd(r.center + p - 1), _mm512_loadu_pd(r.center + p + 1)), _mm512_add_pd(_mm512_loadu_pd(r.ym + p), _mm512_loadu_pd(r.yp + p))),
+                                          _mm512_add_pd(_mm512_loadu_pd(r.xm + p), _mm512_loadu_pd(r.xp + p)));
+        _mm512_storeu_pd(out + p, _mm512_mul_pd(_mm512_sub_pd(sum, _mm512_mul_pd(six, _mm512_loadu_pd(r.center + p))), s));
+    }
+    const __mmask8 m = static_cast<__mmask8>((1u << (n - p)) - 1);
+    const __m512d sum = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(_mm512_maskz_loadu_pd(m, r.center + p - 1), _mm512_maskz_loadu_pd(m, r.center + p + 1)), _mm512_add_pd(_mm512_maskz_loadu_pd(m, r.ym + p), _mm512_maskz_loadu_pd(m, r.yp + p))),
+                                          _mm512_add_pd(_mm512_maskz_loadu_pd(m, r.xm + p), _mm512_maskz_loadu_pd(m, r.xp + p)));
+    _mm512_mask_storeu_pd(out + p, m, _mm512_mul_pd(_mm512_sub_pd(sum, _mm512_mul_pd(six, _mm512_maskz_loadu_pd(m, r.center + p))), s));
+}
+
+__attribute__((target("avx512f"))) inline void jacobiRowAVX512(const StencilRows& r, const double* f, double h2, double* out, std::size_t n)
+{
+    const __m512d sixth = _mm512_set1_pd(SIXTH), h = _mm512_set1_pd(h2);
+    std::size_t p = 0;
+    for (; p + 8 <= n; p += 8) {
+        const __m512d sum = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(_mm512_loadu_pd(r.center + p - 1), _mm512_loadu_pd(r.center + p + 1)), _mm512_add_pd(_mm512_loadu_pd(r.ym + p), _mm512_loadu_pd(r.yp + p))),
+                                          _mm512_add_pd(_mm512_loadu_pd(r.xm + p), _mm512_loadu_pd(r.xp + p)));
+        _mm512_storeu_pd(out + p, _mm512_mul_pd(_mm512_sub_pd(sum, _mm512_mul_pd(h, _mm512_loadu_pd(f + p))), sixth));
+    }
+    const __mmask8 m = static_cast<__mmask8>((1u << (n - p)) - 1);
+    const __m512d sum = _mm512_add_pd(_mm512_add_pd(_mm512_add_pd(_mm512_maskz_loadu_pd(m, r.center + p - 1), _mm512_maskz_loadu_pd(m, r.center + p + 1)), _mm512_add_pd(_mm512_maskz_loadu_pd(m, r.ym + p), _mm512_maskz_loadu_pd(m, r.yp + p))),
+                                          _mm512_add_pd(_mm512_maskz_loadu_pd(m, r.xm + p), _mm512_maskz_loadu_pd(m, r.xp + p)));
+    _mm512_mask_storeu_pd(out + p, m, _mm512_mul_pd(_mm512_sub_pd(sum, _mm512_mul_pd(h, _mm512_maskz_loadu_pd(m, f + p))), sixth));
+}
+#endif
+
+/// The kernels of one instruction set.
+struct Kernels
+{
+    Isa isa;
+    void (*add)(const double*, const double*, double*, std::size_t);
+    void (*sub)(const double*, const double*, double*, std::size_t);
+    void (*scale)(const double*, double, double*, std::size_t);
+    void (*axpy)(double, const double*, double*, std::size_t);
+    void (*fma)(const double*, const double*, const double*, double*, std::size_t);
+    double (*sum)(const double*, std::size_t);
+    double (*dot)(const double*, const double*, std::size_t);
+    void (*laplacianRow)(const StencilRows&, double, double*, std::size_t);
+    void (*jacobiRow)(const StencilRows&, const double*, double, double*, std::size_t);
+};
+
+inline Kernels kernelsFor(Isa isa)
+{
+    switch (isa) {
+#if GRID_SIMD_X86
+    case Isa::AVX512:
+        return {isa, addAVX512, subAVX512, scaleAVX512, axpyAVX512, fmaAVX512, sumAVX512, dotAVX512,
+                laplacianRowAVX512, jacobiRowAVX512};
+    case Isa::AVX2:
+        return {isa, addAVX2, subAVX2, scaleAVX2, axpyAVX2, fmaAVX2, sumAVX2, dotAVX2,
+                laplacianRowAVX2, jacobiRowAVX2};
+    case Isa::SSE2:
+        // SSE2 has no fused multiply-add instruction
+        return {isa, addSSE2, subSSE2, scaleSSE2, axpySSE2, fmaScalar, sumSSE2, dotSSE2,
+                laplacianRowSSE2, jacobiRowSSE2};
+#endif
+    default:
+        return {Isa::Scalar, addScalar, subScalar, scaleScalar, axpyScalar, fmaScalar, sumScalar, dotScalar,
+                laplacianRowScalar, jacobiRowScalar};
+    }
+}
+
+/// The kernels in use, chosen from CPUID on first use.
+inline Kernels& active()
+{
+    static Kernels kernels = kernelsFor(detectIsa());
+    return kernels;
+}
+
+} // namespace detail
+
+/**
+ * @brief The instruction set the kernels currently use.
+ */
+inline Isa activeIsa()
+{
+    return detail::active().isa;
+}
+
+/**
+ * @brief Selects the instruction set of the kernels, for example to compare against the scalar code.
+ * Not thread-safe: call it while no kernel is running.
+ * @param isa An instruction set no wider than detectIsa().
+ */
+inline void setIsa(Isa isa)
+{
+    if (static_cast<int>(isa) > static_cast<int>(detectIsa())) {
+        throw std::invalid_argument(std::string("The CPU does not support ") + isaName(isa) + ".");
+    }
+    detail::active() = detail::kernelsFor(isa);
+}
+
+/**
+ * @brief out[p] = a[p] + b[p] for p < n. The arrays may be the same, or out may alias a or b.
+ */
+inline void add(const double* a, const double* b, double* out, std::size_t n)
+{
+    detail::active().add(a, b, out, n);
+}
+
+/**
+ * @brief out[p] = a[p] - b[p] for p < n.
+ */
+inline void sub(const double* a, const double* b, double* out, std::size_t n)
+{
+    detail::active().sub(a, b, out, n);
+}
+
+/**
+ * @brief out[p] = alpha * a[p] for p < n.
+ */
+inline void scale(const double* a, double alpha, double* out, std::size_t n)
+{
+    detail::active().scale(a, alpha, out, n);
+}
+
+/**
+ * @brief y[p] = y[p] + alpha * x[p] for p < n, with the product rounded before the addition.
+ */
+inline void axpy(double alpha, const double* x, double* y, std::size_t n)
+{
+    detail::active().axpy(alpha, x, y, n);
+}
+
+/**
+ * @brief out[p] = a[p] * b[p] + c[p] for p < n, rounded once (fused multiply-add).
+ */
+inline void fma(const double* a, const double* b, const double* c, double* out, std::size_t n)
+{
+    detail::active().fma(a, b, c, out, n);
+}
+
+/**
+ * @brief Sum of a[p] for p < n, in the fixed order of 8 partial sums.
+ */
+inline double sum(const double* a, std::size_t n)
+{
+    return detail::active().sum(a, n);
+}
+
+/**
+ * @brief Sum of a[p] * b[p] for p < n, in the fixed order of 8 partial sums.
+ */
+inline double dot(const double* a, const double* b, std::size_t n)
+{
+    return detail::active().dot(a, b, n);
+}
+
+/// Rows of a 7-point stencil (see laplacianRow and jacobiRow).
+using detail::StencilRows;
+
+/**
+ * @brief One row of the 7-point Laplacian: out[p] = (sum of the 6 neighbours of center[p] - 6 center[p]) * scale,
+ * with the neighbours summed as ((k - 1 + k + 1) + (j - 1 + j + 1)) + (i - 1 + i + 1).
+ * center[-1] and center[n] must be readable (the halo).
+ */
+inline void laplacianRow(const StencilRows& rows, double scale, double* out, std::size_t n)
+{
+    detail::active().laplacianRow(rows, scale, out, n);
+}
+
+/**
+ * @brief One row of a Jacobi sweep for the Poisson equation (Laplacian of u = f, spacing h):
+ * out[p] = (sum of the 6 neighbours of center[p] - h2 * f[p]) / 6, with h2 = h * h.
+ */
+inline void jacobiRow(const StencilRows& rows, const double* f, double h2, double* out, std::size_t n)
+{
+    detail::active().jacobiRow(rows, f, h2, out, n);
+}
+
+} // namespace simd
+
+#endif
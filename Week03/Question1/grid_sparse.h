@@ -0,0 +1,362 @@
+#ifndef __GRID_SPARSE_H__
+#define __GRID_SPARSE_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "grid3d.h"
+
+/**
+ * @class SparseGrid
+ * @brief A block-sparse nx x ny x nz grid for mostly empty fields: the grid is cut into bricks of
+ * B x B x B points, and a brick is allocated only when a value other than the background is first
+ * written into it. Points of unallocated bricks read as the background value (zero by default).
+ *
+ * The bricks are found through a two-level table: a dense table with one 32-bit entry per brick
+ * (the number of its storage block, or -1), then the point inside the brick, stored row-major
+ * (k fastest). B is a power of two, so both levels are shifts and masks. The table costs
+ * 4 / B^3 bytes per point (under 0.01 byte for B = 8), and every allocated brick B^3 values.
+ *
+ * Writing through the non-const operator() or at(), or set(), may allocate a brick, which
+ * invalidates no reference to other values but is not thread-safe; reading through the const
+ * operator() or at(), or get(), never allocates.
+ */
+template <typename T = double, int B = 8>
+class SparseGrid
+{
+    static_assert(B > 0 && (B & (B - 1)) == 0, "The brick edge must be a power of two.");
+    static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value,
+                  "SparseGrid stores plain values (numbers or simple structs) in raw aligned storage.");
+
+public:
+    /// Edge of a brick in points.
+    static constexpr int BRICK = B;
+    /// Number of values in a brick.
+    static constexpr std::size_t BRICK_SIZE = std::size_t(B) * B * B;
+    /// Alignment of each brick in bytes (one cache line).
+    static constexpr std::size_t ALIGNMENT = 64;
+
+    /**
+     * @brief Constructor of an empty grid: no brick is allocated.
+     * @param nx_ Number of grid points in the x direction.
+     * @param ny_ Number of grid points in the y direction.
+     * @param nz_ Number of grid points in the z direction.
+     * @param background_ Value of every point of an unallocated brick.
+     */
+    SparseGrid(int nx_=1, int ny_=1, int nz_=1, const T& background_ = T())
+        : nx(checkDimension(nx_)), ny(checkDimension(ny_)), nz(checkDimension(nz_)),
+          bx((nx_ + B - 1) / B), by((ny_ + B - 1) / B), bz((nz_ + B - 1) / B), background(background_),
+          table(std::size_t(bx) * by * bz, -1) {}
+
+    /**
+     * @brief Copy constructor: a deep copy of the allocated bricks.
+     */
+    SparseGrid(const SparseGrid& grid)
+        : nx(grid.nx), ny(grid.ny), nz(grid.nz), bx(grid.bx), by(grid.by), bz(grid.bz),
+          background(grid.background), table(grid.table), owners(grid.owners) {
+        bricks.reserve(grid.bricks.size());
+        try {
+            for (const T* brick : grid.bricks) {
+                bricks.push_back(allocateBrick());
+                std::copy(brick, brick + BRICK_SIZE, bricks.back());
+            }
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    SparseGrid(SparseGrid&& grid) noexcept
+        : nx(grid.nx), ny(grid.ny), nz(grid.nz), bx(grid.bx), by(grid.by), bz(grid.bz),
+          background(grid.background), table(std::move(grid.table)), bricks(std::move(grid.bricks)),
+          owners(std::move(grid.owners)) {
+        grid.bricks.clear();
+    }
+
+    /**
+     * @brief Copy and move assignment (copy-and-swap).
+     */
+    SparseGrid& operator=(SparseGrid grid) noexcept {
+        swap(grid);
+        return *this;
+    }
+
+    ~SparseGrid() {
+        release();
+    }
+
+    void swap(SparseGrid& grid) noexcept {
+        std::swap(nx, grid.nx);
+        std::swap(ny, grid.ny);
+        std::swap(nz, grid.nz);
+        std::swap(bx, grid.bx);
+        std::swap(by, grid.by);
+        std::swap(bz, grid.bz);
+        std::swap(background, grid.background);
+        table.swap(grid.table);
+        bricks.swap(grid.bricks);
+        owners.swap(grid.owners);
+    }
+
+    int getNx() const { return nx; }
+    int getNy() const { return ny; }
+    int getNz() const { return nz; }
+
+    /// Number of grid points, allocated or not.
+    std::size_t getSize() const { return std::size_t(nx) * ny * nz; }
+
+    /// Value of the points of unallocated bricks.
+    const T& getBackground() const { return background; }
+
+    /// Number of allocated bricks, and of bricks in the grid.
+    std::size_t getActiveBricks() const { return bricks.size(); }
+    std::size_t getBrickCount() const { return table.size(); }
+
+    /**
+     * @brief Memory used in bytes: the allocated bricks, the brick table and the list of brick owners.
+     */
+    std::size_t getMemory() const {
+        return bricks.size() * (BRICK_SIZE * sizeof(T) + sizeof(T*))
+               + table.size() * sizeof(std::int32_t) + owners.size() * sizeof(std::int32_t);
+    }
+
+    /**
+     * @brief Read access to point (i, j, k): the background value if its brick is not allocated.
+     * Checked only if GRID_CHECK_BOUNDS is set.
+     */
+    const T& operator()(int i, int j, int k) const {
+#if GRID_CHECK_BOUNDS
+        checkGridIndex(i, j, k, nx, ny, nz);
+#endif
+        return get(i, j, k);
+    }
+
+    /**
+     * @brief Write access to point (i, j, k): allocates its brick if needed (filled with the
+     * background value), so use the const operator() or get() to read. Checked only if
+     * GRID_CHECK_BOUNDS is set.
+     */
+    T& operator()(int i, int j, int k) {
+#if GRID_CHECK_BOUNDS
+        checkGridIndex(i, j, k, nx, ny, nz);
+#endif
+        return touch(i, j, k);
+    }
+
+    /**
+     * @brief Access to point (i, j, k) like operator(); throws std::out_of_range for an invalid index.
+     */
+    const T& at(int i, int j, int k) const {
+        checkGridIndex(i, j, k, nx, ny, nz);
+        return get(i, j, k);
+    }
+
+    T& at(int i, int j, int k) {
+        checkGridIndex(i, j, k, nx, ny, nz);
+        return touch(i, j, k);
+    }
+
+    /**
+     * @brief The value at (i, j, k) without allocating; unchecked.
+     */
+    const T& get(int i, int j, int k) const {
+        const std::int32_t brick = table[brickNumber(i, j, k)];
+        return brick < 0 ? background : bricks[brick][inBrick(i, j, k)];
+    }
+
+    /**
+     * @brief Sets the value at (i, j, k). Writing the background value into an unallocated brick
+     * does not allocate it.
+     */
+    void set(int i, int j, int k, const T& value) {
+#if GRID_CHECK_BOUNDS
+        checkGridIndex(i, j, k, nx, ny, nz);
+#endif
+        const std::int32_t brick = table[brickNumber(i, j, k)];
+        if (brick >= 0) {
+            bricks[brick][inBrick(i, j, k)] = value;
+        } else if (!(value == background)) {
+            touch(i, j, k) = value;
+        }
+    }
+
+    /**
+     * @brief Calls f(i0, j0, k0, values) for every allocated brick, in order of allocation: the
+     * brick holds the points (i0 + a, j0 + b, k0 + c) for a, b, c < B at values[(a * B + b) * B + c].
+     * Points beyond the grid in a brick at its edge hold the background value and must be skipped
+     * (see forEachActive).
+     */
+    template <typename F>
+    void forEachBrick(F f) {
+        for (std::size_t b = 0; b < bricks.size(); ++b) {
+            int i0, j0, k0;
+            brickOrigin(owners[b], i0, j0, k0);
+            f(i0, j0, k0, bricks[b]);
+        }
+    }
+
+    template <typename F>
+    void forEachBrick(F f) const {
+        for (std::size_t b = 0; b < bricks.size(); ++b) {
+            int i0, j0, k0;
+            brickOrigin(owners[b], i0, j0, k0);
+            f(i0, j0, k0, static_cast<const T*>(bricks[b]));
+        }
+    }
+
+    /**
+     * @brief Calls f(i, j, k, value) for every grid point of the allocated bricks, brick by brick,
+     * with `value` a reference; the points of unallocated bricks (all at the background value) are
+     * not visited.
+     */
+    template <typename F>
+    void forEachActive(F f) {
+        forEachBrick([&](int i0, int j0, int k0, T* values) { visitBrick(i0, j0, k0, values, f); });
+    }
+
+    template <typename F>
+    void forEachActive(F f) const {
+        forEachBrick([&](int i0, int j0, int k0, const T* values) { visitBrick(i0, j0, k0, values, f); });
+    }
+
+    /**
+     * @brief Sum of all values: the allocated points plus the background value times the others.
+     */
+    T sum() const {
+        T total = T();
+        std::size_t active = 0;
+        forEachActive([&](int, int, int, const T& value) {
+            total += value;
+            ++active;
+        });
+        return total + background * T(getSize() - active);
+    }
+
+    /**
+     * @brief Frees the bricks whose points all hold the background value.
+     * @return The number of bricks freed.
+     */
+    std::size_t prune() {
+        std::size_t freed = 0;
+        for (std::size_t b = bricks.size(); b-- > 0;) {
+            if (std::all_of(bricks[b], bricks[b] + BRICK_SIZE, [this](const T& v) { return v == background; })) {
+                // Move the last brick into the hole, so that the list of bricks has no gaps
+                ::operator delete(bricks[b], std::align_val_t(ALIGNMENT));
+                table[owners[b]] = -1;
+                if (b + 1 != bricks.size()) {
+                    bricks[b] = bricks.back();
+                    owners[b] = owners.back();
+                    table[owners[b]] = static_cast<std::int32_t>(b);
+                }
+                bricks.pop_back();
+                owners.pop_back();
+                ++freed;
+            }
+        }
+        return freed;
+    }
+
+    /**
+     * @brief A dense copy of the grid.
+     */
+    Grid<T, RowMajor> toDense() const {
+        Grid<T, RowMajor> dense(nx, ny, nz, typename Grid<T, RowMajor>::Uninitialized());
+        std::fill(dense.storage(), dense.storage() + dense.getSize(), background);
+        forEachActive([&dense](int i, int j, int k, const T& value) { dense(i, j, k) = value; });
+        return dense;
+    }
+
+private:
+    static int checkDimension(int n) {
+        if (n <= 0) {
+            throw std::invalid_argument("Grid dimensions must be positive.");
+        }
+        return n;
+    }
+
+    static constexpr int shift() {
+        int s = 0;
+        while ((1 << s) < B) {
+            ++s;
+        }
+        return s;
+    }
+
+    std::size_t brickNumber(int i, int j, int k) const {
+        return (std::size_t(i >> shift()) * by + std::size_t(j >> shift())) * bz + std::size_t(k >> shift());
+    }
+
+    static std::size_t inBrick(int i, int j, int k) {
+        return (std::size_t(i & (B - 1)) * B + std::size_t(j & (B - 1))) * B + std::size_t(k & (B - 1));
+    }
+
+    void brickOrigin(std::int32_t number, int& i0, int& j0, int& k0) const {
+        k0 = (number % bz) * B;
+        j0 = (number / bz % by) * B;
+        i0 = (number / bz / by) * B;
+    }
+
+    template <typename U, typename F>
+    void visitBrick(int i0, int j0, int k0, U* values, F& f) const {
+        const int i1 = std::min(nx, i0 + B), j1 = std::min(ny, j0 + B), k1 = std::min(nz, k0 + B);
+        for (int i = i0; i < i1; ++i) {
+            for (int j = j0; j < j1; ++j) {
+                U* row = values + inBrick(i, j, k0);
+                for (int k = k0; k < k1; ++k) {
+                    f(i, j, k, row[k - k0]);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Reference to (i, j, k), allocating its brick if needed.
+     */
+    T& touch(int i, int j, int k) {
+        const std::size_t number = brickNumber(i, j, k);
+        std::int32_t brick = table[number];
+        if (brick < 0) {
+            T* values = allocateBrick();
+            std::fill(values, values + BRICK_SIZE, background);
+            try {
+                bricks.push_back(values);
+                owners.push_back(static_cast<std::int32_t>(number));
+            } catch (...) {
+                if (bricks.size() > owners.size()) {
+                    bricks.pop_back();
+                }
+                ::operator delete(values, std::align_val_t(ALIGNMENT));
+                throw;
+            }
+            brick = static_cast<std::int32_t>(bricks.size() - 1);
+            table[number] = brick;
+        }
+        return bricks[brick][inBrick(i, j, k)];
+    }
+
+    static T* allocateBrick() {
+        return static_cast<T*>(::operator new(BRICK_SIZE * sizeof(T), std::align_val_t(ALIGNMENT)));
+    }
+
+    void release() noexcept {
+        for (T* brick : bricks) {
+            ::operator delete(brick, std::align_val_t(ALIGNMENT));
+        }
+        bricks.clear();
+    }
+
+    int nx, ny, nz;                     ///< Dimensions of the grid.
+    int bx, by, bz;                     ///< Number of bricks along each axis.
+    T background;                       ///< Value of the points of unallocated bricks.
+    std::vector<std::int32_t> table;    ///< Storage block of each brick (i-major), or -1.
+    std::vector<T*> bricks;             ///< Allocated bricks, B^3 values each.
+    std::vector<std::int32_t> owners;   ///< Table entry of each allocated brick.
+};
+
+#endif
@@ -0,0 +1,294 @@
+#ifndef __GRID_VIEW_H__
+#define __GRID_VIEW_H__
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+/**
+ * @brief Whether operator() of grids and views checks its indices. By default the checks are on in
+ * debug builds and off when NDEBUG is defined (release builds, -DNDEBUG), so that the index math
+ * inlines into tight loops; at() always checks. Define GRID_CHECK_BOUNDS to 0 or 1 to override.
+ */
+#ifndef GRID_CHECK_BOUNDS
+#ifdef NDEBUG
+#define GRID_CHECK_BOUNDS 0
+#else
+#define GRID_CHECK_BOUNDS 1
+#endif
+#endif
+
+/**
+ * @brief Throws std::out_of_range unless 0 <= i < nx, 0 <= j < ny and 0 <= k < nz.
+ */
+inline void checkGridIndex(int i, int j, int k, int nx, int ny, int nz)
+{
+    if (i < 0 || j < 0 || k < 0 || i >= nx || j >= ny || k >= nz) {
+        throw std::out_of_range("Index out of range.");
+    }
+}
+
+/**
+ * @brief A contiguous range of values (pointer and length), like C++20's std::span.
+ */
+template <typename T>
+class GridSpan
+{
+public:
+    typedef T element_type;
+    typedef T* iterator;
+
+    GridSpan(T* data_, std::size_t size_) : ptr(data_), count(size_) {}
+
+    T* data() const { return ptr; }
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T& operator[](std::size_t p) const { return ptr[p]; }
+    T* begin() const { return ptr; }
+    T* end() const { return ptr + count; }
+
+private:
+    T* ptr;             ///< First value.
+    std::size_t count;  ///< Number of values.
+};
+
+/**
+ * @brief Storage position of (i, j, k) from the strides of the three indices (in values).
+ */
+struct StridedMapping
+{
+    std::ptrdiff_t si, sj, sk;  ///< Strides of i, j and k.
+
+    std::ptrdiff_t offset(int i, int j, int k) const {
+        return i * si + j * sj + k * sk;
+    }
+};
+
+/**
+ * @brief Storage position of (i, j, k) from a layout policy (see grid3d.h), held by pointer.
+ */
+template <typename Layout>
+struct LayoutMapping
+{
+    const Layout* layout;  ///< The layout of the grid.
+
+    std::ptrdiff_t offset(int i, int j, int k) const {
+        return static_cast<std::ptrdiff_t>(layout->offset(i, j, k));
+    }
+};
+
+/**
+ * @brief Random-access iterator over the points of a grid or view in (i, j, k) order, k fastest,
+ * whatever the order of the storage. T is const for a const iterator; Mapping gives the storage
+ * position of each point.
+ */
+template <typename T, typename Mapping>
+class GridIterator
+{
+public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename std::remove_const<T>::type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T* pointer;
+    typedef T& reference;
+
+    GridIterator() : base(nullptr), map(), ny(1), nz(1), index(0), i(0), j(0), k(0) {}
+
+    /**
+     * @brief Iterator at point number index_ (in k-fastest order) of an nx x ny_ x nz_ grid.
+     */
+    GridIterator(T* base_, const Mapping& map_, int ny_, int nz_, std::ptrdiff_t index_)
+        : base(base_), map(map_), ny(ny_), nz(nz_), index(0), i(0), j(0), k(0) {
+        moveTo(index_);
+    }
+
+    /// Conversion from an iterator to a const iterator.
+    template <typename U, typename = typename std::enable_if<std::is_same<const U, T>::value>::type>
+    GridIterator(const GridIterator<U, Mapping>& it)
+        : base(it.base), map(it.map), ny(it.ny), nz(it.nz), index(it.index), i(it.i), j(it.j), k(it.k) {}
+
+    reference operator*() const { return base[map.offset(i, j, k)]; }
+    pointer operator->() const { return &**this; }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    GridIterator& operator++() {
+        ++index;
+        if (++k == nz) {
+            k = 0;
+            if (++j == ny) {
+                j = 0;
+                ++i;
+            }
+        }
+        return *this;
+    }
+
+    GridIterator& operator--() {
+        --index;
+        if (--k < 0) {
+            k = nz - 1;
+            if (--j < 0) {
+                j = ny - 1;
+                --i;
+            }
+        }
+        return *this;
+    }
+
+    GridIterator operator++(int) { GridIterator it = *this; ++*this; return it; }
+    GridIterator operator--(int) { GridIterator it = *this; --*this; return it; }
+    GridIterator& operator+=(difference_type n) { moveTo(index + n); return *this; }
+    GridIterator& operator-=(difference_type n) { moveTo(index - n); return *this; }
+    GridIterator operator+(difference_type n) const { GridIterator it = *this; return it += n; }
+    GridIterator operator-(difference_type n) const { GridIterator it = *this; return it -= n; }
+    friend GridIterator operator+(difference_type n, const GridIterator& it) { return it + n; }
+    difference_type operator-(const GridIterator& it) const { return index - it.index; }
+
+    bool operator==(const GridIterator& it) const { return index == it.index; }
+    bool operator!=(const GridIterator& it) const { return index != it.index; }
+    bool operator<(const GridIterator& it) const { return index < it.index; }
+    bool operator>(const GridIterator& it) const { return index > it.index; }
+    bool operator<=(const GridIterator& it) const { return index <= it.index; }
+    bool operator>=(const GridIterator& it) const { return index >= it.index; }
+
+    /// The indices of the current point.
+    int getI() const { return i; }
+    int getJ() const { return j; }
+    int getK() const { return k; }
+
+private:
+    template <typename, typename>
+    friend class GridIterator;
+
+    void moveTo(std::ptrdiff_t n) {
+        index = n;
+        if (ny == 0 || nz == 0) {
+            return;  // Empty (moved-from) grid
+        }
+        const std::ptrdiff_t plane = std::ptrdiff_t(ny) * nz;
+        i = static_cast<int>(n / plane);
+        j = static_cast<int>(n % plane / nz);
+        k = static_cast<int>(n % nz);
+    }
+
+    T* base;               ///< Storage of the grid or view.
+    Mapping map;           ///< Maps (i, j, k) to a storage position.
+    int ny, nz;            ///< Extents of the two fastest indices.
+    std::ptrdiff_t index;  ///< Number of the current point in k-fastest order.
+    int i, j, k;           ///< Indices of the current point.
+};
+
+/**
+ * @class GridView
+ * @brief A non-owning view of a box of grid points, possibly with steps, of a grid with a strided
+ * layout (RowMajor or ColumnMajor): point (i, j, k) of the view is origin[i * si + j * sj + k * sk].
+ * Views of views (sub-boxes, every n-th point, planes) only change the origin and the strides, so
+ * no data is copied and kernels keep the plain stride arithmetic. A view must not outlive its grid.
+ * T is const for a read-only view.
+ */
+template <typename T>
+class GridView
+{
+public:
+    typedef typename std::remove_const<T>::type value_type;
+    typedef GridIterator<T, StridedMapping> iterator;
+
+    /**
+     * @brief Constructor from the first point and the extents and strides of the view.
+     */
+    GridView(T* origin_, int nx_, int ny_, int nz_, std::ptrdiff_t si, std::ptrdiff_t sj, std::ptrdiff_t sk)
+        : origin(origin_), nx(nx_), ny(ny_), nz(nz_), strides{si, sj, sk} {}
+
+    /// Conversion to a read-only view.
+    operator GridView<const T>() const {
+        return GridView<const T>(origin, nx, ny, nz, strides.si, strides.sj, strides.sk);
+    }
+
+    int getNx() const { return nx; }
+    int getNy() const { return ny; }
+    int getNz() const { return nz; }
+    std::size_t getSize() const { return std::size_t(nx) * ny * nz; }
+
+    /// Strides of i, j and k in values.
+    std::ptrdiff_t strideI() const { return strides.si; }
+    std::ptrdiff_t strideJ() const { return strides.sj; }
+    std::ptrdiff_t strideK() const { return strides.sk; }
+
+    /// The first point (0, 0, 0) of the view.
+    T* data() const { return origin; }
+
+    /**
+     * @brief Access to point (i, j, k) of the view, checked only if GRID_CHECK_BOUNDS is set.
+     */
+    T& operator()(int i, int j, int k) const {
+#if GRID_CHECK_BOUNDS
+        checkGridIndex(i, j, k, nx, ny, nz);
+#endif
+        return origin[strides.offset(i, j, k)];
+    }
+
+    /**
+     * @brief Access to point (i, j, k) of the view; throws std::out_of_range for an invalid index.
+     */
+    T& at(int i, int j, int k) const {
+        checkGridIndex(i, j, k, nx, ny, nz);
+        return origin[strides.offset(i, j, k)];
+    }
+
+    /**
+     * @brief View of the box of points (i0 + a * di, j0 + b * dj, k0 + c * dk) for a < nx_, b < ny_, c < nz_.
+     * @throws std::out_of_range if the box does not fit in this view.
+     */
+    GridView sub(int i0, int j0, int k0, int nx_, int ny_, int nz_, int di = 1, int dj = 1, int dk = 1) const {
+        if (nx_ <= 0 || ny_ <= 0 || nz_ <= 0 || di <= 0 || dj <= 0 || dk <= 0) {
+            throw std::invalid_argument("View extents and steps must be positive.");
+        }
+        checkGridIndex(i0, j0, k0, nx, ny, nz);
+        checkGridIndex(i0 + (nx_ - 1) * di, j0 + (ny_ - 1) * dj, k0 + (nz_ - 1) * dk, nx, ny, nz);
+        return GridView(origin + strides.offset(i0, j0, k0), nx_, ny_, nz_,
+                        strides.si * di, strides.sj * dj, strides.sk * dk);
+    }
+
+    /**
+     * @brief View of the plane with index `index` along `axis` (0 = i, 1 = j, 2 = k): a view with
+     * extent 1 along that axis.
+     */
+    GridView plane(int axis, int index) const {
+        switch (axis) {
+        case 0: return sub(index, 0, 0, 1, ny, nz);
+        case 1: return sub(0, index, 0, nx, 1, nz);
+        case 2: return sub(0, 0, index, nx, ny, 1);
+        default: throw std::invalid_argument("The axis must be 0, 1 or 2.");
+        }
+    }
+
+    /**
+     * @brief Calls f(value) for every point of the view in (i, j, k) order, with `value` a reference.
+     * The innermost loop walks a pointer by the k stride.
+     */
+    template <typename F>
+    void forEach(F f) const {
+        for (int i = 0; i < nx; ++i) {
+            for (int j = 0; j < ny; ++j) {
+                T* row = origin + strides.offset(i, j, 0);
+                for (int k = 0; k < nz; ++k, row += strides.sk) {
+                    f(*row);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Iterators over the points of the view in (i, j, k) order.
+     */
+    iterator begin() const { return iterator(origin, strides, ny, nz, 0); }
+    iterator end() const { return iterator(origin, strides, ny, nz, static_cast<std::ptrdiff_t>(getSize())); }
+
+private:
+    T* origin;               ///< Point (0, 0, 0) of the view.
+    int nx, ny, nz;          ///< Extents of the view.
+    StridedMapping strides;  ///< Strides of i, j and k in values.
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "grid3d_1d_array.h"
+#include "grid_multigrid.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+/**
+ * @brief Seconds taken by f().
+ */
+template <typename F>
+double timeIt(F f)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count();
+}
+
+/**
+ * @brief Convergence and timing of the multigrid Poisson solver. For 64^3, 128^3, ... cells of the
+ * unit cube (n = 63, 127, ... interior points) it solves Laplacian(u) = f with u = 0 on the
+ * boundary and f such that u = sin(pi x) sin(pi y) sin(pi z), and prints:
+ * - the number of V-cycles that reduce the residual 10^10 times, their mean reduction factor and
+ *   the time per cycle and per point, which stays constant if the work grows linearly;
+ * - the error of the converged solution (the discretization error, divided by 4 when h halves);
+ * - the time and error of one pass of full multigrid;
+ * - for comparison, the Jacobi sweeps that the same reduction would take: the slowest error mode
+ *   shrinks by cos(pi h) per sweep.
+ * Usage: multigrid_grid.x [max_cells] [threads]   (defaults: 512, the hardware concurrency;
+ * 512^3 needs about 4 GiB)
+ */
+int main(int argc, char* argv[])
+{
+    const int maxCells = argc > 1 ? std::atoi(argv[1]) : 512;
+    GridThreadPool pool(argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 0);
+    const double pi = std::acos(-1.0), tolerance = 1e-10;
+    std::cout << "Multigrid V(2,2) cycles with red-black Gauss-Seidel, " << pool.size() << " thread(s)\n"
+              << std::setw(7) << "cells" << std::setw(7) << "levels" << std::setw(8) << "cycles" << std::setw(9)
+              << "factor" << std::setw(10) << "s/cycle" << std::setw(12) << "ns/point" << std::setw(11) << "error"
+              << std::setw(10) << "FMG s" << std::setw(11) << "FMG error" << std::setw(15) << "Jacobi sweeps" << "\n";
+
+    for (int cells = 64; cells <= maxCells; cells *= 2) {
+        const int n = cells - 1;
+        const double h = 1.0 / cells;
+        std::vector<double> wave(n);
+        for (int i = 0; i < n; i++) {
+            wave[i] = std::sin(pi * (i + 1) * h);
+        }
+        Grid1 f(n, n, n);
+        parallel::fill(pool, f, 0.0);
+        multigrid::detail::forPlanes(pool, n, [&](int i0, int i1) {
+            for (int i = i0; i < i1; i++)
+            for (int j = 0; j < n; j++)
+            for (int k = 0; k < n; k++)
+                f(i, j, k) = -3.0 * pi * pi * wave[i] * wave[j] * wave[k];
+        });
+        HaloGrid<double> u(n, n, n);
+        multigrid::PoissonSolver solver(pool, n, n, n, h);
+
+        std::vector<double> history;
+        const double solveTime = timeIt([&] { history = solver.solve(u, f, tolerance, 50); });
+        const int cycles = static_cast<int>(history.size()) - 1;
+        const double factor = std::pow(history.back() / history.front(), 1.0 / cycles);
+        auto maxError = [&] {
+            double error = 0.0;
+            for (int i = 0; i < n; i++)
+            for (int j = 0; j < n; j++)
+            for (int k = 0; k < n; k++)
+                error = std::max(error, std::fabs(u(i, j, k) - wave[i] * wave[j] * wave[k]));
+            return error;
+        };
+        const double error = maxError();
+        // Full multigrid overwrites the interior of u, so it reuses the same grid
+        const double fmgTime = timeIt([&] { solver.fullMultigrid(u, f); });
+        const double fmgError = maxError();
+        const double jacobiSweeps = std::log(tolerance) / std::log(std::cos(pi * h));
+
+        std::cout << std::setw(7) << cells << std::setw(7) << solver.getLevels() << std::setw(8) << cycles
+                  << std::setw(9) << std::setprecision(3) << factor << std::setw(10) << solveTime / cycles
+                  << std::setw(12) << solveTime / cycles / (double(n) * n * n) * 1e9 << std::setw(11) << error
+                  << std::setw(10) << fmgTime << std::setw(11) << fmgError << std::setw(15)
+                  << std::setprecision(0) << std::fixed << jacobiSweeps << "\n" << std::defaultfloat;
+    }
+    return 0;
+}
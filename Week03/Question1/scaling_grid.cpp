@@ -0,0 +1,102 @@
+#include "grid3d_1d_array.h"
+#include "grid_parallel.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Seconds taken by f().
+ */
+template <typename F>
+double timeIt(F f)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    return elapsed.count();
+}
+
+/**
+ * @brief The thread count after `threads` in the scaling curve: the next power of two, or
+ * max_threads if that would skip it.
+ */
+unsigned nextThreadCount(unsigned threads, unsigned max_threads)
+{
+    if (threads < max_threads && threads * 2 > max_threads) {
+        return max_threads;
+    }
+    return threads * 2;
+}
+
+/**
+ * @brief Strong scaling of the parallel grid operations: the same n^3 grids (two of them) are
+ * processed with 1, 2, 4, ... threads and last with max_threads (the whole node, even if it is
+ * not a power of two), and the time of each operation and its speedup over one thread are printed. The grids are created by the pool of each run, so their pages are first
+ * touched by the threads that use them.
+ * Usage: scaling_grid.x [n] [max_threads]   (defaults: 1024, the hardware concurrency;
+ * n = 1024 needs 16 GiB)
+ */
+int main(int argc, char* argv[])
+{
+    const int n = argc > 1 ? std::atoi(argv[1]) : 1024;
+    unsigned max_threads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 0;
+    if (max_threads == 0) {
+        max_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (n <= 0) {
+        std::cerr << "The grid size must be positive.\n";
+        return 1;
+    }
+    std::cout << "Two " << n << "^3 grids of double (" << 2.0 * n * n * n * sizeof(double) / (1 << 30)
+              << " GiB), up to " << max_threads << " threads\n";
+
+    const std::vector<std::string> names = {"zeros", "fill", "apply", "transform", "assign", "sum", "dot",
+                                            "norm", "min", "max"};
+    std::vector<double> baseline;
+    std::cout << std::setw(8) << "threads";
+    for (const std::string& name : names) {
+        std::cout << std::setw(11) << name;
+    }
+    std::cout << std::setw(11) << "total" << std::setw(9) << "speedup" << "\n";
+
+    for (unsigned threads = 1; threads <= max_threads; threads = nextThreadCount(threads, max_threads)) {
+        GridThreadPool pool(threads);
+        std::vector<double> seconds;
+        double check = 0.0;
+        {
+            Grid1 a, b;
+            seconds.push_back(timeIt([&] {
+                a = parallel::zeros<double>(pool, n, n, n);
+                b = parallel::zeros<double>(pool, n, n, n);
+            }));
+            seconds.push_back(timeIt([&] { parallel::fill(pool, a, 1.5); }));
+            seconds.push_back(timeIt([&] { parallel::apply(pool, a, [](double& v) { v = v * v - 1.0; }); }));
+            seconds.push_back(timeIt([&] {
+                parallel::transform(pool, a, b, [](double v) { return 0.5 * v + 0.25; });
+            }));
+            seconds.push_back(timeIt([&] { parallel::assign(pool, b, a + 2.0 * b); }));
+            seconds.push_back(timeIt([&] { check += parallel::sum(pool, b); }));
+            seconds.push_back(timeIt([&] { check += parallel::dot(pool, a, b); }));
+            seconds.push_back(timeIt([&] { check += parallel::norm(pool, a); }));
+            seconds.push_back(timeIt([&] { check += parallel::min(pool, b); }));
+            seconds.push_back(timeIt([&] { check += parallel::max(pool, b); }));
+        }
+        double total = 0.0;
+        std::cout << std::setw(8) << threads << std::setprecision(3);
+        for (double s : seconds) {
+            std::cout << std::setw(11) << s;
+            total += s;
+        }
+        if (baseline.empty()) {
+            baseline = seconds;
+            baseline.push_back(total);
+        }
+        std::cout << std::setw(11) << total << std::setw(9) << baseline.back() / total
+                  << (check > 0.0 ? "" : "  (UNEXPECTED RESULT)") << "\n";
+    }
+    return 0;
+}
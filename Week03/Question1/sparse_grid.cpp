@@ -0,0 +1,137 @@
+#include "grid3d_1d_array.h"
+#include "grid_sparse.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Best time in seconds of three runs of f().
+ */
+template <typename F>
+double bestTime(F f)
+{
+    double best = 1e300;
+    for (int run = 0; run < 3; ++run) {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+/**
+ * @brief A point of the field.
+ */
+struct Point
+{
+    int i, j, k;
+};
+
+/**
+ * @brief Prints the time of an operation on the dense and the sparse grid, and their ratio.
+ */
+void report(const std::string& name, double dense, double sparse, double check)
+{
+    std::cout << std::setw(28) << std::left << name << std::right << std::setw(12) << dense << std::setw(12)
+              << sparse << std::setw(10) << sparse / dense << (std::isfinite(check) ? "" : "  (INVALID RESULT)")
+              << "\n";
+}
+
+/**
+ * @brief Memory and access cost of SparseGrid<double, 8> against the dense Grid1 for a mostly empty
+ * field: a spherical shell `width` points thick and of radius 0.35 n in an n^3 grid (the narrow band
+ * of a level set). Times, in seconds, are the best of three runs:
+ * - write: set() on every point of the shell (the first run allocates the bricks);
+ * - read shell: operator() const on every point of the shell;
+ * - read all: operator() const on every point of the grid, in (i, j, k) order;
+ * - sum active: the sum of the shell, by forEachActive on the sparse grid and by a loop over the
+ *   whole storage of the dense grid.
+ * Usage: sparse_grid.x [n] [width]   (defaults: 512, 4)
+ */
+int main(int argc, char* argv[])
+{
+    const int n = argc > 1 ? std::atoi(argv[1]) : 512;
+    const double width = argc > 2 ? std::atof(argv[2]) : 4.0;
+    if (n <= 0 || !(width > 0.0)) {
+        std::cerr << "The grid size and the shell width must be positive.\n";
+        return 1;
+    }
+    const double radius = 0.35 * n, centre = 0.5 * (n - 1);
+    std::vector<Point> shell;
+    for (int i = 0; i < n; i++)
+    for (int j = 0; j < n; j++)
+    for (int k = 0; k < n; k++) {
+        const double r = std::sqrt((i - centre) * (i - centre) + (j - centre) * (j - centre) + (k - centre) * (k - centre));
+        if (std::fabs(r - radius) < 0.5 * width) {
+            shell.push_back(Point{i, j, k});
+        }
+    }
+
+    Grid1 dense(n, n, n);
+    SparseGrid<double, 8> sparse(n, n, n);
+    const double writeDense = bestTime([&] {
+        for (const Point& p : shell) {
+            dense.set(p.i, p.j, p.k, 1.0 + p.i * 1e-3);
+        }
+    });
+    const double writeSparse = bestTime([&] {
+        for (const Point& p : shell) {
+            sparse.set(p.i, p.j, p.k, 1.0 + p.i * 1e-3);
+        }
+    });
+
+    const Grid1& constDense = dense;
+    const SparseGrid<double, 8>& constSparse = sparse;
+    double check = 0.0;
+    const double shellDense = bestTime([&] {
+        for (const Point& p : shell) {
+            check += constDense(p.i, p.j, p.k);
+        }
+    });
+    const double shellSparse = bestTime([&] {
+        for (const Point& p : shell) {
+            check -= constSparse(p.i, p.j, p.k);
+        }
+    });
+    const double allDense = bestTime([&] {
+        for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+        for (int k = 0; k < n; k++)
+            check += constDense(i, j, k);
+    });
+    const double allSparse = bestTime([&] {
+        for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+        for (int k = 0; k < n; k++)
+            check -= constSparse(i, j, k);
+    });
+    const double sumDense = bestTime([&] { check += dense.sum(); });
+    const double sumSparse = bestTime([&] {
+        double total = 0.0;
+        constSparse.forEachActive([&total](int, int, int, const double& v) { total += v; });
+        check -= total;
+    });
+
+    const double points = double(n) * n * n;
+    std::cout << "Shell of " << shell.size() << " points (" << 100.0 * shell.size() / points << "% of a " << n
+              << "^3 grid), " << sparse.getActiveBricks() << " of " << sparse.getBrickCount() << " 8^3 bricks allocated ("
+              << 100.0 * sparse.getActiveBricks() / sparse.getBrickCount() << "%)\n"
+              << "Memory: dense " << dense.getMemory() / 1048576.0 << " MiB, sparse " << sparse.getMemory() / 1048576.0
+              << " MiB (" << double(dense.getMemory()) / sparse.getMemory() << " times less)\n"
+              << std::setw(28) << std::left << "seconds" << std::right << std::setw(12) << "dense" << std::setw(12)
+              << "sparse" << std::setw(10) << "ratio" << "\n";
+    report("write shell (set)", writeDense, writeSparse, check);
+    report("read shell (operator())", shellDense, shellSparse, check);
+    report("read all (operator())", allDense, allSparse, check);
+    report("sum shell (storage/bricks)", sumDense, sumSparse, check);
+    // Every value was added and subtracted the same number of times
+    std::cout << "Dense and sparse reads " << (std::fabs(check) < 1e-6 * points ? "agree" : "DIFFER") << "\n";
+    return 0;
+}
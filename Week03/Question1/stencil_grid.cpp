@@ -0,0 +1,165 @@
+#include "grid3d_1d_array.h"
+#include "grid_halo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Best time in seconds of `runs` runs of f().
+ */
+template <typename F>
+double bestTime(int runs, F f)
+{
+    double best = 1e300;
+    for (int run = 0; run < runs; ++run) {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+/**
+ * @brief The 7-point Laplacian through operator(), one point at a time and without blocking.
+ */
+void naiveLaplacian(const HaloGrid<double>& u, Grid1& out, double h)
+{
+    const double scale = 1.0 / (h * h);
+    for (int i = 0; i < u.getNx(); i++)
+    for (int j = 0; j < u.getNy(); j++)
+    for (int k = 0; k < u.getNz(); k++) {
+        const double sum = ((u(i, j, k - 1) + u(i, j, k + 1)) + (u(i, j - 1, k) + u(i, j + 1, k)))
+                           + (u(i - 1, j, k) + u(i + 1, j, k));
+        out(i, j, k) = (sum - 6.0 * u(i, j, k)) * scale;
+    }
+}
+
+/**
+ * @brief One Jacobi sweep through operator(), one point at a time and without blocking.
+ */
+void naiveJacobi(const HaloGrid<double>& u, const Grid1& f, HaloGrid<double>& next, double h)
+{
+    for (int i = 0; i < u.getNx(); i++)
+    for (int j = 0; j < u.getNy(); j++)
+    for (int k = 0; k < u.getNz(); k++) {
+        const double sum = ((u(i, j, k - 1) + u(i, j, k + 1)) + (u(i, j - 1, k) + u(i, j + 1, k)))
+                           + (u(i - 1, j, k) + u(i + 1, j, k));
+        next(i, j, k) = (sum - h * h * f(i, j, k)) * (1.0 / 6.0);
+    }
+}
+
+/**
+ * @brief Memory bandwidth in bytes per second: y += a x (simd::axpy) on two arrays of 32 MiB
+ * each, much larger than the caches, which reads 16 and writes 8 bytes per value.
+ */
+double measureBandwidth()
+{
+    const std::size_t n = std::size_t(1) << 22;
+    std::vector<double> x(n, 1.0), y(n, 0.0);
+    const double seconds = bestTime(10, [&] { simd::axpy(1e-3, x.data(), y.data(), n); });
+    return 24.0 * n / seconds;
+}
+
+/// Floating-point operations per point of both stencils (5 additions, 2 multiplications, 1 subtraction).
+constexpr double FLOPS_PER_POINT = 8.0;
+
+/**
+ * @brief Compute ceiling of the stencils in flop/s: simd::laplacianRow over rows of 512 values
+ * that stay in the L1 cache (28 KiB in all), so its speed is limited only by the core for this
+ * mix of loads and flops.
+ */
+double measureCeiling(int runs)
+{
+    const std::size_t n = 512;
+    const int repeats = 20000;
+    std::vector<double> center(n + 2, 1.0), xm(n, 2.0), xp(n, 3.0), ym(n, 4.0), yp(n, 5.0), out(n);
+    const simd::StencilRows rows{center.data() + 1, xm.data(), xp.data(), ym.data(), yp.data()};
+    const double seconds = bestTime(runs, [&] {
+        for (int r = 0; r < repeats; r++) {
+            simd::laplacianRow(rows, 0.5, out.data(), n);
+        }
+    });
+    return FLOPS_PER_POINT * double(n) * repeats / seconds;
+}
+
+/**
+ * @brief Prints one row of the roofline table.
+ * @param name The kernel.
+ * @param points Points updated per run.
+ * @param seconds Time of one run.
+ * @param bytes Minimum memory traffic per point, in bytes.
+ * @param peak Compute ceiling in flop/s.
+ * @param bandwidth Memory bandwidth in bytes/s.
+ */
+void report(const std::string& name, double points, double seconds, double bytes, double peak, double bandwidth)
+{
+    const double flops = FLOPS_PER_POINT * points / seconds;
+    const double intensity = FLOPS_PER_POINT / bytes;
+    const double bound = std::min(peak, intensity * bandwidth);
+    std::cout << std::setw(20) << std::left << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds << std::setw(10) << flops * 1e-9 << std::setw(10)
+              << bytes * points / seconds * 1e-9 << std::setw(8) << intensity << std::setw(10) << bound * 1e-9
+              << std::setw(7) << std::setprecision(0) << 100.0 * flops / bound << "%\n";
+}
+
+/**
+ * @brief Measures the 7-point Laplacian and Jacobi sweep on an n^3 grid (naive, vectorized without
+ * blocking, vectorized and cache-blocked) and places them on the roofline of the machine:
+ * - bandwidth: y += a x on arrays much larger than the caches (see measureBandwidth);
+ * - compute ceiling: the vectorized Laplacian on rows that stay in the L1 cache (see measureCeiling);
+ * - traffic per point: each value of u read once and each result written once, plus the
+ *   write-allocate read of the result line: 24 bytes for the Laplacian (8 + 16) and 32 for Jacobi
+ *   (u, f and next).
+ * GB/s is that minimum traffic over the time; "% roof" is the measured GFLOP/s over
+ * min(ceiling, intensity x bandwidth).
+ * Usage: stencil_grid.x [n] [runs]   (defaults: 256, 5)
+ */
+int main(int argc, char* argv[])
+{
+    const int n = argc > 1 ? std::atoi(argv[1]) : 256;
+    const int runs = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (n <= 0 || runs <= 0) {
+        std::cerr << "The grid size and the number of runs must be positive.\n";
+        return 1;
+    }
+    const double h = 1.0 / (n + 1);
+    const double points = double(n) * n * n;
+
+    HaloGrid<double> u(n, n, n), next(n, n, n);
+    Grid1 f(n, n, n), out(n, n, n);
+    u.interior().forEach([p = 0](double& v) mutable { v = (p++ % 97) * 0.01; });
+    for (double& v : f) {
+        v = 1.0;
+    }
+    u.setBoundary(BoundaryCondition<double>(BoundaryType::Dirichlet, 1.0));
+    u.fillHalo();
+
+    const double bandwidth = measureBandwidth();
+    const double peak = measureCeiling(runs);
+
+    const StencilBlocking unblocked{0, 0};
+    std::cout << "7-point stencils on a " << n << "^3 grid (" << simd::isaName(simd::activeIsa()) << " kernels)\n"
+              << "Memory bandwidth (y += a x): " << std::setprecision(3) << bandwidth * 1e-9 << " GB/s\n"
+              << "Compute ceiling (Laplacian rows in L1): " << peak * 1e-9 << " GFLOP/s\n"
+              << "Ridge point: " << peak / bandwidth << " flop/byte\n"
+              << std::setw(20) << std::left << "kernel" << std::right << std::setw(10) << "seconds" << std::setw(10)
+              << "GFLOP/s" << std::setw(10) << "GB/s" << std::setw(8) << "flop/B" << std::setw(10) << "bound"
+              << std::setw(8) << "% roof" << "\n";
+    report("laplacian naive", points, bestTime(runs, [&] { naiveLaplacian(u, out, h); }), 24.0, peak, bandwidth);
+    report("laplacian simd", points, bestTime(runs, [&] { stencil::laplacian(u, out, h, unblocked); }), 24.0,
+           peak, bandwidth);
+    report("laplacian blocked", points, bestTime(runs, [&] { stencil::laplacian(u, out, h); }), 24.0, peak,
+           bandwidth);
+    report("jacobi naive", points, bestTime(runs, [&] { naiveJacobi(u, f, next, h); }), 32.0, peak, bandwidth);
+    report("jacobi simd", points, bestTime(runs, [&] { stencil::jacobiSweep(u, f, next, h, unblocked); }), 32.0,
+           peak, bandwidth);
+    report("jacobi blocked", points, bestTime(runs, [&] { stencil::jacobiSweep(u, f, next, h); }), 32.0, peak,
+           bandwidth);
+    return 0;
+}
@@ -1,8 +1,19 @@
 #include "grid3d_1d_array.h"
 #include "grid3d_vector.h"
 #include "grid3d_new.h"
+#include "grid_halo.h"
+#include "grid_multigrid.h"
+#include "grid_parallel.h"
+#include "grid_sparse.h"
 #include <iostream>
 #include <chrono>
+#include <cmath>
+#include <functional>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
 
 void test1DArrayGrid()
 {
@@ -55,10 +66,836 @@ void testNewGrid()
     std::cout << "Summed new-operator-based grid:\n" << grid_sum;
 }
 
+/**
+ * @brief Fills a grid of the given layout, checks it against a row-major grid and times a traversal.
+ * @return True if every value, the sum and the copies agree with the row-major grid.
+ */
+template <typename Layout>
+bool testLayout(int nx, int ny, int nz)
+{
+    Grid<double, RowMajor> reference(nx, ny, nz);
+    Grid<double, Layout> grid(nx, ny, nz);
+    for (int i = 0; i < nx; i++) {
+    for (int j = 0; j < ny; j++) {
+    for (int k = 0; k < nz; k++) {
+        reference.set(i, j, k, 10000*i + 100*j + k);
+        grid(i, j, k) = 10000*i + 100*j + k;
+    }}}
+
+    Grid<double, Layout> grid_sum = grid + grid;
+    Grid<double, Layout> copy = grid;
+    Grid<double, Layout> moved = std::move(copy);
+    bool ok = true;
+    for (int i = 0; i < nx; i++) {
+    for (int j = 0; j < ny; j++) {
+    for (int k = 0; k < nz; k++) {
+        ok = ok && grid(i, j, k) == reference(i, j, k) && grid_sum(i, j, k) == 2 * reference(i, j, k)
+                && moved(i, j, k) == reference(i, j, k);
+    }}}
+    ok = ok && copy.getMemory() == 0;
+
+    // A k-fastest sweep suits the row-major layout, an i-fastest sweep the column-major one
+    double sum = 0.0;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < nx; i++)
+    for (int j = 0; j < ny; j++)
+    for (int k = 0; k < nz; k++)
+        sum += grid(i, j, k);
+    std::chrono::duration<double> k_fastest = std::chrono::high_resolution_clock::now() - start;
+    start = std::chrono::high_resolution_clock::now();
+    for (int k = 0; k < nz; k++)
+    for (int j = 0; j < ny; j++)
+    for (int i = 0; i < nx; i++)
+        sum -= grid(i, j, k);
+    std::chrono::duration<double> i_fastest = std::chrono::high_resolution_clock::now() - start;
+
+    std::cout << Layout::name() << " grid " << nx << "x" << ny << "x" << nz << ": "
+              << grid.getMemory() << " bytes, k-fastest sweep " << k_fastest.count()
+              << " s, i-fastest sweep " << i_fastest.count() << " s, "
+              << (ok && sum == 0.0 ? "matches row-major" : "DIFFERS FROM ROW-MAJOR") << "\n";
+    return ok && sum == 0.0;
+}
+
+void testLayouts(bool& ok)
+{
+    std::cout << "Testing grid layouts:\n";
+    // Extents that are not multiples of the tile edge nor powers of two exercise the padding
+    ok = testLayout<RowMajor>(3, 5, 7) && ok;
+    ok = testLayout<ColumnMajor>(3, 5, 7) && ok;
+    ok = testLayout<Tiled3D<4>>(3, 5, 7) && ok;
+    ok = testLayout<Morton>(3, 5, 7) && ok;
+    ok = testLayout<Morton>(1, 16, 3) && ok;
+
+    const int n = 160;
+    ok = testLayout<RowMajor>(n, n, n) && ok;
+    ok = testLayout<ColumnMajor>(n, n, n) && ok;
+    ok = testLayout<Tiled3D<8>>(n, n, n) && ok;
+    ok = testLayout<Morton>(n, n, n) && ok;
+
+    // Invalid dimensions and indices are rejected
+    bool threw = false;
+    try {
+        Grid<double, Morton> invalid(0, 1, 1);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    try {
+        Grid<double, Tiled3D<8>> grid(2, 2, 2);
+        grid.at(2, 0, 0) = 1.0;
+        threw = false;
+    } catch (const std::out_of_range&) {
+    }
+    std::cout << "Invalid dimensions and indices " << (threw ? "rejected" : "NOT REJECTED") << "\n";
+    ok = ok && threw;
+}
+
+/**
+ * @brief Whether two arrays hold the same bits (so NaNs and signed zeros compare as well).
+ */
+bool sameBits(const double* a, const double* b, std::size_t n)
+{
+    return n == 0 || std::memcmp(a, b, n * sizeof(double)) == 0;
+}
+
+/**
+ * @brief Runs every kernel of the active instruction set on x, y and z (n values from offset)
+ * and stores the element-wise results and the reductions.
+ */
+void runKernels(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z,
+                std::size_t offset, std::size_t n, std::vector<std::vector<double>>& results)
+{
+    results.assign(6, std::vector<double>(n + 2));
+    const double* a = x.data() + offset;
+    const double* b = y.data() + offset;
+    simd::add(a, b, results[0].data(), n);
+    simd::sub(a, b, results[1].data(), n);
+    simd::scale(a, -0.37, results[2].data(), n);
+    std::copy(b, b + n, results[3].data());
+    simd::axpy(1.0 / 3.0, a, results[3].data(), n);
+    simd::fma(a, b, z.data() + offset, results[4].data(), n);
+    results[5][0] = simd::sum(a, n);
+    results[5][1] = simd::dot(a, b, n);
+}
+
+/**
+ * @brief Checks the vectorized kernels of every instruction set the CPU supports against the scalar
+ * kernels, bit for bit, for lengths that leave every possible tail and for unaligned arrays, checks
+ * the Grid operations built on them and times the kernels.
+ */
+void testSimd(bool& ok)
+{
+    const simd::Isa best = simd::detectIsa();
+    std::cout << "Testing SIMD kernels (CPU supports up to " << simd::isaName(best) << "):\n";
+
+    // Values of very different magnitudes and signs, so that the order of the additions matters
+    std::mt19937_64 generator(2024);
+    std::uniform_real_distribution<double> mantissa(-1.0, 1.0);
+    std::uniform_int_distribution<int> exponent(-30, 30);
+    std::vector<double> x(1100), y(1100), z(1100);
+    for (std::size_t p = 0; p < x.size(); p++) {
+        x[p] = std::ldexp(mantissa(generator), exponent(generator));
+        y[p] = std::ldexp(mantissa(generator), exponent(generator));
+        z[p] = std::ldexp(mantissa(generator), exponent(generator));
+    }
+    x[5] = -0.0;
+    y[6] = INFINITY;
+
+    for (int isa = static_cast<int>(simd::Isa::SSE2); isa <= static_cast<int>(best); isa++) {
+        bool same = true;
+        for (std::size_t n : {0, 1, 3, 7, 8, 9, 15, 16, 17, 63, 100, 1001}) {
+            for (std::size_t offset : {0, 1, 3}) {
+                std::vector<std::vector<double>> expected, results;
+                simd::setIsa(simd::Isa::Scalar);
+                runKernels(x, y, z, offset, n, expected);
+                simd::setIsa(static_cast<simd::Isa>(isa));
+                runKernels(x, y, z, offset, n, results);
+                for (std::size_t r = 0; r < results.size(); r++) {
+                    same = same && sameBits(results[r].data(), expected[r].data(), results[r].size());
+                }
+            }
+        }
+        std::cout << simd::isaName(static_cast<simd::Isa>(isa)) << " kernels "
+                  << (same ? "match the scalar kernels bit for bit" : "DIFFER FROM THE SCALAR KERNELS") << "\n";
+        ok = ok && same;
+    }
+
+    // The Grid operations, on a padded layout, against the same formulas applied point by point
+    simd::setIsa(best);
+    const int nx = 5, ny = 6, nz = 7;
+    Grid<double, Tiled3D<4>> a(nx, ny, nz), b(nx, ny, nz), c(nx, ny, nz);
+    int count = 0;
+    for (int i = 0; i < nx; i++) {
+    for (int j = 0; j < ny; j++) {
+    for (int k = 0; k < nz; k++) {
+        a(i, j, k) = x[count];
+        b(i, j, k) = y[count + 7];
+        c(i, j, k) = z[count];
+        count++;
+    }}}
+    Grid<double, Tiled3D<4>> difference = a - b;
+    Grid<double, Tiled3D<4>> updated = c;
+    updated.axpy(2.5, a);
+    Grid<double, Tiled3D<4>> fused = c;
+    fused.multiplyAdd(a, b);
+    Grid<double, Tiled3D<4>> scaled = a;
+    scaled.scale(-3.0);
+    bool same = true;
+    double sum_expected = 0.0, sum_error = 0.0, dot_expected = 0.0, dot_error = 0.0;
+    for (int i = 0; i < nx; i++) {
+    for (int j = 0; j < ny; j++) {
+    for (int k = 0; k < nz; k++) {
+        same = same && difference(i, j, k) == a(i, j, k) - b(i, j, k)
+                    && updated(i, j, k) == c(i, j, k) + 2.5 * a(i, j, k)
+                    && fused(i, j, k) == std::fma(a(i, j, k), b(i, j, k), c(i, j, k))
+                    && scaled(i, j, k) == -3.0 * a(i, j, k);
+        sum_expected += a(i, j, k);
+        sum_error += std::fabs(a(i, j, k));
+        dot_expected += a(i, j, k) * b(i, j, k);
+        dot_error += std::fabs(a(i, j, k) * b(i, j, k));
+    }}}
+    // The reductions add in their own order, so they agree with a sequential sum only to rounding
+    same = same && std::fabs(a.sum() - sum_expected) <= 1e-14 * sum_error
+                && std::fabs(a.dot(b) - dot_expected) <= 1e-14 * dot_error;
+    bool threw = false;
+    try {
+        a.axpy(1.0, Grid<double, Tiled3D<4>>(nx, ny, nz + 1));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    std::cout << "Grid -, scale, axpy, multiplyAdd and dot "
+              << (same && threw ? "match point-by-point results" : "DIFFER FROM POINT-BY-POINT RESULTS") << "\n";
+    ok = ok && same && threw;
+
+    // Throughput of add and dot, in the L1 cache (1024 values) and from memory (4M values)
+    for (std::size_t n : {std::size_t(1024), std::size_t(1) << 22}) {
+        std::vector<double> u(n, 1.0), v(n, 0.5), w(n);
+        const std::size_t repeats = (std::size_t(1) << 26) / n;
+        for (int isa = 0; isa <= static_cast<int>(best); isa++) {
+            simd::setIsa(static_cast<simd::Isa>(isa));
+            auto start = std::chrono::high_resolution_clock::now();
+            for (std::size_t r = 0; r < repeats; r++) {
+                simd::add(u.data(), v.data(), w.data(), n);
+            }
+            std::chrono::duration<double> add_time = std::chrono::high_resolution_clock::now() - start;
+            double dot = 0.0;
+            start = std::chrono::high_resolution_clock::now();
+            for (std::size_t r = 0; r < repeats; r++) {
+                dot += simd::dot(u.data(), w.data(), n);
+            }
+            std::chrono::duration<double> dot_time = std::chrono::high_resolution_clock::now() - start;
+            std::cout << simd::isaName(static_cast<simd::Isa>(isa)) << ", " << n << " values: add "
+                      << repeats * n / add_time.count() * 1e-9 << " Gvalues/s, dot "
+                      << repeats * n / dot_time.count() * 1e-9 << " Gvalues/s"
+                      << (dot == 1.5 * n * repeats ? "" : " (WRONG DOT PRODUCT)") << "\n";
+        }
+    }
+    simd::setIsa(best);
+}
+
+/**
+ * @brief Checks that grid expressions give the same values as one pass per operator, checks the
+ * in-place operators, and times a four-term sum evaluated in one pass against one pass per +.
+ */
+void testExpressions(bool& ok)
+{
+    std::cout << "Testing grid expressions:\n";
+    const int nx = 5, ny = 6, nz = 7;
+    Grid<double, Tiled3D<4>> a(nx, ny, nz), b(nx, ny, nz), c(nx, ny, nz);
+    Grid<int, ColumnMajor> m(nx, ny, nz), n(nx, ny, nz);
+    for (int i = 0; i < nx; i++) {
+    for (int j = 0; j < ny; j++) {
+    for (int k = 0; k < nz; k++) {
+        a(i, j, k) = 0.1 * i + 1.0 / (j + 1) - 0.3 * k;
+        b(i, j, k) = std::sqrt(i + j + k + 0.5);
+        c(i, j, k) = 1e8 * std::sin(i * j + k);
+        m(i, j, k) = i - j * k;
+        n(i, j, k) = 3 * i + k;
+    }}}
+
+    // a + b + c in one pass, against one temporary per operator
+    Grid<double, Tiled3D<4>> fused = a + b + c;
+    Grid<double, Tiled3D<4>> first = a + b;
+    Grid<double, Tiled3D<4>> pairwise = first + c;
+    Grid<double, Tiled3D<4>> mixed = 2.0 * a - b * c + (-a) * 0.5;
+    Grid<double, Tiled3D<4>> updated = c;
+    updated += a;
+    updated -= b * b;
+    updated *= 3.0;
+    updated *= a;
+    Grid<double, Tiled3D<4>> axpy = c;
+    axpy += 1.5 * b;
+    Grid<double, Tiled3D<4>> aliased = a;
+    aliased = aliased + aliased * b;
+    Grid<double, Tiled3D<4>> resized(1, 1, 1);
+    resized = a - c;
+    Grid<int, ColumnMajor> integers = m * n - 2 * m;
+    bool same = true;
+    for (int i = 0; i < nx; i++) {
+    for (int j = 0; j < ny; j++) {
+    for (int k = 0; k < nz; k++) {
+        const double x = a(i, j, k), y = b(i, j, k), z = c(i, j, k);
+        same = same && fused(i, j, k) == pairwise(i, j, k)
+                    && mixed(i, j, k) == (2.0 * x - y * z) + (-1.0 * x) * 0.5
+                    && updated(i, j, k) == (3.0 * ((z + x) - y * y)) * x
+                    && axpy(i, j, k) == z + 1.5 * y
+                    && aliased(i, j, k) == x + x * y
+                    && resized(i, j, k) == x - z
+                    && integers(i, j, k) == m(i, j, k) * n(i, j, k) - 2 * m(i, j, k);
+    }}}
+    bool threw = false;
+    try {
+        Grid<double, Tiled3D<4>> d(nx, ny, nz + 1);
+        a += d;
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    std::cout << "Expressions and in-place operators "
+              << (same && threw ? "match one pass per operator" : "DIFFER FROM ONE PASS PER OPERATOR") << "\n";
+    ok = ok && same && threw;
+
+    // d = a + b + c + e on large grids: one pass and one allocation, or three of each
+    const int size = 160;
+    Grid1 u(size, size, size), v(size, size, size), w(size, size, size), x(size, size, size);
+    for (int i = 0; i < size; i++) {
+    for (int j = 0; j < size; j++) {
+    for (int k = 0; k < size; k++) {
+        u(i, j, k) = i;
+        v(i, j, k) = j;
+        w(i, j, k) = k;
+        x(i, j, k) = 0.5;
+    }}}
+    auto start = std::chrono::high_resolution_clock::now();
+    Grid1 one_pass = u + v + w + x;
+    std::chrono::duration<double> fused_time = std::chrono::high_resolution_clock::now() - start;
+    start = std::chrono::high_resolution_clock::now();
+    Grid1 t1 = u + v;
+    Grid1 t2 = t1 + w;
+    Grid1 three_passes = t2 + x;
+    std::chrono::duration<double> pairwise_time = std::chrono::high_resolution_clock::now() - start;
+    const bool equal = std::memcmp(&one_pass(0, 0, 0), &three_passes(0, 0, 0), one_pass.getMemory()) == 0;
+    std::cout << "a + b + c + d on " << size << "^3 grids: one pass " << fused_time.count() << " s and "
+              << one_pass.getMemory() << " bytes allocated, one pass per + " << pairwise_time.count()
+              << " s and " << 3 * one_pass.getMemory() << " bytes allocated, "
+              << (equal ? "same result" : "DIFFERENT RESULTS") << "\n";
+    ok = ok && equal;
+}
+
+/**
+ * @brief Checks the parallel grid operations of one layout against serial loops over the grid points.
+ * @return True if every operation agrees.
+ */
+template <typename Layout>
+bool testParallelLayout(GridThreadPool& pool, int nx, int ny, int nz)
+{
+    Grid<double, Layout> a = parallel::zeros<double, Layout>(pool, nx, ny, nz);
+    bool ok = a.sum() == 0.0;
+    parallel::fill(pool, a, 2.5);
+    // The serial sum runs over the whole storage, so it also checks that the padding stayed zero
+    ok = ok && a.sum() == 2.5 * a.getSize();
+
+    Grid<double, Layout> b(nx, ny, nz), c(nx, ny, nz);
+    double sum = 0.0, sum_error = 0.0, dot = 0.0, dot_error = 0.0, smallest = 1e300, largest = -1e300;
+    for (int i = 0; i < nx; i++) {
+    for (int j = 0; j < ny; j++) {
+    for (int k = 0; k < nz; k++) {
+        a(i, j, k) = std::sin(0.1 * i + 0.2 * j * j - 0.3 * k);
+        b(i, j, k) = std::cos(i - 0.5 * k) + j;
+        sum += a(i, j, k);
+        sum_error += std::fabs(a(i, j, k));
+        dot += a(i, j, k) * b(i, j, k);
+        dot_error += std::fabs(a(i, j, k) * b(i, j, k));
+        smallest = std::min(smallest, a(i, j, k));
+        largest = std::max(largest, a(i, j, k));
+    }}}
+    ok = ok && std::fabs(parallel::sum(pool, a) - sum) <= 1e-13 * sum_error
+            && parallel::sum(pool, a) == parallel::sum(pool, a)
+            && std::fabs(parallel::dot(pool, a, b) - dot) <= 1e-13 * dot_error
+            && std::fabs(parallel::norm(pool, b) - std::sqrt(b.dot(b))) <= 1e-13 * std::sqrt(b.dot(b))
+            && parallel::min(pool, a) == smallest && parallel::max(pool, a) == largest;
+
+    Grid<double, Layout> d(nx, ny, nz);
+    parallel::assign(pool, d, a + b * a - 0.5 * b);
+    Grid<double, Layout> expected = a + b * a - 0.5 * b;
+    parallel::transform(pool, a, c, [](double v) { return std::exp(v); });
+    Grid<double, Layout> e = b;
+    parallel::apply(pool, e, [](double& v) { v = 2 * v + 1; });
+    for (int i = 0; i < nx; i++) {
+    for (int j = 0; j < ny; j++) {
+    for (int k = 0; k < nz; k++) {
+        ok = ok && d(i, j, k) == expected(i, j, k) && c(i, j, k) == std::exp(a(i, j, k))
+                && e(i, j, k) == 2 * b(i, j, k) + 1;
+    }}}
+    // Padding untouched by transform and apply
+    ok = ok && std::fabs(c.sum() - parallel::sum(pool, c)) <= 1e-12 * c.sum()
+            && std::fabs(e.sum() - parallel::sum(pool, e)) <= 1e-12 * std::fabs(e.sum());
+    return ok;
+}
+
+void testParallel(bool& ok)
+{
+    std::cout << "Testing parallel grid operations:\n";
+    for (unsigned threads : {1u, 3u, 4u}) {
+        GridThreadPool pool(threads);
+        bool same = testParallelLayout<RowMajor>(pool, 37, 23, 19)
+                    && testParallelLayout<ColumnMajor>(pool, 37, 23, 19)
+                    && testParallelLayout<Tiled3D<4>>(pool, 37, 23, 19)
+                    && testParallelLayout<Morton>(pool, 37, 23, 19)
+                    && testParallelLayout<RowMajor>(pool, 1, 1, 1);
+
+        // Errors in a task and mismatched grids reach the caller
+        bool threw = false;
+        try {
+            Grid1 a(4, 4, 4), b(4, 4, 5);
+            parallel::transform(pool, a, b, [](double v) { return v; });
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        try {
+            Grid1 a(64, 64, 64);
+            parallel::apply(pool, a, [](double&) { throw std::runtime_error("task failed"); });
+            threw = false;
+        } catch (const std::runtime_error&) {
+        }
+        std::cout << threads << " thread(s): "
+                  << (same && threw ? "match serial loops" : "DIFFER FROM SERIAL LOOPS") << "\n";
+        ok = ok && same && threw;
+    }
+}
+
+/**
+ * @brief Checks the iterators of a grid of the given layout against (i, j, k) loops.
+ * @return True if they visit the same values in the same order.
+ */
+template <typename Layout>
+bool testIterators(int nx, int ny, int nz)
+{
+    Grid<double, Layout> grid(nx, ny, nz);
+    double sum = 0.0;
+    for (int i = 0; i < nx; i++) {
+    for (int j = 0; j < ny; j++) {
+    for (int k = 0; k < nz; k++) {
+        grid(i, j, k) = 1.0 / (1 + i + 2 * j + 3 * k);
+        sum += grid(i, j, k);
+    }}}
+    const Grid<double, Layout>& constant = grid;
+    bool ok = std::accumulate(constant.begin(), constant.end(), 0.0) == sum
+              && std::distance(grid.begin(), grid.end()) == static_cast<std::ptrdiff_t>(grid.getSize())
+              && *(grid.begin() + (2 * ny + 3) * nz + 4) == grid(2, 3, 4)
+              && *(grid.end() - 1) == grid(nx - 1, ny - 1, nz - 1);
+    std::reverse(grid.begin(), grid.end());
+    ok = ok && grid(0, 0, 0) == 1.0 / (nx + 2 * ny + 3 * nz - 5) && grid(nx - 1, ny - 1, nz - 1) == 1.0;
+    std::sort(grid.begin(), grid.end());
+    ok = ok && std::is_sorted(grid.cbegin(), grid.cend()) && grid.sum() == Grid<double, Layout>(grid).sum();
+    return ok;
+}
+
+/**
+ * @brief Checks views (sub-boxes, steps, planes, views of views) of a grid of a strided layout.
+ * @return True if every view shows and modifies the right points.
+ */
+template <typename Layout>
+bool testViews(int nx, int ny, int nz)
+{
+    Grid<double, Layout> grid(nx, ny, nz);
+    for (int i = 0; i < nx; i++) {
+    for (int j = 0; j < ny; j++) {
+    for (int k = 0; k < nz; k++) {
+        grid(i, j, k) = 10000 * i + 100 * j + k;
+    }}}
+    GridView<double> box = grid.view().sub(1, 2, 3, 3, 4, 5, 2, 1, 3);
+    GridView<double> plane = grid.view().plane(1, 4);
+    GridView<double> nested = box.sub(1, 1, 0, 2, 2, 2, 1, 2, 4);
+    GridView<const double> readOnly = box;
+    bool ok = box.getSize() == 60 && plane.getNy() == 1 && plane.getNx() == nx;
+    for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 4; j++) {
+    for (int k = 0; k < 5; k++) {
+        ok = ok && box(i, j, k) == grid(1 + 2 * i, 2 + j, 3 + 3 * k) && readOnly.at(i, j, k) == box(i, j, k);
+    }}}
+    for (int i = 0; i < 2; i++) {
+    for (int j = 0; j < 2; j++) {
+    for (int k = 0; k < 2; k++) {
+        ok = ok && nested(i, j, k) == box(1 + i, 1 + 2 * j, 4 * k);
+    }}}
+    double sum = 0.0;
+    plane.forEach([&sum](double& v) { sum += v; v = -1.0; });
+    double expected = 0.0;
+    for (int i = 0; i < nx; i++) {
+    for (int k = 0; k < nz; k++) {
+        expected += 10000 * i + 400 + k;
+        ok = ok && grid(i, 4, k) == -1.0;
+    }}
+    ok = ok && sum == expected && std::count(grid.begin(), grid.end(), -1.0) == nx * nz
+            && std::accumulate(nested.begin(), nested.end(), 0.0) == nested(0, 0, 0) + nested(0, 0, 1) + nested(0, 1, 0)
+                   + nested(0, 1, 1) + nested(1, 0, 0) + nested(1, 0, 1) + nested(1, 1, 0) + nested(1, 1, 1);
+    bool threw = false;
+    try {
+        box.sub(0, 0, 0, 4, 1, 1, 1, 1, 1);
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    return ok && threw;
+}
+
+/**
+ * @brief Best time of five runs of f.
+ */
+template <typename F>
+double bestTime(F f)
+{
+    double best = 1e300;
+    for (int run = 0; run < 5; run++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+/**
+ * @brief Updates every value of a grid in place (v = 0.5 * v + 1) by several access paths and
+ * prints the best time of each.
+ */
+void timeAccess(int n)
+{
+    Grid1 grid(n, n, n);
+    const double checked = bestTime([&] {
+        for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+        for (int k = 0; k < n; k++)
+            grid.at(i, j, k) = 0.5 * grid.at(i, j, k) + 1.0;
+    });
+    const double call = bestTime([&] {
+        for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+        for (int k = 0; k < n; k++)
+            grid(i, j, k) = 0.5 * grid(i, j, k) + 1.0;
+    });
+    const double iterators = bestTime([&] {
+        for (double& v : grid)
+            v = 0.5 * v + 1.0;
+    });
+    const double span = bestTime([&] {
+        GridSpan<double> values = grid.span();
+        for (std::size_t p = 0; p < values.size(); p++)
+            values[p] = 0.5 * values[p] + 1.0;
+    });
+    const double view = bestTime([&] {
+        grid.view().forEach([](double& v) { v = 0.5 * v + 1.0; });
+    });
+    // Every value went through the same 25 updates
+    double expected = 0.0;
+    for (int update = 0; update < 25; update++) {
+        expected = 0.5 * expected + 1.0;
+    }
+    const bool same = std::count(grid.begin(), grid.end(), expected) == static_cast<std::ptrdiff_t>(grid.getSize());
+    std::cout << "Updating a " << n << "^3 grid in place: at() " << checked << " s, operator() " << call << " s ("
+              << (GRID_CHECK_BOUNDS ? "checked" : "unchecked") << "), iterators " << iterators << " s, span "
+              << span << " s, view forEach " << view << " s" << (same ? "" : " (VALUES DIFFER)") << "\n";
+}
+
+void testAccess(bool& ok)
+{
+    std::cout << "Testing iterators and views:\n";
+    bool same = testIterators<RowMajor>(5, 6, 7) && testIterators<ColumnMajor>(5, 6, 7)
+                && testIterators<Tiled3D<4>>(5, 6, 7) && testIterators<Morton>(5, 6, 7)
+                && testViews<RowMajor>(8, 9, 20) && testViews<ColumnMajor>(8, 9, 20);
+    Grid1 moved(2, 2, 2);
+    Grid1 target = std::move(moved);
+    same = same && moved.begin() == moved.end() && moved.span().empty();
+    std::cout << "Iterators and views " << (same ? "match (i, j, k) loops" : "DIFFER FROM (i, j, k) LOOPS") << "\n";
+    ok = ok && same;
+    timeAccess(160);
+}
+
+/**
+ * @brief The value fillHalo() should give point (i, j, k) of a grid, worked out one point at a time:
+ * a ghost coordinate along z is resolved first from the point it copies or mirrors, then y, then x
+ * (the reverse of the order in which fillHalo() fills the axes).
+ */
+double haloReference(const HaloGrid<double>& grid, int i, int j, int k)
+{
+    int index[3] = {i, j, k};
+    const int n[3] = {grid.getNx(), grid.getNy(), grid.getNz()};
+    for (int axis = 2; axis >= 0; axis--) {
+        const int m = index[axis];
+        if (m >= 0 && m < n[axis]) {
+            continue;
+        }
+        const int side = m < 0 ? 0 : 1;
+        const int l = m < 0 ? -1 - m : m - n[axis];
+        const BoundaryCondition<double>& condition = grid.getBoundary(axis, side);
+        switch (condition.type) {
+        case BoundaryType::Dirichlet:
+            return condition.value;
+        case BoundaryType::Neumann:
+            index[axis] = side == 0 ? l : n[axis] - 1 - l;
+            return haloReference(grid, index[0], index[1], index[2]) + (2 * l + 1) * condition.value;
+        case BoundaryType::Periodic:
+            index[axis] = side == 0 ? n[axis] - 1 - l : l;
+            return haloReference(grid, index[0], index[1], index[2]);
+        }
+    }
+    return grid(i, j, k);
+}
+
+/**
+ * @brief The 7-point stencil computed point by point through operator(), with the neighbours summed
+ * in the order of the row kernels; `combine(sum, i, j, k)` gives the value of a point.
+ */
+void naiveStencil(const HaloGrid<double>& u, Grid1& out, const std::function<double(double, int, int, int)>& combine)
+{
+    for (int i = 0; i < u.getNx(); i++) {
+    for (int j = 0; j < u.getNy(); j++) {
+    for (int k = 0; k < u.getNz(); k++) {
+        const double sum = ((u(i, j, k - 1) + u(i, j, k + 1)) + (u(i, j - 1, k) + u(i, j + 1, k)))
+                           + (u(i - 1, j, k) + u(i + 1, j, k));
+        out(i, j, k) = combine(sum, i, j, k);
+    }}}
+}
+
+void testHalo(bool& ok)
+{
+    std::cout << "Testing halo grids and the 7-point stencil:\n";
+
+    // Every kind of boundary, two ghost layers, corners included
+    HaloGrid<double> grid(4, 5, 6, 2);
+    grid.interior().forEach([n = 0](double& v) mutable { v = 1.0 + n++; });
+    grid.setBoundary(0, 0, BoundaryCondition<double>(BoundaryType::Dirichlet, 7.0));
+    grid.setBoundary(0, 1, BoundaryCondition<double>(BoundaryType::Dirichlet, -3.0));
+    grid.setBoundary(1, 0, BoundaryCondition<double>(BoundaryType::Periodic));
+    grid.setBoundary(1, 1, BoundaryCondition<double>(BoundaryType::Periodic));
+    grid.setBoundary(2, 0, BoundaryCondition<double>(BoundaryType::Neumann));
+    grid.setBoundary(2, 1, BoundaryCondition<double>(BoundaryType::Neumann, 0.5));
+    grid.fillHalo();
+    bool same = true;
+    for (int i = -2; i < 6; i++) {
+    for (int j = -2; j < 7; j++) {
+    for (int k = -2; k < 8; k++) {
+        same = same && grid.at(i, j, k) == haloReference(grid, i, j, k);
+    }}}
+    same = same && grid(-1, 0, 0) == 7.0 && grid(0, -1, 0) == grid(0, 4, 0) && grid(0, 0, -2) == grid(0, 0, 1)
+                && grid(0, 0, 7) == grid(0, 0, 4) + 1.5 && grid.view().getSize() == 8 * 9 * 10;
+    std::cout << "Ghost cells " << (same ? "match" : "DIFFER FROM") << " the boundary conditions\n";
+    ok = ok && same;
+
+    // Blocked, vectorized stencils against point-by-point loops, for every instruction set
+    const int nx = 13, ny = 10, nz = 19;
+    const double h = 0.1;
+    HaloGrid<double> u(nx, ny, nz), next(nx, ny, nz);
+    Grid1 f(nx, ny, nz), expected(nx, ny, nz), result(nx, ny, nz);
+    std::mt19937_64 generator(7);
+    std::uniform_real_distribution<double> value(-1.0, 1.0);
+    u.interior().forEach([&](double& v) { v = value(generator); });
+    for (double& v : f) {
+        v = value(generator);
+    }
+    u.setBoundary(BoundaryCondition<double>(BoundaryType::Periodic));
+    u.fillHalo();
+    Grid1 expectedJacobi(nx, ny, nz);
+    naiveStencil(u, expected, [&](double sum, int i, int j, int k) { return (sum - 6.0 * u(i, j, k)) * (1.0 / (h * h)); });
+    naiveStencil(u, expectedJacobi, [&](double sum, int i, int j, int k) { return (sum - h * h * f(i, j, k)) * (1.0 / 6.0); });
+    const simd::Isa best = simd::detectIsa();
+    same = true;
+    for (int isa = static_cast<int>(simd::Isa::Scalar); isa <= static_cast<int>(best); isa++) {
+        simd::setIsa(static_cast<simd::Isa>(isa));
+        for (StencilBlocking blocking : {StencilBlocking(), StencilBlocking{0, 0}, StencilBlocking{3, 5},
+                                         StencilBlocking{1, 1}, StencilBlocking{4, 8}}) {
+            stencil::laplacian(u, result, h, blocking);
+            stencil::jacobiSweep(u, f, next, h, blocking);
+            same = same && sameBits(result.storage(), expected.storage(), result.getSize());
+            for (int i = 0; i < nx; i++) {
+            for (int j = 0; j < ny; j++) {
+                same = same && sameBits(next.row(i, j), &expectedJacobi(i, j, 0), nz);
+            }}
+        }
+    }
+    simd::setIsa(best);
+    std::cout << "Blocked stencils " << (same ? "match" : "DIFFER FROM") << " point-by-point loops\n";
+    ok = ok && same;
+
+    // Jacobi converges to the constant of the Dirichlet faces when f = 0
+    HaloGrid<double> steady(12, 12, 12);
+    steady.setBoundary(BoundaryCondition<double>(BoundaryType::Dirichlet, 1.0));
+    stencil::jacobi(steady, Grid1(12, 12, 12), 1.0, 800);
+    double error = 0.0;
+    steady.interior().forEach([&error](double& v) { error = std::max(error, std::fabs(v - 1.0)); });
+    bool threw = false;
+    try {
+        stencil::jacobiSweep(u, f, u, h);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    const bool converged = error < 1e-6 && threw;
+    std::cout << "Jacobi iteration " << (converged ? "converges" : "DOES NOT CONVERGE") << " (max error " << error << ")\n";
+    ok = ok && converged;
+}
+
+/**
+ * @brief Result of runMultigrid: the V-cycle residual history, the full-multigrid solution, and the
+ * maximum errors of the converged and full-multigrid solutions.
+ */
+struct MultigridRun
+{
+    std::vector<double> history;
+    HaloGrid<double> fmg;
+    double error, fmgError;
+};
+
+/**
+ * @brief Solves Laplacian(u) = f on an n^3 grid (n = 2^L - 1) of the unit cube with u = 0 on the
+ * boundary and f such that u = sin(pi x) sin(pi y) sin(pi z), with V-cycles to convergence and with
+ * one pass of full multigrid.
+ */
+MultigridRun runMultigrid(GridThreadPool& pool, int n)
+{
+    const double h = 1.0 / (n + 1), pi = std::acos(-1.0);
+    auto exact = [&](int i, int j, int k) {
+        return std::sin(pi * (i + 1) * h) * std::sin(pi * (j + 1) * h) * std::sin(pi * (k + 1) * h);
+    };
+    Grid1 f(n, n, n);
+    for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+    for (int k = 0; k < n; k++) {
+        f(i, j, k) = -3.0 * pi * pi * exact(i, j, k);
+    }}}
+    multigrid::PoissonSolver solver(pool, n, n, n, h);
+    HaloGrid<double> u(n, n, n);
+    MultigridRun run{solver.solve(u, f, 1e-10, 30), HaloGrid<double>(n, n, n), 0.0, 0.0};
+    solver.fullMultigrid(run.fmg, f);
+    for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+    for (int k = 0; k < n; k++) {
+        run.error = std::max(run.error, std::fabs(u(i, j, k) - exact(i, j, k)));
+        run.fmgError = std::max(run.fmgError, std::fabs(run.fmg(i, j, k) - exact(i, j, k)));
+    }}}
+    return run;
+}
+
+void testMultigrid(bool& ok)
+{
+    std::cout << "Testing the multigrid Poisson solver:\n";
+    GridThreadPool serial(1), threads(3);
+    bool same = true, accurate = true;
+    double factor = 0.0, previousError = 0.0, order = 0.0;
+    for (int n : {15, 31}) {
+        const MultigridRun run = runMultigrid(serial, n);
+        const MultigridRun parallelRun = runMultigrid(threads, n);
+        // The residual norms may differ in the last bits (parallel sums), the solutions may not
+        same = same && run.history.size() == parallelRun.history.size()
+                    && sameBits(run.fmg.storage().storage(), parallelRun.fmg.storage().storage(),
+                                run.fmg.storage().getSize());
+        factor = std::max(factor, std::pow(run.history.back() / run.history.front(), 1.0 / (run.history.size() - 1)));
+        accurate = accurate && run.fmgError < 3.0 * run.error;
+        if (previousError > 0.0) {
+            order = previousError / run.error;
+        }
+        previousError = run.error;
+        std::cout << n << "^3: " << run.history.size() - 1 << " V-cycles, error " << run.error
+                  << ", full multigrid error " << run.fmgError << "\n";
+    }
+    // The constant of the Dirichlet faces is reached from a nonzero start
+    HaloGrid<double> u(7, 7, 7);
+    u.interior().forEach([](double& v) { v = 3.0; });
+    u.setBoundary(BoundaryCondition<double>(BoundaryType::Dirichlet, 2.0));
+    multigrid::PoissonSolver solver(serial, 7, 7, 7, 0.125);
+    solver.solve(u, Grid1(7, 7, 7), 1e-12, 30);
+    double error = 0.0;
+    u.interior().forEach([&error](double& v) { error = std::max(error, std::fabs(v - 2.0)); });
+    // Sizes that stop coarsening early (64 at once, 65 at 32) are rejected; 2^L 3 - 1 and 2^L 5 - 1 are not
+    bool sizes = true;
+    for (int n : {64, 65}) {
+        try {
+            multigrid::PoissonSolver(serial, n, n, n, 1.0 / (n + 1));
+            sizes = false;
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    sizes = sizes && multigrid::PoissonSolver(serial, 47, 47, 47, 1.0 / 48).getLevels() == 5
+                  && multigrid::PoissonSolver(serial, 39, 39, 39, 1.0 / 40).getLevels() == 4;
+    std::cout << "Unsupported multigrid sizes " << (sizes ? "rejected" : "NOT REJECTED") << "\n";
+    // Second-order discretization: halving h divides the error by about 4
+    const bool converged = same && accurate && sizes && factor < 0.2 && order > 3.5 && order < 4.5 && error < 1e-9
+                           && solver.getLevels() == 3;
+    std::cout << "V-cycles reduce the residual by " << factor << " per cycle, error ratio " << order
+              << ", serial and parallel runs " << (same ? "match" : "DIFFER") << "\n";
+    std::cout << "Multigrid " << (converged ? "converges as expected" : "DOES NOT CONVERGE AS EXPECTED") << "\n";
+    ok = ok && converged;
+}
+
+void testSparse(bool& ok)
+{
+    std::cout << "Testing block-sparse grids:\n";
+    // Writes scattered over a few regions of a grid whose extents are not multiples of the brick edge
+    const int nx = 37, ny = 29, nz = 45;
+    SparseGrid<double, 8> sparse(nx, ny, nz, 0.5);
+    Grid1 dense(nx, ny, nz);
+    for (double& v : dense) {
+        v = 0.5;
+    }
+    std::mt19937 generator(11);
+    std::uniform_int_distribution<int> corner(0, 20), offset(0, 7);
+    for (int region = 0; region < 4; region++) {
+        const int i0 = corner(generator), j0 = corner(generator), k0 = corner(generator);
+        for (int n = 0; n < 100; n++) {
+            const int i = std::min(nx - 1, i0 + offset(generator) + 8), j = std::min(ny - 1, j0 + offset(generator) + 8);
+            const int k = std::min(nz - 1, k0 + offset(generator) + 20);
+            sparse.set(i, j, k, i + 0.01 * j + 0.0001 * k);
+            dense(i, j, k) = i + 0.01 * j + 0.0001 * k;
+        }
+    }
+    sparse(nx - 1, ny - 1, nz - 1) += 1.0;
+    dense(nx - 1, ny - 1, nz - 1) += 1.0;
+    sparse.set(0, 0, 0, 0.5);  // The background value: nothing to allocate
+    const SparseGrid<double, 8>& constant = sparse;
+    bool same = sparse.get(0, 0, 0) == 0.5;
+    for (int i = 0; i < nx; i++) {
+    for (int j = 0; j < ny; j++) {
+    for (int k = 0; k < nz; k++) {
+        same = same && constant(i, j, k) == dense(i, j, k);
+    }}}
+    const std::size_t active = sparse.getActiveBricks();
+    std::size_t visited = 0;
+    sparse.forEachActive([&](int i, int j, int k, const double& v) { same = same && v == dense(i, j, k); visited++; });
+    same = same && active > 0 && active < sparse.getBrickCount() && sparse.getBrickCount() == 5 * 4 * 6
+                && sparse.getMemory() == active * (512 * sizeof(double) + sizeof(double*) + 4) + 120 * 4
+                && visited <= active * 512 && std::fabs(sparse.sum() - dense.sum()) < 1e-9 * std::fabs(dense.sum());
+
+    // Copies are deep; pruning frees the bricks that went back to the background value
+    SparseGrid<double, 8> copy = sparse;
+    copy(nx - 1, ny - 1, nz - 1) = 0.5;
+    const std::size_t freed = copy.prune();
+    Grid1 back = copy.toDense();
+    same = same && sparse.get(nx - 1, ny - 1, nz - 1) == 1.5 && freed == 1 && copy.getActiveBricks() == active - 1
+                && back(nx - 1, ny - 1, nz - 1) == 0.5 && back(3, 3, 3) == dense(3, 3, 3);
+    copy.forEachActive([&](int i, int j, int k, double& v) { same = same && v == back(i, j, k); });
+    bool threw = false;
+    try {
+        sparse.at(nx, 0, 0);
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    same = same && threw && constant.getActiveBricks() == active;
+    std::cout << "Sparse grids " << (same ? "match" : "DIFFER FROM") << " dense grids (" << active << " of "
+              << sparse.getBrickCount() << " bricks allocated)\n";
+    ok = ok && same;
+}
+
 int main()
 {
     test1DArrayGrid();
     testVectorGrid();
     testNewGrid();
-    return 0;
+
+    bool ok = true;
+    testLayouts(ok);
+    testSimd(ok);
+    testExpressions(ok);
+    testParallel(ok);
+    testAccess(ok);
+    testHalo(ok);
+    testMultigrid(ok);
+    testSparse(ok);
+    return ok ? 0 : 1;
 }